@@ -116,17 +116,19 @@ void ubx_closeConnection(int handle) {
  * For single threaded development and testing, uses static variables rather
  * than requiring state to be tracked by caller.
  *
- * See ubx_readMessage_buf() for full description.
+ * See ubx_readMessage_ring() for full description.
  *
  * @param[in] handle File descriptor from ubx_openConnection()
  * @param[out] out Pointer to message structure to fill with data
  * @return True if out now contains a valid message, false otherwise.
  */
 bool ubx_readMessage(int handle, ubx_message *out) {
-	static uint8_t buf[UBX_SERIAL_BUFF];
-	static int index = 0; // Current read position
-	static int hw = 0;    // Current array end
-	return ubx_readMessage_buf(handle, out, buf, &index, &hw);
+	static byte_ring ring = {0};
+	if (ring.buf == NULL && !ring_init(&ring, UBX_SERIAL_BUFF)) {
+		out->sync1 = 0xAA;
+		return false;
+	}
+	return ubx_readMessage_ring(handle, out, &ring);
 }
 
 /*!
@@ -173,10 +175,8 @@ bool ubx_readMessage_buf(int handle, ubx_message *out, uint8_t buf[UBX_SERIAL_BU
 		}
 	}
 
-	// Check buf[index] is valid ID
-	while (!(buf[(*index)] == 0xB5) && (*index) < (*hw)) {
-		(*index)++; // Current byte cannot be start of a message, so advance
-	}
+	// Advance to next possible sync byte
+	if ((*index) < (*hw)) { (*index) += scan_byte(&(buf[(*index)]), (*hw) - (*index), 0xB5); }
 	if ((*index) == (*hw)) {
 		if ((*hw) > 0 && (*index) > 0) {
 			// Move data from index back to zero position
@@ -257,6 +257,173 @@ bool ubx_readMessage_buf(int handle, ubx_message *out, uint8_t buf[UBX_SERIAL_BU
 	return valid;
 }
 
+/*!
+ * Frame synchronisation for ubx_frame_protocol
+ *
+ * @param[in] data Unprocessed data
+ * @param[in] len  Length of data
+ * @return Offset of first pair of sync bytes, or len if not found
+ */
+static size_t ubx_frame_sync(const uint8_t *data, size_t len) {
+	return scan_pair(data, len, 0xB5, 0x62);
+}
+
+/*!
+ * Frame length for ubx_frame_protocol
+ *
+ * @param[in] data Candidate message, starting with a sync byte
+ * @param[in] len  Length of data
+ * @return Message length including header and checksum, 0 if more data
+ * required, or -1 if second sync byte invalid
+ */
+static ssize_t ubx_frame_length(const uint8_t *data, size_t len) {
+	if (len < 8) { return 0; }
+	if (data[1] != 0x62) { return -1; }
+	return (data[4] + (data[5] << 8)) + 8;
+}
+
+/*!
+ * Frame validation for ubx_frame_protocol
+ *
+ * Equivalent to ubx_check_checksum(), but calculated directly from the
+ * received data.
+ *
+ * @param[in] data Complete message
+ * @param[in] len  Message length
+ * @return True if checksum valid
+ */
+static bool ubx_frame_check(const uint8_t *data, size_t len) {
+	uint8_t a = 0;
+	uint8_t b = 0;
+	for (size_t i = 2; i < len - 2; i++) {
+		a += data[i];
+		b += a;
+	}
+	return (a == data[len - 2]) && (b == data[len - 1]);
+}
+
+//! UBX message framing, for use with frame_next()
+static const frame_protocol ubx_frame_protocol = {.sync = &ubx_frame_sync,
+                                                  .length = &ubx_frame_length,
+                                                  .check = &ubx_frame_check,
+                                                  .maxLength = UBX_SERIAL_BUFF};
+
+/*!
+ * Implementation of ubx_readMessage_ring() and ubx_readMessage_batch().
+ * Data is only read from `handle` if no complete message is buffered and
+ * `filled` is false, and `filled` is set once data has been read.
+ *
+ * @param[in] handle File descriptor from ubx_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @param[in,out] filled Set true once data has been read from handle
+ * @return True if out now contains a valid message, false otherwise.
+ */
+static bool ubx_ring_next(int handle, ubx_message *out, byte_ring *ring, bool *filled) {
+	out->extdata = NULL;
+	while (true) {
+		const uint8_t *frame = NULL;
+		size_t len = 0;
+		const frame_status fs = frame_next(ring, &ubx_frame_protocol, &frame, &len);
+		if (fs == FRAME_OK) {
+			out->sync1 = frame[0];
+			out->sync2 = frame[1];
+			out->msgClass = frame[2];
+			out->msgID = frame[3];
+			out->length = frame[4] + (frame[5] << 8);
+			if (out->length <= 256) {
+				memcpy(out->data, &(frame[6]), out->length);
+			} else {
+				out->extdata = malloc(out->length);
+				if (out->extdata == NULL) {
+					// LCOV_EXCL_START
+					out->sync1 = 0xAA;
+					return false;
+					// LCOV_EXCL_STOP
+				}
+				memcpy(out->extdata, &(frame[6]), out->length);
+			}
+			out->csumA = frame[len - 2];
+			out->csumB = frame[len - 1];
+			return true;
+		}
+
+		if (fs == FRAME_INVALID) {
+			out->sync1 = 0xEE;
+			return false;
+		}
+		if (fs == FRAME_ERROR) {
+			out->sync1 = 0xAA;
+			return false;
+		}
+
+		out->sync1 = 0xFF;
+		if (*filled) { return false; }
+
+		errno = 0;
+		const ssize_t ti = ring_fill(ring, handle);
+		if (ti < 0 && errno != EAGAIN) {
+			fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
+			        handle);
+			fprintf(stderr, "read returned \"%s\" in readMessage\n", strerror(errno));
+			out->sync1 = 0xAA;
+			return false;
+		}
+		if (ti == 0) { out->sync1 = 0xFD; }
+		if (ti <= 0) { return false; }
+		*filled = true;
+	}
+}
+
+/*!
+ * Reads data from `handle` into `ring` when needed, and uses frame_next() to
+ * find the next message in the ring without moving data around.
+ *
+ * If a valid message is found then it is written to the structure provided as
+ * a parameter and the function returns true. Messages with more than 256
+ * bytes of data use extdata, which must be freed by the caller.
+ *
+ * If a message cannot be read, the function returns false and the `sync1`
+ * field is set to an error value, as described for ubx_readMessage_buf().
+ *
+ * Messages longer than UBX_SERIAL_BUFF bytes are discarded.
+ *
+ * @param[in] handle File descriptor from ubx_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return True if out now contains a valid message, false otherwise.
+ */
+bool ubx_readMessage_ring(int handle, ubx_message *out, byte_ring *ring) {
+	bool filled = false;
+	return ubx_ring_next(handle, out, ring, &filled);
+}
+
+/*!
+ * Returns every complete message available after reading from `handle` at
+ * most once, which avoids a read() and a sleep for each message when several
+ * arrive together.
+ *
+ * The number of messages written to `out` is returned. If this is less than
+ * `max`, the `sync1` field of the following entry is set to the error value
+ * that ended the batch (see ubx_readMessage_ring()). Messages with more than
+ * 256 bytes of data use extdata, which must be freed by the caller.
+ *
+ * @param[in] handle File descriptor from ubx_openConnection()
+ * @param[out] out Array of at least `max` message structures
+ * @param[in] max Maximum number of messages to return
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return Number of valid messages written to out
+ */
+size_t ubx_readMessage_batch(int handle, ubx_message *out, size_t max, byte_ring *ring) {
+	if (out == NULL) { return 0; }
+	bool filled = false;
+	size_t n = 0;
+	while (n < max && ubx_ring_next(handle, &(out[n]), ring, &filled)) {
+		n++;
+	}
+	return n;
+}
+
 /*!
  * Messages are read with ubx_readMessage() and discarded until either a
  * message matches the supplied message class and ID values or the maximum
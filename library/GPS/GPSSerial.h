@@ -44,12 +44,18 @@ int ubx_openConnection(const char *port, const int initialBaud);
 //! Close a connection opened with ubx_openConnection()
 void ubx_closeConnection(int handle);
 
-//! Static wrapper around ubx_readMessage_buf()
+//! Static wrapper around ubx_readMessage_ring()
 bool ubx_readMessage(int handle, ubx_message *out);
 
 //! Read data from handle, and parse message if able
 bool ubx_readMessage_buf(int handle, ubx_message *out, uint8_t buf[UBX_SERIAL_BUFF], int *index, int *hw);
 
+//! Read data from handle into a ring buffer, and parse message if able
+bool ubx_readMessage_ring(int handle, ubx_message *out, byte_ring *ring);
+
+//! Read all buffered messages, reading from handle at most once
+size_t ubx_readMessage_batch(int handle, ubx_message *out, size_t max, byte_ring *ring);
+
 //! Read (and discard) messages until required message seen or timeout reached
 bool ubx_waitForMessage(const int handle, const uint8_t msgClass, const uint8_t msgID, const int maxDelay,
                         ubx_message *out);
@@ -54,17 +54,19 @@ void lpms_closeConnection(int handle) {
  * For single threaded development and testing, uses static variables rather
  * than requiring state to be tracked by caller.
  *
- * See lpms_readMessage_buf() for full description.
+ * See lpms_readMessage_ring() for full description.
  *
  * @param[in] handle File descriptor from lpms_openConnection()
  * @param[out] out Pointer to message structure to fill with data
  * @return True if out now contains a valid message, false otherwise.
  */
 bool lpms_readMessage(int handle, lpms_message *out) {
-	static uint8_t buf[LPMS_BUFF];
-	static size_t index = 0; // Current read position
-	static size_t hw = 0;    // Current array end
-	return lpms_readMessage_buf(handle, out, buf, &index, &hw);
+	static byte_ring ring = {0};
+	if (ring.buf == NULL && !ring_init(&ring, LPMS_BUFF)) {
+		out->id = 0xAA;
+		return false;
+	}
+	return lpms_readMessage_ring(handle, out, &ring);
 }
 
 /*!
@@ -137,6 +139,169 @@ bool lpms_readMessage_buf(int handle, lpms_message *out, uint8_t buf[LPMS_BUFF],
 	return r;
 }
 
+/*!
+ * Frame synchronisation for lpms_frame_protocol
+ *
+ * @param[in] data Unprocessed data
+ * @param[in] len  Length of data
+ * @return Offset of first start byte, or len if not found
+ */
+static size_t lpms_frame_sync(const uint8_t *data, size_t len) {
+	return scan_byte(data, len, LPMS_START);
+}
+
+/*!
+ * Frame length for lpms_frame_protocol
+ *
+ * @param[in] data Candidate message, starting with LPMS_START
+ * @param[in] len  Length of data
+ * @return Message length including start and end bytes, or 0 if more data
+ * required
+ */
+static ssize_t lpms_frame_length(const uint8_t *data, size_t len) {
+	if (len < 11) { return 0; }
+	return (data[5] + (data[6] << 8)) + 11;
+}
+
+/*!
+ * Frame validation for lpms_frame_protocol
+ *
+ * Checks the end bytes and the checksum, which is the sum of all bytes
+ * between the start byte and the checksum itself.
+ *
+ * @param[in] data Complete message
+ * @param[in] len  Message length
+ * @return True if message valid
+ */
+static bool lpms_frame_check(const uint8_t *data, size_t len) {
+	if (data[len - 2] != LPMS_END1 || data[len - 1] != LPMS_END2) { return false; }
+	uint16_t cs = 0;
+	for (size_t i = 1; i < len - 4; i++) {
+		cs += data[i];
+	}
+	return cs == (data[len - 4] + (data[len - 3] << 8));
+}
+
+//! LPMS message framing, for use with frame_next()
+static const frame_protocol lpms_frame_protocol = {.sync = &lpms_frame_sync,
+                                                   .length = &lpms_frame_length,
+                                                   .check = &lpms_frame_check,
+                                                   .maxLength = LPMS_BUFF};
+
+/*!
+ * Implementation of lpms_readMessage_ring() and lpms_readMessage_batch().
+ * Data is only read from `handle` if no complete message is buffered and
+ * `filled` is false, and `filled` is set once data has been read.
+ *
+ * @param[in] handle File descriptor from lpms_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @param[in,out] filled Set true once data has been read from handle
+ * @return True if out now contains a valid message, false otherwise.
+ */
+static bool lpms_ring_next(int handle, lpms_message *out, byte_ring *ring, bool *filled) {
+	out->data = NULL;
+	while (true) {
+		const uint8_t *frame = NULL;
+		size_t len = 0;
+		const frame_status fs = frame_next(ring, &lpms_frame_protocol, &frame, &len);
+		if (fs == FRAME_OK) {
+			out->id = frame[1] + ((uint16_t)frame[2] << 8);
+			out->command = frame[3] + ((uint16_t)frame[4] << 8);
+			out->length = frame[5] + ((uint16_t)frame[6] << 8);
+			out->checksum = frame[len - 4] + ((uint16_t)frame[len - 3] << 8);
+			if (out->length > 0) {
+				out->data = malloc(out->length);
+				if (out->data == NULL) {
+					// LCOV_EXCL_START
+					out->id = 0xAA;
+					return false;
+					// LCOV_EXCL_STOP
+				}
+				memcpy(out->data, &(frame[7]), out->length);
+			}
+			return true;
+		}
+
+		if (fs == FRAME_INVALID) {
+			out->id = 0xEE;
+			return false;
+		}
+		if (fs == FRAME_ERROR) {
+			out->id = 0xAA;
+			return false;
+		}
+
+		out->id = 0xFF;
+		if (*filled) { return false; }
+
+		errno = 0;
+		const ssize_t ti = ring_fill(ring, handle);
+		if (ti < 0 && errno != EAGAIN) {
+			fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
+			        handle);
+			fprintf(stderr, "read returned \"%s\" in readMessage\n", strerror(errno));
+			out->id = 0xAA;
+			return false;
+		}
+		if (ti == 0) { out->id = 0xFD; }
+		if (ti <= 0) { return false; }
+		*filled = true;
+	}
+}
+
+/*!
+ * Reads data from `handle` into `ring` when needed, and uses frame_next() to
+ * find the next message in the ring without moving data around.
+ *
+ * If a valid message is found then it is written to the structure provided as
+ * a parameter and the function returns true. If the message contains any
+ * data, out->data is allocated and must be freed by the caller.
+ *
+ * If a message cannot be read, the function returns false and `id` is set to
+ * an error value:
+ * - 0xFF means no message found yet, and more data is required
+ * - 0xFD is a synonym for 0xFF, but indicates that zero bytes were read from source.
+ * - 0xAA means that an error occurred reading in data
+ * - 0xEE means a message was found, but the checksum or end bytes were invalid
+ *
+ * Unlike lpms_readMessage_buf(), the message checksum is verified here.
+ *
+ * @param[in] handle File descriptor from lpms_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return True if out now contains a valid message, false otherwise.
+ */
+bool lpms_readMessage_ring(int handle, lpms_message *out, byte_ring *ring) {
+	bool filled = false;
+	return lpms_ring_next(handle, out, ring, &filled);
+}
+
+/*!
+ * Batch version of lpms_readMessage_ring(). Data is read from `handle` at
+ * most once, and all complete messages are then taken from the ring.
+ *
+ * The number of messages written to `out` is returned. If this is less than
+ * `max`, the `id` field of the following entry holds the reason the batch
+ * ended, using the values listed for lpms_readMessage_ring(). The data field
+ * of each returned message must be freed by the caller.
+ *
+ * @param[in] handle File descriptor from lpms_openConnection()
+ * @param[out] out Array of at least `max` message structures
+ * @param[in] max Maximum number of messages to return
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return Number of valid messages written to out
+ */
+size_t lpms_readMessage_batch(int handle, lpms_message *out, size_t max, byte_ring *ring) {
+	if (out == NULL) { return 0; }
+	bool filled = false;
+	size_t n = 0;
+	while (n < max && lpms_ring_next(handle, &(out[n]), ring, &filled)) {
+		n++;
+	}
+	return n;
+}
+
 /*!
  * Read messages from serial data and discard them until a message matching one
  * of the provided types is seen, or a timeout is reached.
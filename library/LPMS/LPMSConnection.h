@@ -41,12 +41,18 @@ int lpms_openConnection(const char *device, const int baud);
 //! Close LPMS serial connection
 void lpms_closeConnection(int handle);
 
-//! Static wrapper around lpms_readMessage_buf
+//! Static wrapper around lpms_readMessage_ring
 bool lpms_readMessage(int handle, lpms_message *out);
 
 //! Read data from handle, and parse message if able
 bool lpms_readMessage_buf(int handle, lpms_message *out, uint8_t buf[LPMS_BUFF], size_t *index, size_t *hw);
 
+//! Read data from handle into a ring buffer, and parse message if able
+bool lpms_readMessage_ring(int handle, lpms_message *out, byte_ring *ring);
+
+//! Read all buffered messages, reading from handle at most once
+size_t lpms_readMessage_batch(int handle, lpms_message *out, size_t max, byte_ring *ring);
+
 //! Read data from handle until first of specified message types is found
 bool lpms_find_messages(int handle, size_t numtypes, const uint8_t types[], int timeout, lpms_message *out,
                         uint8_t buf[LPMS_BUFF], size_t *index, size_t *hw);
@@ -43,12 +43,9 @@ bool lpms_from_bytes(const uint8_t *in, const size_t len, lpms_message *msg, siz
 	if (in == NULL || msg == NULL || len < 10 || pos == NULL) { return NULL; }
 
 	ssize_t start = -1;
-	while (((*pos) + 10) < len) {
-		if ((in[(*pos)] == LPMS_START)) {
-			start = (*pos);
-			break;
-		}
-		(*pos)++;
+	if (((*pos) + 10) < len) {
+		(*pos) += scan_byte(&(in[(*pos)]), len - 10 - (*pos), LPMS_START);
+		if (((*pos) + 10) < len) { start = (*pos); }
 	}
 
 	if (start < 0) {
@@ -0,0 +1,222 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <pthread.h>
+#include <string.h>
+
+#include "MPBlock.h"
+#include "MPTypes.h"
+
+//! CRC32C polynomial (reversed bit order)
+#define MP_CRC32C_POLY 0x82F63B78
+
+//! Lookup tables for slicing-by-8 CRC calculation
+static uint32_t mp_crc32c_table[8][256];
+
+//! Ensures lookup tables are only generated once
+static pthread_once_t mp_crc32c_once = PTHREAD_ONCE_INIT;
+
+/*!
+ * Generate CRC lookup tables. Called via pthread_once().
+ */
+static void mp_crc32c_init(void) {
+	for (int i = 0; i < 256; i++) {
+		uint32_t c = i;
+		for (int b = 0; b < 8; b++) {
+			c = (c & 1) ? (c >> 1) ^ MP_CRC32C_POLY : (c >> 1);
+		}
+		mp_crc32c_table[0][i] = c;
+	}
+	for (int i = 0; i < 256; i++) {
+		for (int t = 1; t < 8; t++) {
+			const uint32_t p = mp_crc32c_table[t - 1][i];
+			mp_crc32c_table[t][i] = (p >> 8) ^ mp_crc32c_table[0][p & 0xff];
+		}
+	}
+}
+
+/*!
+ * @param[in] p Data
+ * @return Little-endian 32 bit value read from p
+ */
+static inline uint32_t mp_get_le32(const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*!
+ * @param[out] p Output
+ * @param[in]  v Value to be written as little-endian 32 bit integer
+ */
+static inline void mp_put_le32(uint8_t *p, uint32_t v) {
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+/*!
+ * Uses a table driven implementation processing 8 bytes per iteration.
+ *
+ * To calculate the checksum of a single buffer, pass 0 as the initial CRC
+ * value. To continue a calculation, pass the result of the previous call.
+ *
+ * @param[in] crc  Initial CRC value
+ * @param[in] data Input data
+ * @param[in] len  Length of input data
+ * @return Updated CRC value
+ */
+uint32_t mp_crc32c(uint32_t crc, const uint8_t *data, size_t len) {
+	pthread_once(&mp_crc32c_once, mp_crc32c_init);
+	const uint32_t(*t)[256] = (const uint32_t(*)[256])mp_crc32c_table;
+	crc = ~crc;
+	while (len >= 8) {
+		const uint32_t lo = crc ^ mp_get_le32(data);
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+		      t[4][lo >> 24] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+		      t[0][data[7]];
+		data += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xff];
+		data++;
+		len--;
+	}
+	return ~crc;
+}
+
+/*!
+ * @param[out] bi    Block information
+ * @param[in]  clock Primary clock source ID
+ */
+void mp_block_init(mp_block_info *bi, uint8_t clock) {
+	if (bi == NULL) { return; }
+	memset(bi, 0, sizeof(mp_block_info));
+	bi->version = MP_BLOCK_VERSION;
+	bi->clock = clock;
+	bi->flags = MP_BLOCK_NOSTAMP;
+}
+
+/*!
+ * Clears the block contents, but retains the clock source and the primary
+ * timestamp at the end of the previous block, which becomes the timestamp at
+ * the start of this block.
+ *
+ * @param[in,out] bi Block information
+ */
+void mp_block_start(mp_block_info *bi) {
+	if (bi == NULL) { return; }
+	const uint8_t clock = bi->clock;
+	const uint8_t flags = bi->flags & MP_BLOCK_NOSTAMP;
+	const uint32_t stamp = bi->lastStamp;
+	memset(bi, 0, sizeof(mp_block_info));
+	bi->version = MP_BLOCK_VERSION;
+	bi->clock = clock;
+	bi->flags = flags;
+	bi->firstStamp = stamp;
+	bi->lastStamp = stamp;
+}
+
+/*!
+ * @param[in,out] bi     Block information
+ * @param[in]     msg    Message added to block
+ * @param[in]     packed Packed representation of msg
+ * @param[in]     len    Length of packed message
+ */
+void mp_block_add(mp_block_info *bi, const msg_t *msg, const uint8_t *packed, size_t len) {
+	if (bi == NULL || msg == NULL) { return; }
+	bi->count++;
+	bi->length += len;
+	bi->crc = mp_crc32c(bi->crc, packed, len);
+	if (msg->source < 128) { bi->sources[msg->source / 8] |= (1 << (msg->source % 8)); }
+	if (msg->source == bi->clock && msg->type == SLCHAN_TSTAMP &&
+	    msg->dtype == MSG_TIMESTAMP) {
+		if (bi->flags & MP_BLOCK_NOSTAMP) {
+			bi->firstStamp = msg->data.timestamp;
+			bi->flags &= ~MP_BLOCK_NOSTAMP;
+		}
+		bi->lastStamp = msg->data.timestamp;
+	}
+}
+
+/*!
+ * The output is always MP_BLOCK_HEADER_SIZE bytes long, so space can be
+ * reserved for the header before the block contents are known.
+ *
+ * @param[out] buf  Output buffer
+ * @param[in]  size Size of output buffer
+ * @param[in]  bi   Block information
+ * @return Bytes written (MP_BLOCK_HEADER_SIZE), or 0 if buffer too small
+ */
+size_t mp_block_pack(uint8_t *buf, size_t size, const mp_block_info *bi) {
+	if (buf == NULL || bi == NULL || size < MP_BLOCK_HEADER_SIZE) { return 0; }
+	buf[0] = MP_SYNC_BYTE1;
+	buf[1] = MP_SYNC_BYTE2;
+	buf[2] = SLSOURCE_LOCAL;
+	buf[3] = SLCHAN_BLOCK;
+	buf[4] = 0xc4; // bin 8
+	buf[5] = MP_BLOCK_INFO_SIZE;
+
+	uint8_t *p = &buf[6];
+	memset(p, 0, MP_BLOCK_INFO_SIZE);
+	p[0] = bi->version;
+	p[1] = bi->flags;
+	p[2] = bi->clock;
+	mp_put_le32(&p[4], bi->length);
+	mp_put_le32(&p[8], bi->crc);
+	mp_put_le32(&p[12], bi->count);
+	mp_put_le32(&p[16], bi->firstStamp);
+	mp_put_le32(&p[20], bi->lastStamp);
+	memcpy(&p[24], bi->sources, sizeof(bi->sources));
+	return MP_BLOCK_HEADER_SIZE;
+}
+
+/*!
+ * @param[in]  msg Message to be checked
+ * @param[out] bi  Block information, if msg is a valid block header
+ * @return True if msg was a block header of a supported version
+ */
+bool mp_block_parse(const msg_t *msg, mp_block_info *bi) {
+	if (msg == NULL || bi == NULL) { return false; }
+	if (msg->source != SLSOURCE_LOCAL || msg->type != SLCHAN_BLOCK) { return false; }
+	if (msg->dtype != MSG_BYTES || msg->length < MP_BLOCK_INFO_SIZE) { return false; }
+	const uint8_t *p = msg->data.bytes;
+	if (p[0] != MP_BLOCK_VERSION) { return false; }
+	bi->version = p[0];
+	bi->flags = p[1];
+	bi->clock = p[2];
+	bi->length = mp_get_le32(&p[4]);
+	bi->crc = mp_get_le32(&p[8]);
+	bi->count = mp_get_le32(&p[12]);
+	bi->firstStamp = mp_get_le32(&p[16]);
+	bi->lastStamp = mp_get_le32(&p[20]);
+	memcpy(bi->sources, &p[24], sizeof(bi->sources));
+	return true;
+}
+
+/*!
+ * @param[in] bi     Block information
+ * @param[in] source Source ID
+ * @return True if block contains at least one message from source
+ */
+bool mp_block_has_source(const mp_block_info *bi, uint8_t source) {
+	if (bi == NULL || source >= 128) { return false; }
+	return bi->sources[source / 8] & (1 << (source % 8));
+}
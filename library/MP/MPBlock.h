@@ -0,0 +1,116 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SELKIELoggerMP_Block
+#define SELKIELoggerMP_Block
+
+/*!
+ * @file MPBlock.h Block structured data file support
+ * @ingroup SELKIELoggerMP
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SELKIELoggerBase.h"
+
+/*!
+ * @addtogroup SELKIELoggerMP
+ * @{
+ */
+
+/*!
+ * @brief Block structured data files (version 2)
+ *
+ * Version 1 data files are a plain sequence of messages. In version 2 files,
+ * messages are grouped into blocks, each preceded by a block header.
+ *
+ * The block header is itself a valid message (source SLSOURCE_LOCAL, channel
+ * SLCHAN_BLOCK) containing MP_BLOCK_INFO_SIZE bytes of data, so software that
+ * only understands version 1 files can read version 2 files unchanged. The
+ * header data is encoded as follows, with all values little-endian:
+ *
+ * | Offset | Size | Contents                                          |
+ * |--------|------|---------------------------------------------------|
+ * | 0      | 1    | Format version (MP_BLOCK_VERSION)                 |
+ * | 1      | 1    | Flags (MP_BLOCK_NOSTAMP)                          |
+ * | 2      | 1    | Primary clock source ID                           |
+ * | 3      | 1    | Reserved (0)                                      |
+ * | 4      | 4    | Length of block data following header (bytes)     |
+ * | 8      | 4    | CRC32C of block data                              |
+ * | 12     | 4    | Number of messages in block                       |
+ * | 16     | 4    | Primary timestamp in effect at start of block     |
+ * | 20     | 4    | Primary timestamp in effect at end of block       |
+ * | 24     | 16   | Bitmap of source IDs present in block (bit n = ID n) |
+ *
+ * The primary timestamps are the values of the last SLCHAN_TSTAMP message
+ * seen from the primary clock source, so messages in a block were all
+ * received between the start and end timestamps.
+ */
+
+//! Block format version number
+#define MP_BLOCK_VERSION 2
+
+//! Size of encoded block information
+#define MP_BLOCK_INFO_SIZE 40
+
+//! Size of a complete block header message
+#define MP_BLOCK_HEADER_SIZE (MP_BLOCK_INFO_SIZE + 6)
+
+//! Block flag: No primary timestamp available for this block
+#define MP_BLOCK_NOSTAMP 0x01
+
+//! Block header information
+typedef struct {
+	uint8_t version;     //!< Format version
+	uint8_t flags;       //!< Block flags
+	uint8_t clock;       //!< Primary clock source ID
+	uint32_t length;     //!< Length of block data following header
+	uint32_t crc;        //!< CRC32C of block data
+	uint32_t count;      //!< Number of messages in block
+	uint32_t firstStamp; //!< Primary timestamp at start of block
+	uint32_t lastStamp;  //!< Primary timestamp at end of block
+	uint8_t sources[16]; //!< Bitmap of source IDs present in block
+} mp_block_info;
+
+//! Calculate or update a CRC32C (Castagnoli) checksum
+uint32_t mp_crc32c(uint32_t crc, const uint8_t *data, size_t len);
+
+//! Initialise block information for a new sequence of blocks
+void mp_block_init(mp_block_info *bi, uint8_t clock);
+
+//! Reset block information at the start of a new block
+void mp_block_start(mp_block_info *bi);
+
+//! Update block information with a message added to the block
+void mp_block_add(mp_block_info *bi, const msg_t *msg, const uint8_t *packed, size_t len);
+
+//! Pack block information into a block header message
+size_t mp_block_pack(uint8_t *buf, size_t size, const mp_block_info *bi);
+
+//! Extract block information from a block header message
+bool mp_block_parse(const msg_t *msg, mp_block_info *bi);
+
+//! Check whether a block contains messages from a source
+bool mp_block_has_source(const mp_block_info *bi, uint8_t source);
+//! @}
+#endif
@@ -0,0 +1,367 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MPIndex.h"
+
+//! Index file identifier
+static const char mp_index_magic[6] = "SLIDX";
+
+/*!
+ * @param[out] p Output
+ * @param[in]  v Value
+ * @param[in]  n Number of bytes to write, little-endian
+ */
+static void mp_index_put(uint8_t *p, uint64_t v, int n) {
+	for (int i = 0; i < n; i++) {
+		p[i] = (v >> (8 * i)) & 0xff;
+	}
+}
+
+/*!
+ * @param[in] p Input
+ * @param[in] n Number of bytes to read, little-endian
+ * @return Value read
+ */
+static uint64_t mp_index_get(const uint8_t *p, int n) {
+	uint64_t v = 0;
+	for (int i = n - 1; i >= 0; i--) {
+		v = (v << 8) | p[i];
+	}
+	return v;
+}
+
+/*!
+ * @param[in] handle File descriptor
+ * @param[in] buf    Data
+ * @param[in] len    Length of data
+ * @return True if all data written successfully
+ */
+static bool mp_index_write_all(int handle, const uint8_t *buf, size_t len) {
+	size_t done = 0;
+	while (done < len) {
+		ssize_t rv = write(handle, buf + done, len - done);
+		if (rv < 0) {
+			if (errno == EINTR) { continue; }
+			return false;
+		}
+		done += rv;
+	}
+	return true;
+}
+
+/*!
+ * @param[in] x Index writer
+ * @return True on success
+ */
+static bool mp_index_write_header(mp_index_writer *x) {
+	uint8_t hdr[MP_INDEX_HEADER_SIZE] = {0};
+	memcpy(hdr, mp_index_magic, sizeof(mp_index_magic));
+	hdr[6] = MP_INDEX_VERSION;
+	hdr[7] = x->clock;
+	mp_index_put(&hdr[8], x->interval, 4);
+	if (!mp_index_write_all(x->handle, hdr, sizeof(hdr))) {
+		x->error = true;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Write out entry for current span, if it contains any messages, and reset
+ * span counts.
+ *
+ * @param[in] x Index writer
+ * @return True on success
+ */
+static bool mp_index_write_span(mp_index_writer *x) {
+	if (x->total == 0) { return true; }
+	uint8_t buf[MP_INDEX_ENTRY_SIZE + 128 * MP_INDEX_SOURCE_SIZE] = {0};
+	size_t len = MP_INDEX_ENTRY_SIZE;
+	uint16_t nSources = 0;
+	for (int s = 0; s < 128; s++) {
+		if (x->counts[s] == 0) { continue; }
+		buf[len] = s;
+		mp_index_put(&buf[len + 4], x->counts[s], 4);
+		len += MP_INDEX_SOURCE_SIZE;
+		nSources++;
+	}
+	mp_index_put(&buf[0], x->spanOffset, 8);
+	mp_index_put(&buf[8], x->spanStamp, 4);
+	mp_index_put(&buf[12], x->spanEpoch, 4);
+	mp_index_put(&buf[16], x->total, 4);
+	mp_index_put(&buf[20], nSources, 2);
+	mp_index_put(&buf[22], x->spanFlags, 2);
+
+	x->total = 0;
+	memset(x->counts, 0, sizeof(x->counts));
+	if (!mp_index_write_all(x->handle, buf, len)) {
+		x->error = true;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * The file descriptor is not owned by the writer, and will not be closed by
+ * mp_index_writer_destroy().
+ *
+ * @param[out] x        Index writer
+ * @param[in]  handle   Output file descriptor
+ * @param[in]  clock    Primary clock source ID
+ * @param[in]  interval Number of primary timestamps per span. If zero, spans only start after epoch messages.
+ * @return True on success, false on error
+ */
+bool mp_index_writer_init(mp_index_writer *x, int handle, uint8_t clock, int interval) {
+	if (x == NULL || handle < 0 || interval < 0) { return false; }
+	*x = (mp_index_writer){0};
+	x->handle = handle;
+	x->clock = clock;
+	x->interval = interval;
+	x->flags = MP_INDEX_NOSTAMP | MP_INDEX_NOEPOCH;
+	x->spanFlags = x->flags;
+	return mp_index_write_header(x);
+}
+
+/*!
+ * Must be called for every message written to the data file, in order, with
+ * the offset at which the message (or any block header preceding it) will
+ * be written.
+ *
+ * @param[in] x      Index writer
+ * @param[in] msg    Message being written to data file
+ * @param[in] offset Data file offset
+ * @return True on success, false if an index entry could not be written
+ */
+bool mp_index_writer_add(mp_index_writer *x, const msg_t *msg, uint64_t offset) {
+	if (x == NULL || msg == NULL || x->handle < 0) { return false; }
+	if (msg->source == x->clock && msg->dtype == MSG_TIMESTAMP) {
+		if (msg->type == SLCHAN_TSTAMP) {
+			const bool due = (x->spanFlags & MP_INDEX_NOSTAMP) || x->epochSeen ||
+			                 (x->interval > 0 && ++x->ticks >= x->interval);
+			x->lastStamp = msg->data.timestamp;
+			x->flags &= ~MP_INDEX_NOSTAMP;
+			if (due) {
+				x->ticks = 0;
+				x->epochSeen = false;
+				if (!mp_index_write_span(x)) { return false; }
+			}
+		} else if (msg->type == MP_INDEX_EPOCH_CHANNEL) {
+			x->lastEpoch = msg->data.timestamp;
+			x->flags &= ~MP_INDEX_NOEPOCH;
+			x->epochSeen = true;
+		}
+	}
+
+	if (x->total == 0) {
+		x->spanOffset = offset;
+		x->spanStamp = x->lastStamp;
+		x->spanEpoch = x->lastEpoch;
+		x->spanFlags = x->flags;
+	}
+	x->total++;
+	if (msg->source < 128) { x->counts[msg->source]++; }
+	return true;
+}
+
+/*!
+ * The entry for the current span is written to the existing file, and a
+ * header written to the new file. The most recent timestamps are carried
+ * over to the first span in the new file. The previous file descriptor is
+ * not closed.
+ *
+ * @param[in] x      Index writer
+ * @param[in] handle New file descriptor
+ * @return True on success
+ */
+bool mp_index_writer_set_handle(mp_index_writer *x, int handle) {
+	if (x == NULL || handle < 0) { return false; }
+	bool rv = (x->handle < 0) || mp_index_write_span(x);
+	x->handle = handle;
+	x->ticks = 0;
+	x->epochSeen = false;
+	return mp_index_write_header(x) && rv;
+}
+
+/*!
+ * @param[in] x Index writer
+ * @return True if final entry written successfully
+ */
+bool mp_index_writer_destroy(mp_index_writer *x) {
+	if (x == NULL || x->handle < 0) { return false; }
+	const bool rv = mp_index_write_span(x);
+	x->handle = -1;
+	return rv;
+}
+
+/*!
+ * The complete index is read into memory. An incomplete final entry (e.g.
+ * if the index was copied while still being written) is ignored.
+ *
+ * @param[out] idx      Index
+ * @param[in]  fileName Path to index file
+ * @return True on success, false if the file could not be read or is not a valid index file
+ */
+bool mp_index_open(mp_index *idx, const char *fileName) {
+	if (idx == NULL || fileName == NULL) { return false; }
+	*idx = (mp_index){0};
+	FILE *f = fopen(fileName, "rb");
+	if (f == NULL) { return false; }
+
+	uint8_t hdr[MP_INDEX_HEADER_SIZE] = {0};
+	if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) ||
+	    memcmp(hdr, mp_index_magic, sizeof(mp_index_magic)) != 0 || hdr[6] != MP_INDEX_VERSION) {
+		fclose(f);
+		errno = EINVAL;
+		return false;
+	}
+	idx->clock = hdr[7];
+	idx->interval = mp_index_get(&hdr[8], 4);
+
+	size_t entCap = 0;
+	size_t srcCap = 0;
+	uint8_t eb[MP_INDEX_ENTRY_SIZE] = {0};
+	while (fread(eb, 1, sizeof(eb), f) == sizeof(eb)) {
+		mp_index_entry e = {0};
+		e.offset = mp_index_get(&eb[0], 8);
+		e.stamp = mp_index_get(&eb[8], 4);
+		e.epoch = mp_index_get(&eb[12], 4);
+		e.count = mp_index_get(&eb[16], 4);
+		e.nSources = mp_index_get(&eb[20], 2);
+		e.flags = mp_index_get(&eb[22], 2);
+		e.srcStart = idx->nSources;
+		if (e.nSources > 128) { break; }
+
+		if (idx->nSources + e.nSources > srcCap) {
+			const size_t ncap = (srcCap == 0) ? 1024 : 2 * srcCap;
+			mp_index_source *ns = realloc(idx->sources, ncap * sizeof(mp_index_source));
+			if (ns == NULL) {
+				// LCOV_EXCL_START
+				fclose(f);
+				mp_index_close(idx);
+				return false;
+				// LCOV_EXCL_STOP
+			}
+			idx->sources = ns;
+			srcCap = ncap;
+		}
+		bool complete = true;
+		for (size_t i = 0; i < e.nSources; i++) {
+			uint8_t sb[MP_INDEX_SOURCE_SIZE] = {0};
+			if (fread(sb, 1, sizeof(sb), f) != sizeof(sb)) {
+				complete = false;
+				break;
+			}
+			idx->sources[e.srcStart + i].source = sb[0];
+			idx->sources[e.srcStart + i].count = mp_index_get(&sb[4], 4);
+		}
+		if (!complete) { break; }
+
+		if (idx->nEntries == entCap) {
+			const size_t ncap = (entCap == 0) ? 256 : 2 * entCap;
+			mp_index_entry *ne = realloc(idx->entries, ncap * sizeof(mp_index_entry));
+			if (ne == NULL) {
+				// LCOV_EXCL_START
+				fclose(f);
+				mp_index_close(idx);
+				return false;
+				// LCOV_EXCL_STOP
+			}
+			idx->entries = ne;
+			entCap = ncap;
+		}
+		idx->entries[idx->nEntries++] = e;
+		idx->nSources += e.nSources;
+	}
+	fclose(f);
+	return true;
+}
+
+/*!
+ * @param[in] idx Index
+ */
+void mp_index_close(mp_index *idx) {
+	if (idx == NULL) { return; }
+	free(idx->entries);
+	free(idx->sources);
+	*idx = (mp_index){0};
+}
+
+/*!
+ * Entries are sorted by timestamp, so this is a binary search. If the
+ * timestamp is earlier than the first entry, the first entry is returned.
+ *
+ * @param[in] idx Index
+ * @param[in] ts  Primary clock timestamp
+ * @return Entry number, or -1 if index is empty
+ */
+ssize_t mp_index_find(const mp_index *idx, uint32_t ts) {
+	if (idx == NULL || idx->nEntries == 0) { return -1; }
+	size_t lo = 0;
+	size_t hi = idx->nEntries;
+	// Find first entry with stamp > ts
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (idx->entries[mid].stamp <= ts) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return (lo == 0) ? 0 : (ssize_t)(lo - 1);
+}
+
+/*!
+ * @param[in] idx    Index
+ * @param[in] entry  Entry number
+ * @param[in] source Source ID
+ * @return Number of messages from source in span
+ */
+uint32_t mp_index_count(const mp_index *idx, size_t entry, uint8_t source) {
+	if (idx == NULL || entry >= idx->nEntries) { return 0; }
+	const mp_index_entry *e = &idx->entries[entry];
+	for (size_t i = 0; i < e->nSources; i++) {
+		if (idx->sources[e->srcStart + i].source == source) {
+			return idx->sources[e->srcStart + i].count;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * Reading from the stream will then return messages starting with the
+ * primary timestamp at or before ts, so no messages at or after ts are
+ * missed.
+ *
+ * @param[in] idx Index for data file being read by stream
+ * @param[in] s   Stream
+ * @param[in] ts  Primary clock timestamp
+ * @return True on success, false if index is empty or seek failed
+ */
+bool mp_index_seek(const mp_index *idx, mp_stream *s, uint32_t ts) {
+	const ssize_t e = mp_index_find(idx, ts);
+	if (e < 0) { return false; }
+	return mp_stream_seek(s, idx->entries[e].offset);
+}
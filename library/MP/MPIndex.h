@@ -0,0 +1,177 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SELKIELoggerMP_Index
+#define SELKIELoggerMP_Index
+
+/*!
+ * @file MPIndex.h Time index files for data files
+ * @ingroup SELKIELoggerMP
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "SELKIELoggerBase.h"
+
+#include "MPStream.h"
+
+/*!
+ * @addtogroup SELKIELoggerMP
+ * @{
+ */
+
+/*!
+ * @brief Index files
+ *
+ * An index file (.idx) is written alongside each data file, dividing the
+ * data file into spans that each start with a timestamp message from the
+ * primary clock source. A new span starts at every Nth primary timestamp,
+ * and at the first primary timestamp following each epoch message from
+ * the same source.
+ *
+ * The file starts with a header of MP_INDEX_HEADER_SIZE bytes:
+ *
+ * | Offset | Size | Contents                                  |
+ * |--------|------|-------------------------------------------|
+ * | 0      | 6    | "SLIDX" (including terminating null)      |
+ * | 6      | 1    | Format version (MP_INDEX_VERSION)         |
+ * | 7      | 1    | Primary clock source ID                   |
+ * | 8      | 4    | Span interval (primary timestamps)        |
+ * | 12     | 4    | Reserved (0)                              |
+ *
+ * This is followed by one entry per span, each made up of MP_INDEX_ENTRY_SIZE
+ * bytes followed by an 8 byte (source ID, reserved[3], message count) record
+ * for each source with messages in that span:
+ *
+ * | Offset | Size | Contents                                        |
+ * |--------|------|-------------------------------------------------|
+ * | 0      | 8    | Offset of start of span in data file            |
+ * | 8      | 4    | Primary timestamp at start of span              |
+ * | 12     | 4    | Last epoch value received at start of span      |
+ * | 16     | 4    | Total number of messages in span                |
+ * | 20     | 2    | Number of source records following              |
+ * | 22     | 2    | Flags (MP_INDEX_NOSTAMP, MP_INDEX_NOEPOCH)      |
+ *
+ * All values are little-endian. Entries are written once each span is
+ * complete, so the final span is only recorded when the data file is closed.
+ */
+
+//! Index file format version
+#define MP_INDEX_VERSION 1
+
+//! Size of index file header
+#define MP_INDEX_HEADER_SIZE 16
+
+//! Size of fixed part of index entry
+#define MP_INDEX_ENTRY_SIZE 24
+
+//! Size of each per-source count record
+#define MP_INDEX_SOURCE_SIZE 8
+
+//! Default number of primary timestamps per span
+#define MP_INDEX_INTERVAL 100
+
+//! Channel used for epoch timestamps by the primary clock source
+#define MP_INDEX_EPOCH_CHANNEL 4
+
+//! Entry flag: No primary timestamp available at start of span
+#define MP_INDEX_NOSTAMP 0x01
+
+//! Entry flag: No epoch timestamp available at start of span
+#define MP_INDEX_NOEPOCH 0x02
+
+//! Index file writer
+typedef struct {
+	int handle;            //!< Output file descriptor (-1 if not open)
+	uint8_t clock;         //!< Primary clock source ID
+	int interval;          //!< Number of primary timestamps per span (0: epoch only)
+	int ticks;             //!< Primary timestamps since start of span
+	bool epochSeen;        //!< Epoch message received since start of span
+	uint64_t spanOffset;   //!< Data file offset at start of current span
+	uint32_t spanStamp;    //!< Primary timestamp at start of current span
+	uint32_t spanEpoch;    //!< Epoch value at start of current span
+	uint16_t spanFlags;    //!< Flags for current span
+	uint32_t lastStamp;    //!< Last primary timestamp received
+	uint32_t lastEpoch;    //!< Last epoch value received
+	uint16_t flags;        //!< MP_INDEX_NOSTAMP/NOEPOCH if no value received yet
+	uint32_t total;        //!< Messages in current span
+	uint32_t counts[128];  //!< Messages from each source in current span
+	bool error;            //!< Set if a write has failed
+} mp_index_writer;
+
+//! Index entry, as read from file
+typedef struct {
+	uint64_t offset;  //!< Offset of start of span in data file
+	uint32_t stamp;   //!< Primary timestamp at start of span
+	uint32_t epoch;   //!< Epoch value at start of span
+	uint32_t count;   //!< Number of messages in span
+	uint16_t flags;   //!< Entry flags
+	size_t srcStart;  //!< Index of first source record in mp_index.sources
+	size_t nSources;  //!< Number of source records
+} mp_index_entry;
+
+//! Per-source message count for an index entry
+typedef struct {
+	uint8_t source; //!< Source ID
+	uint32_t count; //!< Number of messages
+} mp_index_source;
+
+//! Index file contents
+typedef struct {
+	uint8_t clock;            //!< Primary clock source ID
+	int interval;             //!< Span interval used when writing index
+	size_t nEntries;          //!< Number of entries
+	mp_index_entry *entries;  //!< Entries, in file order
+	size_t nSources;          //!< Total number of source records
+	mp_index_source *sources; //!< Source records for all entries
+} mp_index;
+
+//! Initialise index writer and write file header
+bool mp_index_writer_init(mp_index_writer *x, int handle, uint8_t clock, int interval);
+
+//! Record a message about to be written at a given data file offset
+bool mp_index_writer_add(mp_index_writer *x, const msg_t *msg, uint64_t offset);
+
+//! Complete current index file, and start a new one
+bool mp_index_writer_set_handle(mp_index_writer *x, int handle);
+
+//! Write final index entry
+bool mp_index_writer_destroy(mp_index_writer *x);
+
+//! Read index file into memory
+bool mp_index_open(mp_index *idx, const char *fileName);
+
+//! Release index data
+void mp_index_close(mp_index *idx);
+
+//! Find last entry starting at or before timestamp
+ssize_t mp_index_find(const mp_index *idx, uint32_t ts);
+
+//! Number of messages from a source in a span
+uint32_t mp_index_count(const mp_index *idx, size_t entry, uint8_t source);
+
+//! Position stream at start of span containing timestamp
+bool mp_index_seek(const mp_index *idx, mp_stream *s, uint32_t ts);
+//! @}
+#endif
@@ -30,6 +30,7 @@
 #include <unistd.h>
 
 #include "MPSerial.h"
+#include "MPStream.h"
 #include "MPTypes.h"
 #include <msgpack.h>
 
@@ -54,23 +55,33 @@ void mp_closeConnection(int handle) {
 }
 
 /*!
- * For single threaded development and testing, uses static variables rather
- * than requiring state to be tracked by caller.
+ * For single threaded development and testing, uses a static mp_stream
+ * rather than requiring state to be tracked by caller. The stream is reset if
+ * a different handle is used.
  *
- * See mp_readMessage_buf() for full description.
+ * See mp_stream_read() for full description.
  *
  * @param[in] handle File descriptor from mp_openConnection()
  * @param[out] out Pointer to message structure to fill with data
  * @return True if out now contains a valid message, false otherwise.
  */
 bool mp_readMessage(int handle, msg_t *out) {
-	static uint8_t buf[MP_SERIAL_BUFF];
-	static int index = 0; // Current read position
-	static int hw = 0;    // Current array end
-	return mp_readMessage_buf(handle, out, buf, &index, &hw);
+	static mp_stream stream = {.handle = -1};
+	if (stream.buf == NULL || stream.handle != handle) {
+		mp_stream_destroy(&stream);
+		if (!mp_stream_init(&stream, handle, 0)) {
+			out->dtype = MSG_ERROR;
+			out->data.value = 0xAA;
+			return false;
+		}
+	}
+	return mp_stream_read(&stream, out);
 }
 
 /*!
+ * New code should use an mp_stream and mp_stream_read(), which avoid copying
+ * the buffer for each message.
+ *
  * This function maintains a message buffer (allocated by the caller), filling
  * it from the file handle provided. This handle can be anything supported by
  * read(), but would usually be a file or a serial port.
@@ -118,9 +129,9 @@ bool mp_readMessage_buf(int handle, msg_t *out, uint8_t buf[MP_SERIAL_BUFF], int
 		}
 	}
 
-	// Check buf[index] is valid ID
-	while (!(buf[(*index)] == MP_SYNC_BYTE1) && (*index) < (*hw)) {
-		(*index)++; // Current byte cannot be start of a message, so advance
+	// Advance to next possible sync byte
+	if ((*index) < (*hw)) {
+		(*index) += scan_byte(&(buf[(*index)]), (*hw) - (*index), MP_SYNC_BYTE1);
 	}
 	if ((*index) == (*hw)) {
 		if ((*hw) > 0 && (*index) > 0) {
@@ -331,45 +342,288 @@ bool mp_packMessage(msgpack_sbuffer *sbuf, const msg_t *out) {
 	msgpack_packer pack = {0};
 	msgpack_sbuffer_init(sbuf);
 	msgpack_packer_init(&pack, sbuf, msgpack_sbuffer_write);
-	msgpack_pack_array(&pack, 4); // MP_SYNC_BYTE1
-	msgpack_pack_int(&pack, MP_SYNC_BYTE2);
-	msgpack_pack_int(&pack, out->source);
-	msgpack_pack_int(&pack, out->type);
+	if (!mp_packMessage_packer(&pack, out)) {
+		msgpack_sbuffer_destroy(sbuf);
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Pack a message using an existing msgpack_packer, allowing messages to be
+ * packed directly into any buffer type supported by msgpack.
+ *
+ * On error, the message header may already have been passed to the packer
+ * and the caller should discard any output for this message.
+ *
+ * @param[in] pack Pointer to initialised msgpack_packer
+ * @param[in] out  Message to be packed
+ * @returns true on success, false on error
+ */
+bool mp_packMessage_packer(msgpack_packer *pack, const msg_t *out) {
+	switch (out->dtype) {
+		case MSG_FLOAT:
+		case MSG_TIMESTAMP:
+		case MSG_BYTES:
+		case MSG_STRING:
+		case MSG_STRARRAY:
+		case MSG_NUMARRAY:
+			break;
+		case MSG_ERROR:
+		case MSG_UNDEF:
+		default:
+			return false;
+	}
+
+	msgpack_pack_array(pack, 4); // MP_SYNC_BYTE1
+	msgpack_pack_int(pack, MP_SYNC_BYTE2);
+	msgpack_pack_int(pack, out->source);
+	msgpack_pack_int(pack, out->type);
 	size_t sl = 0;
 	switch (out->dtype) {
 		case MSG_FLOAT:
-			msgpack_pack_float(&pack, out->data.value);
+			msgpack_pack_float(pack, out->data.value);
 			break;
 
 		case MSG_TIMESTAMP:
-			msgpack_pack_uint32(&pack, out->data.timestamp);
+			msgpack_pack_uint32(pack, out->data.timestamp);
 			break;
 
 		case MSG_BYTES:
-			msgpack_pack_bin(&pack, out->length);
-			msgpack_pack_bin_body(&pack, out->data.bytes, out->length);
+			msgpack_pack_bin(pack, out->length);
+			msgpack_pack_bin_body(pack, out->data.bytes, out->length);
 			break;
 
 		case MSG_STRING:
 			sl = out->data.string.length;
 			if (strlen(out->data.string.data) < sl) { sl = strlen(out->data.string.data); }
-			msgpack_pack_str(&pack, sl);
-			msgpack_pack_str_body(&pack, out->data.string.data, sl);
+			msgpack_pack_str(pack, sl);
+			msgpack_pack_str_body(pack, out->data.string.data, sl);
 			break;
 
 		case MSG_STRARRAY:
-			mp_pack_strarray(&pack, &(out->data.names));
+			mp_pack_strarray(pack, &(out->data.names));
 			break;
 		case MSG_NUMARRAY:
-			mp_pack_numarray(&pack, out->length, out->data.farray);
+			mp_pack_numarray(pack, out->length, out->data.farray);
 			break;
+		default:
+			return false; // LCOV_EXCL_LINE
+	}
+	return true;
+}
+
+/*!
+ * @param[in] d Value to be packed
+ * @return Bytes required to pack d as a msgpack unsigned integer
+ */
+static inline size_t mp_uint_length(uint32_t d) {
+	if (d < 0x80) { return 1; }
+	if (d < 0x100) { return 2; }
+	if (d < 0x10000) { return 3; }
+	return 5;
+}
+
+/*!
+ * Array, string and binary headers share the same size thresholds, other
+ * than the larger range of the fixed length forms for arrays and strings.
+ *
+ * @param[in] len     Number of elements/bytes
+ * @param[in] fixMax  Maximum length for single byte form (0 if none)
+ * @param[in] has8    True if a 1 byte length form exists
+ * @return Bytes required for header
+ */
+static inline size_t mp_header_length(size_t len, size_t fixMax, bool has8) {
+	if (len < fixMax) { return 1; }
+	if (has8 && len < 0x100) { return 2; }
+	if (len < 0x10000) { return 3; }
+	return 5;
+}
+
+/*!
+ * @param[in] s String
+ * @return Number of bytes that will be packed for s
+ */
+static inline size_t mp_string_length(const string *s) {
+	size_t sl = s->length;
+	if (sl > 0 && strlen(s->data) < sl) { sl = strlen(s->data); }
+	return sl;
+}
+
+/*!
+ * Write tag byte followed by n byte big-endian value
+ *
+ * @param[in] p   Output position
+ * @param[in] tag msgpack type byte
+ * @param[in] v   Value
+ * @param[in] n   Number of value bytes (1, 2 or 4)
+ * @return Next output position
+ */
+static inline uint8_t *mp_put_be(uint8_t *p, uint8_t tag, uint32_t v, int n) {
+	*p++ = tag;
+	for (int i = n - 1; i >= 0; i--) {
+		*p++ = (v >> (8 * i)) & 0xFF;
+	}
+	return p;
+}
+
+//! Pack unsigned integer, using the smallest representation
+static inline uint8_t *mp_put_uint(uint8_t *p, uint32_t d) {
+	if (d < 0x80) {
+		*p++ = d;
+		return p;
+	}
+	if (d < 0x100) { return mp_put_be(p, 0xcc, d, 1); }
+	if (d < 0x10000) { return mp_put_be(p, 0xcd, d, 2); }
+	return mp_put_be(p, 0xce, d, 4);
+}
+
+//! Pack single precision float
+static inline uint8_t *mp_put_float(uint8_t *p, float f) {
+	uint32_t u = 0;
+	memcpy(&u, &f, sizeof(u));
+	return mp_put_be(p, 0xca, u, 4);
+}
+
+//! Pack array header
+static inline uint8_t *mp_put_array(uint8_t *p, uint32_t n) {
+	if (n < 16) {
+		*p++ = 0x90 | n;
+		return p;
+	}
+	if (n < 0x10000) { return mp_put_be(p, 0xdc, n, 2); }
+	return mp_put_be(p, 0xdd, n, 4);
+}
+
+//! Pack string header and body
+static inline uint8_t *mp_put_str(uint8_t *p, const char *str, uint32_t n) {
+	if (n < 32) {
+		*p++ = 0xa0 | n;
+	} else if (n < 0x100) {
+		p = mp_put_be(p, 0xd9, n, 1);
+	} else if (n < 0x10000) {
+		p = mp_put_be(p, 0xda, n, 2);
+	} else {
+		p = mp_put_be(p, 0xdb, n, 4);
+	}
+	if (n > 0) { memcpy(p, str, n); }
+	return p + n;
+}
+
+/*!
+ * Matches the output of mp_packMessage() exactly.
+ *
+ * @param[in] out Message to be packed
+ * @return Number of bytes required, or 0 if message cannot be packed
+ */
+size_t mp_packedLength(const msg_t *out) {
+	size_t len = 2 + mp_uint_length(out->source) + mp_uint_length(out->type);
+	size_t sl = 0;
+	switch (out->dtype) {
+		case MSG_FLOAT:
+			return len + 5;
+
+		case MSG_TIMESTAMP:
+			return len + mp_uint_length(out->data.timestamp);
+
+		case MSG_BYTES:
+			return len + mp_header_length(out->length, 0, true) + out->length;
+
+		case MSG_STRING:
+			sl = out->data.string.length;
+			if (strlen(out->data.string.data) < sl) { sl = strlen(out->data.string.data); }
+			return len + mp_header_length(sl, 32, true) + sl;
+
+		case MSG_STRARRAY:
+			len += mp_header_length(out->data.names.entries, 16, false);
+			for (int ix = 0; ix < out->data.names.entries; ix++) {
+				sl = mp_string_length(&(out->data.names.strings[ix]));
+				len += mp_header_length(sl, 32, true) + sl;
+			}
+			return len;
+
+		case MSG_NUMARRAY:
+			return len + mp_header_length(out->length, 16, false) + (5 * out->length);
+
 		case MSG_ERROR:
 		case MSG_UNDEF:
 		default:
-			msgpack_sbuffer_destroy(sbuf);
-			return false;
+			return 0;
 	}
-	return true;
+}
+
+/*!
+ * Specialised equivalent of mp_packMessage(), writing the fixed message
+ * header directly into the output buffer and avoiding any allocations.
+ * Output is byte-for-byte identical to mp_packMessage().
+ *
+ * Floats and timestamps are packed without checking the full message length
+ * if at least 16 bytes are available, as they can never exceed this.
+ *
+ * @param[out] buf  Output buffer
+ * @param[in]  size Space available in buf
+ * @param[in]  out  Message to be packed
+ * @return Number of bytes written, or 0 if the message is invalid or does not fit (use mp_packedLength() to check)
+ */
+size_t mp_packMessage_buffer(uint8_t *buf, size_t size, const msg_t *out) {
+	const bool small = (out->dtype == MSG_FLOAT || out->dtype == MSG_TIMESTAMP);
+	if (!small || size < 16) {
+		const size_t need = mp_packedLength(out);
+		if (need == 0 || need > size) { return 0; }
+	}
+
+	uint8_t *p = buf;
+	*p++ = MP_SYNC_BYTE1;
+	*p++ = MP_SYNC_BYTE2;
+	p = mp_put_uint(p, out->source);
+	p = mp_put_uint(p, out->type);
+	switch (out->dtype) {
+		case MSG_FLOAT:
+			p = mp_put_float(p, out->data.value);
+			break;
+
+		case MSG_TIMESTAMP:
+			p = mp_put_uint(p, out->data.timestamp);
+			break;
+
+		case MSG_BYTES:
+			if (out->length < 0x100) {
+				p = mp_put_be(p, 0xc4, out->length, 1);
+			} else if (out->length < 0x10000) {
+				p = mp_put_be(p, 0xc5, out->length, 2);
+			} else {
+				p = mp_put_be(p, 0xc6, out->length, 4);
+			}
+			if (out->length > 0) { memcpy(p, out->data.bytes, out->length); }
+			p += out->length;
+			break;
+
+		case MSG_STRING: {
+			size_t sl = out->data.string.length;
+			if (strlen(out->data.string.data) < sl) { sl = strlen(out->data.string.data); }
+			p = mp_put_str(p, out->data.string.data, sl);
+			break;
+		}
+
+		case MSG_STRARRAY:
+			p = mp_put_array(p, out->data.names.entries);
+			for (int ix = 0; ix < out->data.names.entries; ix++) {
+				const string *s = &(out->data.names.strings[ix]);
+				p = mp_put_str(p, s->data, mp_string_length(s));
+			}
+			break;
+
+		case MSG_NUMARRAY:
+			p = mp_put_array(p, out->length);
+			for (unsigned int ix = 0; ix < out->length; ix++) {
+				p = mp_put_float(p, out->data.farray[ix]);
+			}
+			break;
+
+		default:
+			return 0; // LCOV_EXCL_LINE
+	}
+	return p - buf;
 }
 
 /*!
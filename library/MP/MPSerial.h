@@ -55,6 +55,15 @@ bool mp_readMessage_buf(int handle, msg_t *out, uint8_t buf[MP_SERIAL_BUFF], int
 //! Pack a message into a buffer
 bool mp_packMessage(msgpack_sbuffer *sbuf, const msg_t *out);
 
+//! Pack a message using an existing packer
+bool mp_packMessage_packer(msgpack_packer *pack, const msg_t *out);
+
+//! Number of bytes required to pack a message
+size_t mp_packedLength(const msg_t *out);
+
+//! Pack a message directly into a caller provided buffer
+size_t mp_packMessage_buffer(uint8_t *buf, size_t size, const msg_t *out);
+
 //! Send message to attached device
 bool mp_writeMessage(int handle, const msg_t *out);
 
@@ -0,0 +1,634 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "MPBlock.h"
+#include "MPStream.h"
+#include "MPTypes.h"
+
+//! Maximum nesting depth accepted when skipping msgpack objects
+#define MP_STREAM_DEPTH 8
+
+/*!
+ * @param[in] p Data
+ * @param[in] n Number of bytes (1, 2, 4 or 8)
+ * @return Big-endian value read from p
+ */
+static inline uint64_t mp_get_be(const uint8_t *p, int n) {
+	uint64_t v = 0;
+	for (int i = 0; i < n; i++) {
+		v = (v << 8) | p[i];
+	}
+	return v;
+}
+
+/*!
+ * Find the total length of a msgpack object, without decoding it.
+ *
+ * @param[in]  p     Start of object
+ * @param[in]  len   Data available
+ * @param[out] olen  Length of object
+ * @param[in]  depth Current nesting depth
+ * @return MP_DECODE_OK, MP_DECODE_MORE if object is incomplete, or MP_DECODE_SKIP if invalid
+ */
+static mp_decode_status mp_object_length(const uint8_t *p, size_t len, size_t *olen, int depth) {
+	if (len < 1) { return MP_DECODE_MORE; }
+	if (depth > MP_STREAM_DEPTH) { return MP_DECODE_SKIP; }
+	const uint8_t t = p[0];
+	size_t head = 1;   // Header bytes
+	uint64_t body = 0; // Raw data bytes following header
+	uint64_t nObj = 0; // Child objects following header
+
+	if (t <= 0x7f || t >= 0xe0 || t == 0xc0 || t == 0xc2 || t == 0xc3) {
+		// Fixed integers, nil, booleans
+	} else if (t <= 0x8f) {
+		nObj = 2 * (t & 0x0f);
+	} else if (t <= 0x9f) {
+		nObj = t & 0x0f;
+	} else if (t <= 0xbf) {
+		body = t & 0x1f;
+	} else {
+		// Width of length field for variable types, or size of fixed types
+		int lw = 0;
+		switch (t) {
+			case 0xc4: // bin 8/16/32
+			case 0xc5:
+			case 0xc6:
+				lw = 1 << (t - 0xc4);
+				break;
+			case 0xc7: // ext 8/16/32
+			case 0xc8:
+			case 0xc9:
+				lw = 1 << (t - 0xc7);
+				head = 1; // Type byte, after length
+				body = 1;
+				break;
+			case 0xca:
+				head = 5;
+				break;
+			case 0xcb:
+				head = 9;
+				break;
+			case 0xcc: // Integers
+			case 0xcd:
+			case 0xce:
+			case 0xcf:
+				head = 1 + (1 << (t - 0xcc));
+				break;
+			case 0xd0:
+			case 0xd1:
+			case 0xd2:
+			case 0xd3:
+				head = 1 + (1 << (t - 0xd0));
+				break;
+			case 0xd4: // fixext 1/2/4/8/16
+			case 0xd5:
+			case 0xd6:
+			case 0xd7:
+			case 0xd8:
+				head = 2 + (1 << (t - 0xd4));
+				break;
+			case 0xd9: // str 8/16/32
+			case 0xda:
+			case 0xdb:
+				lw = 1 << (t - 0xd9);
+				break;
+			case 0xdc: // array 16/32
+			case 0xdd:
+				lw = 2 << (t - 0xdc);
+				break;
+			case 0xde: // map 16/32
+			case 0xdf:
+				lw = 2 << (t - 0xde);
+				break;
+			case 0xc1: // Never used
+			default:
+				return MP_DECODE_SKIP;
+		}
+		if (lw > 0) {
+			if (len < (size_t)(1 + lw)) { return MP_DECODE_MORE; }
+			const uint64_t n = mp_get_be(&p[1], lw);
+			head = 1 + lw;
+			if (t == 0xdc || t == 0xdd) {
+				nObj = n;
+			} else if (t == 0xde || t == 0xdf) {
+				nObj = 2 * n;
+			} else {
+				body += n;
+			}
+		}
+	}
+	if (body > MP_STREAM_MAX) { return MP_DECODE_SKIP; }
+	size_t total = head + body;
+	if (len < total) { return MP_DECODE_MORE; }
+
+	for (uint64_t i = 0; i < nObj; i++) {
+		size_t cl = 0;
+		mp_decode_status rs = mp_object_length(&p[total], len - total, &cl, depth + 1);
+		if (rs != MP_DECODE_OK) { return rs; }
+		total += cl;
+	}
+	*olen = total;
+	return MP_DECODE_OK;
+}
+
+/*!
+ * Decode a non-negative integer, consistent with msgpack-c treating
+ * non-negative signed values as positive integers.
+ *
+ * @param[in]  p Start of object
+ * @param[out] v Value
+ * @return True if object was a non-negative integer
+ */
+static bool mp_get_uint(const uint8_t *p, uint64_t *v) {
+	const uint8_t t = p[0];
+	if (t <= 0x7f) {
+		*v = t;
+		return true;
+	}
+	if (t >= 0xcc && t <= 0xcf) {
+		*v = mp_get_be(&p[1], 1 << (t - 0xcc));
+		return true;
+	}
+	if (t >= 0xd0 && t <= 0xd3) {
+		const int n = 1 << (t - 0xd0);
+		// Sign bit set
+		if (p[1] & 0x80) { return false; }
+		*v = mp_get_be(&p[1], n);
+		return true;
+	}
+	return false;
+}
+
+/*!
+ * @param[in] p Start of object
+ * @param[out] f Value
+ * @return True if object was a float32 or float64 value
+ */
+static bool mp_get_float(const uint8_t *p, float *f) {
+	if (p[0] == 0xca) {
+		const uint32_t u = mp_get_be(&p[1], 4);
+		memcpy(f, &u, sizeof(*f));
+		return true;
+	}
+	if (p[0] == 0xcb) {
+		const uint64_t u = mp_get_be(&p[1], 8);
+		double d = 0;
+		memcpy(&d, &u, sizeof(d));
+		*f = d;
+		return true;
+	}
+	return false;
+}
+
+/*!
+ * @param[in]  p     Start of object
+ * @param[out] data  Start of string data
+ * @param[out] len   Length of string data
+ * @return True if object was a string
+ */
+static bool mp_get_str(const uint8_t *p, const char **data, size_t *len) {
+	const uint8_t t = p[0];
+	int lw = 0;
+	if (t >= 0xa0 && t <= 0xbf) {
+		*len = t & 0x1f;
+	} else if (t >= 0xd9 && t <= 0xdb) {
+		lw = 1 << (t - 0xd9);
+		*len = mp_get_be(&p[1], lw);
+	} else {
+		return false;
+	}
+	*data = (const char *)&p[1 + lw];
+	return true;
+}
+
+/*!
+ * @param[in]  p     Start of object
+ * @param[out] n     Number of entries
+ * @return Length of array header, or 0 if object was not an array
+ */
+static size_t mp_get_array(const uint8_t *p, size_t *n) {
+	const uint8_t t = p[0];
+	if (t >= 0x90 && t <= 0x9f) {
+		*n = t & 0x0f;
+		return 1;
+	}
+	if (t == 0xdc || t == 0xdd) {
+		const int lw = 2 << (t - 0xdc);
+		*n = mp_get_be(&p[1], lw);
+		return 1 + lw;
+	}
+	return 0;
+}
+
+/*!
+ * Decode the data element of a message.
+ *
+ * The element has already been checked to be complete and structurally valid
+ * by mp_object_length().
+ *
+ * Binary and numeric array payloads are allocated with msg_alloc_data(), so
+ * small payloads are stored within the message and larger ones taken from the
+ * message pool if it is enabled.
+ *
+ * @param[in]  p   Start of object
+ * @param[in]  len Length of object
+ * @param[out] out Message
+ * @return True if data was valid for a message
+ */
+static bool mp_decode_data(const uint8_t *p, size_t len, msg_t *out) {
+	uint64_t u = 0;
+	const char *str = NULL;
+	size_t sl = 0;
+	size_t n = 0;
+
+	if (mp_get_float(p, &out->data.value)) {
+		out->dtype = MSG_FLOAT;
+		return true;
+	}
+
+	if (mp_get_uint(p, &u)) {
+		out->dtype = MSG_TIMESTAMP;
+		out->data.timestamp = u;
+		return true;
+	}
+
+	if (mp_get_str(p, &str, &sl)) {
+		out->dtype = MSG_STRING;
+		out->length = sl;
+		return str_update(&(out->data.string), sl, str);
+	}
+
+	if (p[0] >= 0xc4 && p[0] <= 0xc6) {
+		const int lw = 1 << (p[0] - 0xc4);
+		out->dtype = MSG_BYTES;
+		out->length = mp_get_be(&p[1], lw);
+		out->data.bytes = msg_alloc_data(out, out->length);
+		if (out->data.bytes == NULL) { return false; }
+		memcpy(out->data.bytes, &p[1 + lw], out->length);
+		return true;
+	}
+
+	size_t off = mp_get_array(p, &n);
+	if (off == 0 || n == 0) { return false; }
+
+	// Array type determined by first entry
+	if (mp_get_str(&p[off], &str, &sl)) {
+		strarray *sa = &(out->data.names);
+		out->dtype = MSG_STRARRAY;
+		sa_destroy(sa);
+		sa->strings = calloc(n, sizeof(string));
+		if (sa->strings == NULL) { return false; }
+		sa->entries = n;
+		for (size_t ix = 0; ix < n; ix++) {
+			size_t el = 0;
+			if (!mp_get_str(&p[off], &str, &sl) || !sa_create_entry(sa, ix, sl, str)) {
+				sa_destroy(sa);
+				return false;
+			}
+			mp_object_length(&p[off], len - off, &el, 0);
+			off += el;
+		}
+		return true;
+	}
+
+	float tmp = 0;
+	if (mp_get_float(&p[off], &tmp)) {
+		out->dtype = MSG_NUMARRAY;
+		out->data.farray = msg_alloc_data(out, n * sizeof(float));
+		if (out->data.farray == NULL) { return false; }
+		for (size_t ix = 0; ix < n; ix++) {
+			if (!mp_get_float(&p[off], &(out->data.farray[ix]))) {
+				msg_release_data(out, out->data.farray);
+				out->data.farray = NULL;
+				return false;
+			}
+			off += (p[off] == 0xca) ? 5 : 9;
+		}
+		out->length = n;
+		return true;
+	}
+	return false;
+}
+
+/*!
+ * Attempts to decode a message starting at the beginning of the buffer. No
+ * data is copied other than into the output message.
+ *
+ * If a complete message frame is found, used is set to its length, including
+ * when the message contents are invalid (MP_DECODE_INVALID), so the caller can
+ * skip over it. On MP_DECODE_SKIP, the caller should advance by at least one
+ * byte and try again.
+ *
+ * @param[in]  buf  Input data
+ * @param[in]  len  Length of input data
+ * @param[out] out  Message, valid if MP_DECODE_OK returned
+ * @param[out] used Number of bytes consumed
+ * @return Decoding status
+ */
+mp_decode_status mp_decodeMessage(const uint8_t *buf, size_t len, msg_t *out, size_t *used) {
+	if (len < 1) { return MP_DECODE_MORE; }
+	if (buf[0] != MP_SYNC_BYTE1) { return MP_DECODE_SKIP; }
+	if (len < 2) { return MP_DECODE_MORE; }
+	if (buf[1] != MP_SYNC_BYTE2) { return MP_DECODE_SKIP; }
+
+	size_t flen = 0;
+	mp_decode_status rs = mp_object_length(buf, len, &flen, 0);
+	if (rs != MP_DECODE_OK) { return rs; }
+
+	// Source and channel IDs must be integers in the range 0-127
+	uint64_t source = 0;
+	uint64_t type = 0;
+	size_t off = 2;
+	size_t el = 0;
+	if (!mp_get_uint(&buf[off], &source) || source >= 128) { return MP_DECODE_SKIP; }
+	mp_object_length(&buf[off], flen - off, &el, 0);
+	off += el;
+	if (!mp_get_uint(&buf[off], &type) || type >= 128) { return MP_DECODE_SKIP; }
+	mp_object_length(&buf[off], flen - off, &el, 0);
+	off += el;
+
+	out->source = source;
+	out->type = type;
+	*used = flen;
+	if (!mp_decode_data(&buf[off], flen - off, out)) {
+		out->dtype = MSG_ERROR;
+		out->data.value = 0xEE;
+		return MP_DECODE_INVALID;
+	}
+	return MP_DECODE_OK;
+}
+
+/*!
+ * @param[in] s        Stream to initialise
+ * @param[in] handle   Input file descriptor. Not closed by mp_stream_destroy().
+ * @param[in] capacity Initial buffer size. If zero, MP_STREAM_BUFF is used.
+ * @return True on success, false on error
+ */
+bool mp_stream_init(mp_stream *s, int handle, size_t capacity) {
+	if (s == NULL || handle < 0) { return false; }
+	if (capacity == 0) { capacity = MP_STREAM_BUFF; }
+	*s = (mp_stream){0};
+	s->buf = malloc(capacity);
+	if (s->buf == NULL) {
+		// LCOV_EXCL_START
+		perror("mp_stream_init");
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	s->handle = handle;
+	s->capacity = capacity;
+	return true;
+}
+
+/*!
+ * @param[in] s Stream
+ */
+void mp_stream_destroy(mp_stream *s) {
+	if (s == NULL) { return; }
+	free(s->buf);
+	*s = (mp_stream){0};
+	s->handle = -1;
+}
+
+/*!
+ * Read more data into the stream buffer, moving unprocessed data to the start
+ * of the buffer if required. The buffer is enlarged if it is full of data
+ * belonging to a single message.
+ *
+ * @param[in] s Stream
+ * @return Return value from read()
+ */
+static ssize_t mp_stream_fill(mp_stream *s) {
+	if (s->index > 0 && (s->hw == s->capacity || s->index >= (s->capacity / 2))) {
+		memmove(s->buf, &(s->buf[s->index]), s->hw - s->index);
+		s->hw -= s->index;
+		s->index = 0;
+	}
+	if (s->hw == s->capacity) {
+		size_t ncap = 2 * s->capacity;
+		if (ncap > MP_STREAM_MAX) { ncap = MP_STREAM_MAX; }
+		if (ncap > s->capacity) {
+			uint8_t *nbuf = realloc(s->buf, ncap);
+			if (nbuf == NULL) {
+				// LCOV_EXCL_START
+				errno = ENOMEM;
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			s->buf = nbuf;
+			s->capacity = ncap;
+		}
+	}
+
+	ssize_t ti = 0;
+	do {
+		errno = 0;
+		ti = read(s->handle, &(s->buf[s->hw]), s->capacity - s->hw);
+	} while (ti < 0 && errno == EINTR);
+	if (ti > 0) { s->hw += ti; }
+	return ti;
+}
+
+/*!
+ * Implementation of mp_stream_read() and mp_stream_read_batch().
+ *
+ * If `filled` is NULL, data is read from the stream handle until a message is
+ * found or no more data is available. Otherwise, data is only read while
+ * `*filled` is false, and `*filled` is set once a read has been attempted.
+ *
+ * @param[in]     s      Stream
+ * @param[out]    out    Pointer to message structure to fill with data
+ * @param[in,out] filled Limits reads from stream handle, or NULL
+ * @return True if out now contains a valid message, false otherwise.
+ */
+static bool mp_stream_next(mp_stream *s, msg_t *out, bool *filled) {
+	while (true) {
+		s->index += scan_pair(&(s->buf[s->index]), s->hw - s->index, MP_SYNC_BYTE1,
+		                      MP_SYNC_BYTE2);
+
+		while (s->index < s->hw) {
+			size_t used = 0;
+			const size_t avail = s->hw - s->index;
+			mp_decode_status rs = mp_decodeMessage(&(s->buf[s->index]), avail, out, &used);
+			if (rs == MP_DECODE_OK) {
+				s->index += used;
+				return true;
+			} else if (rs == MP_DECODE_INVALID) {
+				s->index += used;
+				return false;
+			} else if (rs == MP_DECODE_MORE && avail < MP_STREAM_MAX) {
+				break;
+			}
+			// Not a valid message, or an implausibly large one
+			s->index++;
+			s->index += scan_pair(&(s->buf[s->index]), s->hw - s->index, MP_SYNC_BYTE1,
+			                      MP_SYNC_BYTE2);
+		}
+
+		if (filled) {
+			if (*filled) {
+				out->dtype = MSG_ERROR;
+				out->data.value = 0xFF;
+				return false;
+			}
+			*filled = true;
+		}
+		const ssize_t ti = mp_stream_fill(s);
+		if (ti > 0) { continue; }
+
+		out->dtype = MSG_ERROR;
+		if (ti == 0) {
+			out->data.value = 0xFD;
+		} else if (errno == EAGAIN) {
+			out->data.value = 0xFF;
+		} else {
+			fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
+			        s->handle);
+			fprintf(stderr, "read returned \"%s\" in mp_stream_read\n", strerror(errno));
+			out->data.value = 0xAA;
+		}
+		return false;
+	}
+}
+
+/*!
+ * Equivalent to mp_readMessage_buf(), but messages are decoded directly from
+ * the stream buffer and more data is only read when no complete message is
+ * available.
+ *
+ * If a valid message is found then it is written to the structure provided as
+ * a parameter and the function returns true.
+ *
+ * If a message cannot be read, the function returns false and the float value
+ * field is set to an error value:
+ * - 0xFF means no message found yet, and more data is required
+ * - 0xFD is a synonym for 0xFF, but indicates that zero bytes were read from source.
+ *   This could indicate EOF if reading from file, but can be ignored when streaming from
+ *   a device.
+ * - 0xAA means that an error occurred reading in data
+ * - 0XEE means a valid message header was found, but no valid message
+ *
+ * @param[in]  s   Stream
+ * @param[out] out Pointer to message structure to fill with data
+ * @return True if out now contains a valid message, false otherwise.
+ */
+bool mp_stream_read(mp_stream *s, msg_t *out) {
+	if (s == NULL || s->buf == NULL || out == NULL) { return false; }
+	return mp_stream_next(s, out, NULL);
+}
+
+/*!
+ * Decodes all messages available in the stream buffer after reading from the
+ * stream handle at most once.
+ *
+ * Each entry in `out` must point to a message structure, so that a busy
+ * source can fill a set of preallocated messages and pass them to
+ * queue_push_batch() without further copying.
+ *
+ * The number of valid messages is returned. If this is less than `max`, the
+ * next message in `out` is set to MSG_ERROR with the reason the batch ended,
+ * using the values described for mp_stream_read().
+ *
+ * @param[in]  s   Stream
+ * @param[out] out Array of at least `max` pointers to message structures
+ * @param[in]  max Maximum number of messages to read
+ * @return Number of valid messages read
+ */
+size_t mp_stream_read_batch(mp_stream *s, msg_t **out, size_t max) {
+	if (s == NULL || s->buf == NULL || out == NULL) { return 0; }
+	bool filled = false;
+	size_t n = 0;
+	while (n < max && out[n] != NULL && mp_stream_next(s, out[n], &filled)) {
+		n++;
+	}
+	return n;
+}
+
+/*!
+ * Any buffered data is discarded.
+ *
+ * @param[in] s      Stream
+ * @param[in] offset New position, from start of file
+ * @return True on success, false if the source doesn't support seeking
+ */
+bool mp_stream_seek(mp_stream *s, off_t offset) {
+	if (s == NULL || s->buf == NULL || offset < 0) { return false; }
+	if (lseek(s->handle, offset, SEEK_SET) < 0) { return false; }
+	s->index = 0;
+	s->hw = 0;
+	return true;
+}
+
+/*!
+ * Used to skip over the contents of a block without decoding it. Buffered
+ * data is discarded first, then the file position is moved forward if
+ * possible. For sources that can't seek (e.g. pipes), data is read and
+ * discarded instead.
+ *
+ * @param[in] s   Stream
+ * @param[in] len Number of bytes to skip
+ * @return True if len bytes were skipped, false on error or end of file
+ */
+bool mp_stream_skip(mp_stream *s, size_t len) {
+	if (s == NULL || s->buf == NULL) { return false; }
+	size_t avail = s->hw - s->index;
+	if (len <= avail) {
+		s->index += len;
+		return true;
+	}
+	len -= avail;
+	s->index = 0;
+	s->hw = 0;
+	if (lseek(s->handle, len, SEEK_CUR) >= 0) { return true; }
+	while (len > 0) {
+		const ssize_t ti = mp_stream_fill(s);
+		if (ti <= 0) { return false; }
+		avail = (s->hw < len) ? s->hw : len;
+		len -= avail;
+		s->index = avail;
+	}
+	return true;
+}
+
+/*!
+ * Reads data into the stream buffer until the complete block is available,
+ * and compares its checksum to the value in the block header. The stream
+ * position is not changed, so the block contents can then be read with
+ * mp_stream_read() or skipped with mp_stream_skip().
+ *
+ * @param[in] s  Stream, positioned immediately after a block header
+ * @param[in] bi Block information from header
+ * @return True if the complete block was read and the checksum matches
+ */
+bool mp_stream_check_block(mp_stream *s, const mp_block_info *bi) {
+	if (s == NULL || s->buf == NULL || bi == NULL) { return false; }
+	if (bi->length > MP_STREAM_MAX) { return false; }
+	while ((s->hw - s->index) < bi->length) {
+		if (mp_stream_fill(s) <= 0) { return false; }
+	}
+	return mp_crc32c(0, &(s->buf[s->index]), bi->length) == bi->crc;
+}
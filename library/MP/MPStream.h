@@ -0,0 +1,97 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SELKIELoggerMP_Stream
+#define SELKIELoggerMP_Stream
+
+/*!
+ * @file MPStream.h Streaming message decoder
+ * @ingroup SELKIELoggerMP
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "SELKIELoggerBase.h"
+
+#include "MPBlock.h"
+
+/*!
+ * @addtogroup SELKIELoggerMP
+ * @{
+ */
+
+//! Default stream buffer size
+#define MP_STREAM_BUFF (64 * 1024)
+
+//! Largest single message accepted by a stream
+#define MP_STREAM_MAX (16 * 1024 * 1024)
+
+//! Result of attempting to decode a single message
+typedef enum {
+	MP_DECODE_OK = 0,  //!< Valid message decoded
+	MP_DECODE_MORE,    //!< Possible message, but more data required
+	MP_DECODE_SKIP,    //!< Not the start of a valid message
+	MP_DECODE_INVALID, //!< Complete message frame found, but contents invalid
+} mp_decode_status;
+
+/*!
+ * @brief Message stream reader
+ *
+ * Owns a buffer that is filled from a file descriptor, and decodes messages
+ * in place. Data is only moved within the buffer when space is required for
+ * more data.
+ */
+typedef struct {
+	int handle;      //!< Input file descriptor
+	uint8_t *buf;    //!< Input buffer
+	size_t capacity; //!< Size of input buffer
+	size_t index;    //!< Start of unprocessed data
+	size_t hw;       //!< End of valid data
+} mp_stream;
+
+//! Initialise a stream for an existing file descriptor
+bool mp_stream_init(mp_stream *s, int handle, size_t capacity);
+
+//! Release stream buffer
+void mp_stream_destroy(mp_stream *s);
+
+//! Read the next message from a stream
+bool mp_stream_read(mp_stream *s, msg_t *out);
+
+//! Read all buffered messages from a stream, reading from its handle at most once
+size_t mp_stream_read_batch(mp_stream *s, msg_t **out, size_t max);
+
+//! Move to a new position in a stream
+bool mp_stream_seek(mp_stream *s, off_t offset);
+
+//! Discard data from a stream
+bool mp_stream_skip(mp_stream *s, size_t len);
+
+//! Verify the contents of the next block in a stream
+bool mp_stream_check_block(mp_stream *s, const mp_block_info *bi);
+
+//! Decode a single message from a buffer
+mp_decode_status mp_decodeMessage(const uint8_t *buf, size_t len, msg_t *out, size_t *used);
+//! @}
+#endif
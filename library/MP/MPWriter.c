@@ -0,0 +1,928 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "MPSerial.h"
+#include "MPWriter.h"
+
+/*!
+ * @return Current CLOCK_MONOTONIC time in milliseconds
+ */
+static int64_t mp_writer_now(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*!
+ * Write len bytes from buf to handle, retrying on short writes and
+ * interruptions.
+ *
+ * @param[in] handle File descriptor
+ * @param[in] buf    Data to write
+ * @param[in] len    Number of bytes to write
+ * @return True if all data written, false on error
+ */
+static bool mp_writer_write_all(int handle, const uint8_t *buf, size_t len) {
+	size_t done = 0;
+	while (done < len) {
+		ssize_t ret = write(handle, buf + done, len - done);
+		if (ret < 0) {
+			if (errno == EINTR) { continue; }
+			return false;
+		}
+		done += ret;
+	}
+	return true;
+}
+
+/*!
+ * @return Current CLOCK_MONOTONIC time in milliseconds, with sub-millisecond precision
+ */
+static double mp_writer_now_precise(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double)ts.tv_sec * 1000.0) + ((double)ts.tv_nsec / 1.0E6);
+}
+
+/*!
+ * Takes the writer lock if the writer is asynchronous, as statistics may be
+ * read from other threads.
+ *
+ * @param[in] w       Writer
+ * @param[in] len     Bytes written
+ * @param[in] latency Time taken by write (ms)
+ * @param[in] lag     Time since oldest data in write was added to buffer (ms)
+ */
+static void mp_writer_record(mp_writer *w, size_t len, float latency, float lag) {
+	if (w->async) { pthread_mutex_lock(&w->lock); }
+	w->stats.flushes++;
+	w->stats.bytes += len;
+	if (latency > w->stats.maxLatency) { w->stats.maxLatency = latency; }
+	if (lag > w->stats.maxLag) { w->stats.maxLag = lag; }
+	if (w->async) { pthread_mutex_unlock(&w->lock); }
+}
+
+/*!
+ * Record the creation time of a message added to the active buffer.
+ *
+ * Messages without a creation time are ignored. If the list of stamps can't
+ * be enlarged, the message is silently left out of the latency statistics.
+ *
+ * @param[in] w   Writer
+ * @param[in] msg Message added to buffer
+ */
+static void mp_writer_stamp(mp_writer *w, const msg_t *msg) {
+	if (w->latency == NULL || msg->created == 0) { return; }
+	if (w->nStamps == w->stampCap) {
+		const size_t ncap = (w->stampCap == 0) ? 256 : w->stampCap * 2;
+		lat_stamp *ns = realloc(w->stamps, ncap * sizeof(lat_stamp));
+		if (ns == NULL) { return; } // LCOV_EXCL_LINE
+		w->stamps = ns;
+		w->stampCap = ncap;
+	}
+	w->stamps[w->nStamps++] = (lat_stamp){.created = msg->created, .source = msg->source};
+}
+
+/*!
+ * Record data written to file, so that it can be synced later.
+ *
+ * @param[in] w      Writer
+ * @param[in] handle File descriptor data was written to
+ * @param[in] len    Bytes written
+ * @param[in] end    Time write completed (ms, monotonic)
+ */
+static void mp_writer_written(mp_writer *w, int handle, size_t len, double end) {
+	if (w->syncMode == MP_SYNC_NONE) { return; }
+	if (w->async) { pthread_mutex_lock(&w->lock); }
+	if (w->unsyncedBytes == 0) { w->unsyncedSince = end; }
+	w->unsyncedBytes += len;
+	w->unsyncedHandle = handle;
+	if (w->async) { pthread_mutex_unlock(&w->lock); }
+}
+
+/*!
+ * @param[in] w Writer
+ * @return Time at which unsynced data should be synced (ms, monotonic), or -1 if no sync required
+ */
+static double mp_writer_sync_deadline(const mp_writer *w) {
+	if (w->unsyncedBytes == 0) { return -1; }
+	switch (w->syncMode) {
+		case MP_SYNC_INTERVAL:
+			return w->lastSync + w->syncInterval;
+		case MP_SYNC_BYTES:
+			return (w->unsyncedBytes >= w->syncBytes) ? 0 : -1;
+		case MP_SYNC_NONE:
+		default:
+			return -1;
+	}
+}
+
+/*!
+ * Sync all written data with fdatasync().
+ *
+ * Only called from the thread performing writes. The writer lock is only
+ * taken to update the sync state once complete, so statistics can still be
+ * read while a slow sync is in progress.
+ *
+ * File descriptors that don't support syncing (e.g. pipes) are silently
+ * ignored.
+ *
+ * @param[in] w Writer
+ * @return True on success, false on error (errno set)
+ */
+static bool mp_writer_datasync(mp_writer *w) {
+	if (w->unsyncedBytes == 0) { return true; }
+	const int handle = w->unsyncedHandle;
+	const double since = w->unsyncedSince;
+
+	const double start = mp_writer_now_precise();
+	int rv = fdatasync(handle);
+	const int err = errno;
+	const double end = mp_writer_now_precise();
+	if (rv != 0 && (err == EINVAL || err == EROFS)) { rv = 0; }
+
+	if (w->async) { pthread_mutex_lock(&w->lock); }
+	w->unsyncedBytes = 0;
+	w->lastSync = end;
+	if (rv == 0) {
+		w->stats.syncs++;
+		if ((end - start) > w->stats.maxSyncTime) { w->stats.maxSyncTime = end - start; }
+		if ((end - since) > w->stats.maxUnsynced) { w->stats.maxUnsynced = end - since; }
+	}
+	if (w->async) { pthread_mutex_unlock(&w->lock); }
+	if (rv != 0) {
+		errno = err;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Preallocate file space ahead of a write, in multiples of the extent size.
+ * Preallocated space doesn't change the apparent file size, and is released
+ * by mp_writer_trim().
+ *
+ * Only called from the thread performing writes, before w->filePos is
+ * updated for the write.
+ *
+ * @param[in] w      Writer
+ * @param[in] handle File descriptor about to be written to
+ * @param[in] extent Preallocation extent size
+ * @param[in] len    Size of upcoming write
+ * @return Extent size to use for future writes (0 if preallocation not supported by file)
+ */
+static size_t mp_writer_preallocate(mp_writer *w, int handle, size_t extent, size_t len) {
+	if (extent == 0) { return 0; }
+	const off_t end = w->filePos + len;
+	if (end <= w->allocEnd) { return extent; }
+	const off_t start = (w->allocEnd > w->filePos) ? w->allocEnd : w->filePos;
+	const off_t size = ((end - start + extent - 1) / extent) * extent;
+	if (fallocate(handle, FALLOC_FL_KEEP_SIZE, start, size) == 0) {
+		w->allocEnd = start + size;
+	} else if (errno == EOPNOTSUPP || errno == ENOSYS || errno == ESPIPE || errno == ENODEV) {
+		return 0;
+	}
+	// Other errors (e.g. ENOSPC) are left for write() to report if relevant
+	return extent;
+}
+
+/*!
+ * Release any unused preallocated space at the end of the current file.
+ *
+ * Only called from the thread performing writes, with no data buffered.
+ *
+ * @param[in] w Writer
+ */
+static void mp_writer_trim(mp_writer *w) {
+	if (w->allocEnd <= w->filePos) { return; }
+	const off_t pos = lseek(w->handle, 0, SEEK_CUR);
+	if (pos >= 0 && ftruncate(w->handle, pos) != 0) { perror("mp_writer_trim"); }
+	w->allocEnd = 0;
+}
+
+/*!
+ * Write the first len bytes of the buffer, and move any remaining data to
+ * the start of the buffer.
+ *
+ * @param[in] w   Writer
+ * @param[in] len Number of bytes to write
+ * @return True on success, false on error
+ */
+static bool mp_writer_write_prefix(mp_writer *w, size_t len) {
+	if (len == 0) { return true; }
+	// Complete header for block in buffer (len is always the full buffer)
+	if (w->blocks) { mp_block_pack(w->buf, w->capacity, &w->block); }
+	const double start = mp_writer_now_precise();
+	w->prealloc = mp_writer_preallocate(w, w->handle, w->prealloc, len);
+	if (!mp_writer_write_all(w->handle, w->buf, len)) {
+		w->error = true;
+		return false;
+	}
+	w->filePos += len;
+	const double end = mp_writer_now_precise();
+	if (w->latency) { lat_set_record_stamps(w->latency, w->stamps, w->nStamps, lat_now()); }
+	w->nStamps = 0;
+	mp_writer_record(w, len, end - start, end - w->firstData);
+	mp_writer_written(w, w->handle, len, end);
+	const double due = mp_writer_sync_deadline(w);
+	if (due >= 0 && due <= end && !mp_writer_datasync(w)) {
+		w->error = true;
+		return false;
+	}
+	if (w->used > len) { memmove(w->buf, w->buf + len, w->used - len); }
+	w->used -= len;
+	return true;
+}
+
+/*!
+ * Ensure there is space for len bytes in the output buffer.
+ *
+ * If the data doesn't fit, any messages already in the buffer are written out
+ * first. If a single message is larger than the buffer, the buffer is
+ * enlarged.
+ *
+ * @param[in] w   Writer
+ * @param[in] len Space required
+ * @return True on success, false on error
+ */
+static bool mp_writer_reserve(mp_writer *w, size_t len) {
+	if (w->used + len <= w->capacity) { return true; }
+	if (!mp_writer_write_prefix(w, w->used)) { return false; }
+	if (w->used + len <= w->capacity) { return true; }
+
+	size_t ncap = w->capacity;
+	while (ncap < w->used + len) {
+		ncap *= 2;
+	}
+	uint8_t *nbuf = aligned_alloc(MP_WRITER_ALIGN, ncap);
+	if (nbuf == NULL) {
+		// LCOV_EXCL_START
+		w->error = true;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	memcpy(nbuf, w->buf, w->used);
+	free(w->buf);
+	w->buf = nbuf;
+	w->capacity = ncap;
+	return true;
+}
+
+/*!
+ * Pack a message into the output buffer, updating the current block and any
+ * attached index. Data is written out if the buffer fills, or immediately if
+ * the flush interval is zero.
+ *
+ * Only called from the thread performing writes.
+ *
+ * @param[in] w   Writer
+ * @param[in] msg Message to be packed
+ * @return True on success, false on error
+ */
+static bool mp_writer_pack(mp_writer *w, const msg_t *msg) {
+	const uint64_t offset = atomic_load_explicit(&(w->handleBytes), memory_order_relaxed);
+
+	// Space for a block header is reserved before the first message in a block
+	size_t hdr = (w->blocks && w->used == 0) ? MP_BLOCK_HEADER_SIZE : 0;
+	size_t len = 0;
+	if (w->capacity > w->used + hdr) {
+		len = mp_packMessage_buffer(w->buf + w->used + hdr, w->capacity - w->used - hdr, msg);
+	}
+	if (len == 0) {
+		// Either invalid, or not enough space
+		const size_t need = mp_packedLength(msg);
+		if (need == 0) { return false; }
+		if (!mp_writer_reserve(w, need + (w->blocks ? MP_BLOCK_HEADER_SIZE : 0))) {
+			return false;
+		}
+		hdr = (w->blocks && w->used == 0) ? MP_BLOCK_HEADER_SIZE : 0;
+		len = mp_packMessage_buffer(w->buf + w->used + hdr, w->capacity - w->used - hdr, msg);
+	}
+	if (w->used == 0) { w->firstData = mp_writer_now(); }
+	if (w->blocks) {
+		if (hdr > 0) { mp_block_start(&w->block); }
+		mp_block_add(&w->block, msg, w->buf + w->used + hdr, len);
+	}
+	w->used += hdr + len;
+	atomic_fetch_add_explicit(&(w->handleBytes), hdr + len, memory_order_relaxed);
+	mp_writer_stamp(w, msg);
+	if (w->index && !mp_index_writer_add(w->index, msg, offset)) {
+		w->error = true;
+		return false;
+	}
+	if (w->interval <= 0) { return mp_writer_write_prefix(w, w->used); }
+	return true;
+}
+
+/*!
+ * Carry out any data sync that has become due, then write out buffered data
+ * if it has been held for longer than the flush interval.
+ *
+ * Only called from the thread performing writes.
+ *
+ * @param[in] w Writer
+ * @return False if a sync or write was required and failed, true otherwise
+ */
+static bool mp_writer_service(mp_writer *w) {
+	const double due = mp_writer_sync_deadline(w);
+	if (due >= 0 && due <= mp_writer_now_precise() && !mp_writer_datasync(w)) {
+		w->error = true;
+		return false;
+	}
+	if (w->used == 0) { return true; }
+	if ((mp_writer_now() - w->firstData) < w->interval) { return true; }
+	return mp_writer_write_prefix(w, w->used);
+}
+
+/*!
+ * @param[in] w Writer
+ * @return Milliseconds until mp_writer_service() has work to do, 0 if overdue, or -1 if nothing pending
+ */
+static int mp_writer_due(const mp_writer *w) {
+	int64_t remaining = -1;
+	if (w->used > 0) {
+		remaining = (w->firstData + w->interval) - mp_writer_now();
+		if (remaining < 0) { remaining = 0; }
+	}
+	const double due = mp_writer_sync_deadline(w);
+	if (due >= 0) {
+		int64_t syncRemaining = due - mp_writer_now_precise();
+		if (syncRemaining < 0) { syncRemaining = 0; }
+		if (remaining < 0 || syncRemaining < remaining) { remaining = syncRemaining; }
+	}
+	return (int)remaining;
+}
+
+/*!
+ * For asynchronous writers, check whether the writer thread has recorded an
+ * error. Always false for synchronous writers.
+ *
+ * @param[in] w Writer
+ * @return True if an earlier asynchronous write has failed (errno set)
+ */
+static bool mp_writer_failed(const mp_writer *w) {
+	const int err = atomic_load(&(w->asyncErrno));
+	if (err == 0) { return false; }
+	errno = err;
+	return true;
+}
+
+/*!
+ * Write out all buffered data and, unless the durability mode is
+ * MP_SYNC_NONE, sync it to storage.
+ *
+ * Only called from the thread performing writes, or while the writer thread
+ * is paused.
+ *
+ * @param[in] w Writer
+ * @return True on success, false on error
+ */
+static bool mp_writer_drain(mp_writer *w) {
+	if (mp_writer_failed(w)) {
+		w->error = true;
+		return false;
+	}
+	if (!mp_writer_write_prefix(w, w->used)) { return false; }
+	if (w->syncMode == MP_SYNC_NONE) { return true; }
+	if (mp_writer_datasync(w)) { return true; }
+	w->error = true;
+	return false;
+}
+
+/*!
+ * Wait for the writer thread to pack all queued messages and stop, so that
+ * the calling thread can safely operate on the writer state directly.
+ *
+ * As only a single thread may add messages, nothing more will be queued until
+ * mp_writer_resume() is called. Does nothing for synchronous writers.
+ *
+ * @param[in] w Writer
+ */
+static void mp_writer_pause(mp_writer *w) {
+	if (!w->async) { return; }
+	pthread_mutex_lock(&w->lock);
+	w->pause = true;
+	pthread_mutex_unlock(&w->lock);
+	queue_wake(&w->queue);
+	pthread_mutex_lock(&w->lock);
+	while (!w->paused) {
+		pthread_cond_wait(&w->cond, &w->lock);
+	}
+	pthread_mutex_unlock(&w->lock);
+}
+
+/*!
+ * Allow a writer thread stopped by mp_writer_pause() to continue.
+ *
+ * @param[in] w Writer
+ */
+static void mp_writer_resume(mp_writer *w) {
+	if (!w->async) { return; }
+	pthread_mutex_lock(&w->lock);
+	w->pause = false;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+}
+
+/*!
+ * Writer thread for asynchronous writers.
+ *
+ * Messages are taken from the writer queue in batches and packed into the
+ * output buffer, which is written out as for a synchronous writer. Each
+ * message reference is released once packed.
+ *
+ * While the queue is empty, the thread waits for the next message or until
+ * buffered data is due to be written or synced. It also stops here on request
+ * (see mp_writer_pause()) and exits once the writer is stopped.
+ *
+ * If packing or writing fails, the error is recorded and any further queued
+ * messages are discarded, so that the adding thread can't block forever
+ * waiting for space in the queue.
+ *
+ * @param[in] ptr Pointer to mp_writer
+ * @return NULL
+ */
+static void *mp_writer_thread(void *ptr) {
+	mp_writer *w = ptr;
+	msg_t *batch[MP_WRITER_BATCH];
+	while (true) {
+		bool ok = !mp_writer_failed(w);
+		const size_t n = queue_pop_batch(&w->queue, batch, MP_WRITER_BATCH);
+		for (size_t i = 0; i < n; i++) {
+			if (ok && !mp_writer_pack(w, batch[i])) {
+				atomic_store(&(w->asyncErrno), (errno == 0) ? EIO : errno);
+				ok = false;
+			}
+			msg_free(batch[i]);
+		}
+		if (n == 0) {
+			pthread_mutex_lock(&w->lock);
+			if (w->pause) {
+				w->paused = true;
+				pthread_cond_broadcast(&w->cond);
+				while (w->pause) {
+					pthread_cond_wait(&w->cond, &w->lock);
+				}
+				w->paused = false;
+				pthread_mutex_unlock(&w->lock);
+				continue;
+			}
+			const bool stop = w->stop;
+			pthread_mutex_unlock(&w->lock);
+			if (stop) { break; }
+		}
+
+		// Checked after every batch, so data is still written on time
+		// while messages arrive continuously
+		if (ok && !mp_writer_service(w)) {
+			atomic_store(&(w->asyncErrno), (errno == 0) ? EIO : errno);
+			ok = false;
+		}
+		if (n == 0) { queue_wait(&w->queue, ok ? mp_writer_due(w) : -1); }
+	}
+	return NULL;
+}
+
+/*!
+ * The file descriptor is not owned by the writer, and will not be closed by
+ * mp_writer_destroy().
+ *
+ * @param[in] w        Writer to initialise
+ * @param[in] handle   Output file descriptor
+ * @param[in] capacity Buffer size in bytes, rounded up to a multiple of MP_WRITER_ALIGN. If zero, MP_WRITER_BUFF is used.
+ * @param[in] interval Maximum time to hold data before writing (milliseconds). If zero or negative, every message is written immediately.
+ * @return True on success, false on error
+ */
+bool mp_writer_init(mp_writer *w, int handle, size_t capacity, int interval) {
+	if (w == NULL || handle < 0) { return false; }
+	if (capacity == 0) { capacity = MP_WRITER_BUFF; }
+	capacity = ((capacity + MP_WRITER_ALIGN - 1) / MP_WRITER_ALIGN) * MP_WRITER_ALIGN;
+
+	*w = (mp_writer){0};
+	w->buf = aligned_alloc(MP_WRITER_ALIGN, capacity);
+	if (w->buf == NULL) {
+		// LCOV_EXCL_START
+		perror("mp_writer_init");
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	w->handle = handle;
+	w->capacity = capacity;
+	w->interval = interval;
+	w->unsyncedHandle = -1;
+	w->lastSync = mp_writer_now_precise();
+	w->filePos = lseek(handle, 0, SEEK_CUR);
+	if (w->filePos < 0) { w->filePos = 0; }
+	return true;
+}
+
+/*!
+ * As mp_writer_init(), but messages are packed and written by a dedicated
+ * thread. mp_writer_add() takes a reference to each message and places it in
+ * a queue of (at least) queueLen entries, so the calling thread does no
+ * encoding or I/O and only blocks if the queue is full.
+ *
+ * Write errors are reported by the next call to mp_writer_add(),
+ * mp_writer_tick() or mp_writer_sync().
+ *
+ * @param[in] w        Writer to initialise
+ * @param[in] handle   Output file descriptor
+ * @param[in] capacity Buffer size in bytes, as for mp_writer_init()
+ * @param[in] interval Maximum time to hold data before writing (milliseconds)
+ * @param[in] queueLen Number of messages that can be waiting for the writer thread. Must be at least 2.
+ * @return True on success, false on error
+ */
+bool mp_writer_init_async(mp_writer *w, int handle, size_t capacity, int interval, size_t queueLen) {
+	if (queueLen < 2) { return false; }
+	if (!mp_writer_init(w, handle, capacity, interval)) { return false; }
+	if (!queue_init_size(&w->queue, queueLen)) {
+		// LCOV_EXCL_START
+		perror("mp_writer_init_async");
+		mp_writer_destroy(w);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->cond, NULL);
+	w->async = true;
+	if (pthread_create(&w->thread, NULL, &mp_writer_thread, w) != 0) {
+		// LCOV_EXCL_START
+		perror("mp_writer_init_async");
+		w->async = false;
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->lock);
+		queue_destroy(&w->queue);
+		mp_writer_destroy(w);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	return true;
+}
+
+/*!
+ * Any buffered data is written out before the buffer is released. For
+ * asynchronous writers, all queued messages are written and the writer
+ * thread is stopped first. Any unused preallocated space is released, but
+ * the file descriptor is left open.
+ *
+ * @param[in] w Writer
+ * @return True if all buffered data was written successfully
+ */
+bool mp_writer_destroy(mp_writer *w) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	bool rv = mp_writer_sync(w);
+	if (w->async) {
+		pthread_mutex_lock(&w->lock);
+		w->stop = true;
+		pthread_mutex_unlock(&w->lock);
+		queue_wake(&w->queue);
+		pthread_join(w->thread, NULL);
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->lock);
+		queue_destroy(&w->queue);
+		w->async = false;
+	}
+	mp_writer_trim(w);
+	free(w->buf);
+	w->buf = NULL;
+	w->capacity = 0;
+	w->used = 0;
+	w->handle = -1;
+	free(w->stamps);
+	w->stamps = NULL;
+	w->nStamps = 0;
+	w->stampCap = 0;
+	w->latency = NULL;
+	w->index = NULL;
+	return rv;
+}
+
+/*!
+ * For synchronous writers, the message is packed directly into the output
+ * buffer. Data is written out if the buffer fills, or immediately if the
+ * flush interval is zero.
+ *
+ * Asynchronous writers instead take a reference to the message (see
+ * msg_retain()) and queue it for the writer thread, so the caller can
+ * continue to use and free the message as normal. The message must not be
+ * modified afterwards. Invalid messages are rejected here, but write errors
+ * are only reported by later calls.
+ *
+ * @param[in] w   Writer
+ * @param[in] msg Message to be packed
+ * @return True on success, false on error
+ */
+bool mp_writer_add(mp_writer *w, msg_t *msg) {
+	if (w == NULL || w->buf == NULL || msg == NULL) { return false; }
+	if (!w->async) {
+		w->error = false;
+		return mp_writer_pack(w, msg);
+	}
+	if (mp_writer_failed(w)) { return false; }
+	if (msg->dtype <= MSG_UNDEF || msg->dtype > MSG_NUMARRAY) { return false; }
+
+	msg_retain(msg);
+	if (queue_try_push(&w->queue, msg)) { return true; }
+	pthread_mutex_lock(&w->lock);
+	w->stats.stalls++;
+	pthread_mutex_unlock(&w->lock);
+	if (queue_push(&w->queue, msg)) { return true; }
+	// LCOV_EXCL_START
+	msg_free(msg);
+	return false;
+	// LCOV_EXCL_STOP
+}
+
+/*!
+ * For asynchronous writers, this first waits for all queued messages to be
+ * packed.
+ *
+ * @param[in] w Writer
+ * @return True if all buffered data written successfully
+ */
+bool mp_writer_flush(mp_writer *w) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	bool ok = false;
+	if (mp_writer_failed(w)) {
+		w->error = true;
+	} else {
+		ok = mp_writer_write_prefix(w, w->used);
+	}
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * Should be called regularly, e.g. from the main loop of the thread that owns
+ * the writer.
+ *
+ * Asynchronous writers flush and sync data from the writer thread, so this
+ * only reports any error recorded by that thread.
+ *
+ * @param[in] w Writer
+ * @return False if a flush was required and failed, true otherwise
+ */
+bool mp_writer_tick(mp_writer *w) {
+	if (w == NULL || w->buf == NULL) { return true; }
+	if (w->async) { return !mp_writer_failed(w); }
+	return mp_writer_service(w);
+}
+
+/*!
+ * Suitable for use as a timeout while waiting for more messages.
+ *
+ * This also includes time until any pending data sync is due. Asynchronous
+ * writers don't rely on mp_writer_tick() being called, so always return -1.
+ *
+ * @param[in] w Writer
+ * @return Milliseconds until mp_writer_tick() will flush data, 0 if overdue, or -1 if no data buffered
+ */
+int mp_writer_next_flush(const mp_writer *w) {
+	if (w == NULL || w->buf == NULL || w->async) { return -1; }
+	return mp_writer_due(w);
+}
+
+/*!
+ * Asynchronous writers first pack all queued messages, then all buffered data
+ * is written out from the calling thread.
+ *
+ * Unless the durability mode is MP_SYNC_NONE, written data is also synced
+ * to storage.
+ *
+ * @param[in] w Writer
+ * @return True if all data has been written successfully
+ */
+bool mp_writer_sync(mp_writer *w) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	const bool ok = mp_writer_drain(w);
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * The durability mode can be changed at any time.
+ *
+ * @param[in] w        Writer
+ * @param[in] mode     Durability mode
+ * @param[in] interval Minimum time between syncs in MP_SYNC_INTERVAL mode (ms)
+ * @param[in] bytes    Unsynced data threshold in MP_SYNC_BYTES mode
+ * @return True on success, false if parameters invalid
+ */
+bool mp_writer_set_sync(mp_writer *w, mp_sync_mode mode, int interval, size_t bytes) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	if (mode == MP_SYNC_INTERVAL && interval < 0) { return false; }
+	if (mode == MP_SYNC_BYTES && bytes == 0) { return false; }
+	if (mode != MP_SYNC_NONE && mode != MP_SYNC_INTERVAL && mode != MP_SYNC_BYTES) {
+		return false;
+	}
+	// Writer thread recalculates its sync deadline on resuming
+	mp_writer_pause(w);
+	w->syncMode = mode;
+	w->syncInterval = interval;
+	w->syncBytes = bytes;
+	mp_writer_resume(w);
+	return true;
+}
+
+/*!
+ * Data still held in the output buffer has not yet been written, and will
+ * not be included. Use mp_writer_sync() to write and sync all buffered data.
+ *
+ * @param[in] w Writer
+ * @return True on success, false on error
+ */
+bool mp_writer_commit(mp_writer *w) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	const bool ok = mp_writer_datasync(w);
+	if (!ok) { w->error = true; }
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * Used when rotating output files. All buffered data is written to the
+ * current file before switching, so no messages are split across files.
+ *
+ * For asynchronous writers, all queued messages are written first, so the
+ * previous file descriptor can be closed safely once this returns. Unused
+ * preallocated space is released from the previous file, but the previous
+ * file descriptor is not closed.
+ *
+ * Any attached index is left idle once this returns (until the next message
+ * is added), so it can be switched to a new file at the same time.
+ *
+ * @param[in] w      Writer
+ * @param[in] handle New file descriptor
+ * @return True on success, false if buffered data could not be written (handle not changed)
+ */
+bool mp_writer_set_handle(mp_writer *w, int handle) {
+	if (w == NULL || w->buf == NULL || handle < 0) { return false; }
+	mp_writer_pause(w);
+	const bool ok = mp_writer_drain(w);
+	if (ok) {
+		mp_writer_trim(w);
+		w->handle = handle;
+		atomic_store(&(w->handleBytes), 0);
+		w->filePos = lseek(handle, 0, SEEK_CUR);
+		if (w->filePos < 0) { w->filePos = 0; }
+	}
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * File space is reserved in blocks of this size ahead of the data being
+ * written, reducing fragmentation on slow storage. Unused space is released
+ * when the file descriptor is changed or the writer is destroyed.
+ *
+ * Preallocation is disabled automatically if not supported by the file.
+ *
+ * @param[in] w      Writer
+ * @param[in] extent Preallocation size in bytes, or 0 to disable
+ * @return True on success
+ */
+bool mp_writer_set_prealloc(mp_writer *w, size_t extent) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	w->prealloc = extent;
+	mp_writer_resume(w);
+	return true;
+}
+
+/*!
+ * Messages are grouped into blocks, with one block per write. Each block is
+ * preceded by a header message describing its contents (see MPBlock.h).
+ *
+ * Any data already buffered is written out first, and is not included in a
+ * block.
+ *
+ * @param[in] w      Writer
+ * @param[in] enable True to write block structured (version 2) output
+ * @param[in] clock  Primary clock source ID, used for block timestamps
+ * @return True on success, false if buffered data could not be written
+ */
+bool mp_writer_set_blocks(mp_writer *w, bool enable, uint8_t clock) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	const bool ok = !mp_writer_failed(w) && mp_writer_write_prefix(w, w->used);
+	if (ok) {
+		w->blocks = enable;
+		mp_block_init(&w->block, clock);
+	}
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * For each message with a creation time (see lat_stamp_enable()), the time
+ * between creation and completion of the write containing the message is
+ * recorded in the histogram for the message source.
+ *
+ * Any data already buffered is written out first. The set must remain valid
+ * until latency recording is disabled or the writer is destroyed.
+ *
+ * @param[in] w   Writer
+ * @param[in] set Histograms to update, or NULL to disable
+ * @return True on success, false if buffered data could not be written
+ */
+bool mp_writer_set_latency(mp_writer *w, lat_set *set) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	const bool ok = !mp_writer_failed(w) && mp_writer_write_prefix(w, w->used);
+	if (ok) { w->latency = set; }
+	mp_writer_resume(w);
+	return ok;
+}
+
+/*!
+ * Each message is passed to mp_index_writer_add() as it is packed, along with
+ * the file offset of the message (or of the block header preceding it). For
+ * asynchronous writers this keeps index updates on the writer thread.
+ *
+ * The index writer must remain valid until detached or the writer is
+ * destroyed. While attached, it should only be used directly after
+ * mp_writer_sync() or mp_writer_set_handle() and before the next message is
+ * added, e.g. to switch the index to a new file when rotating.
+ *
+ * @param[in] w     Writer
+ * @param[in] index Index writer to update, or NULL to detach
+ * @return True on success
+ */
+bool mp_writer_set_index(mp_writer *w, mp_index_writer *index) {
+	if (w == NULL || w->buf == NULL) { return false; }
+	mp_writer_pause(w);
+	w->index = index;
+	mp_writer_resume(w);
+	return true;
+}
+
+/*!
+ * Includes data not yet written to file. Used to rotate files by size.
+ *
+ * For asynchronous writers, messages still waiting to be packed are not
+ * included.
+ *
+ * @param[in] w Writer
+ * @return Bytes added to writer since the current file descriptor was set
+ */
+uint64_t mp_writer_handle_bytes(const mp_writer *w) {
+	if (w == NULL) { return 0; }
+	return atomic_load_explicit(&(w->handleBytes), memory_order_relaxed);
+}
+
+/*!
+ * May be called from any thread.
+ *
+ * The reported maxUnsynced also includes the age of any data currently
+ * waiting to be synced.
+ *
+ * @param[in]  w     Writer
+ * @param[out] stats Statistics
+ * @param[in]  reset Reset maxLatency and maxLag after reading
+ */
+void mp_writer_get_stats(mp_writer *w, mp_writer_stats *stats, bool reset) {
+	if (w == NULL || stats == NULL) { return; }
+	if (w->async) { pthread_mutex_lock(&w->lock); }
+	*stats = w->stats;
+	if (w->syncMode != MP_SYNC_NONE && w->unsyncedBytes > 0) {
+		const float age = mp_writer_now_precise() - w->unsyncedSince;
+		if (age > stats->maxUnsynced) { stats->maxUnsynced = age; }
+	}
+	if (reset) {
+		w->stats.maxLatency = 0;
+		w->stats.maxLag = 0;
+		w->stats.maxSyncTime = 0;
+		w->stats.maxUnsynced = 0;
+	}
+	if (w->async) { pthread_mutex_unlock(&w->lock); }
+}
@@ -0,0 +1,221 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SELKIELoggerMP_Writer
+#define SELKIELoggerMP_Writer
+
+/*!
+ * @file MPWriter.h Buffered output of messages to file
+ * @ingroup SELKIELoggerMP
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "SELKIELoggerBase.h"
+
+#include "MPBlock.h"
+#include "MPIndex.h"
+
+/*!
+ * @addtogroup SELKIELoggerMP
+ * @{
+ */
+
+//! Default output buffer size
+#define MP_WRITER_BUFF (256 * 1024)
+
+//! Default maximum time data is held before being written (milliseconds)
+#define MP_WRITER_INTERVAL 1000
+
+//! Output buffers are aligned to this boundary
+#define MP_WRITER_ALIGN 4096
+
+//! Default number of messages that can be waiting for an asynchronous writer thread
+#define MP_WRITER_QUEUE 16384
+
+//! Maximum number of messages taken from the queue at once by a writer thread
+#define MP_WRITER_BATCH 64
+
+//! Default minimum time between data syncs in MP_SYNC_INTERVAL mode (milliseconds)
+#define MP_WRITER_SYNC_INTERVAL 10000
+
+//! Default amount of unsynced data allowed in MP_SYNC_BYTES mode
+#define MP_WRITER_SYNC_BYTES (4 * 1024 * 1024)
+
+//! Default file preallocation extent size
+#define MP_WRITER_PREALLOC (8 * 1024 * 1024)
+
+/*!
+ * @brief Durability modes
+ *
+ * Controls when written data is committed to storage with fdatasync().
+ * Regardless of mode, data is always passed to the kernel using write()
+ * according to the writer's flush interval.
+ */
+typedef enum {
+	MP_SYNC_NONE = 0, //!< Never sync, leaving writeback to the operating system
+	MP_SYNC_INTERVAL, //!< Sync written data, at most once per sync interval
+	MP_SYNC_BYTES,    //!< Sync once a set amount of data has been written
+} mp_sync_mode;
+
+//! Writer performance statistics
+typedef struct {
+	uint64_t flushes;  //!< Number of writes issued
+	uint64_t bytes;    //!< Total bytes written
+	uint64_t stalls;   //!< Number of times the caller waited for space in the writer queue
+	float maxLatency;  //!< Longest time taken by a single write (ms)
+	float maxLag;      //!< Longest time between data being added and being written (ms)
+	uint64_t syncs;    //!< Number of data syncs completed
+	float maxSyncTime; //!< Longest time taken by a single data sync (ms)
+	float maxUnsynced; //!< Longest time written data has waited to be synced (ms)
+} mp_writer_stats;
+
+/*!
+ * @brief Buffered message writer
+ *
+ * Messages are packed directly into a single reusable buffer (using
+ * mp_packMessage_buffer()), which is written out in one call when it fills
+ * or when data has been held for longer than the configured flush interval.
+ * Messages are never split between writes - the buffer is enlarged if a
+ * single message is larger than the buffer itself.
+ *
+ * If enabled with mp_writer_set_blocks(), each write forms a single block in
+ * the version 2 data file format, with space for the block header reserved
+ * at the start of the buffer and the header completed just before writing.
+ *
+ * If an index writer is attached with mp_writer_set_index(), each message is
+ * added to the index as it is packed, along with its offset in the file.
+ *
+ * Asynchronous writers (see mp_writer_init_async()) only pass a reference to
+ * each message to a dedicated thread, through a bounded queue. Packing,
+ * block checksums, index updates and writes are all carried out by that
+ * thread, so the calling thread only blocks if the queue is full.
+ *
+ * If enabled with mp_writer_set_latency(), the time from creation of each
+ * message (msg_t.created) until the write containing it completes is
+ * recorded, per source.
+ *
+ * Other than mp_writer_get_stats(), the functions operating on a writer must
+ * only be called from a single thread. For asynchronous writers, functions
+ * other than mp_writer_add(), mp_writer_tick(), mp_writer_next_flush() and
+ * mp_writer_handle_bytes() wait for the writer thread to pack all queued
+ * messages before taking effect.
+ */
+typedef struct {
+	int handle;         //!< Output file descriptor
+	uint8_t *buf;       //!< Output buffer
+	size_t capacity;    //!< Size of output buffer
+	size_t used;        //!< Bytes currently held in buffer
+	int interval;       //!< Maximum time to hold data (milliseconds)
+	int64_t firstData;  //!< Time at which oldest buffered data was added (ms, monotonic)
+	bool error;         //!< Set if a write has failed
+	mp_writer_stats stats; //!< Performance statistics (protected by lock if async)
+
+	mp_sync_mode syncMode;    //!< Durability mode
+	int syncInterval;         //!< Minimum time between syncs (ms, MP_SYNC_INTERVAL)
+	size_t syncBytes;         //!< Unsynced data threshold (MP_SYNC_BYTES)
+	size_t unsyncedBytes;     //!< Data written since last sync
+	int unsyncedHandle;       //!< File descriptor with unsynced data
+	double unsyncedSince;     //!< Time oldest unsynced data was written (ms, monotonic)
+	double lastSync;          //!< Time of last sync (ms, monotonic)
+
+	size_t prealloc;          //!< File space preallocation extent size (0 to disable)
+	off_t filePos;            //!< Current output file position (updated as data is written)
+	off_t allocEnd;           //!< End of preallocated space in current file
+	atomic_uint_least64_t handleBytes; //!< Bytes added since current file descriptor was set
+
+	bool blocks;              //!< Write block structured (version 2) output
+	mp_block_info block;      //!< Information for block currently being filled
+	mp_index_writer *index;   //!< Index to update as messages are packed, if not NULL
+
+	lat_set *latency;         //!< Record message latency on write, if not NULL
+	lat_stamp *stamps;        //!< Creation times of buffered messages
+	size_t nStamps;           //!< Number of entries in stamps
+	size_t stampCap;          //!< Allocated size of stamps
+
+	bool async;               //!< Use dedicated writer thread
+	msgqueue queue;           //!< Messages waiting to be packed by writer thread
+	bool pause;               //!< Ask writer thread to wait once queue is empty
+	bool paused;              //!< Set while writer thread is waiting for pause to clear
+	bool stop;                //!< Signal writer thread to exit
+	atomic_int asyncErrno;    //!< errno value from failed asynchronous write
+	pthread_t thread;         //!< Writer thread
+	pthread_mutex_t lock;     //!< Protects statistics and pause state shared with thread
+	pthread_cond_t cond;      //!< Signalled when pause state changes
+} mp_writer;
+
+//! Initialise a buffered writer for an existing file descriptor
+bool mp_writer_init(mp_writer *w, int handle, size_t capacity, int interval);
+
+//! Initialise a buffered writer using a dedicated output thread
+bool mp_writer_init_async(mp_writer *w, int handle, size_t capacity, int interval, size_t queueLen);
+
+//! Flush any remaining data and release buffer
+bool mp_writer_destroy(mp_writer *w);
+
+//! Pack a message into the output buffer, or queue it for the writer thread
+bool mp_writer_add(mp_writer *w, msg_t *msg);
+
+//! Write all buffered data to file
+bool mp_writer_flush(mp_writer *w);
+
+//! Flush buffered data if it has been held for longer than the flush interval
+bool mp_writer_tick(mp_writer *w);
+
+//! Time until buffered data is due to be flushed
+int mp_writer_next_flush(const mp_writer *w);
+
+//! Write all buffered data and wait for any pending writes to complete
+bool mp_writer_sync(mp_writer *w);
+
+//! Flush buffered data to current file, then switch to a new file descriptor
+bool mp_writer_set_handle(mp_writer *w, int handle);
+
+//! Set durability mode
+bool mp_writer_set_sync(mp_writer *w, mp_sync_mode mode, int interval, size_t bytes);
+
+//! Sync any written data to storage, regardless of durability mode
+bool mp_writer_commit(mp_writer *w);
+
+//! Set file preallocation extent size
+bool mp_writer_set_prealloc(mp_writer *w, size_t extent);
+
+//! Number of bytes added to the writer since the current file descriptor was set
+uint64_t mp_writer_handle_bytes(const mp_writer *w);
+
+//! Enable or disable block structured output
+bool mp_writer_set_blocks(mp_writer *w, bool enable, uint8_t clock);
+
+//! Record time taken for messages to be written to file
+bool mp_writer_set_latency(mp_writer *w, lat_set *set);
+
+//! Add messages to a time index as they are packed
+bool mp_writer_set_index(mp_writer *w, mp_index_writer *index);
+
+//! Retrieve writer statistics, optionally resetting maximum values
+void mp_writer_get_stats(mp_writer *w, mp_writer_stats *stats, bool reset);
+//! @}
+#endif
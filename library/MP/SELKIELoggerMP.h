@@ -34,7 +34,11 @@
  * devices and data files
  */
 
+#include "MP/MPBlock.h"
+#include "MP/MPIndex.h"
 #include "MP/MPSerial.h"
+#include "MP/MPStream.h"
 #include "MP/MPTypes.h"
+#include "MP/MPWriter.h"
 
 #endif
@@ -66,52 +66,68 @@ bool n2k_act_readMessage(int handle, n2k_act_message *out) {
 }
 
 /*!
- * Pulls data from `handle` and stores it in `buf`, tracking the current search
- * position in `index` and the current fill level/buffer high water mark in `hw`
- *
- * If a valid message is found then it is written to the structure provided as
- * a parameter and the function returns true.
- *
- * If a message cannot be read, the function returns false
+ * Read as much data as will fit into the remaining space in `buf`.
  *
  * @param[in] handle File descriptor from n2k_openConnection()
- * @param[out] out Pointer to message structure to fill with data
  * @param[in,out] buf Serial data buffer
- * @param[in,out] index Current search position within `buf`
  * @param[in,out] hw End of current valid data in `buf`
- * @return True if out now contains a valid message, false otherwise.
- *
+ * @param[out] ti Return value from read(), or 0 if buffer full
+ * @return False if an unexpected error occurred reading from handle
  */
-bool n2k_act_readMessage_buf(int handle, n2k_act_message *out, uint8_t buf[N2K_BUFF], size_t *index, size_t *hw) {
-	int ti = 0;
-	if ((*hw) < N2K_BUFF - 1) {
-		errno = 0;
-		ti = read(handle, &(buf[(*hw)]), N2K_BUFF - (*hw));
-		if (ti >= 0) {
-			(*hw) += ti;
-		} else {
-			if (errno != EAGAIN) {
-				fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
-				        handle);
-				fprintf(stderr, "read returned \"%s\" in readMessage\n", strerror(errno));
-				out->priority = 0xAA;
-				return false;
-			}
-		}
-	}
-	if (((*hw) == N2K_BUFF) && (*index) > 0 && (*index) > ((*hw) - 25)) {
-		// Full buffer, very close to the fill limit
-		// Assume we're full of garbage before index
-		memmove(buf, &(buf[(*index)]), N2K_BUFF - (*index));
-		(*hw) -= (*index);
-		(*index) = 0;
-		out->priority = 0xFF;
-		if (ti == 0) { out->priority = 0xFD; }
+static bool n2k_act_fill(int handle, uint8_t buf[N2K_BUFF], size_t *hw, int *ti) {
+	(*ti) = 0;
+	if ((*hw) >= N2K_BUFF - 1) { return true; }
+	errno = 0;
+	(*ti) = read(handle, &(buf[(*hw)]), N2K_BUFF - (*hw));
+	if ((*ti) >= 0) {
+		(*hw) += (*ti);
+	} else if (errno != EAGAIN) {
+		fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
+		        handle);
+		fprintf(stderr, "read returned \"%s\" in readMessage\n", strerror(errno));
 		return false;
 	}
+	return true;
+}
+
+/*!
+ * If the buffer is full and almost all of it has already been searched,
+ * assume it is full of garbage and discard everything before `index`.
+ *
+ * @param[out] out Status set to 0xFF (or 0xFD if ti is zero) if data discarded
+ * @param[in,out] buf Serial data buffer
+ * @param[in,out] index Current search position within `buf`
+ * @param[in,out] hw End of current valid data in `buf`
+ * @param[in] ti Return value from n2k_act_fill()
+ * @return True if data was discarded
+ */
+static bool n2k_act_discard(n2k_act_message *out, uint8_t buf[N2K_BUFF], size_t *index,
+                            size_t *hw, int ti) {
+	if (!(((*hw) == N2K_BUFF) && (*index) > 0 && (*index) > ((*hw) - 25))) { return false; }
+	// Full buffer, very close to the fill limit
+	// Assume we're full of garbage before index
+	memmove(buf, &(buf[(*index)]), N2K_BUFF - (*index));
+	(*hw) -= (*index);
+	(*index) = 0;
+	out->priority = 0xFF;
+	if (ti == 0) { out->priority = 0xFD; }
+	return true;
+}
 
+/*!
+ * Parse the next message in `buf`, starting from `index`, without moving data
+ * within the buffer.
+ *
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in] buf Serial data buffer
+ * @param[in,out] index Current search position within `buf`
+ * @param[in] hw End of current valid data in `buf`
+ * @return True if out now contains a valid message, false otherwise.
+ */
+static bool n2k_act_parse(n2k_act_message *out, const uint8_t buf[N2K_BUFF], size_t *index,
+                          size_t hw) {
 	n2k_act_message *t = NULL;
-	bool r = n2k_act_from_bytes(buf, *hw, &t, index, false);
+	bool r = n2k_act_from_bytes(buf, hw, &t, index, false);
 	if (t) {
 		(*out) = (*t);
 		free(t); // Shallow copied into out, so don't free ->data
@@ -121,12 +137,88 @@ bool n2k_act_readMessage_buf(int handle, n2k_act_message *out, uint8_t buf[N2K_B
 	}
 
 	if (!r) { out->priority = 0xEE; }
+	return r;
+}
 
+/*!
+ * Move unprocessed data from `index` back to the start of `buf`
+ *
+ * @param[in,out] buf Serial data buffer
+ * @param[in,out] index Current search position within `buf`
+ * @param[in,out] hw End of current valid data in `buf`
+ */
+static void n2k_act_compact(uint8_t buf[N2K_BUFF], size_t *index, size_t *hw) {
 	if ((*hw) > 0 && ((*hw) >= (*index))) {
 		// Move data from index back to zero position
 		memmove(buf, &(buf[(*index)]), N2K_BUFF - (*index));
 		(*hw) -= (*index);
 		(*index) = 0;
 	}
+}
+
+/*!
+ * Pulls data from `handle` and stores it in `buf`, tracking the current search
+ * position in `index` and the current fill level/buffer high water mark in `hw`
+ *
+ * If a valid message is found then it is written to the structure provided as
+ * a parameter and the function returns true.
+ *
+ * If a message cannot be read, the function returns false
+ *
+ * @param[in] handle File descriptor from n2k_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] buf Serial data buffer
+ * @param[in,out] index Current search position within `buf`
+ * @param[in,out] hw End of current valid data in `buf`
+ * @return True if out now contains a valid message, false otherwise.
+ *
+ */
+bool n2k_act_readMessage_buf(int handle, n2k_act_message *out, uint8_t buf[N2K_BUFF], size_t *index, size_t *hw) {
+	int ti = 0;
+	if (!n2k_act_fill(handle, buf, hw, &ti)) {
+		out->priority = 0xAA;
+		return false;
+	}
+	if (n2k_act_discard(out, buf, index, hw, ti)) { return false; }
+
+	bool r = n2k_act_parse(out, buf, index, *hw);
+	n2k_act_compact(buf, index, hw);
 	return r;
 }
+
+/*!
+ * As n2k_act_readMessage_buf(), but after reading from `handle` (at most
+ * once) all complete messages in `buf` are parsed before the remaining data
+ * is moved back to the start of the buffer.
+ *
+ * Returns the number of valid messages written to `out`. If this is less
+ * than `max`, the priority field of the next entry is set to the status that
+ * ended the batch, as for n2k_act_readMessage_buf(). That entry may also
+ * contain a message with an invalid checksum, in which case its data field
+ * must be freed by the caller.
+ *
+ * @param[in] handle File descriptor from n2k_openConnection()
+ * @param[out] out Array of at least `max` message structures
+ * @param[in] max Maximum number of messages to return
+ * @param[in,out] buf Serial data buffer
+ * @param[in,out] index Current search position within `buf`
+ * @param[in,out] hw End of current valid data in `buf`
+ * @return Number of valid messages written to `out`
+ */
+size_t n2k_act_readMessage_batch(int handle, n2k_act_message *out, size_t max,
+                                 uint8_t buf[N2K_BUFF], size_t *index, size_t *hw) {
+	if (out == NULL || max == 0) { return 0; }
+	int ti = 0;
+	if (!n2k_act_fill(handle, buf, hw, &ti)) {
+		out[0].priority = 0xAA;
+		return 0;
+	}
+	if (n2k_act_discard(&(out[0]), buf, index, hw, ti)) { return 0; }
+
+	size_t n = 0;
+	while (n < max && n2k_act_parse(&(out[n]), buf, index, *hw)) {
+		n++;
+	}
+	n2k_act_compact(buf, index, hw);
+	return n;
+}
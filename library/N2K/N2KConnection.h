@@ -46,4 +46,8 @@ bool n2k_act_readMessage(int handle, n2k_act_message *out);
 //! Read data from handle, and parse message if able
 bool n2k_act_readMessage_buf(int handle, n2k_act_message *out, uint8_t buf[N2K_BUFF], size_t *index, size_t *hw);
 
+//! Read data from handle once, and parse all complete messages
+size_t n2k_act_readMessage_batch(int handle, n2k_act_message *out, size_t max,
+                                 uint8_t buf[N2K_BUFF], size_t *index, size_t *hw);
+
 #endif
@@ -100,7 +100,9 @@ bool n2k_act_from_bytes(const uint8_t *in, const size_t len, n2k_act_message **m
 
 	ssize_t start = -1;
 	while (((*pos) + 18) < len) {
-		if ((in[(*pos)] == ACT_ESC) && (in[(*pos) + 1] == ACT_SOT) && (in[(*pos) + 2] == ACT_N2K)) {
+		(*pos) += scan_pair(&(in[(*pos)]), len - 18 - (*pos), ACT_ESC, ACT_SOT);
+		if (((*pos) + 18) >= len) { break; }
+		if ((in[(*pos) + 1] == ACT_SOT) && (in[(*pos) + 2] == ACT_N2K)) {
 			start = (*pos);
 			break;
 		}
@@ -57,17 +57,20 @@ void nmea_closeConnection(int handle) {
  * For single threaded development and testing, uses static variables rather
  * than requiring state to be tracked by caller.
  *
- * See nmea_readMessage_buf() for full description.
+ * See nmea_readMessage_ring() for full description.
  *
  * @param[in] handle File descriptor from nmea_openConnection()
  * @param[out] out Pointer to message structure to fill with data
  * @return True if out now contains a valid message, false otherwise.
  */
 bool nmea_readMessage(int handle, nmea_msg_t *out) {
-	static uint8_t buf[NMEA_SERIAL_BUFF];
-	static int index = 0; // Current read position
-	static int hw = 0;    // Current array end
-	return nmea_readMessage_buf(handle, out, buf, &index, &hw);
+	static byte_ring ring = {0};
+	if (ring.buf == NULL && !ring_init(&ring, NMEA_SERIAL_BUFF)) {
+		out->rawlen = 1;
+		out->raw[0] = 0xAA;
+		return false;
+	}
+	return nmea_readMessage_ring(handle, out, &ring);
 }
 
 /*!
@@ -124,9 +127,10 @@ bool nmea_readMessage_buf(int handle, nmea_msg_t *out, uint8_t buf[NMEA_SERIAL_B
 		if (ti == 0) { out->raw[0] = 0xFD; }
 		return false;
 	}
-	// Check buf[index] matches either of the valid start bytes
-	while (!(buf[(*index)] == NMEA_START_BYTE1 || buf[(*index)] == NMEA_START_BYTE2) && (*index) < (*hw)) {
-		(*index)++; // Current byte cannot be start of a message, so advance
+	// Advance to the next byte matching either of the valid start bytes
+	if ((*index) < (*hw)) {
+		(*index) += scan_either(&(buf[(*index)]), (*hw) - (*index), NMEA_START_BYTE1,
+		                        NMEA_START_BYTE2);
 	}
 	if ((*index) == (*hw)) {
 		if ((*hw) > 0 && (*index) > 0) {
@@ -307,6 +311,229 @@ bool nmea_readMessage_buf(int handle, nmea_msg_t *out, uint8_t buf[NMEA_SERIAL_B
 	return true;
 }
 
+/*!
+ * @param[in] c Character
+ * @return Value of hexadecimal digit, or -1 if not a valid digit
+ */
+static int nmea_hex_digit(uint8_t c) {
+	if (c >= '0' && c <= '9') { return c - '0'; }
+	if (c >= 'A' && c <= 'F') { return (c - 'A') + 10; }
+	if (c >= 'a' && c <= 'f') { return (c - 'a') + 10; }
+	return -1;
+}
+
+/*!
+ * Frame synchronisation for nmea_frame_protocol
+ *
+ * @param[in] data Unprocessed data
+ * @param[in] len  Length of data
+ * @return Offset of first start byte, or len if not found
+ */
+static size_t nmea_frame_sync(const uint8_t *data, size_t len) {
+	return scan_either(data, len, NMEA_START_BYTE1, NMEA_START_BYTE2);
+}
+
+/*!
+ * Frame length for nmea_frame_protocol
+ *
+ * Messages are terminated with CR LF, but some devices (e.g. the USB
+ * gateway) use LF LF at startup, so both are accepted.
+ *
+ * @param[in] data Candidate message, starting with a start byte
+ * @param[in] len  Length of data
+ * @return Message length including terminator, 0 if more data required, or
+ * -1 if no terminator within NMEA_FRAME_MAX bytes
+ */
+static ssize_t nmea_frame_length(const uint8_t *data, size_t len) {
+	if (len < 8) { return 0; }
+	for (size_t eom = 1; eom < len; eom++) {
+		if (data[eom] == NMEA_END_BYTE2 &&
+		    (data[eom - 1] == NMEA_END_BYTE1 || data[eom - 1] == NMEA_END_BYTE2)) {
+			return eom + 1;
+		}
+		if (eom + 1 >= NMEA_FRAME_MAX) { return -1; }
+	}
+	return 0;
+}
+
+/*!
+ * Frame validation for nmea_frame_protocol
+ *
+ * Messages without a checksum are accepted, as the checksum is optional for
+ * some message types.
+ *
+ * @param[in] data Complete message
+ * @param[in] len  Message length
+ * @return False if message has an invalid checksum
+ */
+static bool nmea_frame_check(const uint8_t *data, size_t len) {
+	uint8_t cs = 0;
+	for (size_t i = 1; i < len; i++) {
+		if (data[i] == NMEA_CSUM_MARK) {
+			if (i + 2 >= len) { return false; }
+			const int a = nmea_hex_digit(data[i + 1]);
+			const int b = nmea_hex_digit(data[i + 2]);
+			return (a >= 0 && b >= 0 && cs == ((a << 4) + b));
+		}
+		if (data[i] == NMEA_END_BYTE1 || data[i] == NMEA_END_BYTE2) { return true; }
+		cs ^= data[i];
+	}
+	return true;
+}
+
+//! NMEA message framing, for use with frame_next()
+static const frame_protocol nmea_frame_protocol = {.sync = &nmea_frame_sync,
+                                                   .length = &nmea_frame_length,
+                                                   .check = &nmea_frame_check,
+                                                   .maxLength = NMEA_FRAME_MAX};
+
+/*!
+ * Split a complete message, as found by frame_next(), into the fields of an
+ * nmea_msg_t. The checksum has already been validated by nmea_frame_check().
+ *
+ * @param[in]  data Complete message, including start byte and terminator
+ * @param[in]  len  Message length
+ * @param[out] out  Message structure to fill
+ * @return True if message structure valid
+ */
+static bool nmea_parse_frame(const uint8_t *data, size_t len, nmea_msg_t *out) {
+	const size_t eom = len - 1;
+	size_t som = 0;
+	if (len < 9) { return false; }
+
+	// Can only be one of the start bytes, so no explicit check for BYTE1
+	out->encapsulated = (data[som++] == NMEA_START_BYTE2);
+
+	out->talker[0] = data[som++];
+	out->talker[1] = data[som++];
+	if (out->talker[0] == 'P') {
+		if (len < 11) { return false; }
+		out->talker[2] = data[som++];
+		out->talker[3] = data[som++];
+	}
+	out->message[0] = data[som++];
+	out->message[1] = data[som++];
+	out->message[2] = data[som++];
+
+	if (data[som++] != ',') { return false; }
+
+	out->rawlen = 0;
+	while (som < eom && data[som] != NMEA_CSUM_MARK && data[som] != NMEA_END_BYTE1 &&
+	       data[som + 1] != NMEA_END_BYTE2 && out->rawlen < sizeof(out->raw)) {
+		out->raw[out->rawlen++] = data[som++];
+	}
+
+	if (data[som] == NMEA_CSUM_MARK) {
+		if (som + 3 > eom) { return false; }
+		const int a = nmea_hex_digit(data[som + 1]);
+		const int b = nmea_hex_digit(data[som + 2]);
+		if (a < 0 || b < 0) { return false; }
+		out->checksum = (a << 4) + b;
+		som += 3;
+	}
+
+	return (eom - som) <= 1;
+}
+
+/*!
+ * Implementation of nmea_readMessage_ring() and nmea_readMessage_batch().
+ * Data is only read from `handle` if no complete message is buffered and
+ * `filled` is false, and `filled` is set once data has been read.
+ *
+ * @param[in] handle File descriptor from nmea_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @param[in,out] filled Set true once data has been read from handle
+ * @return True if out now contains a valid message, false otherwise.
+ */
+static bool nmea_ring_next(int handle, nmea_msg_t *out, byte_ring *ring, bool *filled) {
+	while (true) {
+		const uint8_t *frame = NULL;
+		size_t len = 0;
+		const frame_status fs = frame_next(ring, &nmea_frame_protocol, &frame, &len);
+		if (fs == FRAME_OK) {
+			if (nmea_parse_frame(frame, len, out)) { return true; }
+			out->rawlen = 1;
+			out->raw[0] = 0xEE;
+			return false;
+		}
+
+		out->rawlen = 1;
+		if (fs == FRAME_INVALID) {
+			out->raw[0] = 0xEE;
+			return false;
+		}
+		if (fs == FRAME_ERROR) {
+			out->raw[0] = 0xAA;
+			return false;
+		}
+
+		out->raw[0] = 0xFF;
+		if (*filled) { return false; }
+
+		errno = 0;
+		const ssize_t ti = ring_fill(ring, handle);
+		if (ti < 0 && errno != EAGAIN) {
+			fprintf(stderr, "Unexpected error while reading from serial port (handle ID: 0x%02x)\n",
+			        handle);
+			fprintf(stderr, "read returned \"%s\" in readMessage\n", strerror(errno));
+			out->raw[0] = 0xAA;
+			return false;
+		}
+		if (ti == 0) { out->raw[0] = 0xFD; }
+		if (ti <= 0) { return false; }
+		*filled = true;
+	}
+}
+
+/*!
+ * Reads data from `handle` into `ring` when needed, and uses frame_next() to
+ * find the next message in the ring without moving data around.
+ *
+ * If a valid message is found then it is written to the structure provided as
+ * a parameter and the function returns true.
+ *
+ * If a message cannot be read, the function returns false and the first byte
+ * of the raw array is set to an error value, as described for
+ * nmea_readMessage_buf().
+ *
+ * @param[in] handle File descriptor from nmea_openConnection()
+ * @param[out] out Pointer to message structure to fill with data
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return True if out now contains a valid message, false otherwise.
+ */
+bool nmea_readMessage_ring(int handle, nmea_msg_t *out, byte_ring *ring) {
+	bool filled = false;
+	return nmea_ring_next(handle, out, ring, &filled);
+}
+
+/*!
+ * Equivalent to calling nmea_readMessage_ring() repeatedly, but data is read
+ * from `handle` at most once, so all messages already buffered (or received
+ * in a single read) are returned together.
+ *
+ * Messages are written to out[0] onwards, and the number of valid messages is
+ * returned. If fewer than `max` messages are returned, out[n] holds the
+ * reason no further messages were available, as for nmea_readMessage_ring().
+ * An invalid message (0xEE) ends the batch, but further messages may already
+ * be buffered.
+ *
+ * @param[in] handle File descriptor from nmea_openConnection()
+ * @param[out] out Array of at least `max` message structures
+ * @param[in] max Maximum number of messages to return
+ * @param[in,out] ring Data buffer, initialised with ring_init()
+ * @return Number of valid messages written to out
+ */
+size_t nmea_readMessage_batch(int handle, nmea_msg_t *out, size_t max, byte_ring *ring) {
+	if (out == NULL) { return 0; }
+	bool filled = false;
+	size_t n = 0;
+	while (n < max && nmea_ring_next(handle, &(out[n]), ring, &filled)) {
+		n++;
+	}
+	return n;
+}
+
 /*!
  * Takes a message, validates the checksum and writes it out to the device or
  * file connected to `handle`.
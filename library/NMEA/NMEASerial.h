@@ -37,18 +37,27 @@
 //! Default serial buffer allocation size.
 #define NMEA_SERIAL_BUFF 1024
 
+//! Longest message accepted by nmea_readMessage_ring(), including terminator
+#define NMEA_FRAME_MAX 83
+
 //! Set up a connection to the specified port
 int nmea_openConnection(const char *port, const int baudRate);
 
 //! Close existing connection
 void nmea_closeConnection(int handle);
 
-//! Static wrapper around mp_readMessage_buf
+//! Static wrapper around nmea_readMessage_ring
 bool nmea_readMessage(int handle, nmea_msg_t *out);
 
 //! Read data from handle, and parse message if able
 bool nmea_readMessage_buf(int handle, nmea_msg_t *out, uint8_t buf[NMEA_SERIAL_BUFF], int *index, int *hw);
 
+//! Read data from handle into a ring buffer, and parse message if able
+bool nmea_readMessage_ring(int handle, nmea_msg_t *out, byte_ring *ring);
+
+//! Read all buffered messages, reading from handle at most once
+size_t nmea_readMessage_batch(int handle, nmea_msg_t *out, size_t max, byte_ring *ring);
+
 //! Send message to attached device
 bool nmea_writeMessage(int handle, const nmea_msg_t *out);
 //! @}
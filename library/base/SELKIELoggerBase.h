@@ -31,9 +31,15 @@
  * @ingroup Library
  */
 
+#include "base/lanes.h"
+#include "base/latency.h"
+#include "base/live.h"
 #include "base/logging.h"
 #include "base/messages.h"
+#include "base/pool.h"
 #include "base/queue.h"
+#include "base/ring.h"
+#include "base/scan.h"
 #include "base/serial.h"
 #include "base/sources.h"
 
@@ -0,0 +1,231 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "lanes.h"
+
+/*!
+ * Each lane is initialised with queue_init_size() and set to record message
+ * arrival times. Will not re-initialise a lane set that already has storage
+ * allocated.
+ *
+ * @param[in] ml       Pointer to lane set to be initialised
+ * @param[in] nLanes   Number of lanes (must be at least 1)
+ * @param[in] capacity Minimum capacity of each lane. If zero, QUEUE_DEFAULT_CAPACITY is used.
+ * @return True on success, false otherwise
+ */
+bool lanes_init(msglanes *ml, size_t nLanes, size_t capacity) {
+	if (ml->lanes || nLanes == 0) { return false; }
+	if (capacity == 0) { capacity = QUEUE_DEFAULT_CAPACITY; }
+
+	ml->lanes = calloc(nLanes, sizeof(msgqueue));
+	ml->peak = calloc(nLanes, sizeof(size_t));
+	ml->pfds = calloc(nLanes, sizeof(struct pollfd));
+	if (ml->lanes == NULL || ml->peak == NULL || ml->pfds == NULL) {
+		// LCOV_EXCL_START
+		perror("lanes_init");
+		free(ml->lanes);
+		free(ml->peak);
+		free(ml->pfds);
+		ml->lanes = NULL;
+		ml->peak = NULL;
+		ml->pfds = NULL;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	for (size_t l = 0; l < nLanes; l++) {
+		if (!queue_init_size(&(ml->lanes[l]), capacity)) {
+			// LCOV_EXCL_START
+			for (size_t i = 0; i < l; i++) {
+				queue_destroy(&(ml->lanes[i]));
+			}
+			free(ml->lanes);
+			free(ml->peak);
+			free(ml->pfds);
+			ml->lanes = NULL;
+			ml->peak = NULL;
+			ml->pfds = NULL;
+			return false;
+			// LCOV_EXCL_STOP
+		}
+		ml->lanes[l].stamped = true;
+		ml->pfds[l].fd = ml->lanes[l].wakefd;
+		ml->pfds[l].events = POLLIN;
+	}
+	ml->nLanes = nLanes;
+	return true;
+}
+
+/*!
+ * All producers must have stopped pushing to the lanes before this is called.
+ * Any messages remaining in the lanes are destroyed.
+ *
+ * @param[in] ml Pointer to lane set to be destroyed
+ */
+void lanes_destroy(msglanes *ml) {
+	if (ml->lanes) {
+		for (size_t l = 0; l < ml->nLanes; l++) {
+			queue_destroy(&(ml->lanes[l]));
+		}
+	}
+	free(ml->lanes);
+	free(ml->peak);
+	free(ml->pfds);
+	ml->lanes = NULL;
+	ml->peak = NULL;
+	ml->pfds = NULL;
+	ml->nLanes = 0;
+}
+
+/*!
+ * The returned queue can be passed to queue_push() as normal, but must not be
+ * consumed from directly.
+ *
+ * @param[in] ml   Pointer to lane set
+ * @param[in] lane Lane index
+ * @return Pointer to lane, or NULL if lane index invalid
+ */
+msgqueue *lanes_get(msglanes *ml, size_t lane) {
+	if (ml->lanes == NULL || lane >= ml->nLanes) { return NULL; }
+	return &(ml->lanes[lane]);
+}
+
+/*!
+ * Messages are merged across lanes by taking the message with the earliest
+ * arrival time from the heads of all the lanes. As messages are only taken
+ * from the head of each lane, ordering within each lane is always preserved.
+ *
+ * The depth of each lane is checked on each call, and used to update the
+ * peak depth returned by lanes_peak().
+ *
+ * As with queue_pop_batch(), the caller takes ownership of all returned
+ * messages and only a single thread may consume from a lane set.
+ *
+ * @param[in] ml   Pointer to lane set
+ * @param[out] out Array of at least max message pointers
+ * @param[in] max  Maximum number of messages to remove
+ * @return Number of messages stored in out
+ */
+size_t lanes_pop_batch(msglanes *ml, msg_t **out, size_t max) {
+	if (ml->lanes == NULL || out == NULL) { return 0; }
+
+	for (size_t l = 0; l < ml->nLanes; l++) {
+		const int depth = queue_count(&(ml->lanes[l]));
+		if (depth > 0 && (size_t)depth > ml->peak[l]) { ml->peak[l] = depth; }
+	}
+
+	// No merging required
+	if (ml->nLanes == 1) { return queue_pop_batch(&(ml->lanes[0]), out, max); }
+
+	size_t n = 0;
+	while (n < max) {
+		size_t best = SIZE_MAX;
+		uint64_t bestStamp = 0;
+		for (size_t l = 0; l < ml->nLanes; l++) {
+			uint64_t stamp = 0;
+			if (!queue_peek_stamp(&(ml->lanes[l]), &stamp)) { continue; }
+			if (best == SIZE_MAX || stamp < bestStamp) {
+				best = l;
+				bestStamp = stamp;
+			}
+		}
+		if (best == SIZE_MAX) { break; }
+		out[n++] = queue_pop(&(ml->lanes[best]));
+	}
+	return n;
+}
+
+/*!
+ * Equivalent to queue_wait(), but returns when a message is pushed to any
+ * lane in the set. Uses the descriptor array allocated by lanes_init(), so
+ * nothing is allocated while waiting.
+ *
+ * @param[in] ml      Pointer to lane set
+ * @param[in] timeout Maximum time to wait, in milliseconds. Negative values wait indefinitely.
+ * @return True if messages are ready, false on timeout, interruption or error
+ */
+bool lanes_wait(msglanes *ml, int timeout) {
+	if (ml->lanes == NULL) { return false; }
+	if (ml->nLanes == 1) { return queue_wait(&(ml->lanes[0]), timeout); }
+
+	struct pollfd *pfds = ml->pfds;
+	bool ready = false;
+	for (size_t l = 0; l < ml->nLanes; l++) {
+		atomic_store(&(ml->lanes[l].sleeping), true);
+	}
+	// Pairs with fence in queue_push(), as for queue_wait()
+	atomic_thread_fence(memory_order_seq_cst);
+	for (size_t l = 0; l < ml->nLanes; l++) {
+		if (queue_peek_stamp(&(ml->lanes[l]), NULL)) {
+			ready = true;
+			break;
+		}
+	}
+
+	if (!ready && poll(pfds, ml->nLanes, timeout) > 0) {
+		for (size_t l = 0; l < ml->nLanes; l++) {
+			if (!(pfds[l].revents & POLLIN)) { continue; }
+			uint64_t count = 0;
+			if (read(pfds[l].fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+				perror("lanes_wait"); // LCOV_EXCL_LINE
+			}
+		}
+	}
+
+	for (size_t l = 0; l < ml->nLanes; l++) {
+		atomic_store(&(ml->lanes[l].sleeping), false);
+		if (!ready && queue_peek_stamp(&(ml->lanes[l]), NULL)) { ready = true; }
+	}
+	return ready;
+}
+
+/*!
+ * @param[in] ml   Pointer to lane set
+ * @param[in] lane Lane index
+ * @return Number of messages waiting in lane, or -1 on error
+ */
+int lanes_depth(const msglanes *ml, size_t lane) {
+	if (ml->lanes == NULL || lane >= ml->nLanes) { return -1; }
+	return queue_count(&(ml->lanes[lane]));
+}
+
+/*!
+ * Lane depths are sampled each time lanes_pop_batch() is called, so this
+ * reports the worst backlog seen by the consumer.
+ *
+ * @param[in] ml    Pointer to lane set
+ * @param[in] lane  Lane index
+ * @param[in] reset If true, reset peak value after reading
+ * @return Largest number of messages seen waiting in lane, or 0 if lane invalid
+ */
+size_t lanes_peak(msglanes *ml, size_t lane, bool reset) {
+	if (ml->lanes == NULL || lane >= ml->nLanes) { return 0; }
+	const size_t p = ml->peak[lane];
+	if (reset) { ml->peak[lane] = 0; }
+	return p;
+}
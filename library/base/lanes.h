@@ -0,0 +1,82 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELKIELoggerBase_Lanes
+#define SELKIELoggerBase_Lanes
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "messages.h"
+#include "queue.h"
+
+/*!
+ * @file lanes.h Merged sets of message queues
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup lanes Message queue lanes
+ * @ingroup SELKIELoggerBase
+ *
+ * A set of message queues ("lanes") consumed by a single thread as if they
+ * were one queue.
+ *
+ * Giving each producer thread its own lane means producers never write to
+ * the same queue indices, so a busy source cannot delay messages from other
+ * sources by contending for the same cache lines. Messages are recorded
+ * with their arrival time when pushed, and the consumer merges the lanes by
+ * taking the oldest waiting message first.
+ *
+ * Messages from any one lane are always returned in the order they were
+ * pushed.
+ * @{
+ */
+
+//! Set of message queues, consumed in arrival order
+typedef struct {
+	msgqueue *lanes; //!< Array of nLanes queues
+	size_t *peak;    //!< Largest depth seen for each lane since last reset
+	struct pollfd *pfds; //!< Wake descriptors for each lane, used by lanes_wait()
+	size_t nLanes;   //!< Number of lanes
+} msglanes;
+
+//! Allocate and initialise a set of message lanes
+bool lanes_init(msglanes *ml, size_t nLanes, size_t capacity);
+
+//! Destroy all lanes and their contents
+void lanes_destroy(msglanes *ml);
+
+//! Get pointer to an individual lane, for use by a producer
+msgqueue *lanes_get(msglanes *ml, size_t lane);
+
+//! Remove up to max messages from all lanes, oldest first
+size_t lanes_pop_batch(msglanes *ml, msg_t **out, size_t max);
+
+//! Wait for messages to become available in any lane, or for timeout to expire
+bool lanes_wait(msglanes *ml, int timeout);
+
+//! Current number of messages waiting in a lane
+int lanes_depth(const msglanes *ml, size_t lane);
+
+//! Largest number of messages seen waiting in a lane, optionally resetting the count
+size_t lanes_peak(msglanes *ml, size_t lane, bool reset);
+//! @}
+#endif
@@ -0,0 +1,249 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+
+static atomic_bool lat_stamping = false; //!< Set by lat_stamp_enable()
+
+/*!
+ * Values below LAT_SUB_BUCKETS each have their own bucket. Above that, the
+ * bucket is selected by the position of the most significant bit and the
+ * LAT_SUB_BITS bits that follow it.
+ *
+ * @param[in] v Value
+ * @return Bucket index
+ */
+static size_t lat_bucket(uint64_t v) {
+	if (v < LAT_SUB_BUCKETS) { return v; }
+	const int msb = 63 - __builtin_clzll(v);
+	if (msb >= LAT_RANGE_BITS) { return LAT_BUCKETS - 1; }
+	const int shift = msb - LAT_SUB_BITS;
+	return ((size_t)(shift + 1) << LAT_SUB_BITS) + ((v >> shift) - LAT_SUB_BUCKETS);
+}
+
+/*!
+ * @param[in] ix Bucket index
+ * @return Largest value recorded in bucket
+ */
+static uint64_t lat_bucket_max(size_t ix) {
+	if (ix < LAT_SUB_BUCKETS) { return ix; }
+	const int shift = (int)(ix >> LAT_SUB_BITS) - 1;
+	const uint64_t m = (ix & (LAT_SUB_BUCKETS - 1)) + LAT_SUB_BUCKETS;
+	return ((m + 1) << shift) - 1;
+}
+
+/*!
+ * @return Current CLOCK_MONOTONIC time in nanoseconds
+ */
+uint64_t lat_now(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * Disabled by default, so that messages don't pay for a clock read unless
+ * latency is being measured. Messages created while disabled have a
+ * creation time of zero, and should be ignored by consumers.
+ *
+ * @param[in] enable True to record creation times for new messages
+ */
+void lat_stamp_enable(bool enable) {
+	atomic_store(&lat_stamping, enable);
+}
+
+/*!
+ * @return Current monotonic time in nanoseconds if enabled, otherwise 0
+ */
+uint64_t lat_stamp_now(void) {
+	if (!atomic_load_explicit(&lat_stamping, memory_order_relaxed)) { return 0; }
+	return lat_now();
+}
+
+/*!
+ * @param[in] h Histogram
+ */
+void lat_reset(lat_hist *h) {
+	if (h == NULL) { return; }
+	memset(h, 0, sizeof(lat_hist));
+}
+
+/*!
+ * Values larger than the histogram range are counted in the last bucket,
+ * but are still reflected in the reported maximum.
+ *
+ * @param[in] h  Histogram
+ * @param[in] ns Value (nanoseconds)
+ */
+void lat_record(lat_hist *h, uint64_t ns) {
+	h->buckets[lat_bucket(ns)]++;
+	h->count++;
+	if (ns > h->max) { h->max = ns; }
+}
+
+/*!
+ * @param[in] dst Destination histogram
+ * @param[in] src Histogram to be added to dst
+ */
+void lat_merge(lat_hist *dst, const lat_hist *src) {
+	if (dst == NULL || src == NULL || src->count == 0) { return; }
+	for (size_t b = 0; b < LAT_BUCKETS; b++) {
+		dst->buckets[b] += src->buckets[b];
+	}
+	dst->count += src->count;
+	if (src->max > dst->max) { dst->max = src->max; }
+}
+
+/*!
+ * The value returned is the upper limit of the bucket containing the
+ * requested percentile, so will slightly overestimate the true value. It is
+ * never larger than the recorded maximum.
+ *
+ * @param[in] h   Histogram
+ * @param[in] pct Percentile (0-100)
+ * @return Estimated value (nanoseconds), or 0 if histogram is empty
+ */
+uint64_t lat_percentile(const lat_hist *h, double pct) {
+	if (h == NULL || h->count == 0) { return 0; }
+	if (pct >= 100) { return h->max; }
+	uint64_t rank = (uint64_t)((pct / 100.0) * h->count + 0.5);
+	if (rank < 1) { rank = 1; }
+	uint64_t seen = 0;
+	for (size_t b = 0; b < LAT_BUCKETS; b++) {
+		seen += h->buckets[b];
+		if (seen >= rank) {
+			// Last bucket also holds all values beyond histogram range
+			if (b == LAT_BUCKETS - 1) { return h->max; }
+			const uint64_t v = lat_bucket_max(b);
+			return (v < h->max) ? v : h->max;
+		}
+	}
+	return h->max; // LCOV_EXCL_LINE
+}
+
+/*!
+ * @param[in] s Set to initialise
+ * @return True on success
+ */
+bool lat_set_init(lat_set *s) {
+	if (s == NULL) { return false; }
+	*s = (lat_set){0};
+	if (pthread_mutex_init(&s->lock, NULL) != 0) {
+		// LCOV_EXCL_START
+		perror("lat_set_init");
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	return true;
+}
+
+/*!
+ * @param[in] s Set
+ */
+void lat_set_destroy(lat_set *s) {
+	if (s == NULL) { return; }
+	for (int i = 0; i < 128; i++) {
+		free(s->hist[i]);
+		s->hist[i] = NULL;
+	}
+	pthread_mutex_destroy(&s->lock);
+}
+
+/*!
+ * Must be called with the set lock held.
+ *
+ * @param[in] s      Set
+ * @param[in] source Source ID
+ * @return Histogram for source, or NULL if it couldn't be allocated
+ */
+static lat_hist *lat_set_hist(lat_set *s, uint8_t source) {
+	if (source >= 128) { return NULL; }
+	if (s->hist[source] == NULL) { s->hist[source] = calloc(1, sizeof(lat_hist)); }
+	return s->hist[source];
+}
+
+/*!
+ * @param[in] s      Set
+ * @param[in] source Source ID
+ * @param[in] ns     Value (nanoseconds)
+ * @return True on success, false if the histogram couldn't be allocated
+ */
+bool lat_set_record(lat_set *s, uint8_t source, uint64_t ns) {
+	if (s == NULL) { return false; }
+	pthread_mutex_lock(&s->lock);
+	lat_hist *h = lat_set_hist(s, source);
+	if (h) { lat_record(h, ns); }
+	pthread_mutex_unlock(&s->lock);
+	return (h != NULL);
+}
+
+/*!
+ * Records the time from creation to now for each message, taking the lock
+ * only once. Stamps with a creation time of zero are ignored.
+ *
+ * @param[in] s      Set
+ * @param[in] stamps Message creation times and sources
+ * @param[in] n      Number of entries in stamps
+ * @param[in] now    Time at which messages reached this stage (see lat_now())
+ * @return True on success, false if any histogram couldn't be allocated
+ */
+bool lat_set_record_stamps(lat_set *s, const lat_stamp *stamps, size_t n, uint64_t now) {
+	if (s == NULL || (stamps == NULL && n > 0)) { return false; }
+	bool ok = true;
+	pthread_mutex_lock(&s->lock);
+	for (size_t i = 0; i < n; i++) {
+		if (stamps[i].created == 0) { continue; }
+		lat_hist *h = lat_set_hist(s, stamps[i].source);
+		if (h == NULL) {
+			ok = false;
+			continue;
+		}
+		lat_record(h, (now > stamps[i].created) ? now - stamps[i].created : 0);
+	}
+	pthread_mutex_unlock(&s->lock);
+	return ok;
+}
+
+/*!
+ * @param[in]  s      Set
+ * @param[in]  source Source ID
+ * @param[out] out    Copy of histogram for source (empty if nothing recorded)
+ * @return True if any values were recorded for this source since the last call
+ */
+bool lat_set_take(lat_set *s, uint8_t source, lat_hist *out) {
+	if (s == NULL || out == NULL || source >= 128) { return false; }
+	pthread_mutex_lock(&s->lock);
+	lat_hist *h = s->hist[source];
+	if (h == NULL || h->count == 0) {
+		pthread_mutex_unlock(&s->lock);
+		lat_reset(out);
+		return false;
+	}
+	*out = *h;
+	lat_reset(h);
+	pthread_mutex_unlock(&s->lock);
+	return true;
+}
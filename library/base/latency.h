@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELKIELoggerBase_Latency
+#define SELKIELoggerBase_Latency
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @file latency.h Message latency measurement
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup latency Latency histograms
+ * @ingroup SELKIELoggerBase
+ *
+ * If enabled with lat_stamp_enable(), each new message records the
+ * monotonic time at which it was created (msg_t.created). Consumers can then
+ * measure how long messages take to reach each processing stage.
+ *
+ * Latencies are accumulated in fixed size histograms with logarithmically
+ * spaced buckets, each power of two being divided into LAT_SUB_BUCKETS
+ * linear steps. Recording a value is a constant time operation, no memory
+ * is allocated, and percentiles are reported to within about 3% of the true
+ * value across the full range.
+ * @{
+ */
+
+//! Number of bits used to divide each power of two into linear buckets
+#define LAT_SUB_BITS 5
+
+//! Number of linear buckets per power of two
+#define LAT_SUB_BUCKETS (1 << LAT_SUB_BITS)
+
+//! Largest value recorded in its own bucket is 2^LAT_RANGE_BITS - 1 nanoseconds (~18 minutes)
+#define LAT_RANGE_BITS 40
+
+//! Total number of histogram buckets
+#define LAT_BUCKETS ((LAT_RANGE_BITS - LAT_SUB_BITS + 1) * LAT_SUB_BUCKETS)
+
+//! Latency histogram (values in nanoseconds)
+typedef struct {
+	uint64_t count;                //!< Number of values recorded
+	uint64_t max;                  //!< Largest value recorded
+	uint32_t buckets[LAT_BUCKETS]; //!< Number of values recorded in each bucket
+} lat_hist;
+
+//! Creation time of a single message, used to measure latency in bulk
+typedef struct {
+	uint64_t created; //!< Message creation time (msg_t.created)
+	uint8_t source;   //!< Message source
+} lat_stamp;
+
+//! Histograms for each message source, safe to update from multiple threads
+typedef struct {
+	pthread_mutex_t lock; //!< Protects hist
+	lat_hist *hist[128];  //!< Histogram for each source, allocated when first required
+} lat_set;
+
+//! Current monotonic clock time, in nanoseconds
+uint64_t lat_now(void);
+
+//! Enable or disable recording message creation times
+void lat_stamp_enable(bool enable);
+
+//! Creation time for new messages
+uint64_t lat_stamp_now(void);
+
+//! Clear histogram
+void lat_reset(lat_hist *h);
+
+//! Record a single value
+void lat_record(lat_hist *h, uint64_t ns);
+
+//! Add all values from one histogram to another
+void lat_merge(lat_hist *dst, const lat_hist *src);
+
+//! Estimate value at a given percentile
+uint64_t lat_percentile(const lat_hist *h, double pct);
+
+//! Initialise an empty set of histograms
+bool lat_set_init(lat_set *s);
+
+//! Release all histograms in set
+void lat_set_destroy(lat_set *s);
+
+//! Record a single value for a source
+bool lat_set_record(lat_set *s, uint8_t source, uint64_t ns);
+
+//! Record latency for a group of messages reaching the same stage
+bool lat_set_record_stamps(lat_set *s, const lat_stamp *stamps, size_t n, uint64_t now);
+
+//! Copy and reset histogram for a source
+bool lat_set_take(lat_set *s, uint8_t source, lat_hist *out);
+//! @}
+#endif
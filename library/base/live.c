@@ -0,0 +1,395 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "live.h"
+#include "sources.h"
+
+_Static_assert(sizeof(live_header) == LIVE_HEADER_SIZE, "Unexpected live_header size");
+_Static_assert(sizeof(live_entry) == 128, "Unexpected live_entry size");
+_Static_assert(LIVE_HEADER_SIZE + (LIVE_ENTRIES / 8) <= LIVE_TABLE_OFFSET,
+               "Active bitmap overlaps table");
+
+//! Table identifier, stored at start of header
+static const char live_magic[8] = "SLLIVE";
+
+/*!
+ * @brief Start update of a sequence protected region (writer only)
+ * @param[in] seq Sequence counter
+ */
+static inline void live_write_begin(_Atomic uint32_t *seq) {
+	const uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+	atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+/*!
+ * @brief Complete update of a sequence protected region (writer only)
+ * @param[in] seq Sequence counter
+ */
+static inline void live_write_end(_Atomic uint32_t *seq) {
+	const uint32_t s = atomic_load_explicit(seq, memory_order_relaxed);
+	atomic_store_explicit(seq, s + 1, memory_order_release);
+}
+
+/*!
+ * @brief Copy string into fixed size field, truncating if required
+ *
+ * @param[out] dst  Destination
+ * @param[in]  dlen Size of destination
+ * @param[in]  src  Source string
+ * @param[in]  slen Length of source string
+ * @returns Number of characters copied
+ */
+static size_t live_copy_string(char *dst, size_t dlen, const char *src, size_t slen) {
+	if (src == NULL) { slen = 0; }
+	if (slen >= dlen) { slen = dlen - 1; }
+	if (slen > 0) { memcpy(dst, src, slen); }
+	dst[slen] = '\0';
+	return slen;
+}
+
+/*!
+ * The shared memory object is created (replacing any existing object with
+ * the same name) and initialised. The object remains until live_destroy() is
+ * called.
+ *
+ * @param[out] t     Table handle
+ * @param[in]  name  Shared memory object name (see shm_open(3))
+ * @param[in]  clock Primary clock source ID
+ * @returns True on success, false on error (errno set)
+ */
+bool live_create(live_table *t, const char *name, uint8_t clock) {
+	if (t == NULL || name == NULL) {
+		errno = EINVAL;
+		return false;
+	}
+	*t = (live_table){.handle = -1};
+
+	// Remove any stale table left by a previous run
+	shm_unlink(name);
+	t->handle = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (t->handle < 0) { return false; }
+	t->name = strdup(name);
+	t->writer = true;
+	t->size = LIVE_SIZE;
+	if (t->name == NULL || ftruncate(t->handle, t->size) != 0) {
+		// LCOV_EXCL_START
+		const int err = errno;
+		live_destroy(t);
+		errno = err;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	void *map = mmap(NULL, t->size, PROT_READ | PROT_WRITE, MAP_SHARED, t->handle, 0);
+	if (map == MAP_FAILED) {
+		// LCOV_EXCL_START
+		const int err = errno;
+		live_destroy(t);
+		errno = err;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	t->header = map;
+	t->active = (_Atomic uint8_t *)((uint8_t *)map + LIVE_HEADER_SIZE);
+	t->entries = (live_entry *)((uint8_t *)map + LIVE_TABLE_OFFSET);
+
+	// New object is zero filled, so only the header needs to be set
+	live_header *h = t->header;
+	h->version = LIVE_VERSION;
+	h->headerSize = LIVE_HEADER_SIZE;
+	h->tableOffset = LIVE_TABLE_OFFSET;
+	h->entrySize = sizeof(live_entry);
+	h->entries = LIVE_ENTRIES;
+	h->pid = getpid();
+	h->clock = clock;
+	atomic_store(&h->state, 1);
+	// Readers check the identifier last, so set it once all else is ready
+	atomic_thread_fence(memory_order_release);
+	memcpy(h->magic, live_magic, sizeof(live_magic));
+	return true;
+}
+
+/*!
+ * Called by the writer for each message. Numeric values are stored directly;
+ * a string representation is only generated for other message types.
+ *
+ * Source name and channel map messages also update the names stored for the
+ * relevant channels.
+ *
+ * @param[in] t         Table handle (writer)
+ * @param[in] msg       Message
+ * @param[in] timestamp Current primary clock timestamp
+ */
+void live_update(live_table *t, const msg_t *msg, uint32_t timestamp) {
+	if (t == NULL || !t->writer || t->header == NULL || msg == NULL) { return; }
+	if (msg->source >= 128 || msg->type >= 128) { return; }
+
+	if (msg->source == t->header->clock && msg->type == SLCHAN_TSTAMP &&
+	    msg->dtype == MSG_TIMESTAMP) {
+		struct timespec now = {0};
+		clock_gettime(CLOCK_REALTIME, &now);
+		live_write_begin(&t->header->seq);
+		t->header->timestamp = msg->data.timestamp;
+		t->header->updated = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+		live_write_end(&t->header->seq);
+	}
+
+	const size_t ix = (msg->source * 128) + msg->type;
+	live_entry *e = &t->entries[ix];
+	int len = 0;
+	live_write_begin(&e->seq);
+	e->count++;
+	e->timestamp = timestamp;
+	e->dtype = msg->dtype;
+	switch (msg->dtype) {
+		case MSG_FLOAT:
+			e->value = msg->data.value;
+			e->length = 0;
+			e->text[0] = '\0';
+			break;
+		case MSG_TIMESTAMP:
+			e->value = msg->data.timestamp;
+			e->length = 0;
+			e->text[0] = '\0';
+			break;
+		case MSG_STRING:
+			e->value = NAN;
+			e->length = live_copy_string(e->text, LIVE_TEXT_SIZE, msg->data.string.data,
+			                             msg->data.string.length);
+			break;
+		default:
+			e->value = NAN;
+			len = msg_data_format(msg, e->text, LIVE_TEXT_SIZE);
+			if (len < 0) {
+				e->text[0] = '\0';
+				e->length = 0;
+			} else {
+				e->length = (len < LIVE_TEXT_SIZE) ? len : LIVE_TEXT_SIZE - 1;
+			}
+			break;
+	}
+	if (msg->type == SLCHAN_NAME && msg->dtype == MSG_STRING) {
+		live_copy_string(e->name, LIVE_NAME_SIZE, msg->data.string.data,
+		                 msg->data.string.length);
+	}
+	live_write_end(&e->seq);
+
+	if (msg->type == SLCHAN_MAP && msg->dtype == MSG_STRARRAY) {
+		const strarray *sa = &msg->data.names;
+		for (int c = 0; c < sa->entries && c < 128; c++) {
+			if (c == SLCHAN_NAME || c == SLCHAN_MAP) { continue; }
+			live_entry *ce = &t->entries[(msg->source * 128) + c];
+			live_write_begin(&ce->seq);
+			live_copy_string(ce->name, LIVE_NAME_SIZE, sa->strings[c].data,
+			                 sa->strings[c].length);
+			live_write_end(&ce->seq);
+		}
+	}
+
+	const uint8_t bit = 1 << (ix % 8);
+	if (!(atomic_load_explicit(&t->active[ix / 8], memory_order_relaxed) & bit)) {
+		atomic_fetch_or_explicit(&t->active[ix / 8], bit, memory_order_release);
+	}
+}
+
+/*!
+ * For tables created with live_create(), the table is marked as stopped
+ * before the shared memory object is removed. Readers that already have the
+ * table open can continue to read the final values.
+ *
+ * For tables opened with live_open(), this is equivalent to live_close().
+ *
+ * @param[in] t Table handle
+ */
+void live_destroy(live_table *t) {
+	if (t == NULL) { return; }
+	if (t->writer) {
+		if (t->header) { atomic_store(&t->header->state, 0); }
+		if (t->name) { shm_unlink(t->name); }
+	}
+	live_close(t);
+}
+
+/*!
+ * @param[out] t    Table handle
+ * @param[in]  name Shared memory object name
+ * @returns True on success, false if the table does not exist or is invalid (errno set)
+ */
+bool live_open(live_table *t, const char *name) {
+	if (t == NULL || name == NULL) {
+		errno = EINVAL;
+		return false;
+	}
+	*t = (live_table){.handle = -1};
+	t->handle = shm_open(name, O_RDONLY, 0);
+	if (t->handle < 0) { return false; }
+
+	struct stat st = {0};
+	if (fstat(t->handle, &st) != 0 || (size_t)st.st_size < LIVE_SIZE) {
+		live_close(t);
+		errno = EINVAL;
+		return false;
+	}
+	t->size = LIVE_SIZE;
+	void *map = mmap(NULL, t->size, PROT_READ, MAP_SHARED, t->handle, 0);
+	if (map == MAP_FAILED) {
+		// LCOV_EXCL_START
+		const int err = errno;
+		t->size = 0;
+		live_close(t);
+		errno = err;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	t->header = map;
+	t->active = (_Atomic uint8_t *)((uint8_t *)map + LIVE_HEADER_SIZE);
+	t->entries = (live_entry *)((uint8_t *)map + LIVE_TABLE_OFFSET);
+
+	const live_header *h = t->header;
+	const bool valid = memcmp(h->magic, live_magic, sizeof(live_magic)) == 0;
+	atomic_thread_fence(memory_order_acquire);
+	if (!valid || h->version != LIVE_VERSION || h->entrySize != sizeof(live_entry) ||
+	    h->tableOffset != LIVE_TABLE_OFFSET || h->entries != LIVE_ENTRIES) {
+		live_close(t);
+		errno = EINVAL;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * @param[in] t       Table handle
+ * @param[in] source  Source ID
+ * @param[in] channel Channel ID
+ * @returns True if at least one message has been recorded for this channel
+ */
+bool live_active(const live_table *t, uint8_t source, uint8_t channel) {
+	if (t == NULL || t->active == NULL || source >= 128 || channel >= 128) { return false; }
+	const size_t ix = (source * 128) + channel;
+	return atomic_load_explicit(&t->active[ix / 8], memory_order_acquire) & (1 << (ix % 8));
+}
+
+/*!
+ * Retries until a copy is made without the entry being modified part way
+ * through. As the writer updates each entry in a few hundred nanoseconds at
+ * most, this will rarely need more than one attempt.
+ *
+ * If no consistent copy can be made within LIVE_READ_RETRIES attempts, errno
+ * is set to EAGAIN and false is returned. Use live_running() to check
+ * whether the writer is still active before trying again.
+ *
+ * @param[in]  t       Table handle
+ * @param[in]  source  Source ID
+ * @param[in]  channel Channel ID
+ * @param[out] out     Copy of entry
+ * @returns True if entry is active and copied successfully
+ */
+bool live_read(const live_table *t, uint8_t source, uint8_t channel, live_value *out) {
+	if (out == NULL || !live_active(t, source, channel)) { return false; }
+	live_entry *e = &t->entries[(source * 128) + channel];
+	live_entry copy;
+	uint32_t s1 = 0;
+	uint32_t s2 = 0;
+	int tries = 0;
+	do {
+		if (tries++ >= LIVE_READ_RETRIES) {
+			errno = EAGAIN;
+			return false;
+		}
+		s1 = atomic_load_explicit(&e->seq, memory_order_acquire);
+		if (s1 & 1) { continue; }
+		memcpy(&copy, e, sizeof(live_entry));
+		atomic_thread_fence(memory_order_acquire);
+		s2 = atomic_load_explicit(&e->seq, memory_order_relaxed);
+	} while ((s1 & 1) || s1 != s2);
+
+	out->count = copy.count;
+	out->timestamp = copy.timestamp;
+	out->dtype = copy.dtype;
+	out->value = copy.value;
+	memcpy(out->text, copy.text, LIVE_TEXT_SIZE);
+	out->text[LIVE_TEXT_SIZE - 1] = '\0';
+	memcpy(out->name, copy.name, LIVE_NAME_SIZE);
+	out->name[LIVE_NAME_SIZE - 1] = '\0';
+	return true;
+}
+
+/*!
+ * @param[in]  t         Table handle
+ * @param[out] timestamp Most recent primary clock timestamp (may be NULL)
+ * @param[out] updated   Wall clock time at which timestamp received (ms since Unix epoch, may be NULL)
+ * @returns True on success, false if the header could not be read (errno set
+ * to EAGAIN if it remained locked for LIVE_READ_RETRIES attempts)
+ */
+bool live_timestamp(const live_table *t, uint32_t *timestamp, uint64_t *updated) {
+	if (t == NULL || t->header == NULL) { return false; }
+	live_header *h = t->header;
+	uint32_t s1 = 0;
+	uint32_t s2 = 0;
+	uint32_t ts = 0;
+	uint64_t up = 0;
+	int tries = 0;
+	do {
+		if (tries++ >= LIVE_READ_RETRIES) {
+			errno = EAGAIN;
+			return false;
+		}
+		s1 = atomic_load_explicit(&h->seq, memory_order_acquire);
+		if (s1 & 1) { continue; }
+		ts = h->timestamp;
+		up = h->updated;
+		atomic_thread_fence(memory_order_acquire);
+		s2 = atomic_load_explicit(&h->seq, memory_order_relaxed);
+	} while ((s1 & 1) || s1 != s2);
+	if (timestamp) { *timestamp = ts; }
+	if (updated) { *updated = up; }
+	return true;
+}
+
+/*!
+ * @param[in] t Table handle
+ * @returns True if the writer has not marked the table as stopped
+ */
+bool live_running(const live_table *t) {
+	if (t == NULL || t->header == NULL) { return false; }
+	return atomic_load(&t->header->state) == 1;
+}
+
+/*!
+ * @param[in] t Table handle
+ */
+void live_close(live_table *t) {
+	if (t == NULL) { return; }
+	if (t->header && t->size > 0) { munmap(t->header, t->size); }
+	if (t->handle >= 0) { close(t->handle); }
+	free(t->name);
+	*t = (live_table){.handle = -1};
+}
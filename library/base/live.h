@@ -0,0 +1,175 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELKIELoggerBase_Live
+#define SELKIELoggerBase_Live
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "messages.h"
+
+/*!
+ * @file live.h Shared memory table of most recent values
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup live Live value table
+ * @ingroup SELKIELoggerBase
+ *
+ * A fixed size table, published as a POSIX shared memory object, holding the
+ * most recent value, timestamp and message count for each source and
+ * channel, along with the channel names. This allows other processes on the
+ * same system to monitor current values without reading or parsing files.
+ *
+ * The table has a single writer. Each entry is protected by a sequence
+ * counter: the writer increments the counter before and after modifying the
+ * entry, so readers copy the entry and retry if the counter was odd or
+ * changed during the copy. Readers never block the writer, and give up after
+ * LIVE_READ_RETRIES attempts so that a writer that exits mid-update cannot
+ * leave them waiting forever.
+ *
+ * The layout is fixed so that the table can also be read directly from
+ * other languages (see SLFiles.py). All values use native byte order:
+ *
+ * | Offset            | Size                  | Contents                      |
+ * |-------------------|-----------------------|-------------------------------|
+ * | 0                 | LIVE_HEADER_SIZE      | live_header                   |
+ * | LIVE_HEADER_SIZE  | LIVE_ENTRIES / 8      | Active entry bitmap           |
+ * | LIVE_TABLE_OFFSET | LIVE_ENTRIES * 128    | live_entry table              |
+ *
+ * The entry for source S and channel C is at index (S * 128) + C.
+ * @{
+ */
+
+//! Default shared memory object name
+#define LIVE_DEFAULT_NAME "/SELKIELogger"
+
+//! Table format version
+#define LIVE_VERSION 1
+
+//! Number of entries in table (128 sources x 128 channels)
+#define LIVE_ENTRIES (128 * 128)
+
+//! Size of header
+#define LIVE_HEADER_SIZE 64
+
+//! Offset of first entry from start of table
+#define LIVE_TABLE_OFFSET 4096
+
+//! Maximum length of string representation stored for each value, including terminating null
+#define LIVE_TEXT_SIZE 72
+
+//! Maximum length of channel name, including terminating null
+#define LIVE_NAME_SIZE 32
+
+/*!
+ * @brief Maximum attempts to read an entry before giving up
+ *
+ * An entry can only remain locked for longer than this if the writer stopped
+ * part way through an update.
+ */
+#define LIVE_READ_RETRIES 10000
+
+//! Header at start of table
+typedef struct {
+	char magic[8];          //!< "SLLIVE" (null padded)
+	uint32_t version;       //!< LIVE_VERSION
+	uint32_t headerSize;    //!< LIVE_HEADER_SIZE
+	uint32_t tableOffset;   //!< LIVE_TABLE_OFFSET
+	uint32_t entrySize;     //!< sizeof(live_entry)
+	uint32_t entries;       //!< LIVE_ENTRIES
+	uint32_t pid;           //!< Process ID of writer
+	_Atomic uint32_t seq;   //!< Sequence counter protecting following fields
+	uint32_t timestamp;     //!< Most recent primary clock timestamp
+	uint64_t updated;       //!< Wall clock time timestamp was received (ms since Unix epoch)
+	_Atomic uint32_t state; //!< 1 while writer active, 0 once stopped
+	uint8_t clock;          //!< Primary clock source ID
+	uint8_t reserved[11];   //!< Reserved (0)
+} live_header;
+
+//! Table entry for a single source and channel
+typedef struct {
+	_Atomic uint32_t seq;          //!< Sequence counter (odd while entry is being updated)
+	uint32_t count;                //!< Number of messages received
+	uint32_t timestamp;            //!< Primary clock timestamp at which last message received
+	uint8_t dtype;                 //!< Data type of last message (msg_dtype_t)
+	uint8_t reserved;              //!< Reserved (0)
+	uint16_t length;               //!< Length of string in text
+	double value;                  //!< Numeric value (float and timestamp messages), or NaN
+	char text[LIVE_TEXT_SIZE];     //!< String representation of value (may be truncated)
+	char name[LIVE_NAME_SIZE];     //!< Channel name, if known
+} live_entry;
+
+//! Shared memory table handle (writer or reader)
+typedef struct {
+	int handle;               //!< Shared memory file descriptor
+	char *name;               //!< Shared memory object name
+	bool writer;              //!< True if this process created the table
+	size_t size;              //!< Size of mapping
+	live_header *header;      //!< Mapped header
+	_Atomic uint8_t *active;  //!< Mapped active entry bitmap
+	live_entry *entries;      //!< Mapped entries
+} live_table;
+
+//! Copy of a single table entry, as returned to readers
+typedef struct {
+	uint32_t count;               //!< Number of messages received
+	uint32_t timestamp;           //!< Primary clock timestamp at which last message received
+	msg_dtype_t dtype;            //!< Data type of last message
+	double value;                 //!< Numeric value, or NaN
+	char text[LIVE_TEXT_SIZE];    //!< String representation of value
+	char name[LIVE_NAME_SIZE];    //!< Channel name, if known
+} live_value;
+
+//! Size of shared memory object
+#define LIVE_SIZE (LIVE_TABLE_OFFSET + LIVE_ENTRIES * sizeof(live_entry))
+
+//! Create and map a new table for writing
+bool live_create(live_table *t, const char *name, uint8_t clock);
+
+//! Record a message in the table
+void live_update(live_table *t, const msg_t *msg, uint32_t timestamp);
+
+//! Mark table as no longer updated, then unmap and remove it
+void live_destroy(live_table *t);
+
+//! Map an existing table for reading
+bool live_open(live_table *t, const char *name);
+
+//! Check whether an entry has been written
+bool live_active(const live_table *t, uint8_t source, uint8_t channel);
+
+//! Read a consistent copy of an entry
+bool live_read(const live_table *t, uint8_t source, uint8_t channel, live_value *out);
+
+//! Read most recent primary clock timestamp
+bool live_timestamp(const live_table *t, uint32_t *timestamp, uint64_t *updated);
+
+//! Check whether writer is still running
+bool live_running(const live_table *t);
+
+//! Unmap table opened with live_open()
+void live_close(live_table *t);
+//! @}
+#endif
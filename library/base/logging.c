@@ -167,11 +167,26 @@ void log_info(const program_state *s, const int level, const char *format, ...)
  * @returns Opened file handle, or null on failure
  */
 FILE *openSerialNumberedFile(const char *prefix, const char *extension, char **name) {
-	time_t now = time(NULL);
-	struct tm *tm = localtime(&now);
+	return openSerialNumberedFileAt(prefix, extension, name, time(NULL));
+}
+
+/*!
+ * As openSerialNumberedFile(), but the date used in the file name is taken
+ * from `when` rather than the current time. Used to create files in advance.
+ *
+ * @param[in] prefix    File name prefix (can include a path)
+ * @param[in] extension File extension
+ * @param[out] name     File name (without extension) used, if successful
+ * @param[in] when      Time used to generate date portion of file name
+ * @returns Opened file handle, or null on failure
+ */
+FILE *openSerialNumberedFileAt(const char *prefix, const char *extension, char **name,
+                               time_t when) {
+	struct tm tm = {0};
+	localtime_r(&when, &tm);
 	char *fileName = NULL;
 	char date[9];
-	strftime(date, 9, "%Y%m%d", tm);
+	strftime(date, 9, "%Y%m%d", &tm);
 
 	int i = 0;
 	FILE *file = NULL;
@@ -23,6 +23,7 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <time.h>
 
 /*!
  * @file logging.h Output logging and file handling functions
@@ -58,6 +59,10 @@ void log_info(const program_state *s, const int level, const char *format, ...)
 //! Open dated, serial numbered file with given prefix and extension
 FILE *openSerialNumberedFile(const char *prefix, const char *extension, char **name);
 
+//! Open serial numbered file with given prefix and extension, dated for a specified time
+FILE *openSerialNumberedFileAt(const char *prefix, const char *extension, char **name,
+                               time_t when);
+
 //! Cleanly destroy program state
 void destroy_program_state(program_state *s);
 //!@}
@@ -19,12 +19,80 @@
 */
 
 #include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "latency.h"
 #include "messages.h"
+#include "pool.h"
+
+/*!
+ * Uses the message pool if enabled, otherwise falls back to calloc(). The
+ * creation time is recorded if enabled (see lat_stamp_enable()).
+ *
+ * Intended for sources that decode data directly into a message structure,
+ * rather than creating messages with the msg_new functions. The message must
+ * be released with msg_free().
+ *
+ * @return Pointer to zeroed message structure, or NULL on failure
+ */
+msg_t *msg_alloc(void) {
+	msg_t *m = pool_alloc(sizeof(msg_t));
+	if (m) {
+		*m = (msg_t){.flags = MSG_FLAG_POOLED};
+	} else {
+		m = calloc(1, sizeof(msg_t));
+		if (m == NULL) { return NULL; }
+	}
+	m->created = lat_stamp_now();
+	return m;
+}
+
+/*!
+ * Small payloads are stored within the message itself. Larger payloads use
+ * the message pool if enabled, otherwise falling back to calloc(). The
+ * message flags are updated so that msg_destroy() can release the storage
+ * correctly.
+ *
+ * Only suitable for MSG_BYTES and MSG_NUMARRAY payloads. The message may be
+ * allocated by any means, but must have been zero initialised.
+ *
+ * @param[in] msg Message that will own the storage
+ * @param[in] len Number of bytes required
+ * @return Pointer to storage, or NULL on failure
+ */
+void *msg_alloc_data(msg_t *msg, size_t len) {
+	if (len <= MSG_INLINE_SIZE) {
+		msg->flags |= MSG_FLAG_INLINE;
+		return msg->inlineData;
+	}
+	void *d = pool_alloc(len);
+	if (d) {
+		msg->flags |= MSG_FLAG_POOLDATA;
+		return d;
+	}
+	return calloc(len, sizeof(uint8_t));
+}
+
+/*!
+ * Only needed if a payload is abandoned before the message is complete, as
+ * msg_destroy() releases the payload of a complete message.
+ *
+ * @param[in] msg  Message owning the storage
+ * @param[in] data Pointer to storage
+ */
+void msg_release_data(msg_t *msg, void *data) {
+	if (msg->flags & MSG_FLAG_POOLDATA) {
+		pool_free(data);
+	} else if (!(msg->flags & MSG_FLAG_INLINE)) {
+		free(data);
+	}
+	msg->flags &= ~(MSG_FLAG_POOLDATA | MSG_FLAG_INLINE);
+}
 
 /*!
  * Allocates a new msg_t, copies in the source, type and value and sets the data type to
@@ -36,7 +104,7 @@
  * @return Pointer to new message
  */
 msg_t *msg_new_float(const uint8_t source, const uint8_t type, const float val) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_FLOAT;
@@ -55,7 +123,7 @@ msg_t *msg_new_float(const uint8_t source, const uint8_t type, const float val)
  * @return Pointer to new message
  */
 msg_t *msg_new_timestamp(const uint8_t source, const uint8_t type, const uint32_t ts) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_TIMESTAMP;
@@ -82,14 +150,14 @@ msg_t *msg_new_timestamp(const uint8_t source, const uint8_t type, const uint32_
  * @return Pointer to new message, NULL on failure
  */
 msg_t *msg_new_string(const uint8_t source, const uint8_t type, const size_t len, const char *str) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_STRING;
 	newmsg->length = len;
 	if (!str_update(&(newmsg->data.string), len, str)) {
 		// LCOV_EXCL_START
-		free(newmsg);
+		msg_free(newmsg);
 		return NULL;
 		// LCOV_EXCL_STOP
 	}
@@ -114,14 +182,14 @@ msg_t *msg_new_string(const uint8_t source, const uint8_t type, const size_t len
  * @return Pointer to new message, NULL on failure
  */
 msg_t *msg_new_string_array(const uint8_t source, const uint8_t type, const strarray *array) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_STRARRAY;
 	newmsg->length = array->entries;
 	if (!sa_copy(&(newmsg->data.names), array)) {
 		// LCOV_EXCL_START
-		free(newmsg);
+		msg_free(newmsg);
 		return NULL;
 		// LCOV_EXCL_STOP
 	}
@@ -145,17 +213,16 @@ msg_t *msg_new_string_array(const uint8_t source, const uint8_t type, const stra
  */
 
 msg_t *msg_new_bytes(const uint8_t source, const uint8_t type, const size_t len, const uint8_t *bytes) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_BYTES;
 	newmsg->length = len;
-	newmsg->data.bytes = calloc(len, sizeof(uint8_t));
+	newmsg->data.bytes = msg_alloc_data(newmsg, len);
 	errno = 0;
 	memcpy(newmsg->data.bytes, bytes, len);
 	if (errno) {
-		free(newmsg->data.bytes);
-		free(newmsg);
+		msg_free(newmsg);
 		return NULL;
 	}
 	return newmsg;
@@ -174,17 +241,16 @@ msg_t *msg_new_bytes(const uint8_t source, const uint8_t type, const size_t len,
  * @return Pointer to new message
  */
 msg_t *msg_new_float_array(const uint8_t source, const uint8_t type, const size_t entries, const float *array) {
-	msg_t *newmsg = calloc(1, sizeof(msg_t));
+	msg_t *newmsg = msg_alloc();
 	newmsg->source = source;
 	newmsg->type = type;
 	newmsg->dtype = MSG_NUMARRAY;
 	newmsg->length = entries;
-	newmsg->data.farray = calloc(entries, sizeof(float));
+	newmsg->data.farray = msg_alloc_data(newmsg, entries * sizeof(float));
 	errno = 0;
 	memcpy(newmsg->data.farray, array, entries * sizeof(float));
 	if (errno) {
-		free(newmsg->data.farray);
-		free(newmsg);
+		msg_free(newmsg);
 		return NULL;
 	}
 	return newmsg;
@@ -222,48 +288,125 @@ char *msg_to_string(const msg_t *msg) {
 char *msg_data_to_string(const msg_t *msg) {
 	if (msg == NULL) { return NULL; }
 
-	char *out = NULL;
+	const int len = msg_data_format(msg, NULL, 0);
+	if (len < 0) { return NULL; } // LCOV_EXCL_LINE
+
+	char *out = calloc(len + 1, sizeof(char));
+	if (out == NULL) { return NULL; } // LCOV_EXCL_LINE
+	if (msg_data_format(msg, out, len + 1) != len) {
+		// LCOV_EXCL_START
+		free(out);
+		return NULL;
+		// LCOV_EXCL_STOP
+	}
+	return out;
+}
+
+/*!
+ * @brief Append formatted text to a fixed size buffer
+ *
+ * Behaves like snprintf(), except that pos tracks the total length of output
+ * generated so far, including any that did not fit in the buffer.
+ *
+ * @param[in]     buf Output buffer (may be NULL if len is 0)
+ * @param[in]     len Size of output buffer
+ * @param[in,out] pos Current output length
+ * @param[in]     fmt Format string
+ * @returns False on formatting error
+ */
+static bool msg_format_append(char *buf, size_t len, size_t *pos, const char *fmt, ...)
+	__attribute__((format(__printf__, 4, 5)));
+
+static bool msg_format_append(char *buf, size_t len, size_t *pos, const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
 	int rv = 0;
+	if (*pos < len) {
+		rv = vsnprintf(&(buf[*pos]), len - *pos, fmt, ap);
+	} else {
+		rv = vsnprintf(NULL, 0, fmt, ap);
+	}
+	va_end(ap);
+	if (rv < 0) { return false; } // LCOV_EXCL_LINE
+	*pos += rv;
+	return true;
+}
+
+/*!
+ * Generate string representation of message data into an existing buffer
+ *
+ * Used by msg_data_to_string(), and can be used directly where repeated
+ * allocations should be avoided. As with snprintf(), the output is truncated if the buffer is too small and
+ * the return value is the length of the full representation, so the caller
+ * can resize their buffer and try again.
+ *
+ * @param[in]  msg Message containing data to be represented
+ * @param[out] buf Output buffer (may be NULL if len is 0)
+ * @param[in]  len Size of output buffer, including terminating null
+ * @returns Length of string representation (excluding terminating null), or -1 on error
+ */
+int msg_data_format(const msg_t *msg, char *buf, size_t len) {
+	if (msg == NULL || (buf == NULL && len > 0)) { return -1; }
+	if (len > 0) { buf[0] = '\0'; }
+
+	size_t pos = 0;
+	bool ok = true;
+	bool trim = false; // Remove trailing separator from arrays
 	switch (msg->dtype) {
 		case MSG_FLOAT:
-			rv = asprintf(&out, "%.6f", msg->data.value);
+			ok = msg_format_append(buf, len, &pos, "%.6f", msg->data.value);
 			break;
 		case MSG_TIMESTAMP:
-			rv = asprintf(&out, "%09u", msg->data.timestamp);
+			ok = msg_format_append(buf, len, &pos, "%09u", msg->data.timestamp);
 			break;
 		case MSG_STRING:
-			rv = asprintf(&out, "%*s", (int)msg->data.string.length, msg->data.string.data);
+			ok = msg_format_append(buf, len, &pos, "%*s", (int)msg->data.string.length,
+			                       msg->data.string.data);
 			break;
 		case MSG_STRARRAY:
-			out = msg_data_sarr_to_string(msg);
-			if (out == NULL) { out = strdup("[String array - error converting to string]"); }
+			if (msg->data.names.entries <= 0) {
+				ok = msg_format_append(buf, len, &pos, "%s",
+				                       "[String array - error converting to string]");
+				break;
+			}
+			for (int i = 0; ok && i < msg->data.names.entries; i++) {
+				const string *str = &(msg->data.names.strings[i]);
+				if ((str->length == 0) || (str->data == NULL)) {
+					ok = msg_format_append(buf, len, &pos, "-/");
+				} else {
+					ok = msg_format_append(buf, len, &pos, "%s/", str->data);
+				}
+			}
+			trim = true;
 			break;
 		case MSG_BYTES:
-			rv = asprintf(&out, "[Binary data, %zd bytes]", msg->length);
+			ok = msg_format_append(buf, len, &pos, "[Binary data, %zd bytes]", msg->length);
 			break;
 		case MSG_NUMARRAY:
-			out = msg_data_narr_to_string(msg);
-			if (out == NULL) { out = strdup("[Numeric array - error converting to string]"); }
+			for (size_t i = 0; ok && i < msg->length; i++) {
+				ok = msg_format_append(buf, len, &pos, "%.4f/", msg->data.farray[i]);
+			}
+			trim = true;
 			break;
 		// LCOV_EXCL_START
 		case MSG_ERROR:
-			out = strdup("[Message flagged as error]");
+			ok = msg_format_append(buf, len, &pos, "%s", "[Message flagged as error]");
 			break;
 		case MSG_UNDEF:
-			out = strdup("[Message flagged as uninitialised]");
+			ok = msg_format_append(buf, len, &pos, "%s",
+			                       "[Message flagged as uninitialised]");
 			break;
 		default:
-			out = strdup("[Message type unknown]");
+			ok = msg_format_append(buf, len, &pos, "%s", "[Message type unknown]");
 			break;
 			// LCOV_EXCL_STOP
 	}
-	if (rv < 0) {
-		// LCOV_EXCL_START
-		if (out) { free(out); }
-		return NULL;
-		// LCOV_EXCL_STOP
+	if (!ok) { return -1; } // LCOV_EXCL_LINE
+	if (trim && pos > 0) {
+		pos--;
+		if (pos < len) { buf[pos] = '\0'; }
 	}
-	return out;
+	return pos;
 }
 
 /*!
@@ -363,10 +506,12 @@ void msg_destroy(msg_t *msg) {
 			sa_destroy(&(msg->data.names));
 			break;
 		case MSG_BYTES:
-			free(msg->data.bytes);
+			msg_release_data(msg, msg->data.bytes);
+			msg->data.bytes = NULL;
 			break;
 		case MSG_NUMARRAY:
-			free(msg->data.farray);
+			msg_release_data(msg, msg->data.farray);
+			msg->data.farray = NULL;
 			break;
 		// LCOV_EXCL_START
 		default:
@@ -376,4 +521,47 @@ void msg_destroy(msg_t *msg) {
 	}
 	msg->length = 0;
 	msg->dtype = MSG_UNDEF;
+	msg->flags &= ~(MSG_FLAG_POOLDATA | MSG_FLAG_INLINE);
+}
+
+/*!
+ * Destroys the message data with msg_destroy(), then releases the message
+ * itself using either free() or pool_free() as appropriate.
+ *
+ * This should be used in preference to calling free() directly for any
+ * message created by the msg_new functions.
+ *
+ * If other references to the message are held (see msg_retain()), the
+ * reference count is decremented and the message is left intact.
+ *
+ * @param[in] msg Message to be freed
+ */
+void msg_free(msg_t *msg) {
+	if (msg == NULL) { return; }
+	// Messages with a single owner skip the atomic decrement
+	if (atomic_load_explicit(&(msg->refs), memory_order_acquire) > 0 &&
+	    atomic_fetch_sub_explicit(&(msg->refs), 1, memory_order_acq_rel) > 0) {
+		return;
+	}
+	msg_destroy(msg);
+	if (msg->flags & MSG_FLAG_POOLED) {
+		pool_free(msg);
+	} else {
+		free(msg);
+	}
+}
+
+/*!
+ * Allows a message to be handed to another thread while the caller continues
+ * to use it. The message contents must not be modified while shared.
+ *
+ * Each reference taken must be released with msg_free().
+ *
+ * @param[in] msg Message
+ * @return msg, for convenience
+ */
+msg_t *msg_retain(msg_t *msg) {
+	if (msg == NULL) { return NULL; }
+	atomic_fetch_add_explicit(&(msg->refs), 1, memory_order_relaxed);
+	return msg;
 }
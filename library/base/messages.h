@@ -21,6 +21,7 @@
 #ifndef SELKIELoggerBase_Messages
 #define SELKIELoggerBase_Messages
 #include "strarray.h"
+#include <stdatomic.h>
 #include <stdint.h>
 
 /*!
@@ -63,19 +64,56 @@ typedef enum {
 	MSG_NUMARRAY,   //!< Array of floating point values
 } msg_dtype_t;
 
+//! Message header allocated from pool, release with pool_free()
+#define MSG_FLAG_POOLED 0x01
+
+//! Message data (bytes or farray) allocated from pool, release with pool_free()
+#define MSG_FLAG_POOLDATA 0x02
+
+//! Message data (bytes or farray) stored in msg_t.inlineData, no release required
+#define MSG_FLAG_INLINE 0x04
+
+//! Largest bytes or farray payload stored directly within a message
+#define MSG_INLINE_SIZE 64
+
 //! Queuable message
 
 /*!
  * Designed to be flexible mapping between multiple sources and data types.
+ *
+ * Messages created with the msg_new functions may be allocated from the
+ * message pool (see pool.h), so should be released with msg_free() rather
+ * than msg_destroy() and free().
+ *
+ * Small MSG_BYTES and MSG_NUMARRAY payloads (up to MSG_INLINE_SIZE bytes) are
+ * stored in msg_t.inlineData, with data.bytes or data.farray pointing into
+ * the message itself. These messages must not be copied by value.
+ *
+ * A message can be shared between threads by taking an additional reference
+ * with msg_retain(). Each holder then calls msg_free() when finished, and the
+ * message is only released by the last of these calls.
  */
 typedef struct {
 	uint8_t source;    //!< Maps to a specific sensor unit or data source
 	uint8_t type;      //!< Message type. Common types to be documented
+	uint8_t flags;     //!< Allocation details (MSG_FLAG_*), managed by msg_new functions
 	size_t length;     //!< Data type dependent, see the msg_new functions.
 	msg_dtype_t dtype; //!< Embedded data type
 	msg_data_t data;   //!< Embedded data
+	uint64_t created;  //!< Creation time (monotonic, ns) if enabled with lat_stamp_enable(), otherwise 0
+	atomic_uint refs;  //!< Number of additional references held (see msg_retain())
+	_Alignas(8) uint8_t inlineData[MSG_INLINE_SIZE]; //!< Storage for small payloads
 } msg_t;
 
+//! Allocate a new, empty, message (from the message pool if enabled)
+msg_t *msg_alloc(void);
+
+//! Allocate storage for a bytes or float array payload owned by a message
+void *msg_alloc_data(msg_t *msg, size_t len);
+
+//! Release payload storage allocated with msg_alloc_data()
+void msg_release_data(msg_t *msg, void *data);
+
 //! Create new message with a single numeric value
 msg_t *msg_new_float(const uint8_t source, const uint8_t type, const float val);
 
@@ -100,6 +138,9 @@ char *msg_to_string(const msg_t *msg);
 //! Generate string representation of message data
 char *msg_data_to_string(const msg_t *msg);
 
+//! Generate string representation of message data in existing buffer
+int msg_data_format(const msg_t *msg, char *buf, size_t len);
+
 //! Convert numerical array to string
 char *msg_data_narr_to_string(const msg_t *msg);
 
@@ -108,5 +149,11 @@ char *msg_data_sarr_to_string(const msg_t *msg);
 
 //! Destroy a message
 void msg_destroy(msg_t *msg);
+
+//! Destroy a message and free the message itself
+void msg_free(msg_t *msg);
+
+//! Take an additional reference to a message
+msg_t *msg_retain(msg_t *msg);
 //! @}
 #endif
@@ -0,0 +1,406 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+//! Marker used to check that blocks passed to pool_free() came from the pool
+#define POOL_MAGIC 0x534C504FU
+
+//! Alignment (and minimum size) of blocks and slabs
+#define POOL_ALIGN 64
+
+/*!
+ * @brief Header stored in front of each block
+ *
+ * Padded to 16 bytes so that the usable area of each block keeps the same
+ * alignment as memory returned by malloc().
+ */
+typedef struct {
+	uint32_t magic;    //!< Always POOL_MAGIC for pool blocks
+	uint32_t cls;      //!< Size class index
+	uint64_t reserved; //!< Padding
+} pool_block;
+
+//! Fixed size stack of free blocks, exchanged between threads via the depot
+typedef struct pool_magazine {
+	struct pool_magazine *next;   //!< Next magazine in depot list
+	size_t count;                 //!< Number of blocks held
+	void *blocks[POOL_MAGAZINE];  //!< Free blocks
+} pool_magazine;
+
+//! Header for each slab of blocks, used to release memory in pool_destroy()
+typedef struct pool_slab {
+	struct pool_slab *next; //!< Next slab allocated for this class
+} pool_slab;
+
+//! Shared depot for a single size class
+typedef struct {
+	pthread_mutex_t lock;  //!< Protects all other members
+	pool_magazine *full;   //!< Magazines containing free blocks
+	pool_magazine *empty;  //!< Spare empty magazines
+	pool_slab *slabs;      //!< All slabs allocated for this class
+	pool_class_stats stats; //!< Statistics, updated when threads visit the depot
+} pool_class;
+
+//! Per-thread magazines and statistics not yet added to the depot totals
+typedef struct {
+	pool_magazine *mag[POOL_CLASSES]; //!< Current magazine for each class
+	uint64_t allocs[POOL_CLASSES];    //!< Allocations since last visit to depot
+	uint64_t frees[POOL_CLASSES];     //!< Frees since last visit to depot
+	bool registered;                  //!< Thread exit handler registered
+} pool_cache;
+
+//! Total block size, including header, for each size class
+static const size_t pool_block_sizes[POOL_CLASSES] = {64, 128, 256, 512, 1024, 4096};
+
+static pool_class pool_classes[POOL_CLASSES];       //!< Shared depots
+static atomic_bool pool_active = false;             //!< Set by pool_init()
+static atomic_uint_fast64_t pool_oversize = 0;      //!< Requests too large for pool
+static pthread_key_t pool_key;                      //!< Used to detect thread exit
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT; //!< Create pool_key once
+static __thread pool_cache pool_tc = {0};           //!< This thread's magazines
+
+/*!
+ * Add this thread's statistics to the depot totals.
+ *
+ * Class lock must be held by caller.
+ *
+ * @param[in] tc Thread cache
+ * @param[in] c  Size class index
+ */
+static void pool_flush_stats(pool_cache *tc, int c) {
+	pool_classes[c].stats.allocs += tc->allocs[c];
+	pool_classes[c].stats.frees += tc->frees[c];
+	tc->allocs[c] = 0;
+	tc->frees[c] = 0;
+}
+
+/*!
+ * Return a thread's magazines to the depot, so that any free blocks can be
+ * used by other threads.
+ *
+ * Registered as a thread specific data destructor, so is called automatically
+ * when a thread that has used the pool exits.
+ *
+ * @param[in] ptc Pointer to thread's pool_cache
+ */
+static void pool_thread_exit(void *ptc) {
+	pool_cache *tc = ptc;
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		pool_magazine *m = tc->mag[c];
+		tc->mag[c] = NULL;
+		if (!pool_active) {
+			free(m);
+			continue;
+		}
+		pool_class *pc = &(pool_classes[c]);
+		pthread_mutex_lock(&(pc->lock));
+		pool_flush_stats(tc, c);
+		if (m && m->count > 0) {
+			m->next = pc->full;
+			pc->full = m;
+		} else if (m) {
+			m->next = pc->empty;
+			pc->empty = m;
+		}
+		pthread_mutex_unlock(&(pc->lock));
+	}
+	tc->registered = false;
+}
+
+//! Create pool_key, called via pthread_once()
+static void pool_key_create(void) {
+	pthread_key_create(&pool_key, pool_thread_exit);
+}
+
+//! Ensure pool_thread_exit() will be called for the current thread
+static void pool_register(void) {
+	if (pool_tc.registered) { return; }
+	pthread_once(&pool_key_once, pool_key_create);
+	pthread_setspecific(pool_key, &pool_tc);
+	pool_tc.registered = true;
+}
+
+/*!
+ * @param[in] size Requested allocation size
+ * @return Smallest size class with a large enough usable area, or -1 if too large
+ */
+static int pool_class_for(size_t size) {
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		if (size <= (pool_block_sizes[c] - sizeof(pool_block))) { return c; }
+	}
+	return -1;
+}
+
+/*!
+ * Take an empty magazine from the depot, or allocate a new one.
+ *
+ * Class lock must be held by caller.
+ *
+ * @param[in] pc Size class depot
+ * @return Empty magazine, or NULL on allocation failure
+ */
+static pool_magazine *pool_empty_magazine(pool_class *pc) {
+	pool_magazine *m = pc->empty;
+	if (m) {
+		pc->empty = m->next;
+		m->next = NULL;
+		return m;
+	}
+	return calloc(1, sizeof(pool_magazine));
+}
+
+/*!
+ * Called when the current thread's magazine for a class is empty.
+ *
+ * If the depot has a magazine of free blocks, it is exchanged for the empty
+ * magazine. Otherwise a new slab is allocated and split into blocks.
+ *
+ * @param[in] c Size class index
+ * @return True if the current thread's magazine now contains free blocks
+ */
+static bool pool_refill(int c) {
+	pool_class *pc = &(pool_classes[c]);
+	pthread_mutex_lock(&(pc->lock));
+	pool_flush_stats(&pool_tc, c);
+	pool_magazine *cur = pool_tc.mag[c];
+
+	if (pc->full) {
+		pool_magazine *m = pc->full;
+		pc->full = m->next;
+		m->next = NULL;
+		if (cur) {
+			cur->next = pc->empty;
+			pc->empty = cur;
+		}
+		pool_tc.mag[c] = m;
+		pc->stats.depotSwaps++;
+		pthread_mutex_unlock(&(pc->lock));
+		return true;
+	}
+
+	if (cur == NULL) { cur = pool_empty_magazine(pc); }
+	const size_t bs = pool_block_sizes[c];
+	pool_slab *slab = aligned_alloc(POOL_ALIGN, POOL_ALIGN + (POOL_SLAB_BLOCKS * bs));
+	if (cur == NULL || slab == NULL) {
+		// LCOV_EXCL_START
+		perror("pool_refill");
+		free(slab);
+		pool_tc.mag[c] = cur;
+		pthread_mutex_unlock(&(pc->lock));
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	slab->next = pc->slabs;
+	pc->slabs = slab;
+	pc->stats.slabs++;
+
+	// Fill current magazine first, then add any remaining blocks to the depot
+	pool_magazine *m = cur;
+	for (size_t b = 0; b < POOL_SLAB_BLOCKS; b++) {
+		pool_block *blk = (pool_block *)((char *)slab + POOL_ALIGN + (b * bs));
+		blk->magic = POOL_MAGIC;
+		blk->cls = c;
+		if (m->count == POOL_MAGAZINE) {
+			if (m != cur) {
+				m->next = pc->full;
+				pc->full = m;
+			}
+			m = pool_empty_magazine(pc);
+			if (m == NULL) { break; } // LCOV_EXCL_LINE
+		}
+		m->blocks[m->count++] = blk;
+	}
+	if (m && m != cur) {
+		m->next = pc->full;
+		pc->full = m;
+	}
+	pool_tc.mag[c] = cur;
+	pthread_mutex_unlock(&(pc->lock));
+	return true;
+}
+
+/*!
+ * Must be called before any threads start using the pool. Until this is
+ * called, pool_alloc() will always return NULL.
+ *
+ * @return True on success, false if already initialised
+ */
+bool pool_init(void) {
+	if (pool_active) { return false; }
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		pool_class *pc = &(pool_classes[c]);
+		pthread_mutex_init(&(pc->lock), NULL);
+		pc->full = NULL;
+		pc->empty = NULL;
+		pc->slabs = NULL;
+		pc->stats = (pool_class_stats){.blockSize = pool_block_sizes[c] - sizeof(pool_block)};
+	}
+	pool_oversize = 0;
+	atomic_store(&pool_active, true);
+	return true;
+}
+
+/*!
+ * All slabs are released, so any blocks still allocated from the pool become
+ * invalid. All other threads using the pool must have exited before this is
+ * called.
+ */
+void pool_destroy(void) {
+	if (!pool_active) { return; }
+	atomic_store(&pool_active, false);
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		pool_class *pc = &(pool_classes[c]);
+		pthread_mutex_lock(&(pc->lock));
+		free(pool_tc.mag[c]);
+		pool_tc.mag[c] = NULL;
+		pool_tc.allocs[c] = 0;
+		pool_tc.frees[c] = 0;
+		pool_magazine *lists[2] = {pc->full, pc->empty};
+		for (int l = 0; l < 2; l++) {
+			pool_magazine *m = lists[l];
+			while (m) {
+				pool_magazine *next = m->next;
+				free(m);
+				m = next;
+			}
+		}
+		pool_slab *s = pc->slabs;
+		while (s) {
+			pool_slab *next = s->next;
+			free(s);
+			s = next;
+		}
+		pc->full = NULL;
+		pc->empty = NULL;
+		pc->slabs = NULL;
+		pthread_mutex_unlock(&(pc->lock));
+		pthread_mutex_destroy(&(pc->lock));
+	}
+}
+
+/*!
+ * @return True if pool_init() has been called and the pool not yet destroyed
+ */
+bool pool_enabled(void) {
+	return atomic_load_explicit(&pool_active, memory_order_relaxed);
+}
+
+/*!
+ * Memory returned by this function is not cleared, and must be released with
+ * pool_free(). It may be freed by a different thread to the one that
+ * allocated it.
+ *
+ * Returns NULL if the pool is not enabled or the requested size is larger
+ * than the largest size class, in which case the caller should fall back to
+ * malloc() or similar.
+ *
+ * @param[in] size Number of bytes required
+ * @return Pointer to block, or NULL
+ */
+void *pool_alloc(size_t size) {
+	if (!pool_enabled()) { return NULL; }
+	const int c = pool_class_for(size);
+	if (c < 0) {
+		atomic_fetch_add_explicit(&pool_oversize, 1, memory_order_relaxed);
+		return NULL;
+	}
+	pool_register();
+
+	pool_magazine *m = pool_tc.mag[c];
+	if (m == NULL || m->count == 0) {
+		if (!pool_refill(c)) { return NULL; } // LCOV_EXCL_LINE
+		m = pool_tc.mag[c];
+	}
+	pool_block *blk = m->blocks[--(m->count)];
+	pool_tc.allocs[c]++;
+	return blk + 1;
+}
+
+/*!
+ * The block is added to the calling thread's magazine for the relevant size
+ * class. If that magazine is full, it is moved to the depot so that the
+ * blocks can be reused by other threads.
+ *
+ * @param[in] ptr Pointer previously returned by pool_alloc()
+ */
+void pool_free(void *ptr) {
+	if (ptr == NULL) { return; }
+	pool_block *blk = ((pool_block *)ptr) - 1;
+	if (blk->magic != POOL_MAGIC || blk->cls >= POOL_CLASSES) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "pool_free called with invalid pointer\n");
+		return;
+		// LCOV_EXCL_STOP
+	}
+	const int c = blk->cls;
+	pool_register();
+
+	pool_magazine *m = pool_tc.mag[c];
+	if (m == NULL || m->count == POOL_MAGAZINE) {
+		pool_class *pc = &(pool_classes[c]);
+		pthread_mutex_lock(&(pc->lock));
+		pool_flush_stats(&pool_tc, c);
+		if (m) {
+			m->next = pc->full;
+			pc->full = m;
+			pc->stats.depotSwaps++;
+		}
+		m = pool_empty_magazine(pc);
+		pthread_mutex_unlock(&(pc->lock));
+		pool_tc.mag[c] = m;
+		if (m == NULL) {
+			// LCOV_EXCL_START
+			perror("pool_free");
+			return;
+			// LCOV_EXCL_STOP
+		}
+	}
+	m->blocks[m->count++] = blk;
+	pool_tc.frees[c]++;
+}
+
+/*!
+ * Allocation and free counts are gathered by each thread and added to the
+ * totals when that thread next exchanges magazines with the depot, so counts
+ * from other threads may lag by up to a magazine's worth of operations.
+ *
+ * @param[out] stats Statistics structure to be filled
+ */
+void pool_get_stats(pool_stats *stats) {
+	if (stats == NULL) { return; }
+	*stats = (pool_stats){0};
+	if (!pool_enabled()) { return; }
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		pool_class *pc = &(pool_classes[c]);
+		pthread_mutex_lock(&(pc->lock));
+		stats->classes[c] = pc->stats;
+		pthread_mutex_unlock(&(pc->lock));
+		stats->classes[c].allocs += pool_tc.allocs[c];
+		stats->classes[c].frees += pool_tc.frees[c];
+	}
+	stats->oversize = atomic_load(&pool_oversize);
+}
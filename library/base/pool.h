@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SELKIELoggerBase_Pool
+#define SELKIELoggerBase_Pool
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @file pool.h Pooled memory allocation for messages
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup pool Message memory pool
+ * @ingroup SELKIELoggerBase
+ *
+ * Messages are typically allocated by one thread and freed by another, and
+ * are short lived. This pool provides fixed size blocks in a small number of
+ * size classes, carved out of larger slabs that are never returned to the
+ * system.
+ *
+ * Each thread keeps a "magazine" of free blocks for each size class, so most
+ * allocations and frees do not need to take a lock. Full and empty
+ * magazines are exchanged with a shared depot when required, which is how
+ * blocks freed by the consuming thread make their way back to producers.
+ *
+ * The pool is disabled until pool_init() is called, and must only be
+ * destroyed once all threads using it have finished.
+ * @{
+ */
+
+//! Number of block size classes
+#define POOL_CLASSES 6
+
+//! Number of free blocks held in each per-thread magazine
+#define POOL_MAGAZINE 64
+
+//! Number of blocks allocated in each slab
+#define POOL_SLAB_BLOCKS 128
+
+//! Per size class allocation statistics
+typedef struct {
+	size_t blockSize;    //!< Usable size of each block in this class
+	uint64_t allocs;     //!< Number of blocks allocated
+	uint64_t frees;      //!< Number of blocks returned
+	uint64_t depotSwaps; //!< Number of magazines exchanged with the shared depot
+	uint64_t slabs;      //!< Number of slabs allocated from the system
+} pool_class_stats;
+
+//! Allocation statistics for whole pool
+typedef struct {
+	pool_class_stats classes[POOL_CLASSES]; //!< Statistics for each size class
+	uint64_t oversize; //!< Requests too large for any size class
+} pool_stats;
+
+//! Enable the message pool
+bool pool_init(void);
+
+//! Release all pool memory
+void pool_destroy(void);
+
+//! Check whether the pool has been initialised
+bool pool_enabled(void);
+
+//! Allocate a block of at least size bytes from the pool
+void *pool_alloc(size_t size);
+
+//! Return a block to the pool
+void pool_free(void *ptr);
+
+//! Retrieve current allocation statistics
+void pool_get_stats(pool_stats *stats);
+//! @}
+#endif
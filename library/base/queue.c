@@ -18,40 +18,82 @@
  *  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "messages.h"
 #include "queue.h"
 
 /*!
- * Will not re-initialise a queue if it is still valid or has a head or tail
- * value set. Other threads might be able to add entries to the queue between
- * the queue being marked valid and this function returning to the caller.
+ * Wrapper around queue_init_size(), using QUEUE_DEFAULT_CAPACITY.
  *
  * @param[in] queue Pointer to queue structure to be initialised
  * @return True on success, false otherwise
  */
 bool queue_init(msgqueue *queue) {
+	return queue_init_size(queue, QUEUE_DEFAULT_CAPACITY);
+}
+
+/*!
+ * Will not re-initialise a queue if it is still valid or has storage
+ * allocated.
+ *
+ * The requested capacity is rounded up to the next power of two, and all slot
+ * storage is allocated here so that no further allocation is required when
+ * pushing messages.
+ *
+ * @param[in] queue    Pointer to queue structure to be initialised
+ * @param[in] capacity Minimum number of messages the queue must be able to hold
+ * @return True on success, false otherwise
+ */
+bool queue_init_size(msgqueue *queue, size_t capacity) {
 	// Do not reinitialise valid or partially valid queue
-	if (queue->valid || queue->head || queue->tail) { return false; }
-	pthread_mutexattr_t ma = {0};
-	pthread_mutexattr_init(&ma);
-	pthread_mutexattr_settype(&ma, PTHREAD_MUTEX_ERRORCHECK);
-	pthread_mutex_init(&(queue->lock), &ma);
-	pthread_mutexattr_destroy(&ma);
-
-	if (pthread_mutex_lock(&(queue->lock))) {
+	if (queue->valid || queue->slots) { return false; }
+
+	size_t cap = 2;
+	while (cap < capacity) {
+		if (cap > (SIZE_MAX / 2)) { return false; } // LCOV_EXCL_LINE
+		cap <<= 1;
+	}
+
+	queueslot *slots = calloc(cap, sizeof(queueslot));
+	if (slots == NULL) {
 		// LCOV_EXCL_START
 		perror("queue_init");
 		return false;
 		// LCOV_EXCL_STOP
 	}
-	queue->head = NULL;
-	queue->tail = NULL;
-	queue->valid = true;
-	pthread_mutex_unlock(&(queue->lock));
-	return queue->valid;
+	for (size_t i = 0; i < cap; i++) {
+		atomic_init(&(slots[i].seq), i);
+		slots[i].item = NULL;
+	}
+
+	int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (efd < 0) {
+		// LCOV_EXCL_START
+		perror("queue_init");
+		free(slots);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	queue->slots = slots;
+	queue->wakefd = efd;
+	atomic_init(&(queue->sleeping), false);
+	queue->stamped = false;
+	queue->capacity = cap;
+	queue->mask = cap - 1;
+	atomic_init(&(queue->head), 0);
+	atomic_init(&(queue->tail), 0);
+	atomic_store(&(queue->valid), true);
+	return true;
 }
 
 /*!
@@ -59,173 +101,445 @@ bool queue_init(msgqueue *queue) {
  *
  * Any remaining items are removed from the queue and destroyed.
  *
+ * All producers must have stopped pushing to the queue before this is called.
+ *
  * @param[in] queue Pointer to queue structure to be destroyed
  */
 void queue_destroy(msgqueue *queue) {
-	queue->valid = false;
-	if (pthread_mutex_lock(&(queue->lock))) {
-		perror("queue_destroy"); //LCOV_EXCL_LINE
-		// Not returning, as we should still invalidate the queue
-		// Just means that we're already in an odd case
-	}
-	if (queue->head == NULL) {
-		// Queue is empty
-		// Tail should already be null, but set it just in case
-		queue->tail = NULL;
-		pthread_mutex_unlock(&(queue->lock));
-		pthread_mutex_destroy(&(queue->lock));
-		return;
-	}
-	queueitem *qi = queue->head;
-	while (qi) {
-		// Use message destroy to handle underlying storage
-		msg_destroy(qi->item);
-		free(qi->item);
-		qi->item = NULL;
-		queueitem *qin = qi->next;
-		free(qi);
-		qi = qin;
-	}
-	queue->head = NULL;
-	queue->tail = NULL;
-	pthread_mutex_unlock(&(queue->lock));
-	pthread_mutex_destroy(&(queue->lock));
-}
-
-/*!
- * Messages are wrapped into a queue item structure, and passed immediately to
- * queue_push_qi()
+	atomic_store(&(queue->valid), false);
+	if (queue->slots == NULL) { return; }
+
+	size_t pos = atomic_load(&(queue->head));
+	const size_t end = atomic_load(&(queue->tail));
+	while (pos != end) {
+		queueslot *s = &(queue->slots[pos & queue->mask]);
+		if (atomic_load(&(s->seq)) == pos + 1) {
+			// Use message destroy to handle underlying storage
+			msg_free(s->item);
+			s->item = NULL;
+		}
+		pos++;
+	}
+	free(queue->slots);
+	queue->slots = NULL;
+	close(queue->wakefd);
+	queue->wakefd = -1;
+	queue->capacity = 0;
+	queue->mask = 0;
+	atomic_store(&(queue->head), 0);
+	atomic_store(&(queue->tail), 0);
+}
+
+/*!
+ * @brief Arrival time stamp for queued messages
+ *
+ * Uses CLOCK_MONOTONIC, so that stamps from different queues can be compared
+ * without needing a shared counter.
+ *
+ * @return Current monotonic clock time in nanoseconds
+ */
+static uint64_t queue_stamp(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * @brief Wake consumer if blocked in queue_wait()
+ *
+ * Called by producers after publishing a message. The fence pairs with the
+ * one in queue_wait() so that either the consumer sees the new message before
+ * sleeping, or we see the sleeping flag here. Only the first producer to see
+ * the flag writes to the eventfd.
+ *
+ * @param[in] queue Pointer to queue
+ */
+static void queue_signal(msgqueue *queue) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!atomic_load_explicit(&(queue->sleeping), memory_order_relaxed)) { return; }
+	if (!atomic_exchange(&(queue->sleeping), false)) { return; }
+	const uint64_t one = 1;
+	// Failure here means the counter is already non-zero, so consumer will wake anyway
+	if (write(queue->wakefd, &one, sizeof(one)) < 0) { return; }
+}
+
+/*!
+ * @brief Check if a message is ready to be popped
+ *
+ * @param[in] queue Pointer to queue
+ * @return True if the next call to queue_pop() will return a message
+ */
+static bool queue_ready(const msgqueue *queue) {
+	const size_t pos = atomic_load_explicit(&(queue->head), memory_order_relaxed);
+	const queueslot *s = &(queue->slots[pos & queue->mask]);
+	const size_t seq = atomic_load_explicit(&(s->seq), memory_order_acquire);
+	return ((intptr_t)seq - (intptr_t)(pos + 1) >= 0);
+}
+
+/*!
+ * Producers claim a slot by advancing the queue tail, then publish the
+ * message by updating the slot sequence number.
  *
  * @param[in] queue Pointer to queue
  * @param[in] msg Pointer to message
- * @return Return value of queue_push_qi()
+ * @param[in] wait Wait for space if the queue is full
+ * @return True if message successfully appended to queue, false otherwise
  */
-bool queue_push(msgqueue *queue, msg_t *msg) {
-	queueitem *qi = calloc(1, sizeof(queueitem));
-	qi->item = msg;
-	if (queue_push_qi(queue, qi)) {
-		return true;
-	} else {
-		//LCOV_EXCL_START
-		free(qi);
-		return false;
-		//LCOV_EXCL_STOP
+static bool queue_append(msgqueue *queue, msg_t *msg, bool wait) {
+	if (msg == NULL || !queue->valid) { return false; }
+
+	unsigned int waits = 0;
+	size_t pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+	for (;;) {
+		queueslot *s = &(queue->slots[pos & queue->mask]);
+		const size_t seq = atomic_load_explicit(&(s->seq), memory_order_acquire);
+		const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			// Slot is free - try and claim it. On failure, pos is updated
+			// with the current tail value and we go around again
+			if (atomic_compare_exchange_weak_explicit(&(queue->tail), &pos, pos + 1,
+			                                          memory_order_relaxed,
+			                                          memory_order_relaxed)) {
+				s->item = msg;
+				if (queue->stamped) { s->stamp = queue_stamp(); }
+				atomic_store_explicit(&(s->seq), pos + 1, memory_order_release);
+				queue_signal(queue);
+				return true;
+			}
+		} else if (diff < 0) {
+			// Slot still holds a message from the previous lap: queue full
+			if (!wait || !queue->valid) { return false; }
+			if (waits++ < 64) {
+				sched_yield();
+			} else {
+				usleep(100);
+			}
+			pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+		} else {
+			// Another producer claimed this slot first
+			pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+		}
 	}
 }
 
 /*!
  * Will not append to an invalid queue.
  *
- * Once pushed to the queue, the queue owns the message embedded in `item` and
- * the caller should not destroy or free it. That will be handled in
- * queue_destroy() or the function responsible for consuming items out of the
- * queue.
+ * No locks are taken and no memory is allocated.
+ *
+ * If the queue is full, this function will wait for the consumer to free a
+ * slot rather than discarding the message. This only returns false if the
+ * queue is (or becomes) invalid. As it can wait indefinitely, it must not be
+ * called from the thread consuming the queue - use queue_try_push() instead.
+ *
+ * Once pushed to the queue, the queue owns the message and the caller should
+ * not destroy or free it. That will be handled in queue_destroy() or the
+ * function responsible for consuming items out of the queue.
  *
  * @param[in] queue Pointer to queue
- * @param[in] item  Pointer to a queue item
- * @return True if item successfully appended to queue, false otherwise
+ * @param[in] msg Pointer to message
+ * @return True if message successfully appended to queue, false otherwise
  */
-bool queue_push_qi(msgqueue *queue, queueitem *item) {
-	if (!queue->valid) { return false; }
+bool queue_push(msgqueue *queue, msg_t *msg) {
+	return queue_append(queue, msg, true);
+}
 
-	queueitem *qi = NULL;
+/*!
+ * As queue_push(), but returns false immediately if the queue is full.
+ *
+ * Intended for messages generated by the consumer of the queue itself, which
+ * would otherwise wait forever for space that only it can free. If this
+ * returns false, the message is still owned by the caller.
+ *
+ * @param[in] queue Pointer to queue
+ * @param[in] msg Pointer to message
+ * @return True if message appended to queue, false if full or invalid
+ */
+bool queue_try_push(msgqueue *queue, msg_t *msg) {
+	return queue_append(queue, msg, false);
+}
 
-	if (pthread_mutex_lock(&(queue->lock))) {
-		//LCOV_EXCL_START
-		perror("queue_push_qi");
-		return false;
-		//LCOV_EXCL_STOP
+/*!
+ * Adds all messages in `items` to the queue, in order, claiming a run of
+ * consecutive slots with a single update of the queue tail where possible.
+ * Messages from a single batch are therefore stored together, and a blocked
+ * consumer is only woken once per run of slots rather than once per message.
+ *
+ * If there isn't space for all of the messages, as many as possible are
+ * added and the remainder are added as space becomes available, so (as with
+ * queue_push()) this will wait while the queue is full.
+ *
+ * Messages added to the queue are no longer the responsibility of the
+ * caller. If the queue is invalidated part way through, or if any entry in
+ * `items` is NULL, the messages from `items[return value]` onwards are not
+ * added and must still be disposed of by the caller.
+ *
+ * @param[in] queue Pointer to queue
+ * @param[in] items Array of messages to add
+ * @param[in] n     Number of messages in items
+ * @return Number of messages added to queue
+ */
+size_t queue_push_batch(msgqueue *queue, msg_t **items, size_t n) {
+	if (items == NULL || !queue->valid) { return 0; }
+	for (size_t i = 0; i < n; i++) {
+		if (items[i] == NULL) { return 0; }
 	}
 
-	// If head is NULL, the queue is empty, so point head and tail at our
-	// queueitem, unlock the queue and return.
-	if (queue->head == NULL) {
-		queue->head = item;
-		queue->tail = item;
-		pthread_mutex_unlock(&(queue->lock));
-		return true;
-	}
+	size_t done = 0;
+	unsigned int waits = 0;
+	size_t pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+	while (done < n) {
+		// Slots behind the consumer's position have already been released
+		// (see queue_pop()), so this is a safe lower bound on free space
+		const size_t head = atomic_load_explicit(&(queue->head), memory_order_acquire);
+		const size_t used = pos - head;
+		if (used > queue->capacity) {
+			// Stale tail value, try again
+			pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+			continue;
+		}
+		size_t run = queue->capacity - used;
+		if (run == 0) {
+			// Queue full
+			if (!queue->valid) { break; }
+			if (waits++ < 64) {
+				sched_yield();
+			} else {
+				usleep(100);
+			}
+			pos = atomic_load_explicit(&(queue->tail), memory_order_relaxed);
+			continue;
+		}
+		if (run > (n - done)) { run = n - done; }
 
-	// If head wasn't empty, find the tail
-	qi = queue->tail;
-	if (qi) {
-		// There is a slim chance that tail wasn't up to date, so follow queued
-		// items all the way down
-		if (qi->next) {
-			// qi->next is valid, so can re-assign it to qi
-			// The new qi->next is either valid (so loop and
-			// reassign), or NULL and we fall out of the loop
-			do {
-				qi = qi->next;
-			} while (qi->next);
+		// On failure, pos is updated with the current tail value
+		if (!atomic_compare_exchange_weak_explicit(&(queue->tail), &pos, pos + run,
+		                                           memory_order_relaxed,
+		                                           memory_order_relaxed)) {
+			continue;
 		}
-		// Once we've run out of valid qi->next pointers, we make our new item the
-		// end of the queue
-		qi->next = item;
-	}
-	// Update the tail pointer so the next push should jump direct to the end
-	// Note that item is a pointer, so assigning it to qi->next and queue->tail is
-	// valid
-	queue->tail = item;
-	pthread_mutex_unlock(&(queue->lock));
+		const uint64_t stamp = queue->stamped ? queue_stamp() : 0;
+		for (size_t i = 0; i < run; i++) {
+			queueslot *s = &(queue->slots[(pos + i) & queue->mask]);
+			s->item = items[done + i];
+			if (queue->stamped) { s->stamp = stamp; }
+			atomic_store_explicit(&(s->seq), pos + i + 1, memory_order_release);
+		}
+		queue_signal(queue);
+		done += run;
+		pos += run;
+		waits = 0;
+	}
+	return done;
+}
+
+/*!
+ * Retained for compatibility with the earlier linked list queue. The message
+ * embedded in `item` is pushed using queue_push(), and the queue item
+ * structure itself is freed on success.
+ *
+ * @param[in] queue Pointer to queue
+ * @param[in] item  Pointer to a queue item
+ * @return True if item successfully appended to queue, false otherwise
+ */
+bool queue_push_qi(msgqueue *queue, queueitem *item) {
+	if (item == NULL) { return false; }
+	if (!queue_push(queue, item->item)) { return false; }
+	free(item);
 	return true;
 }
 
 /*!
- * Atomically remove the first entry in the queue and return it.
- * The underlying queue item is freed, but our caller must destroy and free the
- * message itself.
+ * Remove the first entry in the queue and return it.
  *
- * The queue item is freed, but the caller is responsible for destroying and
- * freeing the message itself after use (i.e. the caller now owns the message,
- * not the queue or the sending function).
+ * The caller is responsible for destroying and freeing the message itself
+ * after use (i.e. the caller now owns the message, not the queue or the
+ * sending function).
+ *
+ * ** This is only valid while a single thread is consuming items from the queue **
  *
  * @param[in] queue Pointer to queue
- * @return Pointer to previously queued message
+ * @return Pointer to previously queued message, or NULL if queue empty or invalid
  */
 msg_t *queue_pop(msgqueue *queue) {
-	int e = pthread_mutex_lock(&(queue->lock));
-	if (e != 0) {
-		//LCOV_EXCL_START
-		perror("queue_pop");
+	if (!queue->valid || queue->slots == NULL) { return NULL; }
+
+	const size_t pos = atomic_load_explicit(&(queue->head), memory_order_relaxed);
+	queueslot *s = &(queue->slots[pos & queue->mask]);
+	const size_t seq = atomic_load_explicit(&(s->seq), memory_order_acquire);
+	if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) {
+		// Empty, or next message not yet published
 		return NULL;
-		//LCOV_EXCL_STOP
 	}
-	queueitem *head = queue->head;
-	if (head == NULL || !queue->valid) {
-		// Empty or invalid queue
-		pthread_mutex_unlock(&(queue->lock));
-		return NULL;
+
+	msg_t *item = s->item;
+	s->item = NULL;
+	// Mark slot as free for the next lap around the ring
+	atomic_store_explicit(&(s->seq), pos + queue->capacity, memory_order_release);
+	atomic_store_explicit(&(queue->head), pos + 1, memory_order_release);
+	return item;
+}
+
+/*!
+ * Removes consecutive published messages from the head of the queue and
+ * stores them in `out`, in queue order. The queue head is only updated once,
+ * after all messages have been collected.
+ *
+ * As with queue_pop(), the caller takes ownership of all returned messages
+ * and this is only valid while a single thread is consuming from the queue.
+ *
+ * @param[in] queue Pointer to queue
+ * @param[out] out  Array of at least max message pointers
+ * @param[in] max   Maximum number of messages to remove
+ * @return Number of messages stored in out, 0 if queue empty or invalid
+ */
+size_t queue_pop_batch(msgqueue *queue, msg_t **out, size_t max) {
+	if (!queue->valid || queue->slots == NULL || out == NULL) { return 0; }
+
+	const size_t start = atomic_load_explicit(&(queue->head), memory_order_relaxed);
+	size_t n = 0;
+	while (n < max) {
+		const size_t pos = start + n;
+		queueslot *s = &(queue->slots[pos & queue->mask]);
+		const size_t seq = atomic_load_explicit(&(s->seq), memory_order_acquire);
+		if ((intptr_t)seq - (intptr_t)(pos + 1) < 0) {
+			// Empty, or next message not yet published
+			break;
+		}
+		out[n++] = s->item;
+		s->item = NULL;
+		atomic_store_explicit(&(s->seq), pos + queue->capacity, memory_order_release);
 	}
+	if (n > 0) { atomic_store_explicit(&(queue->head), start + n, memory_order_release); }
+	return n;
+}
 
-	msg_t *item = head->item;
-	queue->head = head->next;
+/*!
+ * Allocates an array large enough for all messages currently in the queue
+ * and fills it using queue_pop_batch(). Messages pushed after this function
+ * is called may or may not be included.
+ *
+ * The caller owns the returned messages and must free the array itself. If
+ * no messages were removed, `*out` is set to NULL.
+ *
+ * @param[in] queue Pointer to queue
+ * @param[out] out  Set to point to array of removed messages
+ * @return Number of messages removed from queue
+ */
+size_t queue_drain(msgqueue *queue, msg_t ***out) {
+	if (out == NULL) { return 0; }
+	*out = NULL;
 
-	head->next = NULL;
-	head->item = NULL;
-	if (queue->tail == head) { queue->tail = NULL; }
-	pthread_mutex_unlock(&(queue->lock));
-	// At this point we should have the only valid pointer to head
-	// ** This is only valid while a single thread is consuming items from the queue
-	// ** As with the explanation in queue_pop(), the cast keeps the compiler happy
-	free((struct queueitem *)head);
-	return item;
+	const int count = queue_count(queue);
+	if (count <= 0) { return 0; }
+
+	msg_t **items = calloc(count, sizeof(msg_t *));
+	if (items == NULL) {
+		// LCOV_EXCL_START
+		perror("queue_drain");
+		return 0;
+		// LCOV_EXCL_STOP
+	}
+
+	size_t n = queue_pop_batch(queue, items, count);
+	if (n == 0) {
+		free(items);
+		return 0;
+	}
+	*out = items;
+	return n;
 }
 
 /*!
+ * Calculated from the head and tail positions, so does not need to walk the
+ * queue. Messages still being pushed by another thread are included in the
+ * count.
+ *
  * @param[in] queue Pointer to queue
  * @return Number of items in queue, or -1 on error
  */
 int queue_count(const msgqueue *queue) {
 	if (!queue->valid) { return -1; }
 
-	if (queue->head == NULL) { return 0; }
+	const size_t head = atomic_load_explicit(&(queue->head), memory_order_acquire);
+	const size_t tail = atomic_load_explicit(&(queue->tail), memory_order_acquire);
+	if (tail <= head) { return 0; }
+	return (int)(tail - head);
+}
+
+/*!
+ * Block the calling thread until a message is available to pop, the timeout
+ * expires, or a signal is delivered to the calling thread. Returns
+ * immediately if there are messages already waiting.
+ *
+ * This replaces polling the queue with a fixed sleep, so the consumer wakes
+ * as soon as a message is pushed and does not wake at all while idle.
+ *
+ * As with queue_pop(), only a single thread may wait on a queue.
+ *
+ * @param[in] queue   Pointer to queue
+ * @param[in] timeout Maximum time to wait, in milliseconds. Negative values wait indefinitely.
+ * @return True if messages are ready, false on timeout, interruption or error
+ */
+bool queue_wait(msgqueue *queue, int timeout) {
+	if (!queue->valid || queue->slots == NULL) { return false; }
+	if (queue_ready(queue)) { return true; }
 
-	int count = 1;
-	queueitem *item = queue->head;
-	while (item->next) {
-		count++;
-		item = item->next;
+	atomic_store(&(queue->sleeping), true);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (queue_ready(queue)) {
+		atomic_store(&(queue->sleeping), false);
+		return true;
 	}
-	return count;
+
+	struct pollfd pfd = {.fd = queue->wakefd, .events = POLLIN};
+	int rv = poll(&pfd, 1, timeout);
+	atomic_store(&(queue->sleeping), false);
+	if (rv > 0) {
+		// Reset counter so that the next wait will block
+		uint64_t count = 0;
+		if (read(queue->wakefd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+			perror("queue_wait"); // LCOV_EXCL_LINE
+		}
+	}
+	return queue_ready(queue);
+}
+
+/*!
+ * Lets another thread get the consumer's attention, e.g. to request a change
+ * of state, without having a message to push.
+ *
+ * Unlike producers, the eventfd is always written, so the wake is not lost if
+ * the consumer is between checks and has not yet started waiting. The next
+ * queue_wait() will then return immediately.
+ *
+ * @param[in] queue Pointer to queue
+ */
+void queue_wake(msgqueue *queue) {
+	if (!queue->valid || queue->wakefd < 0) { return; }
+	atomic_store(&(queue->sleeping), false);
+	const uint64_t one = 1;
+	if (write(queue->wakefd, &one, sizeof(one)) < 0) {
+		perror("queue_wake"); // LCOV_EXCL_LINE
+	}
+}
+
+/*!
+ * Used when merging several queues by arrival order. Arrival times are only
+ * recorded if msgqueue.stamped is set, otherwise the stamp will be zero.
+ *
+ * Only the consuming thread should call this function.
+ *
+ * @param[in] queue  Pointer to queue
+ * @param[out] stamp Arrival time of the next message, if available
+ * @return True if a message is ready, false if queue empty or invalid
+ */
+bool queue_peek_stamp(const msgqueue *queue, uint64_t *stamp) {
+	if (!queue->valid || queue->slots == NULL) { return false; }
+	if (!queue_ready(queue)) { return false; }
+	if (stamp) {
+		const size_t pos = atomic_load_explicit(&(queue->head), memory_order_relaxed);
+		*stamp = queue->slots[pos & queue->mask].stamp;
+	}
+	return true;
 }
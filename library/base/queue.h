@@ -22,7 +22,10 @@
 #define SELKIELoggerBase_Queue
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "messages.h"
 
@@ -37,26 +40,63 @@
  * @{
  */
 
-//! Each queue item is a message and pointer to the next queue entry, if any.
+#ifndef QUEUE_DEFAULT_CAPACITY
+//! Number of message slots allocated by queue_init() (rounded up to a power of two)
+#define QUEUE_DEFAULT_CAPACITY 16384
+#endif
+
+//! Assumed cache line size, used to keep producer and consumer indices apart
+#define QUEUE_CACHE_LINE 64
+
+//! Message wrapper accepted by queue_push_qi(), kept only for compatibility with older callers
 typedef struct queueitem queueitem;
 
 /*!
- * @brief Represent a simple FIFO message queue
+ * @brief Single slot in a message queue
+ *
+ * The sequence number is used to hand ownership of the slot between producers
+ * and the consumer without taking a lock. See queue_push() and queue_pop().
+ */
+typedef struct {
+	atomic_size_t seq; //!< Slot sequence number
+	msg_t *item;       //!< Queued message, valid when seq is one ahead of slot position
+	uint64_t stamp;    //!< Arrival time (ns, CLOCK_MONOTONIC), only set if msgqueue.stamped
+} queueslot;
+
+/*!
+ * @brief Represent a bounded FIFO message queue
+ *
+ * Messages are stored in a preallocated ring of msgqueue.capacity slots.
+ * Any number of threads may push messages into the queue, but only a single
+ * thread may remove them.
+ *
+ * Producers claim slots by advancing msgqueue.tail and the consumer releases
+ * them by advancing msgqueue.head. These are padded onto separate cache lines
+ * so that producers and the consumer do not contend for the same line.
  *
- * Represents a queue of items starting at msgqueue.head, with the last item at or near msgqueue.tail.
+ * Items will only be added and removed while msgqueue.valid remains true.
  *
- * The queue is protected by the mutex at msgqueue.lock, and will only have
- * items added and removed while msgqueue.valid remains true.
+ * A consumer with nothing to do can block in queue_wait() rather than
+ * polling. Producers only signal msgqueue.wakefd while msgqueue.sleeping is
+ * set, so there is no additional cost to pushing while the consumer is busy.
  */
 typedef struct msgqueue {
-	queueitem *head;      //!< Points to first message, or NULL if empty
-	queueitem *tail;      //!< brief Tail entry hint
-	pthread_mutex_t lock; //!< Queue lock
-	bool valid;           //!< Queue status
+	queueslot *slots; //!< Preallocated slot storage
+	size_t capacity;  //!< Number of slots (always a power of two)
+	size_t mask;      //!< capacity - 1, used to map positions to slots
+	atomic_bool valid; //!< Queue status
+	char pad0[QUEUE_CACHE_LINE]; //!< Padding - keep head on its own cache line
+	atomic_size_t head; //!< Position of next message to be removed (consumer)
+	char pad1[QUEUE_CACHE_LINE]; //!< Padding - keep tail on its own cache line
+	atomic_size_t tail; //!< Position of next free slot (producers)
+	char pad2[QUEUE_CACHE_LINE]; //!< Padding - keep tail away from following data
+	atomic_bool sleeping; //!< Set while consumer is blocked in queue_wait()
+	int wakefd;           //!< eventfd used to wake a blocked consumer
+	bool stamped;         //!< Record arrival time of each message (see msglanes)
 } msgqueue;
 
 /*!
- * If *next is NULL, it will be assumed that this item is the end of the queue.
+ * Retained for compatibility with the earlier linked list queue implementation.
  *
  * Messages pointed to by queueitem.item "belong" to the queue until popped,
  * when they are then the responsibility of queue_pop()'s caller. Messages
@@ -66,25 +106,49 @@ typedef struct msgqueue {
  */
 struct queueitem {
 	msg_t *item;     //!< Queued message
-	queueitem *next; //!< Pointer to next item, or NULL for queue tail
+	queueitem *next; //!< Unused
 };
 
-//! Ensure queue structure is set to known good values and marked valid
+//! Allocate default sized queue storage and mark queue valid
 bool queue_init(msgqueue *queue);
 
+//! Allocate queue storage for (at least) capacity messages and mark queue valid
+bool queue_init_size(msgqueue *queue, size_t capacity);
+
 //! Invalidate queue and destroy all contents
 void queue_destroy(msgqueue *queue);
 
 //! Add a message to the tail of the queue
 bool queue_push(msgqueue *queue, msg_t *item);
 
+//! Add a message to the tail of the queue, unless the queue is full
+bool queue_try_push(msgqueue *queue, msg_t *item);
+
+//! Add several messages to the tail of the queue in a single operation
+size_t queue_push_batch(msgqueue *queue, msg_t **items, size_t n);
+
 //! Add a queue item to the tail of the queue
 bool queue_push_qi(msgqueue *queue, queueitem *item);
 
 //! Remove topmost item from the queue and return it, if queue is not empty
 msg_t *queue_pop(msgqueue *queue);
 
-//! Iterate over queue and return current number of items
+//! Remove up to max items from the queue in a single operation
+size_t queue_pop_batch(msgqueue *queue, msg_t **out, size_t max);
+
+//! Remove all available items from the queue into a newly allocated array
+size_t queue_drain(msgqueue *queue, msg_t ***out);
+
+//! Return current number of items in queue
 int queue_count(const msgqueue *queue);
+
+//! Wait for messages to become available, or for timeout to expire
+bool queue_wait(msgqueue *queue, int timeout);
+
+//! End any current or next call to queue_wait() early, without pushing a message
+void queue_wake(msgqueue *queue);
+
+//! Check whether a message is ready to be popped and retrieve its arrival time
+bool queue_peek_stamp(const msgqueue *queue, uint64_t *stamp);
 //! @}
 #endif
@@ -0,0 +1,279 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ring.h"
+
+/*!
+ * Creates an anonymous shared memory object of the requested size, and maps
+ * it twice into a single reserved region of address space, so that reads or
+ * writes running past the end of the first mapping continue at the start of
+ * the ring.
+ *
+ * @param[in] size Ring size, must be a multiple of the page size
+ * @return Pointer to start of mapping, or NULL if not possible
+ */
+static uint8_t *ring_map(size_t size) {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+	const int fd = memfd_create("SELKIELogger ring", MFD_CLOEXEC);
+	if (fd < 0) { return NULL; }
+
+	uint8_t *base = NULL;
+	if (ftruncate(fd, size) == 0) {
+		base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED) { base = NULL; }
+	}
+	if (base) {
+		const int prot = PROT_READ | PROT_WRITE;
+		const int flags = MAP_SHARED | MAP_FIXED;
+		if (mmap(base, size, prot, flags, fd, 0) != base ||
+		    mmap(base + size, size, prot, flags, fd, 0) != base + size) {
+			// LCOV_EXCL_START
+			munmap(base, 2 * size);
+			base = NULL;
+			// LCOV_EXCL_STOP
+		}
+	}
+	close(fd);
+	return base;
+#else
+	(void)size;
+	return NULL;
+#endif
+}
+
+/*!
+ * The ring size is rounded up to a power of two, and to at least one page.
+ *
+ * If the mirrored mapping can't be created, a plain buffer is allocated
+ * instead.
+ *
+ * @param[out] r       Ring to initialise
+ * @param[in]  minSize Minimum capacity
+ * @return True on success
+ */
+bool ring_init(byte_ring *r, size_t minSize) {
+	if (r == NULL || minSize == 0) { return false; }
+	*r = (byte_ring){0};
+
+	const long page = sysconf(_SC_PAGESIZE);
+	size_t size = (page > 0) ? (size_t)page : 4096;
+	while (size < minSize) {
+		size <<= 1;
+	}
+	r->size = size;
+
+	r->buf = ring_map(size);
+	if (r->buf) {
+		r->mirrored = true;
+		return true;
+	}
+
+	r->buf = malloc(size);
+	if (r->buf == NULL) {
+		// LCOV_EXCL_START
+		perror("ring_init");
+		r->size = 0;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	return true;
+}
+
+/*!
+ * Any pointers to data in the ring become invalid.
+ *
+ * @param[in] r Ring
+ */
+void ring_destroy(byte_ring *r) {
+	if (r == NULL || r->buf == NULL) { return; }
+	if (r->mirrored) {
+		munmap(r->buf, 2 * r->size);
+	} else {
+		free(r->buf);
+	}
+	*r = (byte_ring){0};
+}
+
+/*!
+ * @param[in] r Ring
+ */
+void ring_reset(byte_ring *r) {
+	if (r == NULL) { return; }
+	r->head = 0;
+	r->used = 0;
+}
+
+/*!
+ * All unprocessed data is available from this pointer as a single block.
+ * The pointer remains valid until the next call to ring_reserve(),
+ * ring_fill() or ring_destroy(), even if the data is consumed.
+ *
+ * @param[in] r Ring
+ * @return Pointer to first unprocessed byte
+ */
+const uint8_t *ring_data(const byte_ring *r) {
+	return &(r->buf[r->head]);
+}
+
+/*!
+ * @param[in] r Ring
+ * @return Number of unprocessed bytes
+ */
+size_t ring_used(const byte_ring *r) {
+	return r->used;
+}
+
+/*!
+ * Data is not moved or overwritten until more data is added to the ring.
+ *
+ * @param[in] r Ring
+ * @param[in] n Number of bytes to discard (limited to ring_used())
+ */
+void ring_consume(byte_ring *r, size_t n) {
+	if (n >= r->used) {
+		r->head = 0;
+		r->used = 0;
+		return;
+	}
+	r->used -= n;
+	r->head += n;
+	if (r->mirrored) { r->head &= (r->size - 1); }
+}
+
+/*!
+ * For mirrored rings, all free space in the ring is returned as a single
+ * block.
+ *
+ * Otherwise, space is only available at the end of the buffer. If less than
+ * half of the free space is at the end, the unprocessed data is first moved
+ * back to the start of the buffer, so data is only moved once per half
+ * buffer read.
+ *
+ * @param[in]  r     Ring
+ * @param[out] space Number of bytes that can be written
+ * @return Pointer to free space
+ */
+uint8_t *ring_reserve(byte_ring *r, size_t *space) {
+	if (r->mirrored) {
+		(*space) = r->size - r->used;
+		return &(r->buf[(r->head + r->used) & (r->size - 1)]);
+	}
+	const size_t avail = r->size - r->used;
+	if (r->head > 0 && (r->size - r->head - r->used) < (avail / 2)) {
+		memmove(r->buf, &(r->buf[r->head]), r->used);
+		r->head = 0;
+	}
+	(*space) = r->size - r->head - r->used;
+	return &(r->buf[r->head + r->used]);
+}
+
+/*!
+ * @param[in] r Ring
+ * @param[in] n Number of bytes written to space from ring_reserve()
+ */
+void ring_commit(byte_ring *r, size_t n) {
+	const size_t space = r->mirrored ? r->size - r->used : r->size - r->head - r->used;
+	r->used += (n < space) ? n : space;
+}
+
+/*!
+ * Reads as much data as will fit in the ring with a single read() call.
+ *
+ * @param[in] r      Ring
+ * @param[in] handle File descriptor
+ * @return As read(). Returns 0 if the ring is full.
+ */
+ssize_t ring_fill(byte_ring *r, int handle) {
+	size_t space = 0;
+	uint8_t *dst = ring_reserve(r, &space);
+	if (space == 0) { return 0; }
+	const ssize_t n = read(handle, dst, space);
+	if (n > 0) { r->used += n; }
+	return n;
+}
+
+/*!
+ * Searches the unprocessed data in the ring for the next message frame, using
+ * the callbacks in p. Data that can't be part of a valid frame is discarded.
+ *
+ * If a frame is found, frame and len are set to refer to the message data
+ * within the ring and the frame is consumed. The frame data remains valid
+ * until more data is added to the ring (see ring_data()).
+ *
+ * If a frame fails the protocol check, the first byte of the frame is
+ * discarded and FRAME_INVALID is returned. The search can then be restarted
+ * immediately, as further frames may already be available.
+ *
+ * @param[in]  r     Ring
+ * @param[in]  p     Protocol description
+ * @param[out] frame Pointer to start of frame
+ * @param[out] len   Frame length
+ * @return Search status
+ */
+frame_status frame_next(byte_ring *r, const frame_protocol *p, const uint8_t **frame,
+                        size_t *len) {
+	if (r == NULL || r->buf == NULL || p == NULL || p->length == NULL || frame == NULL ||
+	    len == NULL) {
+		return FRAME_ERROR;
+	}
+
+	const size_t maxLength = (p->maxLength < r->size) ? p->maxLength : r->size;
+	while (r->used > 0) {
+		const uint8_t *d = ring_data(r);
+		if (p->sync) {
+			const size_t skip = p->sync(d, r->used);
+			if (skip > 0) {
+				ring_consume(r, skip);
+				if (r->used == 0) { break; }
+				d = ring_data(r);
+			}
+		}
+
+		const ssize_t fl = p->length(d, r->used);
+		if (fl == 0) {
+			// Waiting won't help if the frame is already too long
+			if (r->used < maxLength) { return FRAME_MORE; }
+			ring_consume(r, 1);
+			continue;
+		}
+		if (fl < 0 || (size_t)fl > maxLength) {
+			ring_consume(r, 1);
+			continue;
+		}
+		if ((size_t)fl > r->used) { return FRAME_MORE; }
+
+		if (p->check && !p->check(d, fl)) {
+			ring_consume(r, 1);
+			return FRAME_INVALID;
+		}
+
+		(*frame) = d;
+		(*len) = fl;
+		ring_consume(r, fl);
+		return FRAME_OK;
+	}
+	return FRAME_MORE;
+}
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELKIELoggerBase_Ring
+#define SELKIELoggerBase_Ring
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*!
+ * @file ring.h Byte ring buffer and message framing
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup ring Byte ring and message framing
+ * @ingroup SELKIELoggerBase
+ *
+ * The ring holds data read from a device until it can be split into
+ * messages. Where possible, the same memory is mapped twice in succession,
+ * so that any data in the ring (and any free space) can be accessed as a
+ * single contiguous block without copying, regardless of where it wraps
+ * around. If this isn't possible, a plain buffer is used instead and data is
+ * moved back to the start of the buffer only when there is no space left at
+ * the end.
+ *
+ * Each protocol describes its framing with a frame_protocol, and
+ * frame_next() uses this to find messages within the ring. Messages are
+ * returned as pointers into the ring, so the protocol modules only need to
+ * copy the data they decode.
+ * @{
+ */
+
+//! Byte ring buffer
+typedef struct {
+	uint8_t *buf;  //!< Ring storage (mapped twice if mirrored is true)
+	size_t size;   //!< Ring capacity (power of two)
+	size_t head;   //!< Offset of first unprocessed byte
+	size_t used;   //!< Number of unprocessed bytes
+	bool mirrored; //!< Storage is mirrored, so never needs to be moved
+} byte_ring;
+
+//! Allocate a ring of at least minSize bytes
+bool ring_init(byte_ring *r, size_t minSize);
+
+//! Release ring storage
+void ring_destroy(byte_ring *r);
+
+//! Discard all data held in ring
+void ring_reset(byte_ring *r);
+
+//! Pointer to unprocessed data (ring_used() bytes)
+const uint8_t *ring_data(const byte_ring *r);
+
+//! Number of unprocessed bytes in ring
+size_t ring_used(const byte_ring *r);
+
+//! Mark bytes at the start of the ring as processed
+void ring_consume(byte_ring *r, size_t n);
+
+//! Get space for new data
+uint8_t *ring_reserve(byte_ring *r, size_t *space);
+
+//! Add new data written to space returned by ring_reserve()
+void ring_commit(byte_ring *r, size_t n);
+
+//! Read data from a file descriptor into the ring
+ssize_t ring_fill(byte_ring *r, int handle);
+
+//! Result of searching for a message frame
+typedef enum {
+	FRAME_OK = 0,  //!< Complete, valid frame found
+	FRAME_MORE,    //!< No complete frame available yet
+	FRAME_INVALID, //!< Complete frame found, but failed validation
+	FRAME_ERROR,   //!< Invalid arguments
+} frame_status;
+
+/*!
+ * @brief Protocol framing description
+ *
+ * All callbacks are given the unprocessed data in the ring, starting at a
+ * candidate frame position.
+ */
+typedef struct {
+	/*!
+	 * Find the first possible frame start in data. Returns len if no
+	 * frame start is found. If NULL, every byte is a possible frame start.
+	 */
+	size_t (*sync)(const uint8_t *data, size_t len);
+	/*!
+	 * Determine length of frame starting at data[0]. Returns 0 if more data
+	 * is required to decide, or -1 if data[0] is not the start of a valid
+	 * frame.
+	 */
+	ssize_t (*length)(const uint8_t *data, size_t len);
+	//! Validate a complete frame (e.g. checksum). Optional.
+	bool (*check)(const uint8_t *data, size_t len);
+	//! Largest valid frame, which must not be larger than the ring
+	size_t maxLength;
+} frame_protocol;
+
+//! Find the next message frame in a ring
+frame_status frame_next(byte_ring *r, const frame_protocol *p, const uint8_t **frame,
+                        size_t *len);
+//! @}
+#endif
@@ -0,0 +1,157 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "scan.h"
+
+//! Number of bytes checked in each vector comparison
+#define SCAN_BLOCK 16
+
+#if defined(__ARM_NEON)
+/*!
+ * @param[in] m Comparison result
+ * @return True if any lane of m is non-zero
+ */
+static inline bool scan_neon_any(uint8x16_t m) {
+#if defined(__aarch64__)
+	return vmaxvq_u8(m) != 0;
+#else
+	const uint8x8_t r = vorr_u8(vget_low_u8(m), vget_high_u8(m));
+	return vget_lane_u64(vreinterpret_u64_u8(r), 0) != 0;
+#endif
+}
+#endif
+
+/*!
+ * glibc and most other C libraries already provide a vectorised memchr(),
+ * so this is used directly.
+ *
+ * @param[in] data Data to search
+ * @param[in] len  Length of data
+ * @param[in] a    Byte to find
+ * @return Offset of first match, or len if not found
+ */
+size_t scan_byte(const uint8_t *data, size_t len, uint8_t a) {
+	if (data == NULL || len == 0) { return len; }
+	const uint8_t *m = memchr(data, a, len);
+	return m ? (size_t)(m - data) : len;
+}
+
+/*!
+ * Used for protocols with more than one valid start byte (e.g. NMEA).
+ *
+ * @param[in] data Data to search
+ * @param[in] len  Length of data
+ * @param[in] a    First byte to find
+ * @param[in] b    Second byte to find
+ * @return Offset of first byte matching either a or b, or len if not found
+ */
+size_t scan_either(const uint8_t *data, size_t len, uint8_t a, uint8_t b) {
+	if (data == NULL) { return len; }
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i va = _mm_set1_epi8((char)a);
+	const __m128i vb = _mm_set1_epi8((char)b);
+	for (; i + SCAN_BLOCK <= len; i += SCAN_BLOCK) {
+		const __m128i d = _mm_loadu_si128((const __m128i *)&(data[i]));
+		const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(d, va), _mm_cmpeq_epi8(d, vb));
+		const int mask = _mm_movemask_epi8(m);
+		if (mask) { return i + __builtin_ctz((unsigned int)mask); }
+	}
+#elif defined(__ARM_NEON)
+	const uint8x16_t va = vdupq_n_u8(a);
+	const uint8x16_t vb = vdupq_n_u8(b);
+	for (; i + SCAN_BLOCK <= len; i += SCAN_BLOCK) {
+		const uint8x16_t d = vld1q_u8(&(data[i]));
+		if (scan_neon_any(vorrq_u8(vceqq_u8(d, va), vceqq_u8(d, vb)))) { break; }
+	}
+#endif
+	for (; i < len; i++) {
+		if (data[i] == a || data[i] == b) { return i; }
+	}
+	return len;
+}
+
+/*!
+ * Used for protocols with a two byte synchronisation sequence (e.g. UBX,
+ * MP), which avoids stopping at every occurrence of the first byte in
+ * random data.
+ *
+ * If the final byte of data matches a, its offset is returned, as it may be
+ * the start of a sequence that has not been completely received.
+ *
+ * @param[in] data Data to search
+ * @param[in] len  Length of data
+ * @param[in] a    First byte of sequence
+ * @param[in] b    Second byte of sequence
+ * @return Offset of first byte of sequence, or len if not found
+ */
+size_t scan_pair(const uint8_t *data, size_t len, uint8_t a, uint8_t b) {
+	if (data == NULL || len == 0) { return len; }
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i va = _mm_set1_epi8((char)a);
+	const __m128i vb = _mm_set1_epi8((char)b);
+	for (; i + SCAN_BLOCK < len; i += SCAN_BLOCK) {
+		const __m128i d0 = _mm_loadu_si128((const __m128i *)&(data[i]));
+		const __m128i d1 = _mm_loadu_si128((const __m128i *)&(data[i + 1]));
+		const __m128i m = _mm_and_si128(_mm_cmpeq_epi8(d0, va), _mm_cmpeq_epi8(d1, vb));
+		const int mask = _mm_movemask_epi8(m);
+		if (mask) { return i + __builtin_ctz((unsigned int)mask); }
+	}
+#elif defined(__ARM_NEON)
+	const uint8x16_t va = vdupq_n_u8(a);
+	const uint8x16_t vb = vdupq_n_u8(b);
+	for (; i + SCAN_BLOCK < len; i += SCAN_BLOCK) {
+		const uint8x16_t d0 = vld1q_u8(&(data[i]));
+		const uint8x16_t d1 = vld1q_u8(&(data[i + 1]));
+		if (scan_neon_any(vandq_u8(vceqq_u8(d0, va), vceqq_u8(d1, vb)))) { break; }
+	}
+#endif
+	while (i < len) {
+		const uint8_t *m = memchr(&(data[i]), a, len - i);
+		if (m == NULL) { return len; }
+		i = (size_t)(m - data);
+		if (i + 1 == len || data[i + 1] == b) { return i; }
+		i++;
+	}
+	return len;
+}
+
+/*!
+ * @return Short description of the search implementation compiled in
+ */
+const char *scan_implementation(void) {
+#if defined(__SSE2__)
+	return "SSE2";
+#elif defined(__ARM_NEON)
+	return "NEON";
+#else
+	return "Scalar";
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELKIELoggerBase_Scan
+#define SELKIELoggerBase_Scan
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @file scan.h Fast searches for message synchronisation bytes
+ * @ingroup SELKIELoggerBase
+ */
+
+/*!
+ * @addtogroup scan Synchronisation byte searches
+ * @ingroup SELKIELoggerBase
+ *
+ * Protocol readers spend most of their time searching for the start of the
+ * next message when reading noisy or corrupted data. These functions check
+ * 16 bytes at a time using SSE2 or NEON instructions where the target
+ * supports them, falling back to memchr() or a simple loop otherwise.
+ *
+ * All functions return the offset of the first match, or len if no match is
+ * found.
+ * @{
+ */
+
+//! Find first occurrence of a byte
+size_t scan_byte(const uint8_t *data, size_t len, uint8_t a);
+
+//! Find first occurrence of either of two bytes
+size_t scan_either(const uint8_t *data, size_t len, uint8_t a, uint8_t b);
+
+//! Find first occurrence of a two byte sequence
+size_t scan_pair(const uint8_t *data, size_t len, uint8_t a, uint8_t b);
+
+//! Name of the implementation in use (for diagnostics)
+const char *scan_implementation(void);
+//! @}
+#endif
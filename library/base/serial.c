@@ -22,9 +22,14 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <termios.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
 #include "serial.h"
 
 /*!
@@ -34,8 +39,12 @@
  * - Data synchronised mode
  * - Ignore flow control lines
  *
- * The baud rate provided is compared to the mode requested and an error
- * returned if this does not match.
+ * Rates not listed in termios.h are set using serial_set_rate() where
+ * supported, and low latency mode is requested from the driver (see
+ * serial_set_low_latency()).
+ *
+ * The baud rate provided is compared to the rate reported by the driver and a
+ * warning printed if they differ by more than SERIAL_RATE_TOLERANCE percent.
  *
  * @param[in] port Serial port device path
  * @param[in] baudRate Target baud rate (will be passed to baud_to_flag()
@@ -57,14 +66,13 @@ int openSerialConnection(const char *port, const int baudRate) {
 	// interface
 	tcgetattr(handle, &options);
 
-	speed_t rate = baud_to_flag(baudRate);
-	if (rate == (speed_t)-1) {
-		fprintf(stderr, "Unsupported baud rate requested: %d\n", baudRate);
-		return -1;
+	// Non-standard rates can only be set once the other options are applied
+	const speed_t rate = baud_to_flag(baudRate);
+	const bool customRate = (rate == (speed_t)-1);
+	if (!customRate) {
+		cfsetispeed(&options, rate);
+		cfsetospeed(&options, rate);
 	}
-
-	cfsetispeed(&options, rate);
-	cfsetospeed(&options, rate);
 	options.c_oflag &= ~OPOST; // Disable any post processing
 	options.c_cflag &= ~(PARENB | CSTOPB | CSIZE);
 	options.c_cflag |= (CLOCAL | CREAD);
@@ -74,13 +82,25 @@ int openSerialConnection(const char *port, const int baudRate) {
 	options.c_cc[VTIME] = 1;
 	options.c_cc[VMIN] = 0;
 	if (tcsetattr(handle, TCSANOW, &options)) { fprintf(stderr, "tcsetattr() failed!\n"); }
+	if (customRate && !serial_set_rate(handle, baudRate)) {
+		fprintf(stderr, "Unsupported baud rate requested: %d\n", baudRate);
+		close(handle);
+		return -1;
+	}
+	// Not supported by all drivers, so failure is ignored
+	serial_set_low_latency(handle);
 	tcdrain(handle);
 	{
-		struct termios check;
-		tcgetattr(handle, &check);
-		if (cfgetispeed(&check) != rate) {
+		int actual = serial_get_rate(handle);
+		if (actual < 0) {
+			struct termios check;
+			tcgetattr(handle, &check);
+			actual = flag_to_baud(cfgetispeed(&check));
+		}
+		const int diff = (actual > baudRate) ? actual - baudRate : baudRate - actual;
+		if (actual < 0 || diff > (baudRate / 100) * SERIAL_RATE_TOLERANCE) {
 			fprintf(stderr, "Unable to set target baud. Wanted %d, got %d\n", baudRate,
-			        flag_to_baud(cfgetispeed(&check)));
+			        actual);
 			/*close(handle); // Don't leave file descriptor dangling
 			return -1; */
 		}
@@ -221,3 +241,76 @@ int flag_to_baud(const int flag) {
 			return -1;
 	}
 }
+
+/*!
+ * Uses the TIOCGICOUNT ioctl, which is only supported by some drivers. USB
+ * serial adapters and real UARTs generally report these counters, but
+ * virtual devices (e.g. pseudo-terminals) do not.
+ *
+ * The counters are cumulative from when the device was opened or the driver
+ * loaded, so should be compared against an earlier reading.
+ *
+ * @param[in]  handle File descriptor for serial port
+ * @param[out] out    Current counter values
+ * @return True if counters are available, false if not supported
+ */
+bool serial_get_counts(int handle, serial_counts *out) {
+	if (handle < 0 || out == NULL) { return false; }
+#if defined(__linux__) && defined(TIOCGICOUNT)
+	struct serial_icounter_struct ic = {0};
+	if (ioctl(handle, TIOCGICOUNT, &ic) != 0) { return false; }
+	out->overrun = ic.overrun;
+	out->bufOverrun = ic.buf_overrun;
+	out->frame = ic.frame;
+	out->parity = ic.parity;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*!
+ * Sets VMIN to count and VTIME to zero. The terminal driver then only
+ * reports the port as readable (via poll(), select() or epoll) once at least
+ * count bytes are waiting, which reduces the number of wakeups when reading
+ * large amounts of data.
+ *
+ * Non-blocking reads still return any data available immediately.
+ *
+ * @param[in] handle File descriptor for serial port
+ * @param[in] count  Number of bytes (limited to 1-255)
+ * @return True on success
+ */
+bool serial_set_minimum(int handle, int count) {
+	if (handle < 0) { return false; }
+	if (count < 1) { count = 1; }
+	if (count > 255) { count = 255; }
+
+	struct termios options;
+	if (tcgetattr(handle, &options) != 0) { return false; }
+	options.c_cc[VTIME] = 0;
+	options.c_cc[VMIN] = count;
+	return (tcsetattr(handle, TCSANOW, &options) == 0);
+}
+
+/*!
+ * Sets the ASYNC_LOW_LATENCY flag for the port, which asks the driver to pass
+ * received data on immediately rather than batching it. For USB serial
+ * adapters this usually reduces the latency timer from 16ms to 1ms, reducing
+ * the risk of the device buffer overflowing at high data rates.
+ *
+ * @param[in] handle File descriptor for serial port
+ * @return True if low latency mode is enabled
+ */
+bool serial_set_low_latency(int handle) {
+	if (handle < 0) { return false; }
+#if defined(__linux__) && defined(TIOCGSERIAL) && defined(ASYNC_LOW_LATENCY)
+	struct serial_struct ss = {0};
+	if (ioctl(handle, TIOCGSERIAL, &ss) != 0) { return false; }
+	if (ss.flags & ASYNC_LOW_LATENCY) { return true; }
+	ss.flags |= ASYNC_LOW_LATENCY;
+	return (ioctl(handle, TIOCSSERIAL, &ss) == 0);
+#else
+	return false;
+#endif
+}
@@ -21,6 +21,9 @@
 #ifndef SELKIELoggerBase_Serial
 #define SELKIELoggerBase_Serial
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /*!
  * @file serial.h Generic serial connection and utility functions
  * @ingroup SELKIELoggerBase
@@ -30,6 +33,9 @@
  * @addtogroup SELKIELoggerBase
  * @{
  */
+//! Allowed difference between requested and actual baud rates (percent)
+#define SERIAL_RATE_TOLERANCE 2
+
 //! Open a serial connection at a given baud rate
 int openSerialConnection(const char *port, const int baudRate);
 
@@ -38,5 +44,28 @@ int baud_to_flag(const int rate);
 
 //! Convert a termios baud rate flag to a numerical value
 int flag_to_baud(const int flag);
+
+//! Serial port error counters, as reported by the kernel driver
+typedef struct {
+	uint32_t overrun;    //!< Data lost because the hardware FIFO was full
+	uint32_t bufOverrun; //!< Data lost because the kernel buffer was full
+	uint32_t frame;      //!< Framing errors
+	uint32_t parity;     //!< Parity errors
+} serial_counts;
+
+//! Read serial port error counters
+bool serial_get_counts(int handle, serial_counts *out);
+
+//! Set minimum amount of data required before port is reported as readable
+bool serial_set_minimum(int handle, int count);
+
+//! Set an arbitrary baud rate (Linux only)
+bool serial_set_rate(int handle, int baudRate);
+
+//! Get current baud rate as reported by the driver (Linux only)
+int serial_get_rate(int handle);
+
+//! Request low latency handling of received data from the driver
+bool serial_set_low_latency(int handle);
 //! @}
 #endif
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * The kernel definition of struct termios2 conflicts with the C library
+ * definition of struct termios, so these functions are kept separate from
+ * the rest of serial.c
+ */
+#ifdef __linux__
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#endif
+
+#include "serial.h"
+
+/*!
+ * Uses the Linux specific termios2 interface, which allows any baud rate
+ * supported by the device driver to be requested, rather than being limited
+ * to the standard rates listed in termios.h
+ *
+ * All other port settings are left unchanged.
+ *
+ * @param[in] handle   File descriptor for serial port
+ * @param[in] baudRate Target baud rate
+ * @return True if rate accepted by driver (see serial_get_rate() for actual value)
+ */
+bool serial_set_rate(int handle, int baudRate) {
+	if (handle < 0 || baudRate <= 0) { return false; }
+#if defined(__linux__) && defined(BOTHER) && defined(TCGETS2)
+	struct termios2 options;
+	if (ioctl(handle, TCGETS2, &options) != 0) { return false; }
+	options.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+	options.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+	options.c_ispeed = baudRate;
+	options.c_ospeed = baudRate;
+	return (ioctl(handle, TCSETS2, &options) == 0);
+#else
+	return false;
+#endif
+}
+
+/*!
+ * Drivers will update the port settings with the nearest rate they can
+ * achieve, so this can be used to verify that a requested rate is in use.
+ *
+ * @param[in] handle File descriptor for serial port
+ * @return Current input baud rate, or -1 if not available
+ */
+int serial_get_rate(int handle) {
+	if (handle < 0) { return -1; }
+#if defined(__linux__) && defined(TCGETS2)
+	struct termios2 options;
+	if (ioctl(handle, TCGETS2, &options) != 0) { return -1; }
+	return (int)options.c_ispeed;
+#else
+	return -1;
+#endif
+}
@@ -91,6 +91,9 @@
  * The three log message types would not normally be included in a sources
  * channel map, but are available for use by any device.
  *
+ * The block header channel is only used by the logging software, and is not
+ * included in channel maps.
+ *
  * @{
  */
 
@@ -98,6 +101,7 @@
 #define SLCHAN_MAP      0x01 //!< Channel name map (excludes log channels)
 #define SLCHAN_TSTAMP   0x02 //!< Source timestamp (milliseconds, arbitrary epoch)
 #define SLCHAN_RAW      0x03 //!< Raw device data (Not mandatory)
+#define SLCHAN_BLOCK    0x7C //!< Data file block header (SLSOURCE_LOCAL only, see MPBlock.h)
 #define SLCHAN_LOG_INFO 0x7D //!< Information messages
 #define SLCHAN_LOG_WARN 0x7E //!< Warning messages
 #define SLCHAN_LOG_ERR  0x7F //!< Error messages
@@ -45,7 +45,20 @@ int main(int argc, char *argv[]) {
 	state.verbose = 1;
 
 	go.saveState = true;
+	go.stateInterval = STATE_INTERVAL;
 	go.rotateMonitor = true;
+	go.maxSize = 0;
+	go.usePool = true;
+	go.flushInterval = MP_WRITER_INTERVAL;
+	go.writeQueue = MP_WRITER_QUEUE;
+	go.syncMode = MP_SYNC_NONE;
+	go.syncInterval = MP_WRITER_SYNC_INTERVAL;
+	go.syncBytes = MP_WRITER_SYNC_BYTES;
+	go.preallocate = MP_WRITER_PREALLOC;
+	go.blocks = true;
+	go.index = true;
+	go.indexInterval = MP_INDEX_INTERVAL;
+	go.reactorThreads = 1;
 
 	int verbosityModifier = 0;
 
@@ -137,6 +150,200 @@ int main(int argc, char *argv[]) {
 			}
 		}
 
+		kv = NULL;
+		if ((kv = config_get_key(def, "queuesize"))) {
+			errno = 0;
+			go.queueSize = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing queue size: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.queueSize < 0) {
+				log_error(&state, "Invalid queue size (%d)", go.queueSize);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "lanes"))) {
+			int ul = config_parse_bool(kv->value);
+			if (ul < 0) {
+				log_error(&state, "Error parsing option lanes: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.useLanes = ul;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "mempool"))) {
+			int mp = config_parse_bool(kv->value);
+			if (mp < 0) {
+				log_error(&state, "Error parsing option mempool: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.usePool = mp;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "flushinterval"))) {
+			errno = 0;
+			go.flushInterval = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing flush interval: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.flushInterval < 0) {
+				log_error(&state, "Invalid flush interval (%d)", go.flushInterval);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "writequeue"))) {
+			errno = 0;
+			go.writeQueue = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing write queue length: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.writeQueue < 0) {
+				log_error(&state, "Invalid write queue length (%d)", go.writeQueue);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "syncmode"))) {
+			if (strcasecmp(kv->value, "none") == 0) {
+				go.syncMode = MP_SYNC_NONE;
+			} else if (strcasecmp(kv->value, "interval") == 0) {
+				go.syncMode = MP_SYNC_INTERVAL;
+			} else if (strcasecmp(kv->value, "bytes") == 0) {
+				go.syncMode = MP_SYNC_BYTES;
+			} else {
+				log_error(&state, "Invalid sync mode: %s", kv->value);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "syncinterval"))) {
+			errno = 0;
+			go.syncInterval = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing sync interval: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.syncInterval < 0) {
+				log_error(&state, "Invalid sync interval (%d)", go.syncInterval);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "syncbytes"))) {
+			errno = 0;
+			go.syncBytes = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing sync threshold: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.syncBytes <= 0) {
+				log_error(&state, "Invalid sync threshold (%d)", go.syncBytes);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "blocks"))) {
+			int bf = config_parse_bool(kv->value);
+			if (bf < 0) {
+				log_error(&state, "Error parsing option blocks: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.blocks = bf;
+		}
+
+		// Without buffering every message would become a block, each with
+		// its own header, so only use blocks if explicitly requested
+		if (go.blocks && go.flushInterval == 0) {
+			if (kv) {
+				log_warning(&state,
+				            "Block headers will be added to every message, as flushinterval is 0");
+			} else {
+				log_info(&state, 1, "Block headers disabled, as flushinterval is 0");
+				go.blocks = false;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "index"))) {
+			int bf = config_parse_bool(kv->value);
+			if (bf < 0) {
+				log_error(&state, "Error parsing option index: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.index = bf;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "indexinterval"))) {
+			errno = 0;
+			go.indexInterval = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing index interval: %s", strerror(errno));
+				doUsage = true;
+			} else if (go.indexInterval < 0) {
+				log_error(&state, "Invalid index interval (%d)", go.indexInterval);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "latency"))) {
+			int lt = config_parse_bool(kv->value);
+			if (lt < 0) {
+				log_error(&state, "Error parsing option latency: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.latency = lt;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "reactor"))) {
+			int rc = config_parse_bool(kv->value);
+			if (rc < 0) {
+				log_error(&state, "Error parsing option reactor: %s", strerror(errno));
+				doUsage = true;
+			}
+			go.reactor = rc;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "reactorthreads"))) {
+			errno = 0;
+			go.reactorThreads = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing reactor thread count: %s",
+				          strerror(errno));
+				doUsage = true;
+			} else if ((go.reactorThreads < 1) ||
+			           (go.reactorThreads > REACTOR_MAX_THREADS)) {
+				log_error(&state, "Invalid reactor thread count (%d, maximum %d)",
+				          go.reactorThreads, REACTOR_MAX_THREADS);
+				doUsage = true;
+			}
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "preallocate"))) {
+			errno = 0;
+			go.preallocate = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing preallocation size: %s",
+				          strerror(errno));
+				doUsage = true;
+			} else if (go.preallocate < 0) {
+				log_error(&state, "Invalid preallocation size (%d)", go.preallocate);
+				doUsage = true;
+			}
+		}
+
 		kv = NULL;
 		if ((kv = config_get_key(def, "prefix"))) { go.dataPrefix = strdup(kv->value); }
 
@@ -154,6 +361,37 @@ int main(int argc, char *argv[]) {
 			go.saveState = st;
 		}
 
+		kv = NULL;
+		if ((kv = config_get_key(def, "livetable"))) {
+			int lt = config_parse_bool(kv->value);
+			if (lt < 0) {
+				log_error(&state, "Error parsing option livetable: %s",
+				          strerror(errno));
+				doUsage = true;
+			}
+			go.liveTable = lt;
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "livename"))) {
+			free(go.liveName);
+			go.liveName = strdup(kv->value);
+		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "stateinterval"))) {
+			errno = 0;
+			go.stateInterval = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing state file interval: %s",
+				          strerror(errno));
+				doUsage = true;
+			} else if (go.stateInterval < 1) {
+				log_error(&state, "Invalid state file interval (%d)", go.stateInterval);
+				doUsage = true;
+			}
+		}
+
 		kv = NULL;
 		if ((kv = config_get_key(def, "rotate"))) {
 			int rm = config_parse_bool(kv->value);
@@ -164,6 +402,20 @@ int main(int argc, char *argv[]) {
 			}
 			go.rotateMonitor = rm;
 		}
+
+		kv = NULL;
+		if ((kv = config_get_key(def, "maxsize"))) {
+			errno = 0;
+			go.maxSize = strtol(kv->value, NULL, 0);
+			if (errno) {
+				log_error(&state, "Error parsing maximum file size: %s",
+				          strerror(errno));
+				doUsage = true;
+			} else if (go.maxSize < 0) {
+				log_error(&state, "Invalid maximum file size (%d)", go.maxSize);
+				doUsage = true;
+			}
+		}
 	}
 
 	state.verbose += verbosityModifier;
@@ -194,6 +446,7 @@ int main(int argc, char *argv[]) {
 
 	// Default state file name is derived from the port name
 	if (!go.stateName) { go.stateName = strdup(DEFAULT_STATE_NAME); }
+	if (!go.liveName) { go.liveName = strdup(LIVE_DEFAULT_NAME); }
 
 	// Set default frequency if not already set
 	if (!go.coreFreq) { go.coreFreq = DEFAULT_MARK_FREQUENCY; }
@@ -290,6 +543,27 @@ int main(int argc, char *argv[]) {
 	}
 	log_info(&state, 2, "Using variable file %s.var", go.monFileStem);
 
+	if (go.index) {
+		errno = 0;
+		char *idxFileName = NULL;
+		if (asprintf(&idxFileName, "%s.%s", go.monFileStem, "idx") < 0) {
+			log_error(&state, "Failed to allocate memory for index file name: %s",
+			          strerror(errno));
+		} else {
+			go.idxFile = fopen(idxFileName, "w+x");
+			free(idxFileName);
+		}
+
+		if (!go.idxFile) {
+			log_error(&state, "Unable to open index file: %s", strerror(errno));
+			destroy_config(&conf);
+			destroy_global_opts(&go);
+			destroy_program_state(&state);
+			return EXIT_FAILURE;
+		}
+		log_info(&state, 2, "Using index file %s.idx", go.monFileStem);
+	}
+
 	// Preprocessor concatenation, not a format string!
 	log_info(&state, 1, "Version: " GIT_VERSION_STRING);
 
@@ -298,21 +572,19 @@ int main(int argc, char *argv[]) {
 	// Block signal handling until we're up and running
 	signalHandlersBlock();
 
-	msgqueue log_queue = {0};
-	if (!queue_init(&log_queue)) {
-		log_error(&state, "Unable to initialise message queue");
-		destroy_config(&conf);
-		destroy_global_opts(&go);
-		destroy_program_state(&state);
-		return EXIT_FAILURE;
-	}
+	/*
+	 * Message queue(s) are allocated once all sources are configured, as
+	 * the number of lanes required depends on the number of sources.
+	 */
+	msglanes log_lanes = {0};
+	msgqueue *log_queue = NULL;
 
 	/********************************************************************************************
 	 * Configure individual data sources, based on the configuration file sections
 	 * 	For each section:
 	 *		Allocate log_thread_args_t structure (lta)
 	 *		Set lta->tag to section name
-	 *		Set lta->logQ to queue
+	 *		Set lta->logQ to NULL (queue allocated later)
 	 *		Set lta->pstate to &state
 	 *		Identify device type
 	 *		Get callback functions and set lta->funcs
@@ -340,7 +612,7 @@ int main(int argc, char *argv[]) {
 	}
 
 	ltargs[nThreads].tag = strdup("Timer"); // Must be free-able
-	ltargs[nThreads].logQ = &log_queue;
+	ltargs[nThreads].logQ = NULL;
 	ltargs[nThreads].pstate = &state;
 	{
 		timer_params *tp = calloc(1, sizeof(timer_params));
@@ -364,7 +636,7 @@ int main(int argc, char *argv[]) {
 		}
 		log_info(&state, 3, "Found section: %s", conf.sects[i].name);
 		ltargs[nThreads].tag = strdup(conf.sects[i].name);
-		ltargs[nThreads].logQ = &log_queue;
+		ltargs[nThreads].logQ = NULL;
 		ltargs[nThreads].pstate = &state;
 		// TODO: Device specific init
 		config_kv *type = config_get_key(&(conf.sects[i]), "type");
@@ -411,6 +683,7 @@ int main(int argc, char *argv[]) {
 				          strerror(errno));
 				return EXIT_FAILURE;
 			}
+			memset(&(ltt[ltaSize]), 0, 10 * sizeof(log_thread_args_t));
 			ltaSize += 10;
 			ltargs = ltt;
 		}
@@ -432,6 +705,47 @@ int main(int argc, char *argv[]) {
 		return EXIT_FAILURE;
 	}
 	log_info(&state, 2, "Data source configuration complete");
+
+	// Must be enabled before any messages are created
+	if (go.usePool && !pool_init()) {
+		log_warning(&state, "Unable to enable message pool");
+	}
+
+	// Messages are stamped with their creation time once enabled
+	log_latency latency = {0};
+	if (go.latency) {
+		if (latency_init(&latency)) {
+			log_info(&state, 2, "Measuring message latency");
+		} else {
+			log_warning(&state, "Unable to enable latency measurement");
+			go.latency = false;
+		}
+	}
+
+	/*
+	 * If lanes are enabled, lane 0 is used by this thread and each data
+	 * source is given its own lane. Otherwise, all sources share lane 0.
+	 */
+	if (!lanes_init(&log_lanes, go.useLanes ? nThreads + 1 : 1, go.queueSize)) {
+		log_error(&state, "Unable to initialise message queue");
+		for (int i = 0; i < nThreads; i++) {
+			if (ltargs[i].tag) { free(ltargs[i].tag); }
+			if (ltargs[i].type) { free(ltargs[i].type); }
+			if (ltargs[i].dParams) { free(ltargs[i].dParams); }
+		}
+		free(ltargs);
+		destroy_global_opts(&go);
+		destroy_program_state(&state);
+		return EXIT_FAILURE;
+	}
+	log_queue = lanes_get(&log_lanes, 0);
+	for (int tix = 0; tix < nThreads; tix++) {
+		ltargs[tix].logQ = lanes_get(&log_lanes, go.useLanes ? tix + 1 : 0);
+	}
+	if (go.useLanes) {
+		log_info(&state, 2, "Using separate message queues for each data source");
+	}
+
 	log_info(&state, 2, "Initialising threads");
 
 	pthread_t *threads = calloc(nThreads, sizeof(pthread_t));
@@ -470,7 +784,38 @@ int main(int argc, char *argv[]) {
 
 	log_info(&state, 1, "Initialisation complete, starting log threads");
 
-	for (int tix = 0; tix < nThreads; tix++) {
+	/*
+	 * Sources that support it can be serviced by the I/O reactor, which
+	 * must be started before any other threads so that a failure can be
+	 * handled without having to stop them again.
+	 */
+	log_reactor reactor = {0};
+	if (go.reactor) {
+		if (reactor_init(&reactor, go.reactorThreads, &state)) {
+			for (int tix = 0; tix < nThreads; tix++) {
+				if (!reactor_add(&reactor, &(ltargs[tix]))) { continue; }
+				ltargs[tix].reactor = true;
+				log_info(&state, 2, "%s will be handled by I/O reactor",
+				         ltargs[tix].tag);
+			}
+			if (!reactor_start(&reactor)) {
+				log_error(&state, "Unable to start I/O reactor");
+				nextExit = true;
+				shutdownFlag = true; // Ensure threads aware
+			}
+		} else {
+			log_warning(&state, "Unable to initialise I/O reactor, using dedicated "
+			                    "threads for all data sources");
+		}
+	}
+
+	for (int tix = 0; tix < nThreads && !nextExit; tix++) {
+		if (ltargs[tix].reactor) {
+			if (ltargs[tix].funcs.channels) {
+				ltargs[tix].funcs.channels(&ltargs[tix]);
+			}
+			continue;
+		}
 		if (!ltargs[tix].funcs.logging) {
 			log_error(&state,
 			          "Unable to launch thread %s - no logging function provided",
@@ -479,6 +824,7 @@ int main(int argc, char *argv[]) {
 			shutdownFlag = true; // Ensure threads aware
 			for (int it = tix - 1; it >= 0; --it) {
 				if (it < 0) { break; }
+				if (ltargs[it].reactor) { continue; }
 				pthread_join(threads[it], NULL);
 				if (ltargs[it].returnCode != 0) {
 					log_error(&state, "Thread %d has signalled an error: %d",
@@ -494,6 +840,7 @@ int main(int argc, char *argv[]) {
 			shutdownFlag = true; // Ensure threads aware
 			for (int it = tix - 1; it >= 0; --it) {
 				if (it < 0) { break; }
+				if (ltargs[it].reactor) { continue; }
 				pthread_join(threads[it], NULL);
 				if (ltargs[it].returnCode != 0) {
 					log_error(&state, "Thread %d has signalled an error: %d",
@@ -512,6 +859,7 @@ int main(int argc, char *argv[]) {
 	}
 
 	if (nextExit) {
+		reactor_destroy(&reactor);
 		for (int i = 0; i < nThreads; i++) {
 			if (ltargs[i].tag) { free(ltargs[i].tag); }
 			if (ltargs[i].type) { free(ltargs[i].type); }
@@ -530,18 +878,9 @@ int main(int argc, char *argv[]) {
 	fflush(stdout);
 	log_info(&state, 1, "Startup complete");
 
-	if (!log_softwareVersion(&log_queue)) {
-		log_error(&state, "Error pushing version message to queue");
-		for (int i = 0; i < nThreads; i++) {
-			if (ltargs[i].tag) { free(ltargs[i].tag); }
-			if (ltargs[i].type) { free(ltargs[i].type); }
-			if (ltargs[i].dParams) { free(ltargs[i].dParams); }
-		}
-		free(ltargs);
-		destroy_global_opts(&go);
-		destroy_program_state(&state);
-		free(threads);
-		return EXIT_FAILURE;
+	if (!log_softwareVersion(log_queue) || !log_localChannels(log_queue)) {
+		// This thread empties the queue, so can't wait for space here
+		log_warning(&state, "Message queue full - software version not recorded");
 	}
 
 	/***
@@ -559,20 +898,86 @@ int main(int argc, char *argv[]) {
 	// Last 'tick' / timestamp value seen
 	uint32_t lastTimestamp = 0;
 
-	// Last statefile save time
-	time_t lastSave = 0;
-
+	// State file is written out by a background thread
+	log_state stateFile = {0};
 	if (go.saveState) {
+		if (!state_init(&stateFile, go.stateName)) {
+			log_error(&state, "Unable to allocate state file buffers");
+			return -1;
+		}
+		// Initial write made directly, so that errors are caught early
 		errno = 0;
-		if (!write_state_file(go.stateName, stats, lastTimestamp, varFileName)) {
+		if (!state_update(&stateFile, stats, lastTimestamp, varFileName) ||
+		    !state_write(&stateFile)) {
 			log_error(&state, "Unable to write out state file: %s", strerror(errno));
+			state_destroy(&stateFile);
+			return -1;
+		}
+	}
+
+	// Live value table for external monitoring, if enabled
+	live_table live = {.handle = -1};
+	if (go.liveTable) {
+		if (!live_create(&live, go.liveName, SLSOURCE_TIMER)) {
+			log_error(&state, "Unable to create live value table %s: %s", go.liveName,
+			          strerror(errno));
 			return -1;
 		}
+		log_info(&state, 2, "Publishing live values to shared memory as %s", go.liveName);
 	}
-	lastSave = time(NULL);
 
-	// Loop count. Used to avoid checking e.g. date on every iteration
-	unsigned int loopCount = 0;
+	// Buffered output for data and variable files
+	mp_writer datWriter = {0};
+	mp_writer varWriter = {0};
+	// Messages are packed and written to the data file by a separate thread
+	// unless disabled
+	bool writerOK = false;
+	if (go.writeQueue >= 2) {
+		writerOK = mp_writer_init_async(&datWriter, fileno(go.monitorFile), 0,
+		                                go.flushInterval, go.writeQueue);
+	} else {
+		writerOK = mp_writer_init(&datWriter, fileno(go.monitorFile), 0, go.flushInterval);
+	}
+	if (!writerOK || !mp_writer_init(&varWriter, fileno(go.varFile), 0, go.flushInterval)) {
+		log_error(&state, "Unable to allocate output buffers");
+		return -1;
+	}
+	if (!mp_writer_set_sync(&datWriter, go.syncMode, go.syncInterval, go.syncBytes) ||
+	    !mp_writer_set_sync(&varWriter, go.syncMode, go.syncInterval, go.syncBytes)) {
+		log_error(&state, "Unable to configure output file durability");
+		return -1;
+	}
+	mp_writer_set_prealloc(&datWriter, go.preallocate);
+	if (go.latency) { mp_writer_set_latency(&datWriter, &latency.write); }
+	mp_writer_set_blocks(&datWriter, go.blocks, SLSOURCE_TIMER);
+	const uint64_t maxBytes = (uint64_t)go.maxSize * 1024 * 1024;
+
+	// Time index for data file, if enabled
+	mp_index_writer idxWriter = {.handle = -1};
+	if (go.index && !mp_index_writer_init(&idxWriter, fileno(go.idxFile), SLSOURCE_TIMER,
+	                                      go.indexInterval)) {
+		log_error(&state, "Unable to write index file header: %s", strerror(errno));
+		return -1;
+	}
+	// Index is updated by the data writer, as each message is packed
+	if (go.index) { mp_writer_set_index(&datWriter, &idxWriter); }
+
+	// Opens replacement files in advance and closes old files on rotation
+	log_rotator rotator = {0};
+	if (!rotator_init(&rotator, go.dataPrefix, go.index)) {
+		log_error(&state, "Unable to start file rotation thread");
+		return -1;
+	}
+	time_t nextMidnight = 0; // Calculated on demand
+
+	// Deadlines for periodic tasks, against monotonic clock
+	int64_t nextCheck = monotonic_ms() + MAIN_CHECK_INTERVAL;
+	int64_t nextFlush = monotonic_ms() + MAIN_FLUSH_INTERVAL;
+	int64_t nextLaneReport = monotonic_ms() + MAIN_LANE_REPORT_INTERVAL;
+	int64_t nextLatencySummary = monotonic_ms() + MAIN_LATENCY_SUMMARY_INTERVAL;
+	int64_t nextSave = monotonic_ms() + (int64_t)go.stateInterval * 1000;
+	// Logger status messages discarded since last flush, due to full queue
+	unsigned int localDropped = 0;
 	while (!shutdownFlag) {
 		/*
 		 * Main application loop
@@ -586,9 +991,6 @@ int main(int argc, char *argv[]) {
 		 *
 		 */
 
-		// Increment on each iteration - used below to run tasks periodically
-		loopCount++;
-
 		// Check if any of the monitoring threads have exited with an error
 		for (int it = 0; it < nThreads; it++) {
 			if (ltargs[it].returnCode != 0) {
@@ -606,7 +1008,12 @@ int main(int argc, char *argv[]) {
 		// If we're not shutting down, Check if we need to pause
 		if (pauseLog && !shutdownFlag) {
 			log_info(&state, 0, "Logging paused");
-			// Flush outputs, we could be here for a while.
+			// Flush outputs, we could be here for a while. Data and
+			// variable file contents are held by the writers rather than in
+			// stdio buffers, so these need writing out separately.
+			if (!mp_writer_sync(&datWriter) || !mp_writer_sync(&varWriter)) {
+				log_error(&state, "Unable to write out buffered data: %s", strerror(errno));
+			}
 			fflush(NULL);
 			// Loop until either a) We're unpaused, b) We need to shutdown
 			while (pauseLog && !shutdownFlag) {
@@ -617,7 +1024,9 @@ int main(int argc, char *argv[]) {
 		}
 
 		// Periodic jobs that don't need checking/testing every iteration
-		if ((loopCount % 200 == 0)) {
+		const int64_t loopNow = monotonic_ms();
+		if (loopNow >= nextCheck) {
+			nextCheck = loopNow + MAIN_CHECK_INTERVAL;
 			if (go.rotateMonitor) {
 				/*
 				 * During testing of software on the previous project, the
@@ -634,34 +1043,100 @@ int main(int argc, char *argv[]) {
 				if (now->tm_yday != mon_yday) {
 					rotateNow = true;
 					mon_nextyday = now->tm_yday;
+				} else {
+					if (nextMidnight == 0) {
+						struct tm midnight = *now;
+						midnight.tm_mday++;
+						midnight.tm_hour = 0;
+						midnight.tm_min = 0;
+						midnight.tm_sec = 0;
+						midnight.tm_isdst = -1;
+						nextMidnight = mktime(&midnight);
+					}
+					// Open tomorrow's files shortly before they are needed,
+					// unless today's are still required for a pending rotation
+					if (!rotateNow &&
+					    (nextMidnight - timeNow) <= ROTATE_PREPARE_LEAD) {
+						rotator_prepare(&rotator, nextMidnight);
+					}
 				}
 			}
+		}
 
-			if ((loopCount % 1000) == 0) {
-				/*
-				 * Our longest interval check (for now), so we can reset
-				 * the counter here. Note that the interval here (1000)
-				 * must be a multiple of the outer interval (200),
-				 * otherwise this check needs to be moved out a level
-				 */
-				fflush(NULL);
-				if (go.saveState) {
-					time_t now = time(NULL);
-					if ((now - lastSave) > 60) {
-						errno = 0;
-						if (!write_state_file(go.stateName, stats,
-						                      lastTimestamp,
-						                      varFileName)) {
-							log_error(
-								&state,
-								"Unable to write out state file: %s",
-								strerror(errno));
-							return -1;
-						}
-						lastSave = now;
+		if (go.saveState && loopNow >= nextSave) {
+			nextSave = loopNow + (int64_t)go.stateInterval * 1000;
+			// Only channels updated since the last save are copied here
+			errno = 0;
+			if (!state_update(&stateFile, stats, lastTimestamp, varFileName) ||
+			    !state_request(&stateFile)) {
+				log_error(&state, "Unable to write out state file: %s", strerror(errno));
+				return -1;
+			}
+		}
+
+		if (loopNow >= nextFlush) {
+			nextFlush = loopNow + MAIN_FLUSH_INTERVAL;
+			fflush(NULL);
+
+			{
+				// Report worst case write performance since last report
+				mp_writer_stats ws = {0};
+				mp_writer_get_stats(&datWriter, &ws, true);
+				msg_t *lagMsg = msg_new_float(SLSOURCE_LOCAL, SLCHAN_LOCAL_WRITE_LAG, ws.maxLag);
+				msg_t *wtMsg = msg_new_float(SLSOURCE_LOCAL, SLCHAN_LOCAL_WRITE_TIME, ws.maxLatency);
+				// Status messages are discarded if the queue is full, as
+				// only this thread can make space in it
+				if (!queue_try_push(log_queue, lagMsg)) {
+					msg_free(lagMsg);
+					localDropped++;
+				}
+				if (!queue_try_push(log_queue, wtMsg)) {
+					msg_free(wtMsg);
+					localDropped++;
+				}
+				if (go.syncMode != MP_SYNC_NONE) {
+					msg_t *stMsg = msg_new_float(SLSOURCE_LOCAL, SLCHAN_LOCAL_SYNC_TIME,
+					                             ws.maxSyncTime);
+					msg_t *usMsg = msg_new_float(SLSOURCE_LOCAL, SLCHAN_LOCAL_UNSYNCED,
+					                             ws.maxUnsynced);
+					if (!queue_try_push(log_queue, stMsg)) {
+						msg_free(stMsg);
+						localDropped++;
+					}
+					if (!queue_try_push(log_queue, usMsg)) {
+						msg_free(usMsg);
+						localDropped++;
+					}
+				}
+			}
+
+			if (go.latency) {
+				// Combined percentiles are logged as data, per source values
+				// are summarised in the log file less frequently
+				if (!latency_report(&latency, log_queue)) { localDropped++; }
+				if (loopNow >= nextLatencySummary) {
+					nextLatencySummary = loopNow + MAIN_LATENCY_SUMMARY_INTERVAL;
+					latency_summary(&latency, &state, stats);
+				}
+			}
+
+			if (go.useLanes && loopNow >= nextLaneReport) {
+				// Report largest backlog seen for each source since last report
+				nextLaneReport = loopNow + MAIN_LANE_REPORT_INTERVAL;
+				for (int tix = 0; tix < nThreads; tix++) {
+					size_t peak = lanes_peak(&log_lanes, tix + 1, true);
+					if (peak > 0) {
+						log_info(&state, 2, "Peak queue depth for %s: %zu",
+						         ltargs[tix].tag, peak);
 					}
 				}
-				loopCount = 0;
+			}
+
+			if (localDropped > 0) {
+				log_warning(&state,
+				            "Message queue full - %u Logger status messages discarded",
+				            localDropped);
+				localDropped = 0;
 			}
 		}
 
@@ -675,163 +1150,173 @@ int main(int argc, char *argv[]) {
 			 * rotateNow flag will only be set if triggered by a signal, so
 			 * this allows rotating logs on an external trigger even if
 			 * automatic rotation is disabled.
+			 *
+			 * The new files are opened by a background thread, usually
+			 * in advance. If they aren't ready yet, this block is skipped
+			 * and messages continue to be written to the existing files
+			 * until they are.
 			 */
+			log_fileset next = {0};
+			if (rotator_take(&rotator, &next, time(NULL))) {
+				if (next.dat == NULL) {
+					// If the error is likely to be too many data files,
+					// continue with the old files. For all other errors, we
+					// exit.
+					if (errno == EEXIST) {
+						log_error(
+							&state,
+							"Unable to open new files - too many files created with this prefix today?");
+					} else {
+						log_error(&state, "Unable to open new files: %s",
+						          strerror(errno));
+						return -1;
+					}
+				} else {
+					log_info(&state, 0, "Rotating log files");
+					// Index is idle until the next message is added
+					if (!mp_writer_set_handle(&datWriter, fileno(next.dat)) ||
+					    !mp_writer_set_handle(&varWriter, fileno(next.var))) {
+						log_error(&state, "Unable to write out data to log file: %s",
+						          strerror(errno));
+						return -1;
+					}
+					if (go.index && !mp_index_writer_set_handle(&idxWriter, fileno(next.idx))) {
+						log_error(&state, "Unable to write out index file: %s",
+						          strerror(errno));
+						return -1;
+					}
 
-			log_info(&state, 0, "Rotating log files");
+					// Old files are closed in the background
+					rotator_close(&rotator, go.monitorFile);
+					go.monitorFile = next.dat;
+					rotator_close(&rotator, go.varFile);
+					go.varFile = next.var;
+					if (go.index) {
+						rotator_close(&rotator, go.idxFile);
+						go.idxFile = next.idx;
+					}
+					FILE *oldLog = state.log;
+					state.log = next.log;
+					rotator_close(&rotator, oldLog);
+					free(go.monFileStem);
+					go.monFileStem = next.stem;
+
+					free(varFileName);
+					varFileName = NULL;
+					if (asprintf(&varFileName, "%s.%s", go.monFileStem, "var") < 0) {
+						log_error(&state,
+						          "Failed to allocate memory for variable file name: %s",
+						          strerror(errno));
+					}
+					log_info(&state, 2, "Using data file %s.dat", go.monFileStem);
+					log_info(&state, 2, "Using log file %s.log", go.monFileStem);
+					log_info(&state, 2, "Using variable file %s.var", go.monFileStem);
+					if (go.index) {
+						log_info(&state, 2, "Using index file %s.idx", go.monFileStem);
+					}
 
-			// "Monitor" / main data file rotation
-			errno = 0;
+					// Re-request channel names for the new files
+					for (int tix = 0; tix < nThreads; tix++) {
+						if (ltargs[tix].funcs.channels) {
+							ltargs[tix].funcs.channels(&ltargs[tix]);
+						}
+					}
 
-			FILE *newMonitor = NULL;
-			char *newMonFileStem = NULL;
-			newMonitor = openSerialNumberedFile(go.dataPrefix, "dat", &newMonFileStem);
-
-			if (newMonitor == NULL) {
-				// If the error is likely to be too many data files,
-				// continue with the old handle. For all other errors, we
-				// exit.
-				if (errno == EEXIST) {
-					log_error(
-						&state,
-						"Unable to open data file - too many files created with this prefix today?");
-				} else {
-					log_error(&state, "Unable to open data file: %s",
-					          strerror(errno));
-					return -1;
-				}
-			} else {
-				fclose(go.monitorFile);
-				go.monitorFile = newMonitor;
-				free(go.monFileStem);
-				go.monFileStem = newMonFileStem;
-				log_info(&state, 2, "Using data file %s.dat", go.monFileStem);
-			}
+					if (!log_softwareVersion(log_queue) ||
+					    !log_localChannels(log_queue)) {
+						log_warning(&state, "Message queue full - software "
+						                    "version not recorded");
+					}
 
-			// As above, but for the log file
-			FILE *newLog = NULL;
-			errno = 0;
-			{
-				char *logFileName = NULL;
-				if (asprintf(&logFileName, "%s.%s", go.monFileStem, "log") < 0) {
-					log_error(
-						&state,
-						"Failed to allocate memory for log file name: %s",
-						strerror(errno));
-				}
-				newLog = fopen(logFileName, "w+x");
-				free(logFileName);
-			}
-			if (newLog == NULL) {
-				// As above, if the issue is log file names then we
-				// continue with the existing file
-				if (errno == EEXIST) {
-					log_error(
-						&state,
-						"Unable to open log file - mismatch between log files and data file names?");
-				} else {
-					log_error(&state, "Unable to open log file: %s",
-					          strerror(errno));
-					return -1;
+					log_info(&state, 0,
+					         "%d messages read successfully - resetting count",
+					         msgCount);
+					msgCount = 0;
 				}
-			} else {
-				FILE *oldLog = state.log;
-				state.log = newLog;
-				fclose(oldLog);
-				log_info(&state, 2, "Using log file %s.log", go.monFileStem);
+				mon_yday = mon_nextyday;
+				nextMidnight = 0;
+				rotateNow = false;
 			}
+		}
 
-			FILE *newVar = NULL;
-			errno = 0;
-
-			if (varFileName) {
-				free(varFileName);
-				varFileName = NULL;
-			}
-			if (asprintf(&varFileName, "%s.%s", go.monFileStem, "var") < 0) {
-				log_error(&state,
-				          "Failed to allocate memory for variable file name: %s",
+		// Check for waiting messages to be logged
+		msg_t *batch[MAIN_BATCH_SIZE];
+		const size_t nMsgs = lanes_pop_batch(&log_lanes, batch, MAIN_BATCH_SIZE);
+		if (nMsgs == 0) {
+			/*
+			 * No data waiting, so sleep until either a message is pushed
+			 * or the next periodic task is due. Signals delivered to
+			 * this thread will also end the wait early.
+			 */
+			int64_t nextTask = (nextCheck < nextFlush ? nextCheck : nextFlush);
+			if (go.saveState && nextSave < nextTask) { nextTask = nextSave; }
+			int64_t wait = nextTask - monotonic_ms();
+			const int datWait = mp_writer_next_flush(&datWriter);
+			const int varWait = mp_writer_next_flush(&varWriter);
+			if (datWait >= 0 && datWait < wait) { wait = datWait; }
+			if (varWait >= 0 && varWait < wait) { wait = varWait; }
+			if (wait > 0) { lanes_wait(&log_lanes, (int)wait); }
+			if (!mp_writer_tick(&datWriter) || !mp_writer_tick(&varWriter)) {
+				log_error(&state, "Unable to write out data to log file: %s",
 				          strerror(errno));
+				return -1;
 			}
-			newVar = fopen(varFileName, "w+x");
+			continue;
+		}
 
-			if (newVar == NULL) {
-				// As above, if the issue is log file names then we
-				// continue with the existing file
-				if (errno == EEXIST) {
-					log_error(
-						&state,
-						"Unable to open variable file - mismatch between variable file and data file names?");
-				} else {
-					log_error(&state, "Unable to open variable file: %s",
-					          strerror(errno));
-					return -1;
-				}
-			} else {
-				// We're the only thread writing to the .var file, so
-				// fewer shenanigans required.
-				fclose(go.varFile);
-				log_info(&state, 2, "Using variable file %s.var", go.monFileStem);
-				go.varFile = newVar;
+		if (go.latency) { latency_dequeue(&latency, batch, nMsgs); }
+		for (size_t mi = 0; mi < nMsgs; mi++) {
+			msg_t *res = batch[mi];
+			msgCount++;
+			if (!mp_writer_add(&datWriter, res)) {
+				log_error(&state, "Unable to write out data to log file: %s",
+				          strerror(errno));
+				return -1;
 			}
-
-			// Re-request channel names for the new files
-			for (int tix = 0; tix < nThreads; tix++) {
-				if (ltargs[tix].funcs.channels) {
-					ltargs[tix].funcs.channels(&ltargs[tix]);
-				}
+			if (res->type == SLCHAN_MAP || res->type == SLCHAN_NAME) {
+				mp_writer_add(&varWriter, res);
 			}
 
-			if (!log_softwareVersion(&log_queue)) {
-				log_error(&state,
-				          "Unable to push software version message to queue");
-				return -1;
+			if (res->type == SLCHAN_TSTAMP && res->source == 0x02) {
+				lastTimestamp = res->data.timestamp;
 			}
 
-			log_info(&state, 0, "%d messages read successfully - resetting count",
-			         msgCount);
-			msgCount = 0;
-			mon_yday = mon_nextyday;
-			rotateNow = false;
-		}
+			stats[res->source][res->type].count++;
+			stats[res->source][res->type].lastTimestamp = lastTimestamp;
+			state_touch(&stateFile, res->source, res->type);
+			if (go.liveTable) { live_update(&live, res, lastTimestamp); }
 
-		// Check for waiting messages to be logged
-		msg_t *res = queue_pop(&log_queue);
-		if (res == NULL) {
-			// No data waiting, so sleep for a little bit and go back around
-			usleep(5 * SERIAL_SLEEP);
-			continue;
+			// If we have an existing message retained, destroy and free it
+			if (stats[res->source][res->type].lastMessage) {
+				msg_free(stats[res->source][res->type].lastMessage);
+			}
+			// "Move" message into the stats structure
+			stats[res->source][res->type].lastMessage = res;
+			batch[mi] = NULL;
 		}
-		msgCount++;
-		if (!mp_writeMessage(fileno(go.monitorFile), res)) {
-			log_error(&state, "Unable to write out data to log file: %s",
-			          strerror(errno));
+		if (!mp_writer_tick(&datWriter) || !mp_writer_tick(&varWriter)) {
+			log_error(&state, "Unable to write out data to log file: %s", strerror(errno));
 			return -1;
 		}
-		if (res->type == SLCHAN_MAP || res->type == SLCHAN_NAME) {
-			mp_writeMessage(fileno(go.varFile), res);
-		}
-
-		if (res->type == SLCHAN_TSTAMP && res->source == 0x02) {
-			lastTimestamp = res->data.timestamp;
-		}
 
-		stats[res->source][res->type].count++;
-		stats[res->source][res->type].lastTimestamp = lastTimestamp;
-
-		// If we have an existing message retained, destroy and free it
-		if (stats[res->source][res->type].lastMessage) {
-			msg_destroy(stats[res->source][res->type].lastMessage);
-			free(stats[res->source][res->type].lastMessage);
+		// Size based rotation, handled at the start of the next iteration
+		if (maxBytes > 0 && !rotateNow) {
+			const uint64_t datBytes = mp_writer_handle_bytes(&datWriter);
+			if (datBytes >= maxBytes) {
+				log_info(&state, 1, "Data file size limit reached");
+				rotateNow = true;
+			} else if (datBytes >= (maxBytes / 4) * 3) {
+				// Open replacement files in advance
+				rotator_prepare(&rotator, time(NULL));
+			}
 		}
-		// "Move" message into the stats structure
-		stats[res->source][res->type].lastMessage = res;
-		res = NULL;
 	}
 	state.shutdown = true;
 	shutdownFlag = true; // Ensure threads aware
 	log_info(&state, 1, "Shutting down");
+	reactor_stop(&reactor);
 	for (int it = 0; it < nThreads; it++) {
-		pthread_join(threads[it], NULL);
+		if (!ltargs[it].reactor) { pthread_join(threads[it], NULL); }
 		if (ltargs[it].returnCode != 0) {
 			log_error(&state, "Thread %d (%s) has signalled an error: %d", it,
 			          ltargs[it].tag, ltargs[it].returnCode);
@@ -841,6 +1326,7 @@ int main(int argc, char *argv[]) {
 	for (int tix = 0; tix < nThreads; tix++) {
 		ltargs[tix].funcs.shutdown(&(ltargs[tix]));
 	}
+	reactor_destroy(&reactor);
 
 	for (int i = 0; i < nThreads; i++) {
 		if (ltargs[i].tag) { free(ltargs[i].tag); }
@@ -850,21 +1336,75 @@ int main(int argc, char *argv[]) {
 	free(ltargs);
 	free(threads);
 
-	if (queue_count(&log_queue) > 0) {
-		log_info(&state, 2, "Processing remaining queued messages");
-		while (queue_count(&log_queue) > 0) {
-			msg_t *res = queue_pop(&log_queue);
-			msgCount++;
-			msgCount++;
-			mp_writeMessage(fileno(go.monitorFile), res);
-			msg_destroy(res);
-			free(res);
+	log_info(&state, 2, "Processing remaining queued messages");
+	{
+		msg_t *remaining[MAIN_BATCH_SIZE];
+		size_t nRemain = 0;
+		while ((nRemain = lanes_pop_batch(&log_lanes, remaining, MAIN_BATCH_SIZE)) > 0) {
+			for (size_t mi = 0; mi < nRemain; mi++) {
+				msgCount++;
+				mp_writer_add(&datWriter, remaining[mi]);
+				msg_free(remaining[mi]);
+			}
 		}
-		log_info(&state, 2, "Queue emptied");
 	}
-	queue_destroy(&log_queue);
+	if (!mp_writer_sync(&datWriter)) {
+		log_error(&state, "Unable to write out buffered data: %s", strerror(errno));
+	}
+	{
+		mp_writer_stats ws = {0};
+		mp_writer_get_stats(&datWriter, &ws, false);
+		log_info(&state, 2, "%" PRIu64 " bytes written to data file in %" PRIu64
+		         " writes (%" PRIu64 " stalls)", ws.bytes, ws.flushes, ws.stalls);
+		if (go.syncMode != MP_SYNC_NONE) {
+			log_info(&state, 2, "%" PRIu64 " data file syncs", ws.syncs);
+		}
+	}
+	if (!mp_writer_destroy(&datWriter) || !mp_writer_destroy(&varWriter)) {
+		log_error(&state, "Unable to write out buffered data: %s", strerror(errno));
+	}
+	if (go.index && !mp_index_writer_destroy(&idxWriter)) {
+		log_error(&state, "Unable to write out index file: %s", strerror(errno));
+	}
+	// Closes any rotated files still pending, and removes unused files
+	rotator_destroy(&rotator);
+	state_destroy(&stateFile);
+	if (go.liveTable) { live_destroy(&live); }
+	if (go.latency) {
+		// Includes any values not yet reported
+		latency_report(&latency, NULL);
+		latency_summary(&latency, &state, stats);
+		latency_destroy(&latency);
+	}
+	log_info(&state, 2, "Queue emptied");
+	lanes_destroy(&log_lanes);
 	log_info(&state, 2, "Message queue destroyed");
 
+	for (int s = 0; s < 128; s++) {
+		for (int c = 0; c < 128; c++) {
+			msg_free(stats[s][c].lastMessage);
+			stats[s][c].lastMessage = NULL;
+		}
+	}
+
+	if (pool_enabled()) {
+		pool_stats ps = {0};
+		pool_get_stats(&ps);
+		for (int c = 0; c < POOL_CLASSES; c++) {
+			if (ps.classes[c].allocs == 0) { continue; }
+			log_info(&state, 2,
+			         "Message pool (%zu bytes): %" PRIu64 " allocations, %" PRIu64
+			         " frees, %" PRIu64 " depot exchanges, %" PRIu64 " slabs",
+			         ps.classes[c].blockSize, ps.classes[c].allocs, ps.classes[c].frees,
+			         ps.classes[c].depotSwaps, ps.classes[c].slabs);
+		}
+		if (ps.oversize > 0) {
+			log_info(&state, 2, "Message pool: %" PRIu64 " oversize allocations",
+			         ps.oversize);
+		}
+		pool_destroy();
+	}
+
 	fclose(go.monitorFile);
 	free(go.monFileStem);
 	go.monitorFile = NULL;
@@ -920,15 +1460,68 @@ bool timespec_subtract(struct timespec *result, struct timespec *x, struct times
 }
 
 /*!
+ * Uses CLOCK_MONOTONIC, so is not affected by changes to the system clock.
+ * Used for scheduling periodic tasks in the main loop.
+ *
+ * @return Monotonic clock time in milliseconds
+ */
+int64_t monotonic_ms(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((int64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+/*!
+ * Called from the main thread, so does not wait for space in the queue.
+ *
  * @param[in] q Log queue
- * @return True on success
+ * @return True on success, false if the queue is full
  */
 bool log_softwareVersion(msgqueue *q) {
 	const char *version = "Logger version: " GIT_VERSION_STRING;
 	msg_t *verMsg = msg_new_string(SLSOURCE_LOCAL, SLCHAN_LOG_INFO, strlen(version), version);
-	if (!queue_push(q, verMsg)) {
-		msg_destroy(verMsg);
-		free(verMsg);
+	if (!queue_try_push(q, verMsg)) {
+		msg_free(verMsg);
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Describes the status channels generated by the Logger itself, so that they
+ * are included in the variable file.
+ *
+ * As with log_softwareVersion(), messages are discarded if the queue is full.
+ *
+ * @param[in] q Log queue
+ * @return True on success, false if the queue is full
+ */
+bool log_localChannels(msgqueue *q) {
+	const char *name = "Logger";
+	msg_t *nameMsg = msg_new_string(SLSOURCE_LOCAL, SLCHAN_NAME, strlen(name), name);
+	if (!queue_try_push(q, nameMsg)) {
+		msg_free(nameMsg);
+		return false;
+	}
+
+	strarray *channels = sa_new(14);
+	sa_create_entry(channels, SLCHAN_NAME, 4, "Name");
+	sa_create_entry(channels, SLCHAN_MAP, 8, "Channels");
+	sa_create_entry(channels, SLCHAN_LOCAL_WRITE_LAG, 9, "Write Lag");
+	sa_create_entry(channels, SLCHAN_LOCAL_WRITE_TIME, 10, "Write Time");
+	sa_create_entry(channels, SLCHAN_LOCAL_SYNC_TIME, 9, "Sync Time");
+	sa_create_entry(channels, SLCHAN_LOCAL_UNSYNCED, 15, "Unsynced Window");
+	sa_create_entry(channels, SLCHAN_LOCAL_QUEUE_P50, 17, "Queue Latency p50");
+	sa_create_entry(channels, SLCHAN_LOCAL_QUEUE_P99, 17, "Queue Latency p99");
+	sa_create_entry(channels, SLCHAN_LOCAL_QUEUE_MAX, 17, "Queue Latency max");
+	sa_create_entry(channels, SLCHAN_LOCAL_WRITE_P50, 17, "Write Latency p50");
+	sa_create_entry(channels, SLCHAN_LOCAL_WRITE_P99, 17, "Write Latency p99");
+	sa_create_entry(channels, SLCHAN_LOCAL_WRITE_MAX, 17, "Write Latency max");
+	msg_t *mapMsg = msg_new_string_array(SLSOURCE_LOCAL, SLCHAN_MAP, channels);
+	sa_destroy(channels);
+	free(channels);
+	if (!queue_try_push(q, mapMsg)) {
+		msg_free(mapMsg);
 		return false;
 	}
 	return true;
@@ -945,72 +1538,19 @@ void destroy_global_opts(struct global_opts *go) {
 	if (go->dataPrefix) { free(go->dataPrefix); }
 	if (go->stateName) { free(go->stateName); }
 	if (go->monFileStem) { free(go->monFileStem); }
+	if (go->liveName) { free(go->liveName); }
 
 	go->configFileName = NULL;
 	go->dataPrefix = NULL;
 	go->stateName = NULL;
 	go->monFileStem = NULL;
+	go->liveName = NULL;
 
 	if (go->monitorFile) { fclose(go->monitorFile); }
 	if (go->varFile) { fclose(go->varFile); }
+	if (go->idxFile) { fclose(go->idxFile); }
 
 	go->monitorFile = NULL;
 	go->varFile = NULL;
-}
-
-/*!
- * Truncates and recreates the state file, including last received message statistics, timestamps
- * and path to the channel mapping file currently in use. Any change to this output format also
- * needs to be reflected in SLFiles.py
- *
- * @todo Write to temporary file and atomically move into place
- *
- * @param[in] sFName Name and path to state file
- * @param[in] stats Channel statistics array
- * @param[in] lTS Last received timestamp
- * @param[in] vFName Name and path to current channel mapping file
- * @return False if unable to create state file, True otherwise
- */
-bool write_state_file(char *sFName, channel_stats stats[128][128], uint32_t lTS, char *vFName) {
-	char *tmptmp = NULL;
-	char *sfn = strdup(sFName);
-	char *dn = dirname(sfn);
-	if (asprintf(&tmptmp, "%s/stateXXXXXX", dn) < 0) {
-		perror("write_state_file:asprintf");
-		free(sfn);
-		return false;
-	}
-	// free(dn); - Don't free this, as  it points into sfn, which is why we strdup it to begin with
-	free(sfn);
-	sfn = NULL;
-	dn = NULL;
-
-	int sfilefd = mkstemp(tmptmp);
-	FILE *stateFile = fdopen(sfilefd, "w");
-	if (stateFile == NULL) { return false; }
-	fprintf(stateFile, "%u\n", lTS);
-	fprintf(stateFile, "%s\n", vFName);
-	for (int s = 0; s < 128; s++) {
-		for (int c = 0; c < 128; c++) {
-			if (stats[s][c].count > 0) {
-				fprintf(stateFile, "0x%02x,0x%02x,%u,%u,\'%s\'\n", s, c,
-				        stats[s][c].count, stats[s][c].lastTimestamp,
-				        msg_data_to_string(stats[s][c].lastMessage));
-			}
-		}
-	}
-	fclose(stateFile);
-
-	errno = 0;
-	if (rename(tmptmp, sFName) < 0) {
-		perror("write_state_file:rename");
-		unlink(tmptmp);
-		return false;
-	}
-	if (!unlink(tmptmp)) {
-		perror("write_state_file:unlink");
-		// While not ideal don't want to stop logging in this instance, so return true
-		// anyway
-	}
-	return true;
+	go->idxFile = NULL;
 }
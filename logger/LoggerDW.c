@@ -240,7 +240,7 @@ void *dw_logging(void *ptargs) {
 		if (!queue_push(args->logQ, sm)) {
 			log_error(args->pstate, "[DW:%s] Error pushing message to queue",
 			          args->tag);
-			msg_destroy(sm);
+			msg_free(sm);
 			args->returnCode = -1;
 			pthread_exit(&(args->returnCode));
 		}
@@ -271,7 +271,7 @@ void dw_push_message(log_thread_args_t *args, uint8_t sNum, uint8_t cNum, float
 	}
 	if (!queue_push(args->logQ, mm)) {
 		log_error(args->pstate, "[DW:%s] Error pushing data to queue", args->tag);
-		msg_destroy(mm);
+		msg_free(mm);
 		args->returnCode = -1;
 		pthread_exit(&(args->returnCode));
 	}
@@ -390,8 +390,11 @@ dw_params dw_getParams() {
 /*!
  * Populate list of channels and push to queue as a map message
  *
+ * Called by the main thread, which consumes the queue, so messages are
+ * discarded rather than waiting if the queue is full.
+ *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - terminates thread on error
+ * @returns NULL
  */
 void *dw_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -400,11 +403,10 @@ void *dw_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(dwInfo->sourceNum, SLCHAN_NAME, strlen(dwInfo->sourceName),
 	                             dwInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[DW:%s] Error pushing channel name to queue", args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	int nChans = 17;
@@ -448,13 +450,12 @@ void *dw_channels(void *ptargs) {
 	}
 	msg_t *m_cmap = msg_new_string_array(dwInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[DW:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
@@ -108,11 +108,71 @@ void *gps_setup(void *ptargs) {
 	return NULL;
 }
 
+/*!
+ * Converts a message received from the device into messages for the queue.
+ *
+ * NAV-TIMEUTC and NAV-PVT messages are decoded, and the raw message is added
+ * if it was not decoded (or if gps_params.dumpAll is set).
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @param[in] out Message received from device
+ * @param[out] qm Array with space for at least 4 further messages
+ * @returns Number of messages added to qm
+ */
+static size_t gps_convert(log_thread_args_t *args, const ubx_message *out, msg_t **qm) {
+	gps_params *gpsInfo = (gps_params *)args->dParams;
+	size_t k = 0;
+	bool handled = false;
+	if (out->msgClass == UBXNAV && out->msgID == 0x21) {
+		// Extract GPS ToW
+		uint32_t ts = out->data[0] + (out->data[1] << 8) + (out->data[2] << 16) +
+		              (out->data[3] << 24);
+		qm[k++] = msg_new_timestamp(gpsInfo->sourceNum, SLCHAN_TSTAMP, ts);
+		handled = true;
+	} else if (out->msgClass == UBXNAV && out->msgID == 0x07) {
+		// NAV-PVT
+		ubx_nav_pvt nav = {0};
+		if (!ubx_decode_nav_pvt(out, &nav)) {
+			log_error(args->pstate, "[GPS:%s] Unable to decode NAV-PVT message",
+			          args->tag);
+		} else {
+			float posData[6] = {nav.longitude,       nav.latitude,
+			                    nav.height * 1E-3,   nav.ASL * 1E-3,
+			                    nav.horizAcc * 1E-3, nav.vertAcc * 1E-3};
+
+			float velData[7] = {nav.northV * 1E-3, nav.eastV * 1E-3,
+			                    nav.downV * 1E-3,  nav.groundSpeed * 1E-3,
+			                    nav.heading,       nav.speedAcc * 1E-3,
+			                    nav.headingAcc};
+
+			float dt[8] = {nav.year,   nav.month,  nav.day,        nav.hour,
+			               nav.minute, nav.second, nav.nanosecond, nav.accuracy};
+
+			qm[k++] = msg_new_float_array(gpsInfo->sourceNum, 4, 6, posData);
+			qm[k++] = msg_new_float_array(gpsInfo->sourceNum, 5, 7, velData);
+			qm[k++] = msg_new_float_array(gpsInfo->sourceNum, 6, 8, dt);
+			handled = true;
+		}
+	}
+	if (!handled || gpsInfo->dumpAll) {
+		uint8_t *data = NULL;
+		ssize_t len = ubx_flat_array(out, &data);
+		qm[k++] = msg_new_bytes(gpsInfo->sourceNum, 3, len, data);
+		if (data) {
+			// Copied into message, so can safely free here
+			free(data);
+		}
+	}
+	return k;
+}
+
 /*!
  * Takes a gps_params struct (passed via log_thread_args_t)
  *
  * Reads messages from a device configured with gps_setup() and pushes them to
- * the message queue.
+ * the message queue. Each read from the device is followed by decoding all
+ * complete messages buffered (up to SOURCE_BATCH_SIZE), which are queued in a
+ * single operation.
  *
  * Exits on error or when shutdown is signalled.
  *
@@ -126,95 +186,46 @@ void *gps_logging(void *ptargs) {
 
 	log_info(args->pstate, 1, "[GPS:%s] Logging thread started", args->tag);
 
-	uint8_t *buf = calloc(UBX_SERIAL_BUFF, sizeof(uint8_t));
-	int ubx_index = 0;
-	int ubx_hw = 0;
+	byte_ring ring = {0};
+	if (!ring_init(&ring, UBX_SERIAL_BUFF)) {
+		log_error(args->pstate, "[GPS:%s] Unable to allocate input buffer", args->tag);
+		args->returnCode = -1;
+		pthread_exit(&(args->returnCode));
+	}
 	while (!shutdownFlag) {
-		ubx_message out = {0};
-		if (ubx_readMessage_buf(gpsInfo->handle, &out, buf, &ubx_index, &ubx_hw)) {
-			uint8_t *data = NULL;
-			ssize_t len = ubx_flat_array(&out, &data);
-			bool handled = false;
-			if (out.msgClass == UBXNAV && out.msgID == 0x21) {
-				// Extract GPS ToW
-				uint32_t ts = out.data[0] + (out.data[1] << 8) +
-				              (out.data[2] << 16) + (out.data[3] << 24);
-				msg_t *utc =
-					msg_new_timestamp(gpsInfo->sourceNum, SLCHAN_TSTAMP, ts);
-				if (!queue_push(args->logQ, utc)) {
-					log_error(args->pstate,
-					          "[GPS:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(utc);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
-				handled = true;
-			} else if (out.msgClass == UBXNAV && out.msgID == 0x07) {
-				// NAV-PVT
-				ubx_nav_pvt nav = {0};
-				if (!ubx_decode_nav_pvt(&out, &nav)) {
-					log_error(args->pstate,
-					          "[GPS:%s] Unable to decode NAV-PVT message",
-					          args->tag);
-				} else {
-					float posData[6] = {
-						nav.longitude,       nav.latitude,
-						nav.height * 1E-3,   nav.ASL * 1E-3,
-						nav.horizAcc * 1E-3, nav.vertAcc * 1E-3};
-
-					float velData[7] = {
-						nav.northV * 1E-3, nav.eastV * 1E-3,
-						nav.downV * 1E-3,  nav.groundSpeed * 1E-3,
-						nav.heading,       nav.speedAcc * 1E-3,
-						nav.headingAcc};
-
-					float dt[8] = {nav.year,       nav.month,   nav.day,
-					               nav.hour,       nav.minute,  nav.second,
-					               nav.nanosecond, nav.accuracy};
-
-					// clang-format off
-					msg_t *mnav = msg_new_float_array(gpsInfo->sourceNum, 4, 6, posData);
-					msg_t *mvel = msg_new_float_array(gpsInfo->sourceNum, 5, 7, velData);
-					msg_t *mdt = msg_new_float_array(gpsInfo->sourceNum, 6, 8, dt);
-					// clang-format on
-
-					if (!queue_push(args->logQ, mnav) ||
-					    !queue_push(args->logQ, mvel) ||
-					    !queue_push(args->logQ, mdt)) {
-						log_error(
-							args->pstate,
-							"[GPS:%s] Error pushing messages to queue",
-							args->tag);
-						msg_destroy(mnav);
-						msg_destroy(mvel);
-						msg_destroy(mdt);
-						args->returnCode = -1;
-						pthread_exit(&(args->returnCode));
-					}
-					handled = true;
-				}
-			}
-			if (!handled || gpsInfo->dumpAll) {
-				msg_t *sm = msg_new_bytes(gpsInfo->sourceNum, 3, len, data);
-				if (!queue_push(args->logQ, sm)) {
-					log_error(args->pstate,
-					          "[GPS:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(sm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
+		ubx_message out[SOURCE_BATCH_SIZE] = {0};
+		msg_t *qm[4 * SOURCE_BATCH_SIZE] = {0};
+		const size_t n =
+			ubx_readMessage_batch(gpsInfo->handle, out, SOURCE_BATCH_SIZE, &ring);
+		size_t k = 0;
+		for (size_t i = 0; i < n; i++) {
+			k += gps_convert(args, &(out[i]), &(qm[k]));
+			// Similarly, we are finished with this copy
+			if (out[i].extdata) { free(out[i].extdata); }
+		}
+
+		if (k > 0) {
+			// Do not destroy or free queued msg_t objects here
+			// After pushing them to the queue, it is the responsibility
+			// of the consumer to dispose of them after use.
+			const size_t pushed = queue_push_batch(args->logQ, qm, k);
+			if (pushed < k) {
+				log_error(args->pstate, "[GPS:%s] Error pushing messages to queue",
+				          args->tag);
+				for (size_t i = pushed; i < k; i++) {
+					msg_free(qm[i]);
 				}
+				if (n < SOURCE_BATCH_SIZE) { free(out[n].extdata); }
+				ring_destroy(&ring);
+				args->returnCode = -1;
+				pthread_exit(&(args->returnCode));
 			}
-			if (data) {
-				// Copied into message, so can safely free here
-				free(data);
-			}
-			// Do not destroy or free sm (or other msg_t objects) here
-			// After pushing it to the queue, it is the responsibility of the
-			// consumer to dispose of it after use.
-		} else {
-			if (!(out.sync1 == 0xFF || out.sync1 == 0xFD || out.sync1 == 0xEE)) {
+		}
+
+		if (n < SOURCE_BATCH_SIZE) {
+			const uint8_t status = out[n].sync1;
+			if (out[n].extdata) { free(out[n].extdata); }
+			if (!(status == 0xFF || status == 0xFD || status == 0xEE)) {
 				// 0xFF, 0xFD and 0xEE are used to signal recoverable
 				// states that resulted in no valid message.
 				//
@@ -224,25 +235,19 @@ void *gps_logging(void *ptargs) {
 				//
 				// 0xEE indicates an invalid message following valid sync bytes
 				log_error(args->pstate,
-				          "[GPS:%s] Error signalled from gps_readMessage_buf",
+				          "[GPS:%s] Error signalled from ubx_readMessage_batch",
 				          args->tag);
 				args->returnCode = -2;
-				free(buf);
-				if (out.extdata) { free(out.extdata); }
+				ring_destroy(&ring);
 				pthread_exit(&(args->returnCode));
 			}
 			// We've already exited (via pthread_exit) for error
 			// cases, so at this point sleep briefly and wait for
 			// more data
-			usleep(SERIAL_SLEEP);
-		}
-
-		// Clean up before next iteration
-		if (out.extdata) { // Similarly, we are finished with this copy
-			free(out.extdata);
+			if (n == 0) { usleep(SERIAL_SLEEP); }
 		}
 	}
-	free(buf);
+	ring_destroy(&ring);
 	log_info(args->pstate, 1, "[GPS:%s] Logging thread exiting", args->tag);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
@@ -276,10 +281,11 @@ void *gps_shutdown(void *ptargs) {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Terminates thread on error
+ * Messages are discarded (with an error logged) if the queue is full, as
+ * this is called from the main thread.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Error code set in ptargs->returnCode if required
+ * @returns NULL
  */
 void *gps_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -288,11 +294,10 @@ void *gps_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(gpsInfo->sourceNum, SLCHAN_NAME, strlen(gpsInfo->sourceName),
 	                             gpsInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[GPS:%s] Error pushing channel name to queue", args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(7);
@@ -306,13 +311,12 @@ void *gps_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(gpsInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[GPS:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
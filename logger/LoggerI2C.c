@@ -83,7 +83,7 @@ void *i2c_logging(void *ptargs) {
 			if (!queue_push(args->logQ, msg)) {
 				log_error(args->pstate, "[I2C:%s] Error pushing message to queue",
 				          args->tag);
-				msg_destroy(msg);
+				msg_free(msg);
 				args->returnCode = -1;
 				pthread_exit(&(args->returnCode));
 			}
@@ -102,7 +102,7 @@ void *i2c_logging(void *ptargs) {
 		if (!queue_push(args->logQ, msg)) {
 			log_error(args->pstate, "[I2C:%s] Error pushing message to queue",
 			          args->tag);
-			msg_destroy(msg);
+			msg_free(msg);
 			args->returnCode = -1;
 			pthread_exit(&(args->returnCode));
 		}
@@ -155,10 +155,11 @@ void *i2c_shutdown(void *ptargs) {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Terminates thread on error
+ * Called from the main thread: if the queue is full the messages are
+ * dropped rather than waiting for space.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Error code set in ptargs->returnCode if required
+ * @returns NULL
  */
 void *i2c_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -167,11 +168,10 @@ void *i2c_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(i2cInfo->sourceNum, SLCHAN_NAME, strlen(i2cInfo->sourceName),
 	                             i2cInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[I2C:%s] Error pushing channel name to queue", args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	uint8_t maxID = 3;
@@ -192,13 +192,12 @@ void *i2c_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(i2cInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[I2C:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
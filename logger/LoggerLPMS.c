@@ -121,27 +121,40 @@ void *lpms_setup(void *ptargs) {
 }
 
 /*!
- * Create a floating point value message for the specified source and channel
- * numbers, and push it to the queue (Q). If unable to create or push the
- * message, tidy up and return false.
+ * Create a floating point value message for each of the LPMS_IMU_MESSAGES
+ * values logged from an IMU data message.
+ *
+ * Entries in `out` will be NULL if a message could not be allocated, which
+ * will cause queue_push_batch() to reject the whole set.
  *
  * Reduces code duplication in lpms_logging()
  *
- * @param[in] Q Pointer to message queue
  * @param[in] src Message source number
- * @param[in] chan Message type/channel number
- * @param[in] val Message value
- * @returns True on success, False on error
+ * @param[in] d Decoded IMU data
+ * @param[out] out Array with space for at least LPMS_IMU_MESSAGES messages
+ * @returns Number of messages written to out (LPMS_IMU_MESSAGES)
  */
-inline bool lpms_queue_message(msgqueue *Q, const uint8_t src, const uint8_t chan,
-                               const float val) {
-	msg_t *m = msg_new_float(src, chan, val);
-	if (m == NULL) { return false; }
-	if (!queue_push(Q, m)) {
-		msg_destroy(m);
-		return false;
+size_t lpms_imu_messages(const uint8_t src, const lpms_data *d, msg_t **out) {
+	const uint8_t chans[LPMS_IMU_MESSAGES] = {
+		CHAN_ACC_RAW_X, CHAN_ACC_RAW_Y, CHAN_ACC_RAW_Z, CHAN_ACC_CAL_X, CHAN_ACC_CAL_Y,
+		CHAN_ACC_CAL_Z, CHAN_G_RAW_X,   CHAN_G_RAW_Y,   CHAN_G_RAW_Z,   CHAN_G_CAL_X,
+		CHAN_G_CAL_Y,   CHAN_G_CAL_Z,   CHAN_G_ALIGN_X, CHAN_G_ALIGN_Y, CHAN_G_ALIGN_Z,
+		CHAN_OMEGA_X,   CHAN_OMEGA_Y,   CHAN_OMEGA_Z,   CHAN_ROLL,      CHAN_PITCH,
+		CHAN_YAW,       CHAN_ACC_LIN_X, CHAN_ACC_LIN_Y, CHAN_ACC_LIN_Z, CHAN_ALTITUDE};
+	const float vals[LPMS_IMU_MESSAGES] = {
+		d->accel_raw[0],    d->accel_raw[1],    d->accel_raw[2],
+		d->accel_cal[0],    d->accel_cal[1],    d->accel_cal[2],
+		d->gyro_raw[0],     d->gyro_raw[1],     d->gyro_raw[2],
+		d->gyro_cal[0],     d->gyro_cal[1],     d->gyro_cal[2],
+		d->gyro_aligned[0], d->gyro_aligned[1], d->gyro_aligned[2],
+		d->omega[0],        d->omega[1],        d->omega[2],
+		d->euler_angles[0], d->euler_angles[1], d->euler_angles[2],
+		d->accel_linear[0], d->accel_linear[1], d->accel_linear[2],
+		d->altitude};
+	for (int i = 0; i < LPMS_IMU_MESSAGES; i++) {
+		out[i] = msg_new_float(src, chans[i], vals[i]);
 	}
-	return true;
+	return LPMS_IMU_MESSAGES;
 }
 
 /*!
@@ -149,7 +162,9 @@ inline bool lpms_queue_message(msgqueue *Q, const uint8_t src, const uint8_t cha
  * queue. Data is not interpreted, just pushed into the queue with suitable headers.
  *
  * Message size is variable, based on min/max limits and the amount of data
- * available to read from the source.
+ * available to read from the source. All complete messages available after
+ * each read (up to SOURCE_BATCH_SIZE) are processed together, and the
+ * resulting data messages are queued in a single operation.
  *
  * Terminates thread in case of error.
  *
@@ -164,30 +179,27 @@ void *lpms_logging(void *ptargs) {
 	log_info(args->pstate, 1, "[LPMS:%s] Logging thread started", args->tag);
 	lpms_send_stream_mode(lpmsInfo->handle);
 
-	uint8_t *buf = calloc(LPMS_BUFF, sizeof(uint8_t));
-	size_t lpms_hw = 0;
-	size_t lpms_end = 0;
+	byte_ring ring = {0};
+	if (!ring_init(&ring, LPMS_BUFF)) {
+		log_error(args->pstate, "[LPMS:%s] Unable to allocate input buffer", args->tag);
+		args->returnCode = -1;
+		pthread_exit(&(args->returnCode));
+	}
 	uint32_t outputs = 0;
 	bool unitMismatch = false;
 	unsigned int pendingCount = 0;
 	unsigned int missingCount = 0;
 	while (!shutdownFlag) {
-		lpms_data d = {.present = outputs};
-		lpms_message *m = calloc(1, sizeof(lpms_message));
-		if (!m) {
-			perror("lpms_message calloc");
-			args->returnCode = -1;
-			pthread_exit(&(args->returnCode));
-			return NULL;
-		}
-		bool r = lpms_readMessage_buf(lpmsInfo->handle, m, buf, &lpms_end, &lpms_hw);
-		if (r) {
+		lpms_message ms[SOURCE_BATCH_SIZE] = {0};
+		msg_t *qm[(LPMS_IMU_MESSAGES + 1) * SOURCE_BATCH_SIZE] = {0};
+		size_t k = 0;
+		const size_t n =
+			lpms_readMessage_batch(lpmsInfo->handle, ms, SOURCE_BATCH_SIZE, &ring);
+		for (size_t i = 0; i < n; i++) {
+			lpms_message *m = &(ms[i]);
+			lpms_data d = {.present = outputs};
 			uint16_t cs = 0;
-			if (!(lpms_checksum(m, &cs) && cs == m->checksum)) {
-				free(m->data);
-				free(m);
-				continue;
-			}
+			if (!(lpms_checksum(m, &cs) && cs == m->checksum)) { continue; }
 			if ((m->id != lpmsInfo->unitID) && !unitMismatch) {
 				log_warning(
 					args->pstate,
@@ -210,18 +222,10 @@ void *lpms_logging(void *ptargs) {
 				char *lm = NULL;
 				int sl = asprintf(&lm, "LPMS Unit 0x%02x: Sensor model: %-24s",
 				                  m->id, (char *)m->data);
-				msg_t *sm = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO,
-				                           sl, lm);
+				qm[k++] = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO, sl,
+				                         lm);
 				free(lm);
 				lm = NULL;
-				if (!queue_push(args->logQ, sm)) {
-					log_error(args->pstate,
-					          "[LPMS:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(sm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
 			} else if (m->command == LPMS_MSG_GET_SERIALNUM) {
 				log_info(args->pstate, 1,
 				         "[LPMS:%s] Unit 0x%02x: Serial number: %-24s", args->tag,
@@ -229,18 +233,10 @@ void *lpms_logging(void *ptargs) {
 				char *lm = NULL;
 				int sl = asprintf(&lm, "LPMS Unit 0x%02x: Serial number: %-24s",
 				                  m->id, (char *)m->data);
-				msg_t *sm = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO,
-				                           sl, lm);
+				qm[k++] = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO, sl,
+				                         lm);
 				free(lm);
 				lm = NULL;
-				if (!queue_push(args->logQ, sm)) {
-					log_error(args->pstate,
-					          "[LPMS:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(sm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
 			} else if (m->command == LPMS_MSG_GET_FIRMWAREVER) {
 				log_info(args->pstate, 1,
 				         "[LPMS:%s] Unit 0x%02x: Firmware version: %-24s",
@@ -248,18 +244,10 @@ void *lpms_logging(void *ptargs) {
 				char *lm = NULL;
 				int sl = asprintf(&lm, "LPMS Unit 0x%02x: Firmware version: %-24s",
 				                  m->id, (char *)m->data);
-				msg_t *sm = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO,
-				                           sl, lm);
+				qm[k++] = msg_new_string(lpmsInfo->sourceNum, SLCHAN_LOG_INFO, sl,
+				                         lm);
 				free(lm);
 				lm = NULL;
-				if (!queue_push(args->logQ, sm)) {
-					log_error(args->pstate,
-					          "[LPMS:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(sm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
 			} else if (m->command == LPMS_MSG_GET_FREQ) {
 				uint32_t rate = m->data[0] + ((uint32_t)m->data[1] << 8) +
 				                ((uint32_t)m->data[2] << 16) +
@@ -284,24 +272,11 @@ void *lpms_logging(void *ptargs) {
 						lpms_send_command(lpmsInfo->handle,
 						                  &getTransmitted);
 					}
-					free(m->data);
-					free(m);
 					continue;
 				}
 				if (lpms_imu_set_timestamp(m, &d)) {
-					msg_t *ts = msg_new_timestamp(lpmsInfo->sourceNum,
-					                              SLCHAN_TSTAMP, d.timestamp);
-					if (!queue_push(args->logQ, ts)) {
-						log_error(
-							args->pstate,
-							"[LPMS:%s] Error pushing message to queue",
-							args->tag);
-						msg_destroy(ts);
-						free(m->data);
-						free(m);
-						args->returnCode = -1;
-						pthread_exit(&(args->returnCode));
-					}
+					qm[k++] = msg_new_timestamp(lpmsInfo->sourceNum,
+					                            SLCHAN_TSTAMP, d.timestamp);
 				} else {
 					log_warning(args->pstate,
 					            "[LPMS:%s] Unit 0x%02x: Timestamp invalid",
@@ -335,81 +310,38 @@ void *lpms_logging(void *ptargs) {
 				} else {
 					missingCount = 0;
 				}
-				// Create output messages and push to queue
-				bool rs = true;
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_RAW_X, d.accel_raw[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_RAW_Y, d.accel_raw[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_RAW_Z, d.accel_raw[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_CAL_X, d.accel_cal[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_CAL_Y, d.accel_cal[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_CAL_Z, d.accel_cal[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_RAW_X, d.gyro_raw[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_RAW_Y, d.gyro_raw[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_RAW_Z, d.gyro_raw[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_CAL_X, d.gyro_cal[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_CAL_Y, d.gyro_cal[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_CAL_Z, d.gyro_cal[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_ALIGN_X, d.gyro_aligned[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_ALIGN_Y, d.gyro_aligned[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_G_ALIGN_Z, d.gyro_aligned[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_OMEGA_X, d.omega[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_OMEGA_Y, d.omega[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_OMEGA_Z, d.omega[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ROLL, d.euler_angles[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_PITCH, d.euler_angles[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum, CHAN_YAW,
-				                         d.euler_angles[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_LIN_X, d.accel_linear[0]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_LIN_Y, d.accel_linear[1]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ACC_LIN_Z, d.accel_linear[2]);
-				rs &= lpms_queue_message(args->logQ, lpmsInfo->sourceNum,
-				                         CHAN_ALTITUDE, d.altitude);
-				if (!rs) {
-					log_error(
-						args->pstate,
-						"[LPMS:%s] Unable to allocate and/or queue all messages (%d)",
-						args->tag, errno);
-					free(m->data);
-					free(m);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
+				// Create output messages, queued below
+				k += lpms_imu_messages(lpmsInfo->sourceNum, &d, &(qm[k]));
 			} else {
 				log_info(args->pstate, 2,
 				         "[LPSM:%s] Unhandled message type: 0x%02x [%02d bytes]",
 				         args->tag, m->command, m->length);
 			}
-			free(m->data);
-			free(m);
-		} else {
-			// No message available, so sleep
-			usleep(1E5);
 		}
+		for (size_t i = 0; i < n; i++) {
+			free(ms[i].data);
+		}
+
+		if (k > 0) {
+			const size_t pushed = queue_push_batch(args->logQ, qm, k);
+			if (pushed < k) {
+				log_error(args->pstate,
+				          "[LPMS:%s] Unable to allocate and/or queue all messages (%d)",
+				          args->tag, errno);
+				for (size_t i = pushed; i < k; i++) {
+					msg_free(qm[i]);
+				}
+				ring_destroy(&ring);
+				args->returnCode = -1;
+				pthread_exit(&(args->returnCode));
+			}
+		}
+
+		// Invalid messages may be followed by more buffered data,
+		// otherwise no message available, so sleep
+		if (n == 0 && ms[0].id != 0xEE) { usleep(1E5); }
 	}
-	free(buf);
+	ring_destroy(&ring);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
 }
@@ -458,10 +390,11 @@ lpms_params lpms_getParams() {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Exits thread in case of error.
+ * If the queue is full, the messages are dropped and an error logged
+ * (this runs in the main thread, which empties the queue).
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *lpms_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -470,12 +403,11 @@ void *lpms_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(lpmsInfo->sourceNum, SLCHAN_NAME,
 	                             strlen(lpmsInfo->sourceName), lpmsInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[LPMS:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(29);
@@ -510,13 +442,12 @@ void *lpms_channels(void *ptargs) {
 	sa_create_entry(channels, CHAN_ALTITUDE, 8, "Altitude");
 	msg_t *m_cmap = msg_new_string_array(lpmsInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[LPMS:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
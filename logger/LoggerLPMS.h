@@ -54,8 +54,11 @@ typedef struct {
 //! Generic serial connection setup
 void *lpms_setup(void *ptargs);
 
-//! Helper function: Create and queue data messages, with error handling
-bool lpms_queue_message(msgqueue *Q, const uint8_t src, const uint8_t chan, const float val);
+//! Number of data messages created from each LPMS IMU data message
+#define LPMS_IMU_MESSAGES 25
+
+//! Helper function: Create data messages from decoded IMU values
+size_t lpms_imu_messages(const uint8_t src, const lpms_data *d, msg_t **out);
 
 //! Serial source main logging loop
 void *lpms_logging(void *ptargs);
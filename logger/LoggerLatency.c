@@ -0,0 +1,195 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Logger.h"
+
+#include "LoggerLatency.h"
+
+//! Number of stamps collected before being recorded in latency_dequeue()
+#define LATENCY_CHUNK 64
+
+/*!
+ * @param[in] ns Time in nanoseconds
+ * @returns Time in milliseconds
+ */
+static float latency_ms(uint64_t ns) {
+	return (float)(ns / 1.0E6);
+}
+
+/*!
+ * Message creation times are recorded from this point, so this should be
+ * called before any data sources are started.
+ *
+ * @param[in] l Latency state
+ * @returns True on success
+ */
+bool latency_init(log_latency *l) {
+	if (l == NULL) { return false; }
+	*l = (log_latency){0};
+	if (!lat_set_init(&l->queue)) { return false; }
+	if (!lat_set_init(&l->write)) {
+		// LCOV_EXCL_START
+		lat_set_destroy(&l->queue);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	lat_stamp_enable(true);
+	return true;
+}
+
+/*!
+ * All messages in the batch are treated as having been removed from the
+ * queue at the same time.
+ *
+ * @param[in] l     Latency state
+ * @param[in] batch Messages removed from queue
+ * @param[in] n     Number of messages in batch
+ */
+void latency_dequeue(log_latency *l, msg_t **batch, size_t n) {
+	if (l == NULL || batch == NULL) { return; }
+	const uint64_t now = lat_now();
+	lat_stamp stamps[LATENCY_CHUNK];
+	size_t ns = 0;
+	for (size_t i = 0; i < n; i++) {
+		stamps[ns].created = batch[i]->created;
+		stamps[ns].source = batch[i]->source;
+		ns++;
+		if (ns == LATENCY_CHUNK) {
+			lat_set_record_stamps(&l->queue, stamps, ns, now);
+			ns = 0;
+		}
+	}
+	if (ns > 0) { lat_set_record_stamps(&l->queue, stamps, ns, now); }
+}
+
+/*!
+ * The message is discarded if the queue is full, as reports are generated by
+ * the thread responsible for emptying it.
+ *
+ * @param[in] q  Message queue
+ * @param[in] ch Channel
+ * @param[in] v  Value
+ * @returns True if message queued successfully
+ */
+static bool latency_push(msgqueue *q, uint8_t ch, float v) {
+	msg_t *m = msg_new_float(SLSOURCE_LOCAL, ch, v);
+	if (!queue_try_push(q, m)) {
+		msg_free(m);
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Values recorded since the last report are combined across all sources,
+ * and the 50th and 99th percentile and maximum latency for each stage are
+ * pushed to the queue (in milliseconds). Nothing is pushed for a stage if no
+ * messages have been recorded.
+ *
+ * The per source values are retained for latency_summary(). If q is NULL,
+ * values are collected for the summary without being queued.
+ *
+ * @param[in] l Latency state
+ * @param[in] q Message queue, or NULL
+ * @returns False if messages could not be queued
+ */
+bool latency_report(log_latency *l, msgqueue *q) {
+	if (l == NULL) { return false; }
+	const uint8_t base[LATENCY_STAGES] = {SLCHAN_LOCAL_QUEUE_P50, SLCHAN_LOCAL_WRITE_P50};
+	lat_set *sets[LATENCY_STAGES] = {&l->queue, &l->write};
+	bool ok = true;
+	for (int st = 0; st < LATENCY_STAGES; st++) {
+		lat_reset(&l->total);
+		for (int s = 0; s < 128; s++) {
+			if (!lat_set_take(sets[st], s, &l->taken)) { continue; }
+			lat_merge(&l->total, &l->taken);
+			if (l->summary[s][st] == NULL) {
+				l->summary[s][st] = calloc(1, sizeof(lat_hist));
+			}
+			lat_merge(l->summary[s][st], &l->taken);
+		}
+		if (q == NULL || l->total.count == 0) { continue; }
+		ok &= latency_push(q, base[st], latency_ms(lat_percentile(&l->total, 50)));
+		ok &= latency_push(q, base[st] + 1, latency_ms(lat_percentile(&l->total, 99)));
+		ok &= latency_push(q, base[st] + 2, latency_ms(l->total.max));
+	}
+	return ok;
+}
+
+/*!
+ * Logs the 50th and 99th percentile and maximum latency at each stage for
+ * every source with messages recorded since the last summary. Only values
+ * already collected by latency_report() are included.
+ *
+ * @param[in] l     Latency state
+ * @param[in] s     Program state, for logging
+ * @param[in] stats Channel statistics, used to find source names
+ */
+void latency_summary(log_latency *l, program_state *s, channel_stats stats[128][128]) {
+	if (l == NULL || s == NULL) { return; }
+	const char *stageNames[LATENCY_STAGES] = {"queue", "write"};
+	for (int src = 0; src < 128; src++) {
+		char line[200] = {0};
+		size_t pos = 0;
+		uint64_t count = 0;
+		for (int st = 0; st < LATENCY_STAGES; st++) {
+			const lat_hist *h = l->summary[src][st];
+			if (h == NULL || h->count == 0) { continue; }
+			if (h->count > count) { count = h->count; }
+			int r = snprintf(&line[pos], sizeof(line) - pos, "%s%s %.3f/%.3f/%.3f ms",
+			                 (pos > 0) ? ", " : "", stageNames[st],
+			                 latency_ms(lat_percentile(h, 50)),
+			                 latency_ms(lat_percentile(h, 99)), latency_ms(h->max));
+			if (r > 0) { pos = ((size_t)r < sizeof(line) - pos) ? pos + r : sizeof(line) - 1; }
+		}
+		if (count == 0) { continue; }
+
+		const msg_t *nm = stats ? stats[src][SLCHAN_NAME].lastMessage : NULL;
+		const char *name = "Unknown";
+		if (nm && nm->dtype == MSG_STRING) { name = nm->data.string.data; }
+		log_info(s, 2,
+		         "Latency for %s (0x%02x): %s (p50/p99/max, %" PRIu64 " messages)", name,
+		         src, line, count);
+		for (int st = 0; st < LATENCY_STAGES; st++) {
+			lat_reset(l->summary[src][st]);
+		}
+	}
+}
+
+/*!
+ * @param[in] l Latency state
+ */
+void latency_destroy(log_latency *l) {
+	if (l == NULL) { return; }
+	lat_stamp_enable(false);
+	lat_set_destroy(&l->queue);
+	lat_set_destroy(&l->write);
+	for (int s = 0; s < 128; s++) {
+		for (int st = 0; st < LATENCY_STAGES; st++) {
+			free(l->summary[s][st]);
+			l->summary[s][st] = NULL;
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SL_LOGGER_LATENCY_H
+#define SL_LOGGER_LATENCY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//! @file
+
+/*!
+ * @addtogroup loggerLatency Logger: Latency measurement
+ * @ingroup logger
+ *
+ * When enabled, each message is stamped with its creation time, and the
+ * time taken for it to be removed from the queue by the main thread and to
+ * be written to the data file is recorded in a histogram for each source.
+ *
+ * At each report, the 50th and 99th percentile and maximum values across
+ * all sources are logged as SLSOURCE_LOCAL channels. Per source values are
+ * accumulated for longer and summarised in the text log.
+ *
+ * @{
+ */
+
+//! Stages at which latency is measured
+typedef enum {
+	LATENCY_QUEUE = 0, //!< Message removed from queue by main thread
+	LATENCY_WRITE,     //!< Write containing message completed
+	LATENCY_STAGES     //!< Number of stages
+} latency_stage;
+
+//! Latency measurement state
+typedef struct {
+	lat_set queue;                          //!< Creation to dequeue, updated by main thread
+	lat_set write;                          //!< Creation to write, updated by data file writer
+	lat_hist *summary[128][LATENCY_STAGES]; //!< Per source totals since last summary
+	lat_hist total;                         //!< Scratch histogram used while reporting
+	lat_hist taken;                         //!< Scratch histogram used while reporting
+} log_latency;
+
+//! Enable message stamping and allocate histograms
+bool latency_init(log_latency *l);
+
+//! Record queue latency for a batch of messages
+void latency_dequeue(log_latency *l, msg_t **batch, size_t n);
+
+//! Push percentiles for each stage to message queue
+bool latency_report(log_latency *l, msgqueue *q);
+
+//! Write per source summary to log and reset
+void latency_summary(log_latency *l, program_state *s, channel_stats stats[128][128]);
+
+//! Disable message stamping and release histograms
+void latency_destroy(log_latency *l);
+/*! @} */
+#endif
@@ -41,11 +41,154 @@ void *mp_setup(void *ptargs) {
 		return NULL;
 	}
 
+	if (!mp_stream_init(&(mpInfo->stream), mpInfo->handle, MP_SERIAL_BUFF)) {
+		log_error(args->pstate, "[MP:%s] Unable to allocate input buffer", args->tag);
+		args->returnCode = -2;
+		return NULL;
+	}
+
 	log_info(args->pstate, 2, "[MP:%s] Connected", args->tag);
 	args->returnCode = 0;
 	return NULL;
 }
 
+/*!
+ * Update cached source name and channel map from a message received from
+ * the device.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @param[in] out Message, not yet queued
+ * @returns False on error (args->returnCode set)
+ */
+static bool mp_cache(log_thread_args_t *args, const msg_t *out) {
+	mp_params *mpInfo = (mp_params *)args->dParams;
+	if (out->type == SLCHAN_NAME) {
+		if (out->dtype != MSG_STRING) {
+			log_warning(
+				args->pstate,
+				"[MP:%s] Unexpected message type (0x%02x) for source name (Source ID: 0x{%02x})",
+				args->tag, out->dtype, out->source);
+			return true;
+		}
+
+		if (mpInfo->csource > 0 && mpInfo->csource != out->source) {
+			log_warning(
+				args->pstate,
+				"[MP:%s] Received source ID (0x%02x) does not match cached value (0x%02x) - multiple devices on a single input not currently supported!",
+				args->tag, out->source, mpInfo->csource);
+		}
+		mpInfo->csource = out->source;
+
+		if (mpInfo->cname) {
+			free(mpInfo->cname);
+			mpInfo->cname = NULL;
+		}
+		mpInfo->cname = strdup(out->data.string.data);
+	} else if (out->type == SLCHAN_MAP) {
+		if (mpInfo->csource > 0 && mpInfo->csource != out->source) {
+			log_warning(
+				args->pstate,
+				"[MP:%s] Received source ID (0x%02x) does not match cached value (0x%02x) - multiple devices on a single input not currently supported!",
+				args->tag, out->source, mpInfo->csource);
+		}
+		mpInfo->csource = out->source;
+
+		if (!sa_copy(&mpInfo->cmap, &(out->data.names))) {
+			log_error(args->pstate, "[MP:%s] Error caching channel map", args->tag);
+			args->returnCode = -1;
+			return false;
+		}
+	}
+	return true;
+}
+
+/*!
+ * Decodes all messages buffered from the stream opened by mp_setup() (reading
+ * more data from the device at most once), and pushes them to the queue in a
+ * single operation.
+ *
+ * Messages are allocated with msg_alloc() immediately before the read, so
+ * they come from the message pool (if enabled) and are stamped with the
+ * time the data was read. Messages are decoded directly into these
+ * structures, and any left unused are released before returning so that
+ * their creation times are not carried over to a later read.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @returns 1 if the stream should be checked again, 0 if more data is
+ * required, or -1 on error (args->returnCode set)
+ */
+static int mp_read(log_thread_args_t *args) {
+	mp_params *mpInfo = (mp_params *)args->dParams;
+
+	// Needs to be on the heap as we'll be queuing them
+	for (int i = 0; i < SOURCE_BATCH_SIZE; i++) {
+		if (mpInfo->batch[i]) { continue; }
+		mpInfo->batch[i] = msg_alloc();
+		if (mpInfo->batch[i] == NULL) {
+			// LCOV_EXCL_START
+			log_error(args->pstate, "[MP:%s] Unable to allocate messages", args->tag);
+			args->returnCode = -1;
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+
+	const size_t n = mp_stream_read_batch(&(mpInfo->stream), mpInfo->batch, SOURCE_BATCH_SIZE);
+	int rc = (n == SOURCE_BATCH_SIZE) ? 1 : 0;
+
+	if (n > 0) {
+		// Messages may be released by the consumer as soon as they
+		// have been queued, so update the cache first.
+		for (size_t i = 0; i < n; i++) {
+			if (!mp_cache(args, mpInfo->batch[i])) { return -1; }
+		}
+
+		// After pushing messages to the queue, it is the
+		// responsibility of the consumer to dispose of them after use.
+		const size_t pushed = queue_push_batch(args->logQ, mpInfo->batch, n);
+		for (size_t i = 0; i < pushed; i++) {
+			mpInfo->batch[i] = NULL;
+		}
+		if (pushed < n) {
+			log_error(args->pstate, "[MP:%s] Error pushing message to queue",
+			          args->tag);
+			args->returnCode = -1;
+			return -1;
+		}
+	}
+
+	if (n < SOURCE_BATCH_SIZE) {
+		const msg_t *status = mpInfo->batch[n];
+		if (status->dtype == MSG_ERROR &&
+		    !(status->data.value == 0xFF || status->data.value == 0xFD ||
+		      status->data.value == 0xEE)) {
+			// 0xFF, 0xFD and 0xEE are used to signal recoverable
+			// states that resulted in no valid message.
+			//
+			// 0xFF and 0xFD indicate an out of data error, which is
+			// not a problem for serial monitoring, but might indicate
+			// EOF when reading from file
+			//
+			// 0xEE indicates an invalid message following valid sync
+			// bytes
+			log_error(args->pstate, "[MP:%s] Error signalled from mp_stream_read_batch",
+			          args->tag);
+			args->returnCode = -2;
+			rc = -1;
+		} else if (!(status->dtype == MSG_ERROR &&
+		             (status->data.value == 0xFF || status->data.value == 0xFD))) {
+			rc = 1;
+		}
+	}
+
+	// Release the status message and any messages that weren't needed
+	for (size_t i = n; i < SOURCE_BATCH_SIZE; i++) {
+		msg_free(mpInfo->batch[i]);
+		mpInfo->batch[i] = NULL;
+	}
+	return rc;
+}
+
 /*!
  * Reads messages from the serial connection established by mp_setup(), and pushes them to
  * the queue. As messages are already in the right format, no further processing is done
@@ -57,109 +200,53 @@ void *mp_setup(void *ptargs) {
 void *mp_logging(void *ptargs) {
 	signalHandlersBlock();
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
-	mp_params *mpInfo = (mp_params *)args->dParams;
 
 	log_info(args->pstate, 1, "[MP:%s] Logging thread started", args->tag);
 
-	uint8_t *buf = calloc(MP_SERIAL_BUFF, sizeof(uint8_t));
-	int mp_index = 0;
-	int mp_hw = 0;
 	while (!shutdownFlag) {
-		// Needs to be on the heap as we'll be queuing it
-		msg_t *out = calloc(1, sizeof(msg_t));
-		if (mp_readMessage_buf(mpInfo->handle, out, buf, &mp_index, &mp_hw)) {
-			if (!queue_push(args->logQ, out)) {
-				log_error(args->pstate, "[MP:%s] Error pushing message to queue",
-				          args->tag);
-				msg_destroy(out);
-				args->returnCode = -1;
-				pthread_exit(&(args->returnCode));
-			}
-
-			if (out->type == SLCHAN_NAME) {
-				if (out->dtype != MSG_STRING) {
-					log_warning(
-						args->pstate,
-						"[MP:%s] Unexpected message type (0x%02x) for source name (Source ID: 0x{%02x})",
-						args->tag, out->dtype, out->source);
-					continue;
-				}
-
-				if (mpInfo->csource > 0 && mpInfo->csource != out->source) {
-					log_warning(
-						args->pstate,
-						"[MP:%s] Received source ID (0x%02x) does not match cached value (0x%02x) - multiple devices on a single input not currently supported!",
-						args->tag, out->source, mpInfo->csource);
-				}
-				mpInfo->csource = out->source;
-
-				if (mpInfo->cname) {
-					free(mpInfo->cname);
-					mpInfo->cname = NULL;
-				}
-				mpInfo->cname = strdup(out->data.string.data);
-			} else if (out->type == SLCHAN_MAP) {
-				if (mpInfo->csource > 0 && mpInfo->csource != out->source) {
-					log_warning(
-						args->pstate,
-						"[MP:%s] Received source ID (0x%02x) does not match cached value (0x%02x) - multiple devices on a single input not currently supported!",
-						args->tag, out->source, mpInfo->csource);
-				}
-				mpInfo->csource = out->source;
-
-				if (!sa_copy(&mpInfo->cmap, &(out->data.names))) {
-					log_error(args->pstate,
-					          "[MP:%s] Error caching channel map", args->tag);
-					// Not destroying "out", as already queued
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
-			}
-			// After pushing it to the queue, it is the responsibility of the
-			// consumer to dispose of it after use.
-		} else {
-			if (out->dtype == MSG_ERROR &&
-			    !(out->data.value == 0xFF || out->data.value == 0xFD ||
-			      out->data.value == 0xEE)) {
-				// 0xFF, 0xFD and 0xEE are used to signal recoverable
-				// states that resulted in no valid message.
-				//
-				// 0xFF and 0xFD indicate an out of data error, which is
-				// not a problem for serial monitoring, but might indicate
-				// EOF when reading from file
-				//
-				// 0xEE indicates an invalid message following valid sync
-				// bytes
-				log_error(args->pstate,
-				          "[MP:%s] Error signalled from mp_readMessage_buf",
-				          args->tag);
-				free(buf);
-				free(out);
-				args->returnCode = -2;
-				pthread_exit(&(args->returnCode));
-			}
-			// out was allocated but not pushed to the queue, so free it here.
-			msg_destroy(out);
-			free(out);
-
+		const int rs = mp_read(args);
+		if (rs < 0) { pthread_exit(&(args->returnCode)); }
+		if (rs == 0) {
 			// We've already exited (via pthread_exit) for error
 			// cases, so at this point sleep briefly and wait for
 			// more data
 			usleep(SERIAL_SLEEP);
 		}
 	}
-	free(buf);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
 }
 
+/*!
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns Handle for device opened by mp_setup()
+ */
+int mp_handle(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	return ((mp_params *)args->dParams)->handle;
+}
+
+/*!
+ * Called by the I/O reactor when data is available. Equivalent to
+ * mp_logging(), but returns once all available messages have been queued.
+ *
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns True on success, false on error (exit code in ptargs->returnCode)
+ */
+bool mp_readable(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	int rs = 0;
+	while (!shutdownFlag && (rs = mp_read(args)) > 0) {}
+	return rs >= 0;
+}
+
 /*!
  * Duplicate cached channel map and enqueue
  *
- * Terminates thread on error.
+ * Called from the main thread, so nothing is queued if the queue is full.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Error code set in ptargs->returnCode if required
+ * @returns NULL
  */
 void *mp_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -173,24 +260,22 @@ void *mp_channels(void *ptargs) {
 		msg_t *out = msg_new_string(mpInfo->csource, SLCHAN_NAME, strlen(mpInfo->cname),
 		                            mpInfo->cname);
 
-		if (!queue_push(args->logQ, out)) {
+		if (!queue_try_push(args->logQ, out)) {
 			log_error(args->pstate, "[MP:%s] Error pushing source name to queue",
 			          args->tag);
-			msg_destroy(out);
-			args->returnCode = -1;
-			pthread_exit(&(args->returnCode));
+			msg_free(out);
+			return NULL;
 		}
 	}
 
 	if (mpInfo->cmap.entries > 0) {
 		msg_t *out = msg_new_string_array(mpInfo->csource, SLCHAN_MAP, &mpInfo->cmap);
 
-		if (!queue_push(args->logQ, out)) {
+		if (!queue_try_push(args->logQ, out)) {
 			log_error(args->pstate, "[MP:%s] Error pushing channel map to queue",
 			          args->tag);
-			msg_destroy(out);
-			args->returnCode = -1;
-			pthread_exit(&(args->returnCode));
+			msg_free(out);
+			return NULL;
 		}
 	}
 
@@ -211,6 +296,11 @@ void *mp_shutdown(void *ptargs) {
 		mp_closeConnection(mpInfo->handle);
 	}
 	mpInfo->handle = -1;
+	mp_stream_destroy(&(mpInfo->stream));
+	for (int i = 0; i < SOURCE_BATCH_SIZE; i++) {
+		msg_free(mpInfo->batch[i]);
+		mpInfo->batch[i] = NULL;
+	}
 	if (mpInfo->portName) {
 		free(mpInfo->portName);
 		mpInfo->portName = NULL;
@@ -225,7 +315,9 @@ device_callbacks mp_getCallbacks() {
 	device_callbacks cb = {.startup = &mp_setup,
 	                       .logging = &mp_logging,
 	                       .shutdown = &mp_shutdown,
-	                       .channels = &mp_channels};
+	                       .channels = &mp_channels,
+	                       .handle = &mp_handle,
+	                       .readable = &mp_readable};
 	return cb;
 }
 
@@ -238,7 +330,9 @@ mp_params mp_getParams() {
 	                .handle = -1,
 	                .csource = 0,
 	                .cname = NULL,
-	                .cmap = {0}};
+	                .cmap = {0},
+	                .stream = {0},
+	                .batch = {0}};
 	return mp;
 }
 
@@ -44,12 +44,14 @@
  */
 //! MP Source device specific parameters
 typedef struct {
-	char *portName;  //!< Target port name
-	int baudRate;    //!< Baud rate for operations (currently unused)
-	int handle;      //!< Handle for currently opened device
-	uint8_t csource; //!< Cache source ID
-	char *cname;     //!< Cache latest device name
-	strarray cmap;   //!< Cache latest channel map
+	char *portName;   //!< Target port name
+	int baudRate;     //!< Baud rate for operations (currently unused)
+	int handle;       //!< Handle for currently opened device
+	uint8_t csource;  //!< Cache source ID
+	char *cname;      //!< Cache latest device name
+	strarray cmap;    //!< Cache latest channel map
+	mp_stream stream; //!< Input stream for device
+	msg_t *batch[SOURCE_BATCH_SIZE]; //!< Messages allocated for next batch read
 } mp_params;
 
 //! MP connection setup
@@ -58,6 +60,12 @@ void *mp_setup(void *ptargs);
 //! MP source main logging loop
 void *mp_logging(void *ptargs);
 
+//! MP source file descriptor, for reactor
+int mp_handle(void *ptargs);
+
+//! MP source read available data, for reactor
+bool mp_readable(void *ptargs);
+
 //! Push device information from cache to queue
 void *mp_channels(void *ptargs);
 
@@ -110,7 +110,7 @@ void *mqtt_logging(void *ptargs) {
 		if (!queue_push(args->logQ, in)) {
 			log_error(args->pstate, "[MQTT:%s] Error pushing message to queue",
 			          args->tag);
-			msg_destroy(in);
+			msg_free(in);
 			args->returnCode = -1;
 			pthread_exit(&(args->returnCode));
 		}
@@ -148,10 +148,11 @@ void *mqtt_shutdown(void *ptargs) {
 /*!
  * Create channel map from configured IDs and push to queue.
  *
- * Terminates thread on error.
+ * As this runs in the main thread, messages that don't fit in the queue
+ * are discarded.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Error code stored in ptarges->returnCode
+ * @returns NULL
  */
 void *mqtt_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -160,12 +161,11 @@ void *mqtt_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(mqttInfo->sourceNum, SLCHAN_NAME,
 	                             strlen(mqttInfo->sourceName), mqttInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[MQTT:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(4 + mqttInfo->qm.numtopics);
@@ -180,13 +180,12 @@ void *mqtt_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(mqttInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[MQTT:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
@@ -49,11 +49,55 @@ void *n2k_setup(void *ptargs) {
 	return NULL;
 }
 
+/*!
+ * Converts a message received from the device into messages for the queue.
+ *
+ * The raw message is always added, preceded by the decoded position if the
+ * message is a PGN 129025 position update.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @param[in] in Message received from device
+ * @param[out] qm Array with space for at least 3 further messages
+ * @returns Number of messages added to qm
+ */
+static size_t n2k_convert(log_thread_args_t *args, const n2k_act_message *in, msg_t **qm) {
+	n2k_params *n2kInfo = (n2k_params *)args->dParams;
+	size_t k = 0;
+
+	if (in->PGN == 129025) {
+		double lat = 0;
+		double lon = 0;
+		if (n2k_129025_values(in, &lat, &lon)) {
+			qm[k++] = msg_new_float(n2kInfo->sourceNum, N2KCHAN_LAT, lat);
+			qm[k++] = msg_new_float(n2kInfo->sourceNum, N2KCHAN_LON, lon);
+		} else {
+			log_warning(args->pstate,
+			            "[N2K:%s] Failed to decode message (PGN %d, Source %d)",
+			            args->tag, in->PGN, in->src);
+		}
+	}
+
+	size_t mlen = 0;
+	uint8_t *rd = NULL;
+	if (!n2k_act_to_bytes(in, &rd, &mlen)) {
+		log_warning(args->pstate, "[N2K:%s] Unable to serialise message (PGN %d, Source %d)",
+		            args->tag, in->PGN, in->src);
+		if (rd) { free(rd); }
+		return k;
+	}
+	qm[k++] = msg_new_bytes(n2kInfo->sourceNum, N2KCHAN_RAW, mlen, rd);
+	free(rd);
+	return k;
+}
+
 /*!
  * Takes a n2k_params struct (passed via log_thread_args_t)
  * messages from a device configured with n2k_setup() and pushes them to the
  * message queue.
  *
+ * All complete messages buffered after each read from the device (up to
+ * SOURCE_BATCH_SIZE) are queued in a single operation.
+ *
  * Exits thread on error or when shutdown is signalled.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
@@ -70,72 +114,38 @@ void *n2k_logging(void *ptargs) {
 	size_t n2k_index = 0;
 	size_t n2k_hw = 0;
 	while (!shutdownFlag) {
-		n2k_act_message out = {0};
-		if (n2k_act_readMessage_buf(n2kInfo->handle, &out, buf, &n2k_index, &n2k_hw)) {
-			bool handled = false;
-
-			if (out.PGN == 129025) {
-				double lat = 0;
-				double lon = 0;
-				if (n2k_129025_values(&out, &lat, &lon)) {
-					msg_t *rm = NULL;
-					rm = msg_new_float(n2kInfo->sourceNum, N2KCHAN_LAT, lat);
-					if (!queue_push(args->logQ, rm)) {
-						log_error(
-							args->pstate,
-							"[N2K:%s] Error pushing message to queue",
-							args->tag);
-						msg_destroy(rm);
-						args->returnCode = -1;
-						pthread_exit(&(args->returnCode));
-					}
-					rm = NULL; // Discard pointer as message is now "owned" by
-					           // queue
-					rm = msg_new_float(n2kInfo->sourceNum, N2KCHAN_LON, lon);
-					if (!queue_push(args->logQ, rm)) {
-						log_error(
-							args->pstate,
-							"[N2K:%s] Error pushing message to queue",
-							args->tag);
-						msg_destroy(rm);
-						args->returnCode = -1;
-						pthread_exit(&(args->returnCode));
-					}
-				} else {
-					log_warning(
-						args->pstate,
-						"[N2K:%s] Failed to decode message (PGN %d, Source %d)",
-						args->tag, out.PGN, out.src);
-				}
-			}
-			if (!handled) {
-				size_t mlen = 0;
-				uint8_t *rd = NULL;
-				if (!n2k_act_to_bytes(&out, &rd, &mlen)) {
-					log_warning(
-						args->pstate,
-						"[N2K:%s] Unable to serialise message (PGN %d, Source %d)",
-						args->tag, out.PGN, out.src);
-					if (rd) { free(rd); }
-					continue;
-				}
-				msg_t *rm = NULL;
-				rm = msg_new_bytes(n2kInfo->sourceNum, N2KCHAN_RAW, mlen, rd);
-				if (!queue_push(args->logQ, rm)) {
-					log_error(args->pstate,
-					          "[N2K:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(rm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
+		n2k_act_message out[SOURCE_BATCH_SIZE] = {0};
+		msg_t *qm[3 * SOURCE_BATCH_SIZE] = {0};
+		const size_t n = n2k_act_readMessage_batch(n2kInfo->handle, out, SOURCE_BATCH_SIZE,
+		                                           buf, &n2k_index, &n2k_hw);
+		size_t k = 0;
+		for (size_t i = 0; i < n; i++) {
+			k += n2k_convert(args, &(out[i]), &(qm[k]));
+			free(out[i].data);
+		}
+
+		if (k > 0) {
+			// Do not destroy or free messages once queued
+			// After pushing them to the queue, it is the responsibility
+			// of the consumer to dispose of them after use.
+			const size_t pushed = queue_push_batch(args->logQ, qm, k);
+			if (pushed < k) {
+				log_error(args->pstate, "[N2K:%s] Error pushing message to queue",
+				          args->tag);
+				for (size_t i = pushed; i < k; i++) {
+					msg_free(qm[i]);
 				}
+				if (n < SOURCE_BATCH_SIZE) { free(out[n].data); }
+				free(buf);
+				args->returnCode = -1;
+				pthread_exit(&(args->returnCode));
 			}
-			// Do not destroy or free message here
-			// After pushing it to the queue, it is the responsibility of the
-			// consumer to dispose of it after use.
-		} else {
-			if (!(out.priority == 0xFF || out.priority == 0xFD ||
-			      out.priority == 0xEE)) {
+		}
+
+		if (n < SOURCE_BATCH_SIZE) {
+			const uint8_t status = out[n].priority;
+			if (out[n].data) { free(out[n].data); }
+			if (!(status == 0xFF || status == 0xFD || status == 0xEE)) {
 				// 0xFF, 0xFD and 0xEE are used to signal recoverable
 				// states that resulted in no valid message.
 				//
@@ -146,7 +156,7 @@ void *n2k_logging(void *ptargs) {
 				// 0xEE indicates an invalid message following valid sync
 				// bytes
 				log_error(args->pstate,
-				          "[N2K:%s] Error signalled from n2k_readMessage_buf",
+				          "[N2K:%s] Error signalled from n2k_act_readMessage_batch",
 				          args->tag);
 				args->returnCode = -2;
 				free(buf);
@@ -155,9 +165,8 @@ void *n2k_logging(void *ptargs) {
 			// We've already exited (via pthread_exit) for error
 			// cases, so at this point sleep briefly and wait for
 			// more data
-			usleep(SERIAL_SLEEP);
+			if (n == 0) { usleep(SERIAL_SLEEP); }
 		}
-		if (out.data) { free(out.data); }
 
 		if (n2k_hw == 1024) { log_error(args->pstate, "[N2K:%s] Buffer full", args->tag); }
 
@@ -200,10 +209,11 @@ void *n2k_shutdown(void *ptargs) {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Terminates thread on error
+ * Messages are dropped if the queue is full, since the main thread calls
+ * this and is also responsible for emptying the queue.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *n2k_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -212,11 +222,10 @@ void *n2k_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(n2kInfo->sourceNum, SLCHAN_NAME, strlen(n2kInfo->sourceName),
 	                             n2kInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[N2K:%s] Error pushing channel name to queue", args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(6);
@@ -229,13 +238,12 @@ void *n2k_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(n2kInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[N2K:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
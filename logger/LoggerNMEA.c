@@ -42,11 +42,100 @@ void *nmea_setup(void *ptargs) {
 		return NULL;
 	}
 
+	if (!ring_init(&(nmeaInfo->ring), NMEA_SERIAL_BUFF)) {
+		log_error(args->pstate, "[NMEA:%s] Unable to allocate input buffer", args->tag);
+		args->returnCode = -1;
+		return NULL;
+	}
+
 	log_info(args->pstate, 2, "[NMEA:%s] Connected", args->tag);
 	args->returnCode = 0;
 	return NULL;
 }
 
+/*!
+ * Reads all buffered messages (reading more data from the device at most
+ * once), and pushes them to the message queue in a single operation.
+ *
+ * Up to SOURCE_BATCH_SIZE messages are handled in each call.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @returns 1 if the buffer should be checked again, 0 if more data is
+ * required, or -1 on error (args->returnCode set)
+ */
+static int nmea_read(log_thread_args_t *args) {
+	nmea_params *nmeaInfo = (nmea_params *)args->dParams;
+	nmea_msg_t out[SOURCE_BATCH_SIZE] = {0};
+	msg_t *qm[SOURCE_BATCH_SIZE] = {0};
+	const size_t n = nmea_readMessage_batch(nmeaInfo->handle, out, SOURCE_BATCH_SIZE,
+	                                        &(nmeaInfo->ring));
+
+	for (size_t i = 0; i < n; i++) {
+		qm[i] = NULL;
+		if ((strncmp(out[i].talker, "II", 2) == 0) &&
+		    (strncmp(out[i].message, "ZDA", 3) == 0)) {
+			struct tm *t = nmea_parse_zda(&(out[i]));
+			if (t != NULL) {
+				time_t epoch = mktime(t) - t->tm_gmtoff;
+				if (epoch != (time_t)(-1)) {
+					// Suppress ZDA messages
+					qm[i] = msg_new_timestamp(nmeaInfo->sourceNum, 4, epoch);
+				}
+				free(t);
+			}
+		}
+		if (qm[i] == NULL) {
+			char *data = NULL;
+			ssize_t len = nmea_flat_array(&(out[i]), &data);
+			qm[i] = msg_new_bytes(nmeaInfo->sourceNum, 3, len, (uint8_t *)data);
+			// Copied into message, so can safely free here
+			free(data);
+		}
+		sa_destroy(&(out[i].fields));
+	}
+
+	// Status of the message that ended the batch, if any
+	uint8_t status = 0;
+	if (n < SOURCE_BATCH_SIZE) {
+		sa_destroy(&(out[n].fields));
+		status = out[n].raw[0];
+	}
+
+	if (n > 0) {
+		// After pushing messages to the queue, it is the
+		// responsibility of the consumer to dispose of them after use.
+		const size_t pushed = queue_push_batch(args->logQ, qm, n);
+		if (pushed < n) {
+			log_error(args->pstate, "[NMEA:%s] Error pushing message to queue",
+			          args->tag);
+			for (size_t i = pushed; i < n; i++) {
+				msg_free(qm[i]);
+			}
+			args->returnCode = -1;
+			return -1;
+		}
+	}
+
+	if (n == SOURCE_BATCH_SIZE || status == 0xEE) {
+		// Batch full, or an invalid message following valid sync
+		// bytes (0xEE): there may be further messages already buffered
+		return 1;
+	}
+	if (!(status == 0xFF || status == 0xFD)) {
+		// 0xFF and 0xFD are used to signal recoverable states that
+		// resulted in no valid message.
+		//
+		// 0xFF and 0xFD indicate an out of data error, which is
+		// not a problem for serial monitoring, but might indicate
+		// EOF when reading from file
+		log_error(args->pstate, "[NMEA:%s] Error signalled from nmea_readMessage_batch",
+		          args->tag);
+		args->returnCode = -2;
+		return -1;
+	}
+	return 0;
+}
+
 /*!
  * Takes a nmea_params struct (passed via log_thread_args_t)
  * messages from a device configured with nmea_setup() and pushes them to the
@@ -60,96 +149,47 @@ void *nmea_setup(void *ptargs) {
 void *nmea_logging(void *ptargs) {
 	signalHandlersBlock();
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
-	nmea_params *nmeaInfo = (nmea_params *)args->dParams;
 
 	log_info(args->pstate, 1, "[NMEA:%s] Logging thread started", args->tag);
 
-	uint8_t *buf = calloc(NMEA_SERIAL_BUFF, sizeof(uint8_t));
-	int nmea_index = 0;
-	int nmea_hw = 0;
 	while (!shutdownFlag) {
-		nmea_msg_t out = {0};
-		if (nmea_readMessage_buf(nmeaInfo->handle, &out, buf, &nmea_index, &nmea_hw)) {
-			char *data = NULL;
-			ssize_t len = nmea_flat_array(&out, &data);
-			bool handled = false;
-
-			if ((strncmp(out.talker, "II", 2) == 0) &&
-			    (strncmp(out.message, "ZDA", 3) == 0)) {
-				struct tm *t = nmea_parse_zda(&out);
-				if (t != NULL) {
-					time_t epoch = mktime(t) - t->tm_gmtoff;
-					if (epoch != (time_t)(-1)) {
-						// clang-format off
-						msg_t *tm = msg_new_timestamp(nmeaInfo->sourceNum, 4, epoch);
-						// clang-format on
-						if (!queue_push(args->logQ, tm)) {
-							log_error(
-								args->pstate,
-								"[NMEA:%s] Error pushing message to queue",
-								args->tag);
-							msg_destroy(tm);
-							free(t);
-							args->returnCode = -1;
-							pthread_exit(&(args->returnCode));
-						}
-						handled = true; // Suppress ZDA messages
-					}
-				}
-			}
-			if (!handled) {
-				msg_t *sm = msg_new_bytes(nmeaInfo->sourceNum, 3, len,
-				                          (uint8_t *)data);
-				if (!queue_push(args->logQ, sm)) {
-					log_error(args->pstate,
-					          "[NMEA:%s] Error pushing message to queue",
-					          args->tag);
-					msg_destroy(sm);
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
-			}
-			if (data) {
-				// Copied into message, so can safely free here
-				free(data);
-			}
-			// Do not destroy or free sm here
-			// After pushing it to the queue, it is the responsibility of the
-			// consumer to dispose of it after use.
-		} else {
-			if (!(out.raw[0] == 0xFF || out.raw[0] == 0xFD || out.raw[0] == 0xEE)) {
-				// 0xFF, 0xFD and 0xEE are used to signal recoverable
-				// states that resulted in no valid message.
-				//
-				// 0xFF and 0xFD indicate an out of data error, which is
-				// not a problem for serial monitoring, but might indicate
-				// EOF when reading from file
-				//
-				// 0xEE indicates an invalid message following valid sync
-				// bytes
-				log_error(args->pstate,
-				          "[NMEA:%s] Error signalled from nmea_readMessage_buf",
-				          args->tag);
-				args->returnCode = -2;
-				free(buf);
-				sa_destroy(&(out.fields));
-				pthread_exit(&(args->returnCode));
-			}
+		const int rs = nmea_read(args);
+		if (rs < 0) { pthread_exit(&(args->returnCode)); }
+		if (rs == 0) {
 			// We've already exited (via pthread_exit) for error
 			// cases, so at this point sleep briefly and wait for
 			// more data
 			usleep(SERIAL_SLEEP);
 		}
-
-		// Clean up before next iteration
-		sa_destroy(&(out.fields));
 	}
-	free(buf);
 	log_info(args->pstate, 1, "[NMEA:%s] Logging thread exiting", args->tag);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
 }
 
+/*!
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns Handle for device opened by nmea_setup()
+ */
+int nmea_handle(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	return ((nmea_params *)args->dParams)->handle;
+}
+
+/*!
+ * Called by the I/O reactor when data is available. Equivalent to
+ * nmea_logging(), but returns once all available messages have been queued.
+ *
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns True on success, false on error (exit code in ptargs->returnCode)
+ */
+bool nmea_readable(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	int rs = 0;
+	while (!shutdownFlag && (rs = nmea_read(args)) > 0) {}
+	return rs >= 0;
+}
+
 /*!
  * Calls nmea_closeConnection(), which will do any cleanup required.
  *
@@ -164,6 +204,7 @@ void *nmea_shutdown(void *ptargs) {
 		nmea_closeConnection(nmeaInfo->handle);
 	}
 	nmeaInfo->handle = -1;
+	ring_destroy(&(nmeaInfo->ring));
 	if (nmeaInfo->sourceName) {
 		free(nmeaInfo->sourceName);
 		nmeaInfo->sourceName = NULL;
@@ -178,10 +219,11 @@ void *nmea_shutdown(void *ptargs) {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Exits thread in case of error.
+ * The main thread calls this, so messages are discarded rather than
+ * waiting for space if the queue is full.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *nmea_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -190,12 +232,11 @@ void *nmea_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(nmeaInfo->sourceNum, SLCHAN_NAME,
 	                             strlen(nmeaInfo->sourceName), nmeaInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[NMEA:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(5);
@@ -207,13 +248,12 @@ void *nmea_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(nmeaInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[NMEA:%s] Error pushing channel map to queue", args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
@@ -228,7 +268,9 @@ device_callbacks nmea_getCallbacks() {
 	device_callbacks cb = {.startup = &nmea_setup,
 	                       .logging = &nmea_logging,
 	                       .shutdown = &nmea_shutdown,
-	                       .channels = &nmea_channels};
+	                       .channels = &nmea_channels,
+	                       .handle = &nmea_handle,
+	                       .readable = &nmea_readable};
 	return cb;
 }
 
@@ -236,8 +278,11 @@ device_callbacks nmea_getCallbacks() {
  * @returns Default parameters for NMEA serial sources
  */
 nmea_params nmea_getParams() {
-	nmea_params gp = {
-		.portName = NULL, .sourceNum = SLSOURCE_NMEA, .baudRate = 115200, .handle = -1};
+	nmea_params gp = {.portName = NULL,
+	                  .sourceNum = SLSOURCE_NMEA,
+	                  .baudRate = 115200,
+	                  .handle = -1,
+	                  .ring = {0}};
 	return gp;
 }
 
@@ -50,6 +50,7 @@ typedef struct {
 	uint8_t sourceNum; //!< Source ID for messages
 	int baudRate;      //!< Baud rate for operations
 	int handle;        //!< Handle for currently opened device
+	byte_ring ring;    //!< Data read but not yet processed
 	                   // Future expansion: Talker/Message -> Source/Message map?
 } nmea_params;
 
@@ -59,6 +60,12 @@ void *nmea_setup(void *ptargs);
 //! NMEA logging (with pthread function signature)
 void *nmea_logging(void *ptargs);
 
+//! NMEA file descriptor, for reactor
+int nmea_handle(void *ptargs);
+
+//! NMEA read available data, for reactor
+bool nmea_readable(void *ptargs);
+
 //! NMEA Shutdown
 void *nmea_shutdown(void *ptargs);
 
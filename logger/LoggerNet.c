@@ -126,7 +126,7 @@ void *net_logging(void *ptargs) {
 		if (!queue_push(args->logQ, sm)) {
 			log_error(args->pstate, "[Network:%s] Error pushing message to queue",
 			          args->tag);
-			msg_destroy(sm);
+			msg_free(sm);
 			args->returnCode = -1;
 			pthread_exit(&(args->returnCode));
 		}
@@ -257,8 +257,10 @@ net_params net_getParams() {
 /*!
  * Populate list of channels and push to queue as a map message
  *
+ * Called from the main thread. Messages are discarded if the queue is full.
+ *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *net_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -267,12 +269,11 @@ void *net_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(netInfo->sourceNum, SLCHAN_NAME, strlen(netInfo->sourceName),
 	                             netInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[Network:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
 	strarray *channels = sa_new(4);
@@ -283,14 +284,13 @@ void *net_channels(void *ptargs) {
 
 	msg_t *m_cmap = msg_new_string_array(netInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[Network:%s] Error pushing channel map to queue",
 		          args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
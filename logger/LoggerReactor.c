@@ -0,0 +1,241 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+#include "LoggerReactor.h"
+#include "LoggerSignals.h"
+
+/*!
+ * Sources are removed if their readable function reports an error, or if
+ * their device reports a hangup or error condition.
+ *
+ * @param[in] w    Reactor thread
+ * @param[in] args Source to remove
+ */
+static void reactor_remove(reactor_worker *w, log_thread_args_t *args) {
+	const int fd = args->funcs.handle(args);
+	if (fd >= 0) { epoll_ctl(w->epfd, EPOLL_CTL_DEL, fd, NULL); }
+	w->nSources--;
+}
+
+/*!
+ * Waits for data to become available on any of the sources registered with
+ * this thread, and calls the readable function for each source that is ready.
+ *
+ * Runs until shutdownFlag is set and the thread is woken by reactor_stop().
+ *
+ * @param[in] ptr Pointer to reactor_worker
+ * @returns NULL
+ */
+static void *reactor_run(void *ptr) {
+	signalHandlersBlock();
+	reactor_worker *w = (reactor_worker *)ptr;
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+
+	while (!shutdownFlag) {
+		const int n = epoll_wait(w->epfd, events, REACTOR_MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR) { continue; }
+			// LCOV_EXCL_START
+			log_error(w->pstate, "[Reactor] Error waiting for data: %s",
+			          strerror(errno));
+			shutdownFlag = true;
+			break;
+			// LCOV_EXCL_STOP
+		}
+		for (int e = 0; e < n && !shutdownFlag; e++) {
+			if (events[e].data.ptr == NULL) {
+				// Wakeup event, only used to signal shutdown
+				uint64_t v = 0;
+				if (read(w->wakefd, &v, sizeof(v)) < 0 && errno != EAGAIN) {
+					// LCOV_EXCL_START
+					log_warning(w->pstate,
+					            "[Reactor] Error reading wakeup event: %s",
+					            strerror(errno));
+					// LCOV_EXCL_STOP
+				}
+				continue;
+			}
+
+			log_thread_args_t *args = (log_thread_args_t *)events[e].data.ptr;
+			if (!args->funcs.readable(args)) {
+				// Error already logged by source
+				if (args->returnCode == 0) { args->returnCode = -1; }
+				reactor_remove(w, args);
+				continue;
+			}
+
+			if (events[e].events & (EPOLLHUP | EPOLLERR)) {
+				log_warning(
+					w->pstate,
+					"[Reactor] %s disconnected or in error, no longer monitored",
+					args->tag);
+				reactor_remove(w, args);
+			}
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * Each thread has its own epoll instance and an eventfd used to wake it
+ * when shutting down.
+ *
+ * @param[out] r        Reactor state
+ * @param[in]  nThreads Number of threads (1 - REACTOR_MAX_THREADS)
+ * @param[in]  pstate   Program state, for logging
+ * @returns True on success
+ */
+bool reactor_init(log_reactor *r, int nThreads, program_state *pstate) {
+	if (r == NULL || nThreads < 1 || nThreads > REACTOR_MAX_THREADS) { return false; }
+	*r = (log_reactor){0};
+	for (int t = 0; t < nThreads; t++) {
+		reactor_worker *w = &(r->workers[t]);
+		w->pstate = pstate;
+		w->epfd = epoll_create1(EPOLL_CLOEXEC);
+		w->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+		if (w->epfd < 0 || w->wakefd < 0 ||
+		    epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wakefd, &ev) != 0) {
+			// LCOV_EXCL_START
+			log_error(pstate, "[Reactor] Unable to create event handles: %s",
+			          strerror(errno));
+			if (w->epfd >= 0) { close(w->epfd); }
+			if (w->wakefd >= 0) { close(w->wakefd); }
+			reactor_destroy(r);
+			return false;
+			// LCOV_EXCL_STOP
+		}
+		r->nWorkers++;
+	}
+	return true;
+}
+
+/*!
+ * Must be called before reactor_start().
+ *
+ * Sources must provide both device_callbacks.handle and
+ * device_callbacks.readable. Sources are assigned to each reactor thread in
+ * turn.
+ *
+ * @param[in] r    Reactor state
+ * @param[in] args Source to be added
+ * @returns True if the source will be serviced by the reactor, false if it
+ * requires a dedicated logging thread
+ */
+bool reactor_add(log_reactor *r, log_thread_args_t *args) {
+	if (r == NULL || args == NULL || r->nWorkers < 1) { return false; }
+	if (args->funcs.handle == NULL || args->funcs.readable == NULL) { return false; }
+
+	const int fd = args->funcs.handle(args);
+	if (fd < 0) { return false; }
+
+	reactor_worker *w = &(r->workers[r->next]);
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = args};
+	if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		// e.g. regular files, which are always readable and can't be polled
+		return false;
+	}
+	w->nSources++;
+	r->next = (r->next + 1) % r->nWorkers;
+	return true;
+}
+
+/*!
+ * Threads are only started if sources have been assigned to them.
+ *
+ * @param[in] r Reactor state
+ * @returns True on success
+ */
+bool reactor_start(log_reactor *r) {
+	if (r == NULL) { return false; }
+	for (int t = 0; t < r->nWorkers; t++) {
+		reactor_worker *w = &(r->workers[t]);
+		if (w->nSources == 0 || w->running) { continue; }
+		if (pthread_create(&(w->thread), NULL, &reactor_run, w) != 0) {
+			// LCOV_EXCL_START
+			log_error(w->pstate, "[Reactor] Unable to launch thread %d", t);
+			return false;
+			// LCOV_EXCL_STOP
+		}
+		w->running = true;
+#ifdef _GNU_SOURCE
+		char threadname[16] = {0};
+		snprintf(threadname, 16, "Logger: IO %hhu", (unsigned char)t);
+		pthread_setname_np(w->thread, threadname);
+#endif
+		log_info(w->pstate, 2, "[Reactor] Thread %d started with %d sources", t,
+		         w->nSources);
+	}
+	return true;
+}
+
+/*!
+ * shutdownFlag must be set before calling this function, otherwise the
+ * reactor threads will continue waiting for data.
+ *
+ * @param[in] r Reactor state
+ */
+void reactor_stop(log_reactor *r) {
+	if (r == NULL) { return; }
+	for (int t = 0; t < r->nWorkers; t++) {
+		reactor_worker *w = &(r->workers[t]);
+		if (!w->running) { continue; }
+		const uint64_t v = 1;
+		if (write(w->wakefd, &v, sizeof(v)) < 0) {
+			// LCOV_EXCL_START
+			log_warning(w->pstate, "[Reactor] Unable to wake thread %d: %s", t,
+			            strerror(errno));
+			// LCOV_EXCL_STOP
+		}
+	}
+	for (int t = 0; t < r->nWorkers; t++) {
+		reactor_worker *w = &(r->workers[t]);
+		if (!w->running) { continue; }
+		pthread_join(w->thread, NULL);
+		w->running = false;
+	}
+}
+
+/*!
+ * Sources are not closed or modified, as they remain the responsibility of
+ * their own shutdown functions.
+ *
+ * @param[in] r Reactor state
+ */
+void reactor_destroy(log_reactor *r) {
+	if (r == NULL) { return; }
+	reactor_stop(r);
+	for (int t = 0; t < r->nWorkers; t++) {
+		close(r->workers[t].epfd);
+		close(r->workers[t].wakefd);
+		r->workers[t].epfd = -1;
+		r->workers[t].wakefd = -1;
+	}
+	r->nWorkers = 0;
+}
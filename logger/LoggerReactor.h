@@ -0,0 +1,83 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SL_LOGGER_REACTOR_H
+#define SL_LOGGER_REACTOR_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+//! @file
+
+/*!
+ * @addtogroup loggerReactor Logger: I/O reactor
+ * @ingroup logger
+ *
+ * Data sources that provide device_callbacks.handle and
+ * device_callbacks.readable can be serviced by a small number of shared
+ * threads instead of each having a dedicated logging thread that polls its
+ * device.
+ *
+ * Each reactor thread waits on its own epoll instance, and only calls a
+ * source's readable function when data is available to be read from its file
+ * descriptor. Sources are distributed between the threads as they are added.
+ *
+ * @{
+ */
+
+//! Maximum number of reactor threads
+#define REACTOR_MAX_THREADS 8
+
+//! Maximum number of events handled per call to epoll_wait()
+#define REACTOR_MAX_EVENTS 16
+
+//! State for a single reactor thread
+typedef struct {
+	int epfd;         //!< epoll instance for this thread
+	int wakefd;       //!< eventfd used to wake this thread for shutdown
+	int nSources;     //!< Number of sources registered with this thread
+	bool running;     //!< Thread has been started
+	pthread_t thread; //!< Thread handle, valid if running is true
+	program_state *pstate; //!< Program state, used for logging
+} reactor_worker;
+
+//! I/O reactor state
+typedef struct {
+	int nWorkers;                                //!< Number of reactor threads
+	int next;                                    //!< Worker for next source added
+	reactor_worker workers[REACTOR_MAX_THREADS]; //!< Reactor threads
+} log_reactor;
+
+//! Create epoll instances for reactor threads
+bool reactor_init(log_reactor *r, int nThreads, program_state *pstate);
+
+//! Register a data source with the reactor
+bool reactor_add(log_reactor *r, log_thread_args_t *args);
+
+//! Start reactor threads
+bool reactor_start(log_reactor *r);
+
+//! Stop and wait for reactor threads
+void reactor_stop(log_reactor *r);
+
+//! Stop reactor threads and release resources
+void reactor_destroy(log_reactor *r);
+//! @}
+#endif
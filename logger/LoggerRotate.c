@@ -0,0 +1,357 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+#include "LoggerRotate.h"
+
+/*!
+ * @brief Open the file with the given extension alongside an existing data file
+ *
+ * @param[in] stem      File name stem
+ * @param[in] extension File extension
+ * @returns Opened file, or NULL on error
+ */
+static FILE *rotator_open_sibling(const char *stem, const char *extension) {
+	char *fileName = NULL;
+	if (asprintf(&fileName, "%s.%s", stem, extension) < 0) { return NULL; }
+	FILE *f = fopen(fileName, "w+x");
+	free(fileName);
+	return f;
+}
+
+/*!
+ * @brief Remove a file created alongside a data file
+ *
+ * @param[in] stem      File name stem
+ * @param[in] extension File extension
+ */
+static void rotator_remove_sibling(const char *stem, const char *extension) {
+	char *fileName = NULL;
+	if (asprintf(&fileName, "%s.%s", stem, extension) < 0) { return; }
+	unlink(fileName);
+	free(fileName);
+}
+
+/*!
+ * Opens a new data file using openSerialNumberedFileAt(), then the matching
+ * log, variable and (optionally) index files. If any file cannot be opened,
+ * any files already created are closed and removed.
+ *
+ * @param[in] prefix Output file prefix
+ * @param[in] when   Time used to generate date portion of file names
+ * @param[in] index  Open index file
+ * @param[out] fs    Opened files
+ * @returns True on success, false on error (errno set)
+ */
+bool rotator_open_fileset(const char *prefix, time_t when, bool index, log_fileset *fs) {
+	if (prefix == NULL || fs == NULL) {
+		errno = EINVAL;
+		return false;
+	}
+	memset(fs, 0, sizeof(log_fileset));
+
+	errno = 0;
+	fs->dat = openSerialNumberedFileAt(prefix, "dat", &fs->stem, when);
+	if (fs->dat == NULL) { return false; }
+
+	errno = 0;
+	fs->log = rotator_open_sibling(fs->stem, "log");
+	if (fs->log) {
+		errno = 0;
+		fs->var = rotator_open_sibling(fs->stem, "var");
+	}
+	if (fs->var && index) {
+		errno = 0;
+		fs->idx = rotator_open_sibling(fs->stem, "idx");
+	}
+	if (fs->var == NULL || (index && fs->idx == NULL)) {
+		const int err = errno;
+		rotator_discard_fileset(fs);
+		errno = err;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Used to clean up files that were opened in advance but never used.
+ *
+ * @param[in] fs Fileset to discard
+ */
+void rotator_discard_fileset(log_fileset *fs) {
+	if (fs == NULL) { return; }
+	if (fs->dat) {
+		fclose(fs->dat);
+		rotator_remove_sibling(fs->stem, "dat");
+	}
+	if (fs->log) {
+		fclose(fs->log);
+		rotator_remove_sibling(fs->stem, "log");
+	}
+	if (fs->var) {
+		fclose(fs->var);
+		rotator_remove_sibling(fs->stem, "var");
+	}
+	if (fs->idx) {
+		fclose(fs->idx);
+		rotator_remove_sibling(fs->stem, "idx");
+	}
+	free(fs->stem);
+	memset(fs, 0, sizeof(log_fileset));
+}
+
+/*!
+ * @brief Record the (local) day covered by the current request
+ *
+ * File names only include the date, so any time within this day would
+ * produce the same names. Storing the day boundaries lets later requests be
+ * compared without further localtime() calls.
+ *
+ * @param[in] r    Rotator
+ * @param[in] when Time used for naming requested fileset
+ */
+static void rotator_set_day(log_rotator *r, time_t when) {
+	struct tm day = {0};
+	localtime_r(&when, &day);
+	day.tm_hour = 0;
+	day.tm_min = 0;
+	day.tm_sec = 0;
+	day.tm_isdst = -1;
+	r->dayStart = mktime(&day);
+	day.tm_mday++;
+	day.tm_isdst = -1;
+	r->dayEnd = mktime(&day);
+}
+
+/*!
+ * @brief Check whether files named for `when` would match the current request
+ *
+ * @param[in] r    Rotator
+ * @param[in] when Time to check
+ * @returns True if `when` falls on the same day as the current request
+ */
+static bool rotator_same_day(const log_rotator *r, time_t when) {
+	return (when >= r->dayStart) && (when < r->dayEnd);
+}
+
+/*!
+ * @brief Background thread: open requested filesets and close old files
+ *
+ * @param[in] ptr Pointer to log_rotator
+ * @returns NULL
+ */
+static void *rotator_thread(void *ptr) {
+	log_rotator *r = ptr;
+	pthread_mutex_lock(&r->lock);
+	while (true) {
+		if (r->nClosing > 0) {
+			FILE *f = r->closing[--r->nClosing];
+			pthread_mutex_unlock(&r->lock);
+			fclose(f);
+			pthread_mutex_lock(&r->lock);
+			continue;
+		}
+
+		if (r->stale.stem) {
+			log_fileset stale = r->stale;
+			memset(&r->stale, 0, sizeof(log_fileset));
+			pthread_mutex_unlock(&r->lock);
+			rotator_discard_fileset(&stale);
+			pthread_mutex_lock(&r->lock);
+			continue;
+		}
+
+		if (r->pending && !r->ready && !r->stop) {
+			const time_t when = r->when;
+			pthread_mutex_unlock(&r->lock);
+			log_fileset fs = {0};
+			const bool ok = rotator_open_fileset(r->prefix, when, r->index, &fs);
+			const int err = errno;
+			pthread_mutex_lock(&r->lock);
+			if (!rotator_same_day(r, when)) {
+				// Request changed to a different day while these were opened
+				pthread_mutex_unlock(&r->lock);
+				rotator_discard_fileset(&fs);
+				pthread_mutex_lock(&r->lock);
+				continue;
+			}
+			r->next = fs;
+			r->error = ok ? 0 : err;
+			r->ready = true;
+			continue;
+		}
+
+		if (r->stop) { break; }
+		pthread_cond_wait(&r->cond, &r->lock);
+	}
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+/*!
+ * @param[out] r      Rotator to initialise
+ * @param[in]  prefix Output file prefix (copied)
+ * @param[in]  index  Include index file in each set of files
+ * @returns True on success
+ */
+bool rotator_init(log_rotator *r, const char *prefix, bool index) {
+	if (r == NULL || prefix == NULL) { return false; }
+	memset(r, 0, sizeof(log_rotator));
+	r->index = index;
+	r->prefix = strdup(prefix);
+	if (r->prefix == NULL) { return false; }
+	if (pthread_mutex_init(&r->lock, NULL) != 0 || pthread_cond_init(&r->cond, NULL) != 0) {
+		// LCOV_EXCL_START
+		free(r->prefix);
+		r->prefix = NULL;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	if (pthread_create(&r->thread, NULL, rotator_thread, r) != 0) {
+		// LCOV_EXCL_START
+		pthread_cond_destroy(&r->cond);
+		pthread_mutex_destroy(&r->lock);
+		free(r->prefix);
+		r->prefix = NULL;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	return true;
+}
+
+/*!
+ * The files are opened by the background thread, and can be collected with
+ * rotator_take() once ready. Only one set of files can be requested at a time.
+ *
+ * If files have already been requested for the same day, this has no effect.
+ * A request for a different day replaces the outstanding one, and any files
+ * already opened for it are removed by the background thread.
+ *
+ * @param[in] r    Rotator
+ * @param[in] when Time used to generate date portion of file names
+ * @returns True if a new request was made
+ */
+bool rotator_prepare(log_rotator *r, time_t when) {
+	if (r == NULL || r->prefix == NULL) { return false; }
+	log_fileset unused = {0};
+	pthread_mutex_lock(&r->lock);
+	const bool request = !r->pending || !rotator_same_day(r, when);
+	if (request) {
+		if (r->ready) {
+			// Files opened for the wrong day, hand them back for removal
+			if (r->stale.stem == NULL) {
+				r->stale = r->next;
+			} else {
+				unused = r->next;
+			}
+			memset(&r->next, 0, sizeof(log_fileset));
+		}
+		r->pending = true;
+		r->ready = false;
+		r->when = when;
+		rotator_set_day(r, when);
+		pthread_cond_signal(&r->cond);
+	}
+	pthread_mutex_unlock(&r->lock);
+	if (unused.stem) { rotator_discard_fileset(&unused); }
+	return request;
+}
+
+/*!
+ * Does not block. Only files named for the same day as `when` are returned:
+ * if the outstanding request was for a different day it is replaced (see
+ * rotator_prepare()) and this returns false until the new files are ready.
+ * If no files have been requested, a request is made for `when`.
+ *
+ * If the background thread was unable to open the files, this returns true
+ * with all members of fs set to NULL and errno set to the error encountered.
+ * A new request can then be made with rotator_prepare().
+ *
+ * @param[in]  r    Rotator
+ * @param[out] fs   Opened files, now owned by caller
+ * @param[in]  when Time the files will be used from (normally the current time)
+ * @returns True if the request has completed, false if not yet ready
+ */
+bool rotator_take(log_rotator *r, log_fileset *fs, time_t when) {
+	if (r == NULL || fs == NULL) { return false; }
+	rotator_prepare(r, when);
+	pthread_mutex_lock(&r->lock);
+	const bool ready = r->ready;
+	if (ready) {
+		*fs = r->next;
+		errno = r->error;
+		memset(&r->next, 0, sizeof(log_fileset));
+		r->ready = false;
+		r->pending = false;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return ready;
+}
+
+/*!
+ * Buffered data is written out and the file closed by the background thread.
+ * The file is closed immediately if too many files are already waiting.
+ *
+ * @param[in] r Rotator
+ * @param[in] f File to be closed
+ */
+void rotator_close(log_rotator *r, FILE *f) {
+	if (f == NULL) { return; }
+	if (r == NULL || r->prefix == NULL) {
+		fclose(f);
+		return;
+	}
+	pthread_mutex_lock(&r->lock);
+	if (r->nClosing < ROTATE_CLOSE_MAX) {
+		r->closing[r->nClosing++] = f;
+		f = NULL;
+		pthread_cond_signal(&r->cond);
+	}
+	pthread_mutex_unlock(&r->lock);
+	if (f) { fclose(f); }
+}
+
+/*!
+ * Waits for any outstanding files to be closed. Files opened in advance but
+ * never used are removed.
+ *
+ * @param[in] r Rotator
+ */
+void rotator_destroy(log_rotator *r) {
+	if (r == NULL || r->prefix == NULL) { return; }
+	pthread_mutex_lock(&r->lock);
+	r->stop = true;
+	pthread_cond_signal(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+	pthread_join(r->thread, NULL);
+
+	if (r->ready) { rotator_discard_fileset(&r->next); }
+	rotator_discard_fileset(&r->stale);
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->lock);
+	free(r->prefix);
+	r->prefix = NULL;
+}
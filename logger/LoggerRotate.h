@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SL_LOGGER_ROTATE_H
+#define SL_LOGGER_ROTATE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+//! @file
+
+/*!
+ * @addtogroup loggerRotate Logger: Background file rotation
+ * @ingroup logger
+ *
+ * Opening and closing files can take a significant amount of time on slow
+ * storage. To avoid delaying the main logging loop, the next set of output
+ * files is opened in advance by a background thread, and the previous files
+ * are closed by the same thread once they have been replaced.
+ *
+ * @{
+ */
+
+//! Time before midnight at which the next day's files are opened (seconds)
+#define ROTATE_PREPARE_LEAD 5
+
+//! Maximum number of files waiting to be closed
+#define ROTATE_CLOSE_MAX 16
+
+//! Set of output files, sharing a common name stem
+typedef struct {
+	FILE *dat;  //!< Data file
+	FILE *log;  //!< Text log file
+	FILE *var;  //!< Variable / channel map file
+	FILE *idx;  //!< Index file (if enabled)
+	char *stem; //!< Path and name of files, without extension
+} log_fileset;
+
+//! Background file rotation state
+typedef struct {
+	char *prefix;      //!< Output file prefix
+	bool index;        //!< Open index files
+	pthread_t thread;  //!< Background thread
+	pthread_mutex_t lock; //!< Protects all following members
+	pthread_cond_t cond;  //!< Signals new work for background thread
+	bool stop;         //!< Background thread should exit
+	bool pending;      //!< Next fileset has been requested
+	time_t when;       //!< Time used for naming requested fileset
+	time_t dayStart;   //!< Start of the day covered by the requested fileset
+	time_t dayEnd;     //!< Start of the following day
+	bool ready;        //!< Requested fileset opened (or failed)
+	int error;         //!< errno value from failed open, or 0
+	log_fileset next;  //!< Opened fileset, if ready and successful
+	log_fileset stale; //!< Unused fileset waiting to be removed
+	FILE *closing[ROTATE_CLOSE_MAX]; //!< Files waiting to be closed
+	int nClosing;      //!< Number of entries in closing
+} log_rotator;
+
+//! Start background rotation thread
+bool rotator_init(log_rotator *r, const char *prefix, bool index);
+
+//! Request that the next set of files is opened
+bool rotator_prepare(log_rotator *r, time_t when);
+
+//! Retrieve next set of files, if available
+bool rotator_take(log_rotator *r, log_fileset *fs, time_t when);
+
+//! Close a file in the background
+void rotator_close(log_rotator *r, FILE *f);
+
+//! Stop background thread and release resources
+void rotator_destroy(log_rotator *r);
+
+//! Open a complete set of output files
+bool rotator_open_fileset(const char *prefix, time_t when, bool index, log_fileset *fs);
+
+//! Close and remove an unused set of output files
+void rotator_discard_fileset(log_fileset *fs);
+/*! @} */
+#endif
@@ -42,17 +42,141 @@ void *rx_setup(void *ptargs) {
 		return NULL;
 	}
 
+	// Only wake for new data once a full message is available, unless
+	// looking for gaps between messages
+	if (!serial_set_minimum(rxInfo->handle, (rxInfo->idleGap > 0) ? 1 : rxInfo->minBytes)) {
+		log_warning(args->pstate, "[Serial:%s] Unable to set read threshold", args->tag);
+	}
+
+	rxInfo->haveCounts = serial_get_counts(rxInfo->handle, &(rxInfo->counts));
+	if (!rxInfo->haveCounts) {
+		log_info(args->pstate, 2, "[Serial:%s] Device does not report receive errors",
+		         args->tag);
+	}
+
+	rxInfo->buf = calloc(rxInfo->maxBytes, sizeof(uint8_t));
+	rxInfo->hw = 0;
+	if (rxInfo->buf == NULL) {
+		log_error(args->pstate, "[Serial:%s] Unable to allocate input buffer", args->tag);
+		args->returnCode = -1;
+		return NULL;
+	}
+
 	log_info(args->pstate, 2, "[Serial:%s] Connected", args->tag);
 	args->returnCode = 0;
 	return NULL;
 }
 
+/*!
+ * Reads any available data into the buffer, up to maxBytes.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @returns Number of bytes read, or -1 on error (args->returnCode set)
+ */
+static int rx_fill(log_thread_args_t *args) {
+	rx_params *rxInfo = (rx_params *)args->dParams;
+	if (rxInfo->hw >= rxInfo->maxBytes) { return 0; }
+
+	errno = 0;
+	int ti = read(rxInfo->handle, &(rxInfo->buf[rxInfo->hw]), rxInfo->maxBytes - rxInfo->hw);
+	if (ti >= 0) {
+		rxInfo->hw += ti;
+		return ti;
+	}
+	if (errno == EAGAIN) { return 0; }
+	log_error(args->pstate, "[Serial:%s] Unexpected error while reading from serial port (%s)",
+	          args->tag, strerror(errno));
+	args->returnCode = -1;
+	return -1;
+}
+
+/*!
+ * @param[in] args Pointer to log_thread_args_t
+ * @param[in] msg  Message to be queued
+ * @returns True on success, false on error (args->returnCode set)
+ */
+static bool rx_push(log_thread_args_t *args, msg_t *msg) {
+	if (!queue_push(args->logQ, msg)) {
+		log_error(args->pstate, "[Serial:%s] Error pushing message to queue", args->tag);
+		msg_free(msg);
+		args->returnCode = -1;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * The buffer is not cleared, as only the first hw bytes are ever used.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @returns True on success, false on error (args->returnCode set)
+ */
+static bool rx_push_buffer(log_thread_args_t *args) {
+	rx_params *rxInfo = (rx_params *)args->dParams;
+	msg_t *sm = msg_new_bytes(rxInfo->sourceNum, SLCHAN_RAW, rxInfo->hw, rxInfo->buf);
+	if (!rx_push(args, sm)) { return false; }
+	rxInfo->hw = 0;
+	return true;
+}
+
+/*!
+ * Checks the error counters for the port (at most every RX_COUNT_INTERVAL
+ * milliseconds), and logs a warning and queues the updated totals if they
+ * have changed since the last check.
+ *
+ * Nothing is done for devices that don't report these counters.
+ *
+ * @param[in] args Pointer to log_thread_args_t
+ * @returns True on success, false on error (args->returnCode set)
+ */
+static bool rx_check_counts(log_thread_args_t *args) {
+	rx_params *rxInfo = (rx_params *)args->dParams;
+	if (!rxInfo->haveCounts) { return true; }
+
+	const int64_t now = monotonic_ms();
+	if (now < rxInfo->nextCount) { return true; }
+	rxInfo->nextCount = now + RX_COUNT_INTERVAL;
+
+	serial_counts sc = {0};
+	if (!serial_get_counts(rxInfo->handle, &sc)) { return true; }
+
+	const serial_counts *base = &(rxInfo->counts);
+	const uint32_t overruns =
+		(sc.overrun - base->overrun) + (sc.bufOverrun - base->bufOverrun);
+	const uint32_t errors = (sc.frame - base->frame) + (sc.parity - base->parity);
+	if (overruns == rxInfo->overruns && errors == rxInfo->errors) { return true; }
+
+	if (overruns != rxInfo->overruns) {
+		log_warning(args->pstate,
+		            "[Serial:%s] Data lost due to receive overrun (%u new, %u total)",
+		            args->tag, overruns - rxInfo->overruns, overruns);
+	}
+	if (errors != rxInfo->errors) {
+		log_warning(args->pstate,
+		            "[Serial:%s] Framing or parity errors detected (%u new, %u total)",
+		            args->tag, errors - rxInfo->errors, errors);
+	}
+	rxInfo->overruns = overruns;
+	rxInfo->errors = errors;
+
+	return rx_push(args, msg_new_float(rxInfo->sourceNum, RXCHAN_OVERRUNS, overruns)) &&
+	       rx_push(args, msg_new_float(rxInfo->sourceNum, RXCHAN_ERRORS, errors));
+}
+
 /*!
  * Reads messages from the connection established by rx_setup(), and pushes them to the
  * queue. Data is not interpreted, just pushed into the queue with suitable headers.
  *
- * Message size is variable, based on min/max limits and the amount of data
- * available to read from the source.
+ * The thread waits in poll() until data is available, and the port is
+ * configured by rx_setup() so that it is only reported as readable once at
+ * least minBytes are waiting.
+ *
+ * If idleGap is set, buffered data is instead pushed to the queue once no
+ * data has been received for idleGap milliseconds, so that messages are
+ * split at natural gaps in the data stream.
+ *
+ * In either case, data is pushed to the queue immediately once maxBytes
+ * are buffered.
  *
  * Terminates thread in case of error.
  *
@@ -66,51 +190,77 @@ void *rx_logging(void *ptargs) {
 
 	log_info(args->pstate, 1, "[Serial:%s] Logging thread started", args->tag);
 
-	uint8_t *buf = calloc(rxInfo->maxBytes, sizeof(uint8_t));
-	int rx_hw = 0;
+	// Maximum time between checks of shutdownFlag and the error counters
+	int pollWait = 1000 / rxInfo->pollFreq;
+	if (pollWait < 1) { pollWait = 1; }
+
+	struct pollfd pfd = {.fd = rxInfo->handle, .events = POLLIN};
 	while (!shutdownFlag) {
-		// Need to implement a message handling loop here
-		int ti = 0;
-		if (rx_hw < rxInfo->maxBytes - 1) {
-			errno = 0;
-			ti = read(rxInfo->handle, &(buf[rx_hw]), rxInfo->maxBytes - rx_hw);
-			if (ti >= 0) {
-				rx_hw += ti;
-			} else {
-				if (errno != EAGAIN) {
-					log_error(
-						args->pstate,
-						"[Serial:%s] Unexpected error while reading from serial port (%s)",
-						args->tag, strerror(errno));
-					args->returnCode = -1;
-					pthread_exit(&(args->returnCode));
-				}
-			}
+		const bool waitGap = (rxInfo->idleGap > 0) && (rxInfo->hw > 0);
+		const int pr = poll(&pfd, 1, waitGap ? rxInfo->idleGap : pollWait);
+		if (pr < 0 && errno != EINTR) {
+			log_error(args->pstate, "[Serial:%s] Error waiting for data (%s)",
+			          args->tag, strerror(errno));
+			args->returnCode = -1;
+			pthread_exit(&(args->returnCode));
 		}
 
-		if (rx_hw < rxInfo->minBytes) {
-			// Sleep briefly, then loop until we have more than the minimum
-			// number of bytes available
-			usleep(1E6 / rxInfo->pollFreq);
-			continue;
+		if (pr > 0) {
+			const int ti = rx_fill(args);
+			if (ti < 0) { pthread_exit(&(args->returnCode)); }
+			if (ti == 0 && (pfd.revents & (POLLHUP | POLLERR))) {
+				// Avoid spinning on a disconnected device
+				usleep(1E6 / rxInfo->pollFreq);
+			}
 		}
 
-		msg_t *sm = msg_new_bytes(rxInfo->sourceNum, 3, rx_hw, buf);
-		if (!queue_push(args->logQ, sm)) {
-			log_error(args->pstate, "[Serial:%s] Error pushing message to queue",
-			          args->tag);
-			msg_destroy(sm);
-			args->returnCode = -1;
-			pthread_exit(&(args->returnCode));
+		bool push = (rxInfo->hw >= rxInfo->maxBytes);
+		if (rxInfo->idleGap > 0) {
+			push |= (pr == 0 && rxInfo->hw > 0);
+		} else {
+			push |= (rxInfo->hw >= rxInfo->minBytes);
 		}
-		rx_hw = 0;
-		memset(buf, 0, rxInfo->maxBytes);
+		if (push && !rx_push_buffer(args)) { pthread_exit(&(args->returnCode)); }
+		if (!rx_check_counts(args)) { pthread_exit(&(args->returnCode)); }
 	}
-	free(buf);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
 }
 
+/*!
+ * Sources with idleGap set require a timeout to detect gaps in the data,
+ * and so are always handled by their own thread.
+ *
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns Handle for device opened by rx_setup(), or -1 if the reactor
+ * can't be used for this source
+ */
+int rx_handle(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	rx_params *rxInfo = (rx_params *)args->dParams;
+	if (rxInfo->idleGap > 0) { return -1; }
+	return rxInfo->handle;
+}
+
+/*!
+ * Called by the I/O reactor when data is available. Equivalent to
+ * rx_logging(), but returns once all available data has been read.
+ *
+ * @param[in] ptargs Pointer to log_thread_args_t
+ * @returns True on success, false on error (exit code in ptargs->returnCode)
+ */
+bool rx_readable(void *ptargs) {
+	log_thread_args_t *args = (log_thread_args_t *)ptargs;
+	rx_params *rxInfo = (rx_params *)args->dParams;
+	int ti = 0;
+	do {
+		ti = rx_fill(args);
+		if (ti < 0) { return false; }
+		if (rxInfo->hw >= rxInfo->minBytes && !rx_push_buffer(args)) { return false; }
+	} while (ti > 0 && !shutdownFlag);
+	return rx_check_counts(args);
+}
+
 /*!
  * Simple wrapper around rx_closeConnection(), which will do any cleanup required.
  *
@@ -125,6 +275,10 @@ void *rx_shutdown(void *ptargs) {
 		close(rxInfo->handle);
 	}
 	rxInfo->handle = -1;
+	if (rxInfo->buf) {
+		free(rxInfo->buf);
+		rxInfo->buf = NULL;
+	}
 	if (rxInfo->portName) {
 		free(rxInfo->portName);
 		rxInfo->portName = NULL;
@@ -139,7 +293,9 @@ device_callbacks rx_getCallbacks() {
 	device_callbacks cb = {.startup = &rx_setup,
 	                       .logging = &rx_logging,
 	                       .shutdown = &rx_shutdown,
-	                       .channels = &rx_channels};
+	                       .channels = &rx_channels,
+	                       .handle = &rx_handle,
+	                       .readable = &rx_readable};
 	return cb;
 }
 
@@ -152,17 +308,22 @@ rx_params rx_getParams() {
 	                .handle = -1,
 	                .minBytes = 10,
 	                .maxBytes = 1024,
-	                .pollFreq = 10};
+	                .pollFreq = 10,
+	                .idleGap = 0,
+	                .buf = NULL,
+	                .hw = 0,
+	                .haveCounts = false};
 	return mp;
 }
 
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Exits thread in case of error.
+ * Runs in the main thread, so if the queue is full the messages are
+ * discarded instead.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *rx_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -171,30 +332,30 @@ void *rx_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(rxInfo->sourceNum, SLCHAN_NAME, strlen(rxInfo->sourceName),
 	                             rxInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[Serial:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
-	strarray *channels = sa_new(4);
+	strarray *channels = sa_new(RXCHAN_ERRORS + 1);
 	sa_create_entry(channels, SLCHAN_NAME, 4, "Name");
 	sa_create_entry(channels, SLCHAN_MAP, 8, "Channels");
 	sa_create_entry(channels, SLCHAN_TSTAMP, 9, "Timestamp");
 	sa_create_entry(channels, SLCHAN_RAW, 8, "Raw Data");
+	sa_create_entry(channels, RXCHAN_OVERRUNS, 8, "Overruns");
+	sa_create_entry(channels, RXCHAN_ERRORS, 11, "Line Errors");
 
 	msg_t *m_cmap = msg_new_string_array(rxInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[Serial:%s] Error pushing channel map to queue",
 		          args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
@@ -351,6 +512,26 @@ bool rx_parseConfig(log_thread_args_t *lta, config_section *s) {
 		}
 	}
 	t = NULL;
+
+	if ((t = config_get_key(s, "idlegap"))) {
+		errno = 0;
+		rx->idleGap = strtol(t->value, NULL, 0);
+		if (errno) {
+			log_error(lta->pstate, "[Serial:%s] Error parsing idle gap: %s", lta->tag,
+			          strerror(errno));
+			free(rx);
+			return false;
+		}
+
+		if (rx->idleGap < 0) {
+			log_error(lta->pstate,
+			          "[Serial:%s] Invalid idle gap (%d is less than zero)", lta->tag,
+			          rx->idleGap);
+			free(rx);
+			return false;
+		}
+	}
+	t = NULL;
 	lta->dParams = rx;
 	return true;
 }
@@ -22,6 +22,7 @@
 #define SL_LOGGER_SERIAL_H
 
 #include <errno.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -39,16 +40,37 @@
  *
  * @{
  */
+/*!
+ * @brief Channels used by serial sources, in addition to SLCHAN_RAW
+ *
+ * Only used if the device reports receive errors.
+ * @{
+ */
+#define RXCHAN_OVERRUNS 4 //!< Receive overruns since device opened
+#define RXCHAN_ERRORS   5 //!< Framing and parity errors since device opened
+//! @}
+
+//! Minimum interval between checks of receive error counters (milliseconds)
+#define RX_COUNT_INTERVAL 1000
+
 //! Serial device specific parameters
 typedef struct {
-	char *sourceName;  //!< User defined name for this source
-	uint8_t sourceNum; //!< Source ID for messages
-	char *portName;    //!< Target port name
-	int baudRate;      //!< Baud rate for operations (currently unused)
-	int handle;        //!< Handle for currently opened device
-	int minBytes;      //!< Minimum number of bytes to group into a message
-	int maxBytes;      //!< Maximum number of bytes to group into a message
-	int pollFreq;      //!< Minimum number of times per second to check for data
+	char *sourceName;     //!< User defined name for this source
+	uint8_t sourceNum;    //!< Source ID for messages
+	char *portName;       //!< Target port name
+	int baudRate;         //!< Baud rate for operations (currently unused)
+	int handle;           //!< Handle for currently opened device
+	int minBytes;         //!< Minimum number of bytes to group into a message
+	int maxBytes;         //!< Maximum number of bytes to group into a message
+	int pollFreq;         //!< Minimum number of times per second to check for data
+	int idleGap;          //!< Push data once none received for this long (ms, 0 to disable)
+	uint8_t *buf;         //!< Data read but not yet queued
+	int hw;               //!< Amount of data in buf
+	bool haveCounts;      //!< Device reports receive error counters
+	serial_counts counts; //!< Receive error counters when device opened
+	uint32_t overruns;    //!< Overruns since device opened, as last reported
+	uint32_t errors;      //!< Framing and parity errors since device opened, as last reported
+	int64_t nextCount;    //!< Time of next error counter check (see monotonic_ms())
 } rx_params;
 
 //! Generic serial connection setup
@@ -57,6 +79,12 @@ void *rx_setup(void *ptargs);
 //! Serial source main logging loop
 void *rx_logging(void *ptargs);
 
+//! Serial source file descriptor, for reactor
+int rx_handle(void *ptargs);
+
+//! Serial source read available data, for reactor
+bool rx_readable(void *ptargs);
+
 //! Serial source shutdown
 void *rx_shutdown(void *ptargs);
 
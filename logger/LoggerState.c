@@ -0,0 +1,381 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <libgen.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Logger.h"
+
+#include "LoggerState.h"
+
+//! Number of entries in state table
+#define STATE_ENTRIES (128 * 128)
+
+/*!
+ * @brief Ensure a buffer can hold at least the requested number of bytes
+ *
+ * @param[in,out] buf Buffer
+ * @param[in,out] cap Allocated size of buffer
+ * @param[in]     len Required size
+ * @returns False if unable to allocate memory
+ */
+static bool state_reserve(char **buf, size_t *cap, size_t len) {
+	if (len <= *cap) { return true; }
+	size_t ncap = (*cap > 0) ? *cap : 64;
+	while (ncap < len) {
+		ncap *= 2;
+	}
+	char *nb = realloc(*buf, ncap);
+	if (nb == NULL) { return false; } // LCOV_EXCL_LINE
+	*buf = nb;
+	*cap = ncap;
+	return true;
+}
+
+/*!
+ * @brief Background thread: write out snapshot when requested
+ *
+ * @param[in] ptr Pointer to log_state
+ * @returns NULL
+ */
+static void *state_thread(void *ptr) {
+	log_state *st = ptr;
+	pthread_mutex_lock(&st->lock);
+	while (true) {
+		if (st->pending && !st->stop) {
+			st->pending = false;
+			pthread_mutex_unlock(&st->lock);
+			errno = 0;
+			const bool ok = state_write(st);
+			const int err = errno;
+			pthread_mutex_lock(&st->lock);
+			st->error = ok ? 0 : (err ? err : EIO);
+			continue;
+		}
+		if (st->stop) { break; }
+		pthread_cond_wait(&st->cond, &st->lock);
+	}
+	pthread_mutex_unlock(&st->lock);
+	return NULL;
+}
+
+/*!
+ * Temporary files are created in the same directory as the state file, so
+ * that the completed file can be moved into place atomically.
+ *
+ * @param[out] st       State
+ * @param[in]  fileName State file name (copied)
+ * @returns True on success
+ */
+bool state_init(log_state *st, const char *fileName) {
+	if (st == NULL || fileName == NULL) { return false; }
+	memset(st, 0, sizeof(log_state));
+
+	st->fileName = strdup(fileName);
+	char *sfn = strdup(fileName);
+	if (st->fileName == NULL || sfn == NULL ||
+	    asprintf(&st->tmpName, "%s/stateXXXXXX", dirname(sfn)) < 0) {
+		// LCOV_EXCL_START
+		free(sfn);
+		free(st->fileName);
+		st->fileName = NULL;
+		st->tmpName = NULL;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	// dirname() result points into sfn
+	free(sfn);
+
+	st->dirty = calloc(STATE_ENTRIES, sizeof(uint16_t));
+	st->isDirty = calloc(STATE_ENTRIES, sizeof(bool));
+	st->active = calloc(STATE_ENTRIES, sizeof(uint16_t));
+	st->entries = calloc(STATE_ENTRIES, sizeof(state_entry));
+	if (!st->dirty || !st->isDirty || !st->active || !st->entries) {
+		// LCOV_EXCL_START
+		state_destroy(st);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	if (pthread_mutex_init(&st->lock, NULL) != 0 ||
+	    pthread_mutex_init(&st->fileLock, NULL) != 0 || pthread_cond_init(&st->cond, NULL) != 0) {
+		// LCOV_EXCL_START
+		state_destroy(st);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	if (pthread_create(&st->thread, NULL, state_thread, st) != 0) {
+		// LCOV_EXCL_START
+		pthread_cond_destroy(&st->cond);
+		pthread_mutex_destroy(&st->fileLock);
+		pthread_mutex_destroy(&st->lock);
+		state_destroy(st);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+	st->running = true;
+	return true;
+}
+
+/*!
+ * Called from the main thread for each message processed, so this only
+ * records the channel in a list to be processed by state_update().
+ *
+ * @param[in] st     State
+ * @param[in] source Message source
+ * @param[in] type   Message type / channel
+ */
+void state_touch(log_state *st, uint8_t source, uint8_t type) {
+	if (st == NULL || st->isDirty == NULL || source >= 128 || type >= 128) { return; }
+	const uint16_t ix = (source << 7) | type;
+	if (st->isDirty[ix]) { return; }
+	st->isDirty[ix] = true;
+	st->dirty[st->nDirty++] = ix;
+}
+
+/*!
+ * Must be called from the same thread as state_touch(). Only channels updated
+ * since the last call are processed, and memory is only allocated if a value
+ * requires more space than the previous value for that channel.
+ *
+ * @param[in] st     State
+ * @param[in] stats  Channel statistics
+ * @param[in] lTS    Last received timestamp
+ * @param[in] vFName Name and path to current channel mapping file
+ * @returns False if unable to allocate memory
+ */
+bool state_update(log_state *st, channel_stats stats[128][128], uint32_t lTS, const char *vFName) {
+	if (st == NULL || st->entries == NULL) { return false; }
+	bool ok = true;
+	pthread_mutex_lock(&st->lock);
+	st->timestamp = lTS;
+	const size_t vlen = vFName ? strlen(vFName) : 0;
+	if (state_reserve(&st->varFile, &st->varCap, vlen + 1)) {
+		memcpy(st->varFile, vFName ? vFName : "", vlen + 1);
+	} else {
+		ok = false; // LCOV_EXCL_LINE
+	}
+
+	for (int d = 0; d < st->nDirty; d++) {
+		const uint16_t ix = st->dirty[d];
+		st->isDirty[ix] = false;
+		const channel_stats *cs = &stats[ix >> 7][ix & 0x7F];
+		state_entry *e = &st->entries[ix];
+		if (cs->count == 0 || cs->lastMessage == NULL) { continue; }
+		if (e->count == 0) {
+			// New channel: insert into active list, keeping it sorted
+			int pos = st->nActive;
+			while (pos > 0 && st->active[pos - 1] > ix) {
+				pos--;
+			}
+			memmove(&st->active[pos + 1], &st->active[pos],
+			        (st->nActive - pos) * sizeof(uint16_t));
+			st->active[pos] = ix;
+			st->nActive++;
+		}
+		e->count = cs->count;
+		e->lastTimestamp = cs->lastTimestamp;
+		int len = msg_data_format(cs->lastMessage, e->text, e->textCap);
+		if (len >= 0 && (size_t)len >= e->textCap) {
+			if (state_reserve(&e->text, &e->textCap, len + 1)) {
+				len = msg_data_format(cs->lastMessage, e->text, e->textCap);
+			} else {
+				len = -1; // LCOV_EXCL_LINE
+			}
+		}
+		if (len < 0) {
+			// LCOV_EXCL_START
+			e->textLen = 0;
+			ok = false;
+			continue;
+			// LCOV_EXCL_STOP
+		}
+		e->textLen = len;
+	}
+	st->nDirty = 0;
+	pthread_mutex_unlock(&st->lock);
+	return ok;
+}
+
+/*!
+ * @brief Append formatted text to state output buffer
+ *
+ * @param[in,out] st  State
+ * @param[in,out] pos Current position in output buffer
+ * @param[in]     fmt Format string
+ * @returns False if unable to allocate memory
+ */
+static bool state_append(log_state *st, size_t *pos, const char *fmt, ...)
+	__attribute__((format(__printf__, 3, 4)));
+
+static bool state_append(log_state *st, size_t *pos, const char *fmt, ...) {
+	while (true) {
+		va_list ap;
+		va_start(ap, fmt);
+		const int rv = vsnprintf(st->out + *pos, st->outCap - *pos, fmt, ap);
+		va_end(ap);
+		if (rv < 0) { return false; } // LCOV_EXCL_LINE
+		if ((size_t)rv < st->outCap - *pos) {
+			*pos += rv;
+			return true;
+		}
+		if (!state_reserve(&st->out, &st->outCap, *pos + rv + 1)) { return false; }
+	}
+}
+
+/*!
+ * The file contains the most recent timestamp, the path to the channel
+ * mapping file currently in use, and a line for each channel with the number
+ * of messages received, the timestamp of the last message and its value. Any
+ * change to this output format also needs to be reflected in SLFiles.py
+ *
+ * The output is written to a temporary file, which then replaces the
+ * existing state file. May be called from any thread.
+ *
+ * @param[in] st State
+ * @returns False if unable to create state file, True otherwise
+ */
+bool state_write(log_state *st) {
+	if (st == NULL || st->entries == NULL) { return false; }
+	pthread_mutex_lock(&st->fileLock);
+	if (!state_reserve(&st->out, &st->outCap, 4096)) {
+		// LCOV_EXCL_START
+		pthread_mutex_unlock(&st->fileLock);
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	// Copy snapshot to output buffer, then release lock before writing
+	size_t pos = 0;
+	pthread_mutex_lock(&st->lock);
+	bool ok = state_append(st, &pos, "%u\n%s\n", st->timestamp,
+	                       st->varFile ? st->varFile : "");
+	for (int a = 0; ok && a < st->nActive; a++) {
+		const uint16_t ix = st->active[a];
+		const state_entry *e = &st->entries[ix];
+		ok = state_append(st, &pos, "0x%02x,0x%02x,%u,%u,\'%.*s\'\n", ix >> 7, ix & 0x7F,
+		                  e->count, e->lastTimestamp, e->textLen,
+		                  e->text ? e->text : "");
+	}
+	pthread_mutex_unlock(&st->lock);
+	if (!ok) {
+		// LCOV_EXCL_START
+		pthread_mutex_unlock(&st->fileLock);
+		errno = ENOMEM;
+		return false;
+		// LCOV_EXCL_STOP
+	}
+
+	// mkstemp modifies the template, so restore it first
+	const size_t tlen = strlen(st->tmpName);
+	memcpy(&st->tmpName[tlen - 6], "XXXXXX", 6);
+	const int fd = mkstemp(st->tmpName);
+	if (fd < 0) {
+		pthread_mutex_unlock(&st->fileLock);
+		return false;
+	}
+
+	size_t done = 0;
+	while (done < pos) {
+		const ssize_t rv = write(fd, st->out + done, pos - done);
+		if (rv < 0) {
+			if (errno == EINTR) { continue; }
+			// LCOV_EXCL_START
+			const int err = errno;
+			close(fd);
+			unlink(st->tmpName);
+			pthread_mutex_unlock(&st->fileLock);
+			errno = err;
+			return false;
+			// LCOV_EXCL_STOP
+		}
+		done += rv;
+	}
+	close(fd);
+
+	errno = 0;
+	if (rename(st->tmpName, st->fileName) < 0) {
+		const int err = errno;
+		unlink(st->tmpName);
+		pthread_mutex_unlock(&st->fileLock);
+		errno = err;
+		return false;
+	}
+	pthread_mutex_unlock(&st->fileLock);
+	return true;
+}
+
+/*!
+ * Does not block. The snapshot should first be updated with state_update().
+ *
+ * @param[in] st State
+ * @returns False if the previous background write failed (errno set)
+ */
+bool state_request(log_state *st) {
+	if (st == NULL || st->entries == NULL) { return false; }
+	pthread_mutex_lock(&st->lock);
+	const int err = st->error;
+	st->error = 0;
+	st->pending = true;
+	pthread_cond_signal(&st->cond);
+	pthread_mutex_unlock(&st->lock);
+	if (err) {
+		errno = err;
+		return false;
+	}
+	return true;
+}
+
+/*!
+ * Any write in progress is completed, but outstanding requests are discarded.
+ *
+ * @param[in] st State
+ */
+void state_destroy(log_state *st) {
+	if (st == NULL) { return; }
+	if (st->running) {
+		pthread_mutex_lock(&st->lock);
+		st->stop = true;
+		pthread_cond_signal(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+		pthread_join(st->thread, NULL);
+		pthread_cond_destroy(&st->cond);
+		pthread_mutex_destroy(&st->fileLock);
+		pthread_mutex_destroy(&st->lock);
+	}
+	if (st->entries) {
+		for (int i = 0; i < STATE_ENTRIES; i++) {
+			free(st->entries[i].text);
+		}
+	}
+	free(st->entries);
+	free(st->active);
+	free(st->isDirty);
+	free(st->dirty);
+	free(st->varFile);
+	free(st->out);
+	free(st->tmpName);
+	free(st->fileName);
+	memset(st, 0, sizeof(log_state));
+}
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SL_LOGGER_STATE_H
+#define SL_LOGGER_STATE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//! @file
+
+/*!
+ * @addtogroup loggerState Logger: State file
+ * @ingroup logger
+ *
+ * The state file contains the most recent value received on each channel,
+ * and is read by external tools to display live data.
+ *
+ * The main thread records which channels have been updated as messages are
+ * processed. Periodically, the values for those channels (and only those
+ * channels) are copied into a snapshot, which is then written out to the
+ * state file by a background thread. Buffers are reused between updates, so
+ * no memory is allocated once all active channels have been seen.
+ *
+ * @{
+ */
+
+//! Default interval between state file updates (seconds)
+#define STATE_INTERVAL 60
+
+//! Snapshot of a single channel, as written to the state file
+typedef struct {
+	unsigned int count;     //!< Number of messages received
+	uint32_t lastTimestamp; //!< Timestamp of last received message
+	char *text;             //!< String representation of last message
+	size_t textCap;         //!< Allocated size of text
+	int textLen;            //!< Length of string in text
+} state_entry;
+
+//! State file writer
+typedef struct {
+	char *fileName;          //!< State file name
+	char *tmpName;           //!< Temporary file name template
+	uint16_t *dirty;         //!< Channels updated since last snapshot (source << 7 | channel)
+	int nDirty;              //!< Number of entries in dirty
+	bool *isDirty;           //!< Channel present in dirty list (indexed as dirty)
+	pthread_t thread;        //!< Background thread
+	bool running;            //!< Background thread started
+	pthread_mutex_t lock;    //!< Protects all following members
+	pthread_cond_t cond;     //!< Signals new work for background thread
+	pthread_mutex_t fileLock; //!< Serialises writes to state file
+	bool stop;               //!< Background thread should exit
+	bool pending;            //!< Snapshot has been updated and needs writing
+	int error;               //!< errno value from last failed write, or 0
+	state_entry *entries;    //!< Snapshot of each channel (128 x 128)
+	uint16_t *active;        //!< Channels with at least one message, in order
+	int nActive;             //!< Number of entries in active
+	uint32_t timestamp;      //!< Most recent timestamp
+	char *varFile;           //!< Current variable file name
+	size_t varCap;           //!< Allocated size of varFile
+	char *out;               //!< Output buffer (used while writing)
+	size_t outCap;           //!< Allocated size of out
+} log_state;
+
+//! Allocate state and start background thread
+bool state_init(log_state *st, const char *fileName);
+
+//! Mark channel as updated
+void state_touch(log_state *st, uint8_t source, uint8_t type);
+
+//! Copy updated channels into snapshot
+bool state_update(log_state *st, channel_stats stats[128][128], uint32_t lTS, const char *vFName);
+
+//! Write current snapshot to state file
+bool state_write(log_state *st);
+
+//! Ask background thread to write current snapshot
+bool state_request(log_state *st);
+
+//! Stop background thread and release resources
+void state_destroy(log_state *st);
+/*! @} */
+#endif
@@ -46,14 +46,58 @@ void *timer_setup(void *ptargs) {
 	return NULL;
 }
 
+//! Upper limit of each jitter histogram bin (microseconds), except the last
+static const uint64_t timer_jitter_limits[TIMER_JITTER_BINS - 1] = {10,   50,   100,  500,
+                                                                    1000, 5000, 10000};
+
+/*!
+ * @param[in] ns Jitter (nanoseconds)
+ * @returns Index of jitter histogram bin
+ */
+static int timer_jitter_bin(uint64_t ns) {
+	const uint64_t us = ns / 1000;
+	for (int b = 0; b < (TIMER_JITTER_BINS - 1); b++) {
+		if (us < timer_jitter_limits[b]) { return b; }
+	}
+	return TIMER_JITTER_BINS - 1;
+}
+
+/*!
+ * Push message to queue, exiting thread on error.
+ *
+ * @param[in] args Thread arguments
+ * @param[in] msg  Message to push
+ */
+static void timer_push(log_thread_args_t *args, msg_t *msg) {
+	if (!queue_push(args->logQ, msg)) {
+		log_error(args->pstate, "[Timer:%s] Error pushing message to queue", args->tag);
+		msg_free(msg);
+		args->returnCode = -1;
+		pthread_exit(&(args->returnCode));
+	}
+}
+
 /*!
  * Generate timestamp messages at the specified interval using CLOCK_MONOTONIC,
- * and epoch messages whenever the value of time() changes (i.e once a second).
+ * and epoch messages whenever the Unix time changes (i.e once a second).
+ *
+ * Ticks are scheduled at multiples of the timer period, and the thread
+ * sleeps until each deadline using an absolute clock_nanosleep() so that
+ * time spent in the loop doesn't cause the timer to drift. The timestamp
+ * message for each tick contains the deadline rather than the time the
+ * thread actually woke, so timestamps are evenly spaced.
  *
- * The loop saves the value of CLOCK_MONOTONIC at the start of each iteration
- * and uses that to calculate the target start time for the next iteration.  If
- * the execution of the loop has taken too long (i.e. the next iteration should
- * already have started), a warning is generated.
+ * If a deadline has already passed by more than a full period (e.g. if the
+ * system was heavily loaded), the missed ticks are skipped and counted.
+ *
+ * Every reportInterval seconds, the distribution of wake up delays (jitter)
+ * and the number of missed ticks are pushed to the timer's own channels:
+ * - TIMER_CHAN_JITTER: Counts in bins of <10, <50, <100, <500, <1000, <5000,
+ *   <10000 and >=10000 microseconds
+ * - TIMER_CHAN_JITTER_P50, TIMER_CHAN_JITTER_P99, TIMER_CHAN_JITTER_MAX
+ * - TIMER_CHAN_MISSED
+ *
+ * A single warning is logged per report if any ticks were missed.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
  * @returns NULL - Exit code in ptargs->returnCode if required
@@ -65,55 +109,93 @@ void *timer_logging(void *ptargs) {
 
 	log_info(args->pstate, 1, "[Timer:%s] Logging thread started", args->tag);
 
-	const int incr_nsec = (1E9 / timerInfo->frequency);
+	lat_hist *jitter = calloc(1, sizeof(lat_hist));
+	if (jitter == NULL) {
+		log_error(args->pstate, "[Timer:%s] Unable to allocate jitter histogram",
+		          args->tag);
+		args->returnCode = -2;
+		pthread_exit(&(args->returnCode));
+	}
+	uint64_t bins[TIMER_JITTER_BINS] = {0};
+	uint64_t missed = 0;
+
+	const uint64_t period = 1000000000ULL / timerInfo->frequency;
+	const uint64_t reportPeriod = (uint64_t)timerInfo->reportInterval * 1000000000ULL;
+	uint64_t deadline = ((lat_now() / period) + 1) * period;
+	uint64_t nextReport = deadline + reportPeriod;
+	uint64_t nextEpoch = 0; // Monotonic time at which Unix time is next due to change
 	time_t lstamp = 0;
 	while (!shutdownFlag) {
-		struct timespec now = {0};
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		// Millisecond precision timestamp, but arbitrary reference point
-		msg_t *msg = msg_new_timestamp(timerInfo->sourceNum, SLCHAN_TSTAMP,
-		                               (1000 * now.tv_sec + now.tv_nsec / 1000000));
-		if (!queue_push(args->logQ, msg)) {
-			log_error(args->pstate, "[Timer:%s] Error pushing message to queue",
-			          args->tag);
-			msg_destroy(msg);
+		const struct timespec target = {.tv_sec = deadline / 1000000000ULL,
+		                                .tv_nsec = deadline % 1000000000ULL};
+		int rv = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL);
+		if (rv == EINTR) { continue; }
+		if (rv != 0) {
+			// LCOV_EXCL_START
+			log_error(args->pstate, "[Timer:%s] Unable to wait for next tick: %s",
+			          args->tag, strerror(rv));
+			free(jitter);
 			args->returnCode = -1;
 			pthread_exit(&(args->returnCode));
+			// LCOV_EXCL_STOP
 		}
 
-		time_t nstamp = time(NULL);
-		if (nstamp != lstamp) {
-			// Unix Epoch referenced timestamp
-			msg_t *epoch_msg = msg_new_timestamp(timerInfo->sourceNum, 4, nstamp);
-			if (!queue_push(args->logQ, epoch_msg)) {
-				log_error(args->pstate,
-				          "[Timer:%s] Error pushing message to queue", args->tag);
-				msg_destroy(epoch_msg);
-				args->returnCode = -1;
-				pthread_exit(&(args->returnCode));
-			}
-			lstamp = nstamp;
+		const uint64_t now = lat_now();
+		if (now >= deadline + period) {
+			const uint64_t skip = (now - deadline) / period;
+			missed += skip;
+			deadline += skip * period;
 		}
+		const uint64_t late = (now > deadline) ? now - deadline : 0;
+		lat_record(jitter, late);
+		bins[timer_jitter_bin(late)]++;
+
+		// Millisecond precision timestamp, but arbitrary reference point
+		timer_push(args, msg_new_timestamp(timerInfo->sourceNum, SLCHAN_TSTAMP,
+		                                   (uint32_t)(deadline / 1000000)));
 
-		struct timespec nextIter = now;
-		nextIter.tv_nsec += incr_nsec;
-		if (nextIter.tv_nsec >= 1E9) {
-			int nsec = nextIter.tv_nsec / 1000000000;
-			nextIter.tv_nsec = nextIter.tv_nsec % 1000000000;
-			nextIter.tv_sec += nsec;
+		if (now >= nextEpoch) {
+			struct timespec rt = {0};
+			clock_gettime(CLOCK_REALTIME, &rt);
+			if (rt.tv_sec != lstamp) {
+				// Unix Epoch referenced timestamp
+				timer_push(args, msg_new_timestamp(timerInfo->sourceNum,
+				                                   TIMER_CHAN_EPOCH, rt.tv_sec));
+				lstamp = rt.tv_sec;
+			}
+			nextEpoch = now + (1000000000ULL - rt.tv_nsec);
 		}
-		nextIter.tv_nsec -= (nextIter.tv_nsec % incr_nsec);
-
-		struct timespec target = {0};
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		if (timespec_subtract(&target, &nextIter, &now)) {
-			// Target has passed! Update ASAP and continue
-			log_warning(args->pstate, "[Timer:%s] Deadline missed", args->tag);
-			continue;
-		} else {
-			nanosleep(&target, NULL);
+
+		if (now >= nextReport) {
+			float fb[TIMER_JITTER_BINS] = {0};
+			for (int b = 0; b < TIMER_JITTER_BINS; b++) {
+				fb[b] = bins[b];
+				bins[b] = 0;
+			}
+			const uint8_t src = timerInfo->sourceNum;
+			timer_push(args, msg_new_float_array(src, TIMER_CHAN_JITTER,
+			                                     TIMER_JITTER_BINS, fb));
+			timer_push(args, msg_new_float(src, TIMER_CHAN_JITTER_P50,
+			                               lat_percentile(jitter, 50) / 1000.0));
+			timer_push(args, msg_new_float(src, TIMER_CHAN_JITTER_P99,
+			                               lat_percentile(jitter, 99) / 1000.0));
+			timer_push(args,
+			           msg_new_float(src, TIMER_CHAN_JITTER_MAX, jitter->max / 1000.0));
+			timer_push(args, msg_new_float(src, TIMER_CHAN_MISSED, missed));
+			if (missed > 0) {
+				log_warning(args->pstate,
+				            "[Timer:%s] %" PRIu64 " ticks missed in last %d seconds",
+				            args->tag, missed, timerInfo->reportInterval);
+			}
+			lat_reset(jitter);
+			missed = 0;
+			nextReport += reportPeriod;
+			if (nextReport <= now) { nextReport = now + reportPeriod; }
 		}
+
+		deadline += period;
 	}
+	free(jitter);
 	pthread_exit(NULL);
 	return NULL; // Superfluous, as returning zero via pthread_exit above
 }
@@ -138,10 +220,11 @@ void *timer_shutdown(void *ptargs) {
 /*!
  * Populate list of channels and push to queue as a map message
  *
- * Exits thread in case of error.
+ * Called from the main thread, which can't wait for space in the queue,
+ * so messages are discarded if it is full.
  *
  * @param[in] ptargs Pointer to log_thread_args_t
- * @returns NULL - Exit code in ptargs->returnCode if required
+ * @returns NULL
  */
 void *timer_channels(void *ptargs) {
 	log_thread_args_t *args = (log_thread_args_t *)ptargs;
@@ -150,30 +233,33 @@ void *timer_channels(void *ptargs) {
 	msg_t *m_sn = msg_new_string(timerInfo->sourceNum, SLCHAN_NAME,
 	                             strlen(timerInfo->sourceName), timerInfo->sourceName);
 
-	if (!queue_push(args->logQ, m_sn)) {
+	if (!queue_try_push(args->logQ, m_sn)) {
 		log_error(args->pstate, "[Timer:%s] Error pushing channel name to queue",
 		          args->tag);
-		msg_destroy(m_sn);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		msg_free(m_sn);
+		return NULL;
 	}
 
-	strarray *channels = sa_new(5); // 0,1,2 and 4
+	strarray *channels = sa_new(TIMER_CHAN_MISSED + 1);
 	sa_create_entry(channels, SLCHAN_NAME, 4, "Name");
 	sa_create_entry(channels, SLCHAN_MAP, 8, "Channels");
 	sa_create_entry(channels, SLCHAN_TSTAMP, 9, "Timestamp");
-	sa_create_entry(channels, 4, 5, "Epoch");
+	sa_create_entry(channels, TIMER_CHAN_EPOCH, 5, "Epoch");
+	sa_create_entry(channels, TIMER_CHAN_JITTER, 16, "Jitter Histogram");
+	sa_create_entry(channels, TIMER_CHAN_JITTER_P50, 10, "Jitter p50");
+	sa_create_entry(channels, TIMER_CHAN_JITTER_P99, 10, "Jitter p99");
+	sa_create_entry(channels, TIMER_CHAN_JITTER_MAX, 10, "Jitter max");
+	sa_create_entry(channels, TIMER_CHAN_MISSED, 12, "Missed Ticks");
 
 	msg_t *m_cmap = msg_new_string_array(timerInfo->sourceNum, SLCHAN_MAP, channels);
 
-	if (!queue_push(args->logQ, m_cmap)) {
+	if (!queue_try_push(args->logQ, m_cmap)) {
 		log_error(args->pstate, "[Timer:%s] Error pushing channel map to queue",
 		          args->tag);
-		msg_destroy(m_cmap);
+		msg_free(m_cmap);
 		sa_destroy(channels);
 		free(channels);
-		args->returnCode = -1;
-		pthread_exit(&(args->returnCode));
+		return NULL;
 	}
 
 	sa_destroy(channels);
@@ -200,6 +286,7 @@ timer_params timer_getParams() {
 		.sourceNum = SLSOURCE_TIMER,
 		.sourceName = NULL,
 		.frequency = DEFAULT_MARK_FREQUENCY,
+		.reportInterval = TIMER_REPORT_INTERVAL,
 	};
 	return timer;
 }
@@ -252,6 +339,25 @@ bool timer_parseConfig(log_thread_args_t *lta, config_section *s) {
 	}
 	t = NULL;
 
+	if ((t = config_get_key(s, "reportinterval"))) {
+		errno = 0;
+		tp->reportInterval = strtol(t->value, NULL, 0);
+		if (errno) {
+			log_error(lta->pstate, "[Timer:%s] Error parsing report interval: %s",
+			          lta->tag, strerror(errno));
+			free(tp);
+			return false;
+		}
+		if (tp->reportInterval <= 0) {
+			log_error(lta->pstate,
+			          "[Timer:%s] Invalid report interval (%d) - must be positive and non-zero",
+			          lta->tag, tp->reportInterval);
+			free(tp);
+			return false;
+		}
+	}
+	t = NULL;
+
 	if ((t = config_get_key(s, "sourcenum"))) {
 		errno = 0;
 		int sn = strtol(t->value, NULL, 0);
@@ -39,14 +39,39 @@
  * Generate timestamps at as close to a regular frequency as possible, which can be used
  * to synchronise the output.
  *
+ * Each tick is scheduled against an absolute deadline, so delays in one
+ * iteration don't accumulate. The time between each deadline and the thread
+ * actually waking (jitter) is recorded, and summarised periodically on the
+ * timer's own channels along with the number of ticks that were missed
+ * entirely.
+ *
+ * @{
+ */
+
+//! Default interval between jitter reports (seconds)
+#define TIMER_REPORT_INTERVAL 10
+
+//! Number of bins in reported jitter histogram
+#define TIMER_JITTER_BINS 8
+
+/*!
+ * @brief Channels used by timer sources, in addition to SLCHAN_TSTAMP
  * @{
  */
+#define TIMER_CHAN_EPOCH      0x04 //!< Unix epoch timestamp (seconds), once per second
+#define TIMER_CHAN_JITTER     0x05 //!< Jitter histogram (counts per bin, see timer_logging())
+#define TIMER_CHAN_JITTER_P50 0x06 //!< Median jitter (microseconds)
+#define TIMER_CHAN_JITTER_P99 0x07 //!< 99th percentile jitter (microseconds)
+#define TIMER_CHAN_JITTER_MAX 0x08 //!< Maximum jitter (microseconds)
+#define TIMER_CHAN_MISSED     0x09 //!< Number of ticks missed
+//! @}
 
 //! Timer specific parameters
 typedef struct {
-	uint8_t sourceNum; //!< Source ID for messages
-	char *sourceName;  //!< Name to report for this timer
-	int frequency;     //!< Aim to sample this many times per second
+	uint8_t sourceNum;  //!< Source ID for messages
+	char *sourceName;   //!< Name to report for this timer
+	int frequency;      //!< Aim to sample this many times per second
+	int reportInterval; //!< Interval between jitter reports (seconds)
 } timer_params;
 
 //! Check parameters, but no other setup required
@@ -17,8 +17,10 @@
 # If not, see <http://www.gnu.org/licenses/>.
 
 import logging
+import mmap
 import msgpack
 import os
+import struct
 import pandas as pd
 import numpy as np
 
@@ -688,3 +690,118 @@ class StateFile:
             self.parse()
         delta = self._mtime - self._ts / 1000
         return pd.to_datetime(timestamp / 1000 + delta, unit="s")
+
+
+class LiveTable(StateFile):
+    """!
+    Read current values from the shared memory table published by the logger.
+
+    Provides the same interface as StateFile, but values are read directly
+    from memory rather than from a file written periodically. See
+    library/base/live.h for details of the table layout.
+    """
+
+    ## Table header: identifier, version, header size, table offset, entry
+    ## size, entry count, PID, sequence, timestamp, update time, state, clock
+    _header = struct.Struct("=8s7IIQIB11x")
+    ## Table entry: sequence, count, timestamp, data type, reserved, text
+    ## length, value, text, name
+    _entry = struct.Struct("=IIIBBHd72s32s")
+    ## Number of entries in table
+    _entries = 128 * 128
+    ## Maximum attempts to read a region before giving up (LIVE_READ_RETRIES)
+    _retries = 10000
+
+    def __init__(self, name="/SELKIELogger"):
+        """!
+        Create new object. Table is not opened or read until requested.
+        @param name Shared memory object name, as set in logger configuration
+        """
+        super().__init__(None)
+        ## Shared memory object name
+        self._name = name
+
+    @classmethod
+    def _read_stable(cls, mm, offset, size):
+        """!
+        Copy region protected by a sequence counter at `offset`, retrying
+        until the copy is not modified by the writer during the read.
+        @param mm Mapped table
+        @param offset Offset of sequence counter
+        @param size Size of region, including counter
+        @returns Copy of region as bytes, or None if no consistent copy could
+        be made (e.g. the writer stopped part way through an update)
+        """
+        for _ in range(cls._retries):
+            s1 = struct.unpack_from("=I", mm, offset)[0]
+            if s1 & 1:
+                continue
+            data = mm[offset : offset + size]
+            s2 = struct.unpack_from("=I", mm, offset)[0]
+            if s1 == s2:
+                return data
+        return None
+
+    @staticmethod
+    def _text(raw):
+        """!
+        @param raw Null terminated byte string
+        @returns Decoded string
+        """
+        return raw.split(b"\0", 1)[0].decode("utf-8", errors="replace")
+
+    def parse(self):
+        """!
+        Read all active entries from the table
+        @returns Channel statistics (also stored in _stats), or None if the
+        table header could not be read
+        """
+        path = os.path.join("/dev/shm", self._name.lstrip("/"))
+        with open(path, "rb") as f:
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mm:
+                hdr = self._header.unpack_from(mm, 0)
+                if hdr[0].rstrip(b"\0") != b"SLLIVE" or hdr[1] != 1:
+                    raise ValueError(f"{self._name} is not a valid live value table")
+                hdrSize, tableOffset, entrySize = hdr[2:5]
+
+                ## True if the logger was still running when the table was read
+                self.running = hdr[10] == 1
+                hs = self._read_stable(mm, 32, 24)
+                if hs is None:
+                    state = "running" if self.running else "stopped"
+                    log.error(f"Unable to read timestamp from {self._name} (logger {state})")
+                    return None
+                _, self._ts, updated = struct.unpack_from("=IIQ", hs, 0)
+                self._mtime = updated / 1000
+
+                bitmap = mm[hdrSize : hdrSize + self._entries // 8]
+                rows = []
+                skipped = 0
+                for ix in range(self._entries):
+                    if not bitmap[ix // 8] & (1 << (ix % 8)):
+                        continue
+                    raw = self._read_stable(mm, tableOffset + ix * entrySize, entrySize)
+                    if raw is None:
+                        # Entry left mid-update, skip it rather than report a torn value
+                        skipped += 1
+                        continue
+                    _, count, ts, dtype, _, _, value, text, name = self._entry.unpack(raw)
+                    if dtype == 1:
+                        text = f"{value:.6f}"
+                    elif dtype == 2:
+                        text = f"{int(value):09d}"
+                    else:
+                        text = self._text(text)
+                    rows.append((ix // 128, ix % 128, count, ts, text, self._text(name)))
+                if skipped:
+                    log.warning(f"{skipped} entries in {self._name} could not be read")
+
+        cols = ["Source", "Channel", "Count", "Time", "Value", "Name"]
+        self._stats = pd.DataFrame(rows, columns=cols).set_index(["Source", "Channel"])
+        self._stats["SecondsAgo"] = (self._stats["Time"] - self._ts) / 1000
+        self._stats["DateTime"] = (
+            self._stats["Time"]
+            .apply(self.to_clocktime)
+            .apply(lambda x: x.strftime("%Y-%m-%d %H:%M:%S"))
+        )
+        return self._stats
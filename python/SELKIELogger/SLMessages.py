@@ -63,6 +63,8 @@ class IDs:
     SLCHAN_TSTAMP = 0x02
     ## Raw device data (Not mandatory)
     SLCHAN_RAW = 0x03
+    ## Data file block header (SLSOURCE_LOCAL only)
+    SLCHAN_BLOCK = 0x7C
     ## Information messages
     SLCHAN_LOG_INFO = 0x7D
     ## Warning messages
@@ -588,6 +590,12 @@ class SLMessageSink:
             )
             self._sm.UpdateTimestamp(message.SourceID, message.Data)
             suppressOutput = True
+        elif (
+            message.SourceID == IDs.SLSOURCE_LOCAL
+            and message.ChannelID == IDs.SLCHAN_BLOCK
+        ):
+            # Block headers describe file structure rather than data
+            suppressOutput = True
         elif message.ChannelID == 125:
             self._msglog.info(self.FormatMessage(message))
             suppressOutput = True
@@ -0,0 +1,318 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerGPS.h"
+#include "SELKIELoggerLPMS.h"
+#include "SELKIELoggerMP.h"
+#include "SELKIELoggerN2K.h"
+#include "SELKIELoggerNMEA.h"
+
+/*! @file BatchReadTest.c
+ *
+ * @brief Test batch message readers
+ *
+ * @test Reads the NMEA, UBX, LPMS and MP sample files using both the single
+ * message readers and the corresponding batch readers, and checks that the
+ * same number of messages is returned by each. Small batch sizes are used so
+ * that batches are split across reads.
+ *
+ * N2K messages are written to a non-blocking pipe, and all but the last must
+ * be returned by a single call to n2k_act_readMessage_batch(). The parser
+ * holds back the final message in the buffer until further data arrives.
+ *
+ * @ingroup testing
+ */
+
+//! Batch size used when reading sample files
+#define BRT_BATCH 7
+
+//! Number of N2K messages expected from pipe (one more is written)
+#define BRT_N2K 30
+
+/*!
+ * @param[in] name File name
+ * @returns File descriptor
+ */
+static int brt_open(const char *name) {
+	const int fd = open(name, O_RDONLY);
+	if (fd < 0) {
+		// LCOV_EXCL_START
+		perror(name);
+		exit(-2);
+		// LCOV_EXCL_STOP
+	}
+	return fd;
+}
+
+/*!
+ * @param[in] name NMEA sample file
+ * @returns True if batch and single reads match
+ */
+static bool brt_nmea(const char *name) {
+	byte_ring r = {0};
+	assert(ring_init(&r, NMEA_SERIAL_BUFF));
+	int fd = brt_open(name);
+	int single = 0;
+	while (true) {
+		nmea_msg_t m = {0};
+		const bool ok = nmea_readMessage_ring(fd, &m, &r);
+		sa_destroy(&(m.fields));
+		if (ok) {
+			single++;
+		} else if (m.raw[0] == 0xFD) {
+			break;
+		}
+	}
+	close(fd);
+
+	ring_reset(&r);
+	fd = brt_open(name);
+	int batched = 0;
+	while (true) {
+		nmea_msg_t m[BRT_BATCH + 1] = {0};
+		const size_t n = nmea_readMessage_batch(fd, m, BRT_BATCH, &r);
+		for (size_t i = 0; i <= BRT_BATCH; i++) {
+			sa_destroy(&(m[i].fields));
+		}
+		batched += n;
+		if (n < BRT_BATCH && m[n].raw[0] == 0xFD) { break; }
+	}
+	close(fd);
+	ring_destroy(&r);
+	fprintf(stdout, "NMEA: %d messages read singly, %d in batches\n", single, batched);
+	return single > 0 && single == batched;
+}
+
+/*!
+ * @param[in] name UBX sample file
+ * @returns True if batch and single reads match
+ */
+static bool brt_ubx(const char *name) {
+	byte_ring r = {0};
+	assert(ring_init(&r, UBX_SERIAL_BUFF));
+	int fd = brt_open(name);
+	int single = 0;
+	while (true) {
+		ubx_message m = {0};
+		const bool ok = ubx_readMessage_ring(fd, &m, &r);
+		free(m.extdata);
+		if (ok) {
+			single++;
+		} else if (m.sync1 == 0xFD) {
+			break;
+		}
+	}
+	close(fd);
+
+	ring_reset(&r);
+	fd = brt_open(name);
+	int batched = 0;
+	while (true) {
+		ubx_message m[2] = {0};
+		const size_t n = ubx_readMessage_batch(fd, m, 1, &r);
+		free(m[0].extdata);
+		batched += n;
+		if (n == 0 && m[0].sync1 == 0xFD) { break; }
+	}
+	close(fd);
+	ring_destroy(&r);
+	fprintf(stdout, "UBX: %d messages read singly, %d in batches\n", single, batched);
+	return single > 0 && single == batched;
+}
+
+/*!
+ * @param[in] name LPMS sample file
+ * @returns True if batch and single reads match
+ */
+static bool brt_lpms(const char *name) {
+	byte_ring r = {0};
+	assert(ring_init(&r, LPMS_BUFF));
+	int fd = brt_open(name);
+	int single = 0;
+	while (true) {
+		lpms_message m = {0};
+		const bool ok = lpms_readMessage_ring(fd, &m, &r);
+		if (ok) {
+			free(m.data);
+			single++;
+		} else if (m.id == 0xFD) {
+			break;
+		}
+	}
+	close(fd);
+
+	ring_reset(&r);
+	fd = brt_open(name);
+	int batched = 0;
+	while (true) {
+		lpms_message m[BRT_BATCH] = {0};
+		const size_t n = lpms_readMessage_batch(fd, m, BRT_BATCH, &r);
+		for (size_t i = 0; i < n; i++) {
+			free(m[i].data);
+		}
+		batched += n;
+		if (n < BRT_BATCH && m[n].id == 0xFD) { break; }
+	}
+	close(fd);
+	ring_destroy(&r);
+	fprintf(stdout, "LPMS: %d messages read singly, %d in batches\n", single, batched);
+	return single > 0 && single == batched;
+}
+
+/*!
+ * @param[in] name MP sample file
+ * @returns True if batch and single reads match
+ */
+static bool brt_mp(const char *name) {
+	mp_stream s = {0};
+	int fd = brt_open(name);
+	assert(mp_stream_init(&s, fd, 0));
+	int single = 0;
+	while (true) {
+		msg_t m = {0};
+		if (mp_stream_read(&s, &m)) {
+			single++;
+			msg_destroy(&m);
+		} else if (m.dtype == MSG_ERROR && m.data.value == 0xFD) {
+			break;
+		}
+	}
+	mp_stream_destroy(&s);
+	close(fd);
+
+	fd = brt_open(name);
+	assert(mp_stream_init(&s, fd, 1024));
+	msg_t *m[BRT_BATCH] = {0};
+	for (int i = 0; i < BRT_BATCH; i++) {
+		m[i] = calloc(1, sizeof(msg_t));
+		assert(m[i]);
+	}
+	int batched = 0;
+	while (true) {
+		const size_t n = mp_stream_read_batch(&s, m, BRT_BATCH);
+		for (size_t i = 0; i < n; i++) {
+			msg_destroy(m[i]);
+			*(m[i]) = (msg_t){0};
+		}
+		batched += n;
+		if (n < BRT_BATCH && m[n]->dtype == MSG_ERROR && m[n]->data.value == 0xFD) {
+			break;
+		}
+	}
+	for (int i = 0; i < BRT_BATCH; i++) {
+		msg_destroy(m[i]);
+		free(m[i]);
+	}
+	mp_stream_destroy(&s);
+	close(fd);
+	fprintf(stdout, "MP: %d messages read singly, %d in batches\n", single, batched);
+	return single > 0 && single == batched;
+}
+
+/*!
+ * Write BRT_N2K + 1 messages to a pipe, then read them back with a single
+ * call.
+ *
+ * @returns True if all messages returned, in order
+ */
+static bool brt_n2k(void) {
+	int pfd[2] = {-1, -1};
+	assert(pipe(pfd) == 0);
+	assert(fcntl(pfd[0], F_SETFL, O_NONBLOCK) == 0);
+
+	uint8_t payload[8] = {0};
+	size_t total = 0;
+	for (int i = 0; i <= BRT_N2K; i++) {
+		for (int j = 0; j < 8; j++) {
+			payload[j] = (uint8_t)(i + j);
+		}
+		n2k_act_message a = {.priority = 2,
+		                     .PGN = 127250,
+		                     .dst = 255,
+		                     .src = (uint8_t)i,
+		                     .timestamp = 1000 * i,
+		                     .datalen = 8,
+		                     .data = payload};
+		a.length = a.datalen + 11;
+		a.csum = n2k_act_checksum(&a);
+		uint8_t *bytes = NULL;
+		size_t len = 0;
+		assert(n2k_act_to_bytes(&a, &bytes, &len));
+		assert(write(pfd[1], bytes, len) == (ssize_t)len);
+		free(bytes);
+		total += len;
+	}
+	assert(total < N2K_BUFF);
+
+	uint8_t buf[N2K_BUFF] = {0};
+	size_t index = 0;
+	size_t hw = 0;
+	n2k_act_message out[BRT_N2K + 1] = {0};
+	const size_t n = n2k_act_readMessage_batch(pfd[0], out, BRT_N2K + 1, buf, &index, &hw);
+	bool ok = (n == BRT_N2K);
+	for (size_t i = 0; i < n; i++) {
+		if (out[i].src != i || out[i].PGN != 127250 ||
+		    out[i].data[7] != (uint8_t)(i + 7)) {
+			ok = false;
+		}
+		free(out[i].data);
+	}
+	free(out[n].data);
+	out[0] = (n2k_act_message){0};
+	if (n2k_act_readMessage_batch(pfd[0], out, 1, buf, &index, &hw) != 0) { ok = false; }
+	free(out[0].data);
+
+	close(pfd[0]);
+	close(pfd[1]);
+	fprintf(stdout, "N2K: %zu of %d messages read in a single batch\n", n, BRT_N2K);
+	return ok;
+}
+
+/*!
+ * Compare batch and single message readers
+ *
+ * @param[in] argc Argument count
+ * @param[in] argv NMEA, UBX, LPMS and MP sample files
+ * @returns 0 (Pass), -1 (Fail), -2 (Failed to run / Error)
+ */
+int main(int argc, char *argv[]) {
+	//LCOV_EXCL_START
+	if (argc < 5) {
+		fprintf(stderr, "Usage: %s <NMEA file> <UBX file> <LPMS file> <MP file>\n", argv[0]);
+		return -2;
+	}
+	//LCOV_EXCL_STOP
+
+	bool ok = true;
+	ok &= brt_nmea(argv[1]);
+	ok &= brt_ubx(argv[2]);
+	ok &= brt_lpms(argv[3]);
+	ok &= brt_mp(argv[4]);
+	ok &= brt_n2k();
+	return ok ? 0 : -1;
+}
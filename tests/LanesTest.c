@@ -0,0 +1,161 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file LanesTest.c
+ *
+ * @brief Message lane merge testing
+ *
+ * @test Messages are pushed into several lanes in a known order and then
+ * removed in small batches. The merged output must match the order in which
+ * messages were pushed, and the peak depth recorded for each lane is checked.
+ *
+ * @ingroup testing
+ */
+
+//! Number of lanes to create
+#define LT_LANES 3
+
+//! Number of messages to push
+#define LT_MESSAGES 30
+
+/*!
+ * Push messages to lanes in an uneven pattern, then check merged output.
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	msglanes ML = {0};
+	if (!lanes_init(&ML, LT_LANES, 8)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise lanes\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	if (lanes_get(&ML, LT_LANES) != NULL || lanes_depth(&ML, LT_LANES) != -1) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Invalid lane index accepted\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	if (lanes_wait(&ML, 10)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "lanes_wait() returned true with no messages queued\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	// Lane pattern: 0, 1, 1, 2, 2, 2, 0, 1, 1, ...
+	int pushed = 0;
+	int next = 0;
+	int perLane[LT_LANES] = {0};
+	while (pushed < LT_MESSAGES) {
+		const int lane = (pushed % 6 == 0) ? 0 : ((pushed % 6) < 3 ? 1 : 2);
+		msg_t *m = msg_new_float(lane, 4, pushed);
+		if (!queue_push(lanes_get(&ML, lane), m)) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Unable to push message %d to lane %d\n", pushed, lane);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		pushed++;
+		perLane[lane]++;
+
+		// Remove a few messages every so often, so lanes don't fill
+		if (pushed % 5 == 0) {
+			if (!lanes_wait(&ML, -1)) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "lanes_wait() returned false with messages queued\n");
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			msg_t *out[4] = {0};
+			size_t n = lanes_pop_batch(&ML, out, 4);
+			for (size_t i = 0; i < n; i++) {
+				if (out[i]->data.value != next) {
+					// LCOV_EXCL_START
+					fprintf(stderr, "Out of order: expected %d, got %.0f\n", next,
+					        out[i]->data.value);
+					return -1;
+					// LCOV_EXCL_STOP
+				}
+				next++;
+				perLane[out[i]->source]--;
+				msg_destroy(out[i]);
+				free(out[i]);
+			}
+		}
+	}
+
+	for (int l = 0; l < LT_LANES; l++) {
+		if (lanes_depth(&ML, l) != perLane[l]) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Incorrect depth for lane %d (expected %d, got %d)\n", l,
+			        perLane[l], lanes_depth(&ML, l));
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+
+	msg_t *out[LT_MESSAGES] = {0};
+	size_t n = lanes_pop_batch(&ML, out, LT_MESSAGES);
+	for (size_t i = 0; i < n; i++) {
+		if (out[i]->data.value != next) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Out of order: expected %d, got %.0f\n", next, out[i]->data.value);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		next++;
+		msg_destroy(out[i]);
+		free(out[i]);
+	}
+
+	if (next != LT_MESSAGES) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Expected %d messages, got %d\n", LT_MESSAGES, next);
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	for (int l = 0; l < LT_LANES; l++) {
+		const size_t peak = lanes_peak(&ML, l, true);
+		fprintf(stdout, "Lane %d peak depth: %zu\n", l, peak);
+		if (peak == 0 || lanes_peak(&ML, l, false) != 0) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Incorrect peak depth for lane %d\n", l);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+
+	// Leave messages in lanes to be cleaned up on destroy
+	queue_push(lanes_get(&ML, 1), msg_new_float(1, 4, 0));
+	lanes_destroy(&ML);
+	fprintf(stdout, "%d messages merged from %d lanes\n", next, LT_LANES);
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file LatencyTest.c
+ *
+ * @brief Test latency histograms and message creation stamps
+ *
+ * @test Records known distributions of values and checks that the reported
+ * percentiles are within the expected precision, across small and large
+ * values. Checks merging histograms, per source sets and recording message
+ * latency from creation stamps.
+ *
+ * @ingroup testing
+ */
+
+/*!
+ * Check estimate is no smaller than, and within 1/LAT_SUB_BUCKETS of, expected value
+ *
+ * @param[in] est Estimated value
+ * @param[in] exp Expected value
+ * @returns True if estimate acceptable
+ */
+static bool close_to(uint64_t est, uint64_t exp) {
+	if (est < exp) { return false; }
+	return (est - exp) <= (exp / LAT_SUB_BUCKETS) + 1;
+}
+
+/*!
+ * Test histogram and set functions
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	lat_hist *h = calloc(1, sizeof(lat_hist));
+	lat_hist *h2 = calloc(1, sizeof(lat_hist));
+	assert(h && h2);
+
+	assert(lat_percentile(h, 50) == 0);
+
+	// Small values are recorded exactly
+	for (uint64_t v = 1; v <= LAT_SUB_BUCKETS; v++) {
+		lat_record(h, v);
+	}
+	assert(h->count == LAT_SUB_BUCKETS && h->max == LAT_SUB_BUCKETS);
+	assert(lat_percentile(h, 50) == LAT_SUB_BUCKETS / 2);
+	assert(lat_percentile(h, 100) == LAT_SUB_BUCKETS);
+
+	// 1..100000 microseconds, uniformly distributed
+	lat_reset(h);
+	for (uint64_t v = 1; v <= 100000; v++) {
+		lat_record(h, v * 1000);
+	}
+	assert(h->count == 100000 && h->max == 100000000);
+	assert(close_to(lat_percentile(h, 50), 50000000));
+	assert(close_to(lat_percentile(h, 99), 99000000));
+	assert(close_to(lat_percentile(h, 99.9), 99900000));
+	assert(lat_percentile(h, 100) == 100000000);
+	assert(lat_percentile(h, 0) <= 1000 + (1000 / LAT_SUB_BUCKETS) + 1);
+
+	// Merge a small number of very large values
+	for (int i = 0; i < 2000; i++) {
+		lat_record(h2, 3600ULL * 1000000000ULL);
+	}
+	lat_merge(h, h2);
+	assert(h->count == 102000 && h->max == 3600ULL * 1000000000ULL);
+	assert(close_to(lat_percentile(h, 50), 51000000));
+	assert(lat_percentile(h, 99) == h->max);
+
+	// Per source sets
+	lat_set s = {0};
+	assert(lat_set_init(&s));
+	assert(!lat_set_take(&s, SLSOURCE_TEST1, h));
+	assert(h->count == 0);
+	assert(lat_set_record(&s, SLSOURCE_TEST1, 500));
+	assert(!lat_set_record(&s, 200, 500));
+	assert(lat_set_take(&s, SLSOURCE_TEST1, h));
+	assert(h->count == 1 && h->max == 500);
+	assert(!lat_set_take(&s, SLSOURCE_TEST1, h));
+
+	// Messages are only stamped while enabled
+	msg_t *m1 = msg_new_float(SLSOURCE_TEST1, 4, 1.0);
+	assert(m1->created == 0);
+	lat_stamp_enable(true);
+	const uint64_t before = lat_now();
+	msg_t *m2 = msg_new_float(SLSOURCE_TEST2, 4, 1.0);
+	msg_t *m3 = msg_new_string(SLSOURCE_TEST2, 5, 4, "Test");
+	lat_stamp_enable(false);
+	assert(m2->created >= before && m3->created >= m2->created);
+
+	const lat_stamp st[3] = {{m1->created, m1->source},
+	                         {m2->created, m2->source},
+	                         {m3->created, m3->source}};
+	const uint64_t now = lat_now();
+	assert(lat_set_record_stamps(&s, st, 3, now));
+	assert(!lat_set_take(&s, SLSOURCE_TEST1, h));
+	assert(lat_set_take(&s, SLSOURCE_TEST2, h));
+	assert(h->count == 2 && h->max == now - m2->created);
+
+	msg_free(m1);
+	msg_free(m2);
+	msg_free(m3);
+	lat_set_destroy(&s);
+	free(h);
+	free(h2);
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file LiveTest.c
+ *
+ * @brief Test shared memory live value table
+ *
+ * @test Creates a table and records name, channel map, numeric, timestamp
+ * and string messages. The table is then opened separately as a reader, and
+ * the values, names and primary timestamp checked.
+ *
+ * An entry and the header are then left marked as mid-update, to check that
+ * readers give up with EAGAIN rather than waiting indefinitely.
+ *
+ * A second thread then updates a single entry continuously while the main
+ * thread reads it, checking that every copy returned is consistent.
+ *
+ * Finally, the table is removed and checked to ensure existing readers see
+ * the writer as stopped.
+ *
+ * @ingroup testing
+ */
+
+//! Number of updates made while checking reader consistency
+#define LIVE_TEST_UPDATES 200000
+
+//! Set once writer thread has finished
+static atomic_bool writerDone = false;
+
+/*!
+ * Write messages to a single entry where count, timestamp and value are equal
+ *
+ * @param[in] ptr Pointer to live_table
+ * @returns NULL
+ */
+static void *writer_thread(void *ptr) {
+	live_table *t = ptr;
+	msg_t *m = msg_new_float(SLSOURCE_TEST1, 10, 0);
+	for (int i = 1; i <= LIVE_TEST_UPDATES; i++) {
+		m->data.value = i;
+		live_update(t, m, i);
+	}
+	msg_free(m);
+	atomic_store(&writerDone, true);
+	return NULL;
+}
+
+/*!
+ * Record message and free it
+ *
+ * @param[in] t  Table
+ * @param[in] m  Message
+ * @param[in] ts Timestamp
+ */
+static void update(live_table *t, msg_t *m, uint32_t ts) {
+	assert(m);
+	live_update(t, m, ts);
+	msg_free(m);
+}
+
+/*!
+ * Create, update and read live value table
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	char name[64] = {0};
+	snprintf(name, sizeof(name), "/SLLiveTest-%d", (int)getpid());
+
+	live_table w = {0};
+	assert(live_create(&w, name, SLSOURCE_TIMER));
+
+	live_table r = {0};
+	assert(live_open(&r, name));
+	assert(live_running(&r));
+	assert(!live_active(&r, SLSOURCE_TEST1, 4));
+	live_value v = {0};
+	assert(!live_read(&r, SLSOURCE_TEST1, 4, &v));
+	assert(!live_open(&(live_table){0}, "/SLLiveTest-does-not-exist"));
+
+	update(&w, msg_new_string(SLSOURCE_TEST1, SLCHAN_NAME, 5, "Test1"), 0);
+	strarray *sa = sa_new(6);
+	assert(sa);
+	sa_create_entry(sa, 0, 4, "Name");
+	sa_create_entry(sa, 1, 8, "Channels");
+	sa_create_entry(sa, 4, 11, "Temperature");
+	sa_create_entry(sa, 5, 6, "Status");
+	update(&w, msg_new_string_array(SLSOURCE_TEST1, SLCHAN_MAP, sa), 0);
+	sa_destroy(sa);
+	free(sa);
+
+	update(&w, msg_new_timestamp(SLSOURCE_TIMER, SLCHAN_TSTAMP, 1000), 1000);
+	update(&w, msg_new_float(SLSOURCE_TEST1, 4, 1.5), 1000);
+	update(&w, msg_new_float(SLSOURCE_TEST1, 4, 2.5), 1000);
+	update(&w, msg_new_timestamp(SLSOURCE_TIMER, SLCHAN_TSTAMP, 1100), 1100);
+	update(&w, msg_new_string(SLSOURCE_TEST1, 5, 2, "OK"), 1100);
+	const float fa[3] = {1, 2, 3};
+	update(&w, msg_new_float_array(SLSOURCE_TEST1, 6, 3, fa), 1100);
+
+	uint32_t ts = 0;
+	uint64_t updated = 0;
+	assert(live_timestamp(&r, &ts, &updated));
+	assert(ts == 1100 && updated > 0);
+
+	assert(live_read(&r, SLSOURCE_TEST1, SLCHAN_NAME, &v));
+	assert(strcmp(v.text, "Test1") == 0 && strcmp(v.name, "Test1") == 0);
+	assert(live_read(&r, SLSOURCE_TEST1, 4, &v));
+	assert(v.count == 2 && v.timestamp == 1000 && v.value == 2.5);
+	assert(v.dtype == MSG_FLOAT && strcmp(v.name, "Temperature") == 0);
+	assert(live_read(&r, SLSOURCE_TEST1, 5, &v));
+	assert(v.count == 1 && v.dtype == MSG_STRING && isnan(v.value));
+	assert(strcmp(v.text, "OK") == 0 && strcmp(v.name, "Status") == 0);
+	assert(live_read(&r, SLSOURCE_TEST1, 6, &v));
+	assert(strcmp(v.text, "1.0000/2.0000/3.0000") == 0 && v.name[0] == '\0');
+	assert(live_read(&r, SLSOURCE_TIMER, SLCHAN_TSTAMP, &v));
+	assert(v.count == 2 && v.dtype == MSG_TIMESTAMP && v.value == 1100);
+
+	// Long strings are truncated
+	char longText[200] = {0};
+	memset(longText, 'x', sizeof(longText) - 1);
+	update(&w, msg_new_string(SLSOURCE_TEST1, 5, 199, longText), 1200);
+	assert(live_read(&r, SLSOURCE_TEST1, 5, &v));
+	assert(strlen(v.text) == LIVE_TEXT_SIZE - 1);
+
+	// Readers give up if the writer stops part way through an update
+	live_entry *stuck = &w.entries[(SLSOURCE_TEST1 * 128) + 4];
+	atomic_fetch_add(&stuck->seq, 1);
+	atomic_fetch_add(&w.header->seq, 1);
+	errno = 0;
+	assert(!live_read(&r, SLSOURCE_TEST1, 4, &v) && errno == EAGAIN);
+	errno = 0;
+	assert(!live_timestamp(&r, &ts, &updated) && errno == EAGAIN);
+	atomic_fetch_add(&stuck->seq, 1);
+	atomic_fetch_add(&w.header->seq, 1);
+	assert(live_read(&r, SLSOURCE_TEST1, 4, &v) && v.value == 2.5);
+	assert(live_timestamp(&r, &ts, &updated) && ts == 1100);
+
+	// Consistency under concurrent updates
+	pthread_t wt;
+	assert(pthread_create(&wt, NULL, writer_thread, &w) == 0);
+	int reads = 0;
+	while (!atomic_load(&writerDone)) {
+		if (!live_read(&r, SLSOURCE_TEST1, 10, &v)) { continue; }
+		assert(v.count == v.timestamp);
+		assert(v.value == v.count);
+		reads++;
+	}
+	pthread_join(wt, NULL);
+	assert(live_read(&r, SLSOURCE_TEST1, 10, &v));
+	assert(v.count == LIVE_TEST_UPDATES && v.value == LIVE_TEST_UPDATES);
+	fprintf(stdout, "%d consistent reads during updates\n", reads);
+
+	live_destroy(&w);
+	assert(!live_running(&r));
+	assert(live_read(&r, SLSOURCE_TEST1, 4, &v) && v.value == 2.5);
+	live_close(&r);
+	assert(!live_open(&r, name));
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerMP.h"
+
+/*! @file MPBlockTest.c
+ *
+ * @brief Test block structured data files
+ *
+ * @test Checks the CRC32C implementation against a known value, then writes
+ * a sequence of messages using a writer with block output enabled. The file
+ * is read back, checking that each block header correctly describes the
+ * messages that follow it, and that blocks can be skipped without decoding.
+ *
+ * Finally, a byte in the file is modified and the affected block is checked
+ * to ensure it fails verification.
+ *
+ * @ingroup testing
+ */
+
+//! Number of messages written to test file
+#define BLOCK_TEST_COUNT 400
+
+/*!
+ * Read back file, checking block headers against their contents
+ *
+ * @param[in] fd   File descriptor, positioned at start of file
+ * @param[in] skip Skip block contents rather than reading them
+ * @param[out] bad Number of blocks failing verification
+ * @returns Number of messages read, excluding block headers
+ */
+static int read_blocks(int fd, bool skip, int *bad) {
+	mp_stream s = {0};
+	assert(mp_stream_init(&s, fd, 1024));
+	int total = 0;
+	int blocks = 0;
+	*bad = 0;
+	mp_block_info bi = {0};
+	mp_block_info prev = {0};
+	uint32_t inBlock = 0;
+	uint8_t seen[16] = {0};
+	while (true) {
+		msg_t m = {0};
+		if (!mp_stream_read(&s, &m)) {
+			assert((uint8_t)m.data.value == 0xFD);
+			break;
+		}
+		if (mp_block_parse(&m, &bi)) {
+			// Previous block contents must match its header
+			if (blocks > 0 && !skip) {
+				assert(inBlock == prev.count);
+				assert(memcmp(seen, prev.sources, sizeof(seen)) == 0);
+			}
+			assert(bi.version == MP_BLOCK_VERSION && bi.clock == SLSOURCE_TIMER);
+			assert(bi.count > 0 && bi.length > 0);
+			if (blocks > 0) { assert(bi.firstStamp == prev.lastStamp); }
+			assert(bi.firstStamp <= bi.lastStamp);
+			if (!mp_stream_check_block(&s, &bi)) { (*bad)++; }
+			if (skip) { assert(mp_stream_skip(&s, bi.length)); }
+			prev = bi;
+			blocks++;
+			inBlock = 0;
+			memset(seen, 0, sizeof(seen));
+		} else {
+			// Every message is preceded by a block header
+			assert(blocks > 0);
+			inBlock++;
+			total++;
+			seen[m.source / 8] |= (1 << (m.source % 8));
+			if (m.source == SLSOURCE_TIMER) {
+				assert(m.data.timestamp >= prev.firstStamp);
+				assert(m.data.timestamp <= prev.lastStamp);
+			}
+		}
+		msg_destroy(&m);
+	}
+	if (!skip) { assert(inBlock == prev.count); }
+	mp_stream_destroy(&s);
+	return total;
+}
+
+/*!
+ * Write and verify block structured file
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	const uint8_t check[] = "123456789";
+	assert(mp_crc32c(0, check, 9) == 0xE3069283);
+	assert(mp_crc32c(mp_crc32c(0, check, 4), &check[4], 5) == 0xE3069283);
+	assert(mp_crc32c(0, check, 0) == 0);
+
+	FILE *tmp = tmpfile();
+	assert(tmp);
+	const int fd = fileno(tmp);
+
+	uint8_t *big = calloc(8192, 1);
+	assert(big);
+
+	mp_writer w = {0};
+	assert(mp_writer_init(&w, fd, 4096, 1000000));
+	assert(mp_writer_set_blocks(&w, true, SLSOURCE_TIMER));
+	for (int i = 0; i < BLOCK_TEST_COUNT; i++) {
+		msg_t *m = NULL;
+		if (i % 5 == 0) {
+			m = msg_new_timestamp(SLSOURCE_TIMER, SLCHAN_TSTAMP, 1000 + i);
+		} else if (i == 201) {
+			// Larger than writer buffer
+			m = msg_new_bytes(SLSOURCE_TEST2, 4, 8192, big);
+		} else {
+			m = msg_new_float(SLSOURCE_TEST1, 4, i);
+		}
+		assert(mp_writer_add(&w, m));
+		msg_free(m);
+	}
+	assert(mp_writer_destroy(&w));
+	free(big);
+
+	int bad = 0;
+	assert(lseek(fd, 0, SEEK_SET) == 0);
+	assert(read_blocks(fd, false, &bad) == BLOCK_TEST_COUNT);
+	assert(bad == 0);
+
+	assert(lseek(fd, 0, SEEK_SET) == 0);
+	assert(read_blocks(fd, true, &bad) == 0);
+	assert(bad == 0);
+
+	// Modify a single data byte towards the end of the file
+	const off_t pos = lseek(fd, -3, SEEK_END);
+	uint8_t b = 0;
+	assert(pread(fd, &b, 1, pos) == 1);
+	b ^= 0x01;
+	assert(pwrite(fd, &b, 1, pos) == 1);
+	assert(lseek(fd, 0, SEEK_SET) == 0);
+	read_blocks(fd, true, &bad);
+	assert(bad == 1);
+
+	fclose(tmp);
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerMP.h"
+
+/*! @file MPIndexTest.c
+ *
+ * @brief Test index file generation and use
+ *
+ * @test Writes a sequence of timestamp, epoch and data messages to a data
+ * file, generating an index file at the same time. The index is read back,
+ * checking that spans start at the expected timestamps, that the message
+ * counts match the data written, and that seeking to a timestamp positions
+ * the data file at the correct timestamp message.
+ *
+ * The index file is then truncated part way through the final entry, and
+ * checked to ensure the remaining entries can still be read.
+ *
+ * @ingroup testing
+ */
+
+//! Number of primary timestamps written to test file
+#define INDEX_TEST_TICKS 95
+
+//! Primary timestamps between index entries
+#define INDEX_TEST_INTERVAL 4
+
+//! Primary timestamps between epoch messages
+#define INDEX_TEST_EPOCH 10
+
+/*!
+ * Write message to data file and index
+ *
+ * @param[in] w Data file writer
+ * @param[in] x Index writer
+ * @param[in] m Message (freed)
+ */
+static void write_msg(mp_writer *w, mp_index_writer *x, msg_t *m) {
+	assert(m);
+	const uint64_t offset = mp_writer_handle_bytes(w);
+	assert(mp_writer_add(w, m));
+	assert(mp_index_writer_add(x, m, offset));
+	msg_free(m);
+}
+
+/*!
+ * Write data and index files, then verify index contents
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	FILE *dat = tmpfile();
+	assert(dat);
+	char idxName[] = "/tmp/MPIndexTest-XXXXXX";
+	const int ifd = mkstemp(idxName);
+	assert(ifd >= 0);
+
+	mp_writer w = {0};
+	mp_index_writer x = {0};
+	assert(mp_writer_init(&w, fileno(dat), 512, 1000000));
+	assert(mp_writer_set_blocks(&w, true, SLSOURCE_TIMER));
+	assert(mp_index_writer_init(&x, ifd, SLSOURCE_TIMER, INDEX_TEST_INTERVAL));
+
+	// Messages before the first timestamp
+	write_msg(&w, &x, msg_new_float(SLSOURCE_TEST1, 4, -1));
+	int total = 1;
+	int test2 = 0;
+	for (int t = 0; t < INDEX_TEST_TICKS; t++) {
+		write_msg(&w, &x, msg_new_timestamp(SLSOURCE_TIMER, SLCHAN_TSTAMP, 1000 + t));
+		total++;
+		if (t % INDEX_TEST_EPOCH == 5) {
+			write_msg(&w, &x,
+			          msg_new_timestamp(SLSOURCE_TIMER, MP_INDEX_EPOCH_CHANNEL, 5000 + t));
+			total++;
+		}
+		write_msg(&w, &x, msg_new_float(SLSOURCE_TEST1, 4, t));
+		total++;
+		if (t % 3 == 0) {
+			write_msg(&w, &x, msg_new_float(SLSOURCE_TEST2, 4, t));
+			total++;
+			test2++;
+		}
+	}
+	assert(mp_writer_destroy(&w));
+	assert(mp_index_writer_destroy(&x));
+	assert(!mp_index_writer_add(&x, NULL, 0));
+
+	mp_index idx = {0};
+	assert(mp_index_open(&idx, idxName));
+	assert(idx.clock == SLSOURCE_TIMER);
+	assert(idx.interval == INDEX_TEST_INTERVAL);
+	assert(idx.nEntries > INDEX_TEST_TICKS / INDEX_TEST_INTERVAL);
+
+	// Initial span has no timestamp, and contains a single message
+	assert(idx.entries[0].flags == (MP_INDEX_NOSTAMP | MP_INDEX_NOEPOCH));
+	assert(idx.entries[0].count == 1);
+	assert(idx.entries[0].offset == 0);
+	assert(mp_index_count(&idx, 0, SLSOURCE_TEST1) == 1);
+	assert(idx.entries[1].stamp == 1000);
+
+	uint32_t sum = 0;
+	uint32_t sum2 = 0;
+	for (size_t e = 0; e < idx.nEntries; e++) {
+		const mp_index_entry *ie = &idx.entries[e];
+		sum += ie->count;
+		sum2 += mp_index_count(&idx, e, SLSOURCE_TEST2);
+		uint32_t srcTotal = 0;
+		for (size_t s = 0; s < ie->nSources; s++) {
+			srcTotal += idx.sources[ie->srcStart + s].count;
+		}
+		assert(srcTotal == ie->count);
+		if (e > 0) {
+			const mp_index_entry *prev = &idx.entries[e - 1];
+			assert(ie->offset > prev->offset);
+			assert(ie->stamp > prev->stamp);
+			assert(!(ie->flags & MP_INDEX_NOSTAMP));
+			if (e > 1) { assert(ie->stamp - prev->stamp <= INDEX_TEST_INTERVAL); }
+			// Epoch message starts a new span at the following timestamp
+			if (ie->epoch != prev->epoch) {
+				assert(!(ie->flags & MP_INDEX_NOEPOCH));
+				assert(ie->stamp == (ie->epoch - 5000) + 1000 + 1);
+			}
+		}
+	}
+	assert(sum == (uint32_t)total);
+	assert(sum2 == (uint32_t)test2);
+
+	// Search and seek
+	assert(mp_index_find(&idx, 0) == 0);
+	assert(mp_index_find(&idx, UINT32_MAX) == (ssize_t)idx.nEntries - 1);
+	mp_stream s = {0};
+	assert(mp_stream_init(&s, fileno(dat), 256));
+	for (uint32_t ts = 1000; ts < 1000 + INDEX_TEST_TICKS; ts += 7) {
+		const ssize_t e = mp_index_find(&idx, ts);
+		assert(e > 0);
+		assert(idx.entries[e].stamp <= ts);
+		if ((size_t)e + 1 < idx.nEntries) { assert(idx.entries[e + 1].stamp > ts); }
+		assert(mp_index_seek(&idx, &s, ts));
+
+		// First message read may be a block header, then the span timestamp
+		msg_t m = {0};
+		assert(mp_stream_read(&s, &m));
+		mp_block_info bi = {0};
+		if (mp_block_parse(&m, &bi)) {
+			msg_destroy(&m);
+			assert(mp_stream_read(&s, &m));
+		}
+		assert(m.source == SLSOURCE_TIMER && m.type == SLCHAN_TSTAMP);
+		assert(m.data.timestamp == idx.entries[e].stamp);
+		msg_destroy(&m);
+	}
+	mp_stream_destroy(&s);
+
+	// Truncate part way through final entry
+	const size_t nEntries = idx.nEntries;
+	mp_index_close(&idx);
+	assert(idx.entries == NULL && idx.nEntries == 0);
+	assert(mp_index_find(&idx, 1000) == -1);
+	const off_t isize = lseek(ifd, 0, SEEK_END);
+	assert(ftruncate(ifd, isize - 3) == 0);
+	assert(mp_index_open(&idx, idxName));
+	assert(idx.nEntries == nEntries - 1);
+	mp_index_close(&idx);
+
+	// Invalid header
+	assert(ftruncate(ifd, MP_INDEX_HEADER_SIZE - 1) == 0);
+	assert(!mp_index_open(&idx, idxName));
+
+	close(ifd);
+	unlink(idxName);
+	fclose(dat);
+	return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerMP.h"
+
+/*! @file MPPackTest.c
+ *
+ * @brief Test specialised message encoder
+ *
+ * @test Packs messages of each type, covering each of the msgpack length
+ * encodings, using both mp_packMessage() and mp_packMessage_buffer(). Checks
+ * that the output is identical, that mp_packedLength() is correct, and that
+ * messages are rejected if the output buffer is too small.
+ *
+ * The string representation generated by msg_data_format() is also checked
+ * against msg_data_to_string(), including truncation to a short buffer.
+ *
+ * Also reports the time taken to pack float messages using each method.
+ *
+ * @ingroup testing
+ */
+
+//! Number of messages packed for timing comparison
+#define TIMING_COUNT 1000000
+
+/*!
+ * Compare encoders for a single message. The message is freed.
+ *
+ * @param[in] m Message to test
+ * @returns True if output matches
+ */
+static bool check_message(msg_t *m) {
+	assert(m);
+	msgpack_sbuffer sbuf;
+	assert(mp_packMessage(&sbuf, m));
+
+	const size_t len = mp_packedLength(m);
+	uint8_t *buf = calloc(len + 1, 1);
+	assert(buf);
+	bool ok = (len == sbuf.size);
+	ok = ok && (mp_packMessage_buffer(buf, len + 1, m) == len);
+	ok = ok && (memcmp(buf, sbuf.data, len) == 0);
+	// Must not write past end of buffer, or accept a buffer that is too small
+	ok = ok && (buf[len] == 0);
+	ok = ok && (mp_packMessage_buffer(buf, len - 1, m) == 0);
+	if (!ok) {
+		// LCOV_EXCL_START
+		char *str = msg_to_string(m);
+		fprintf(stderr, "Encoder mismatch for message %s (%zu / %zu bytes)\n", str,
+		        len, sbuf.size);
+		free(str);
+		// LCOV_EXCL_STOP
+	}
+	free(buf);
+	msgpack_sbuffer_destroy(&sbuf);
+
+	char *str = msg_data_to_string(m);
+	char shortBuf[8] = {0};
+	const int slen = msg_data_format(m, shortBuf, sizeof(shortBuf));
+	ok = ok && str && (slen == (int)strlen(str));
+	ok = ok && (strncmp(shortBuf, str, sizeof(shortBuf) - 1) == 0);
+	ok = ok && (strlen(shortBuf) == (slen < 8 ? (size_t)slen : 7));
+	ok = ok && (msg_data_format(m, NULL, 0) == slen);
+	if (!ok) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "String mismatch for message (%d / %s)\n", slen, str);
+		// LCOV_EXCL_STOP
+	}
+	free(str);
+	msg_free(m);
+	return ok;
+}
+
+/*!
+ * @return Current CLOCK_MONOTONIC time in nanoseconds
+ */
+static double now_ns(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1.0E9) + ts.tv_nsec;
+}
+
+/*!
+ * Check encoder equivalence for all message types
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	bool ok = true;
+	const uint8_t sources[] = {0x00, SLSOURCE_TEST1, 0x7F, 0x80, 0xFF};
+	for (size_t i = 0; i < sizeof(sources); i++) {
+		ok = check_message(msg_new_float(sources[i], 0x7F, 1.5)) && ok;
+		ok = check_message(msg_new_float(SLSOURCE_TEST1, sources[i], -2.0E9)) && ok;
+	}
+
+	const uint32_t stamps[] = {0, 0x7F, 0x80, 0xFF, 0x100, 0xFFFF, 0x10000, UINT32_MAX};
+	for (size_t i = 0; i < sizeof(stamps) / sizeof(stamps[0]); i++) {
+		ok = check_message(msg_new_timestamp(SLSOURCE_TEST1, SLCHAN_TSTAMP, stamps[i])) && ok;
+	}
+
+	const size_t lengths[] = {1, 31, 32, 255, 256, 0xFFFF, 0x10000};
+	char *text = calloc(0x10001, 1);
+	float *fa = calloc(0x10001, sizeof(float));
+	assert(text && fa);
+	for (size_t i = 0; i < 0x10000; i++) {
+		text[i] = 'A' + (i % 26);
+		fa[i] = i * 0.25;
+	}
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		ok = check_message(msg_new_bytes(SLSOURCE_TEST1, 4, lengths[i], (uint8_t *)text)) && ok;
+		ok = check_message(msg_new_string(SLSOURCE_TEST1, 5, lengths[i], text)) && ok;
+		ok = check_message(msg_new_float_array(SLSOURCE_TEST1, 6, lengths[i], fa)) && ok;
+	}
+	free(fa);
+
+	// Declared string length longer than actual string
+	ok = check_message(msg_new_string(SLSOURCE_TEST1, 5, 10, "Short")) && ok;
+
+	strarray *sa = sa_new(20);
+	for (int i = 0; i < 20; i++) {
+		sa_create_entry(sa, i, i * 3, text);
+	}
+	ok = check_message(msg_new_string_array(SLSOURCE_TEST1, SLCHAN_MAP, sa)) && ok;
+	sa_destroy(sa);
+	free(sa);
+	free(text);
+
+	// Invalid messages are rejected
+	msg_t bad = {0};
+	uint8_t out[32] = {0};
+	assert(mp_packedLength(&bad) == 0);
+	assert(mp_packMessage_buffer(out, sizeof(out), &bad) == 0);
+
+	if (!ok) { return -1; }
+
+	// Timing comparison, not used to determine pass/fail
+	msg_t *m = msg_new_float(SLSOURCE_TEST1, 4, 3.14159);
+	double start = now_ns();
+	for (int i = 0; i < TIMING_COUNT; i++) {
+		msgpack_sbuffer sbuf;
+		mp_packMessage(&sbuf, m);
+		msgpack_sbuffer_destroy(&sbuf);
+	}
+	const double general = (now_ns() - start) / TIMING_COUNT;
+
+	uint8_t *tbuf = malloc(16 * 1024);
+	assert(tbuf);
+	size_t off = 0;
+	start = now_ns();
+	for (int i = 0; i < TIMING_COUNT; i++) {
+		if (off > (16 * 1024 - 16)) { off = 0; }
+		off += mp_packMessage_buffer(tbuf + off, 16, m);
+	}
+	const double fixed = (now_ns() - start) / TIMING_COUNT;
+	free(tbuf);
+	msg_free(m);
+
+	fprintf(stdout, "Float message: %.1fns (mp_packMessage), %.1fns (mp_packMessage_buffer)\n",
+	        general, fixed);
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerMP.h"
+
+/*! @file MPStreamTest.c
+ *
+ * @brief Test streaming message decoder
+ *
+ * @test Writes a sequence of messages interleaved with invalid data to a
+ * file, including a message larger than the initial stream buffer, and checks
+ * that each valid message is decoded correctly and that the expected status
+ * codes are returned for invalid and incomplete data. Small binary and
+ * numeric array payloads must be decoded into the message's inline storage.
+ *
+ * Also checks partial messages delivered through a non-blocking pipe.
+ *
+ * @ingroup testing
+ */
+
+/*!
+ * Check that two messages encode identically
+ *
+ * @param[in] a First message
+ * @param[in] b Second message
+ * @returns True if messages match
+ */
+static bool same_message(const msg_t *a, const msg_t *b) {
+	const size_t la = mp_packedLength(a);
+	const size_t lb = mp_packedLength(b);
+	if (la == 0 || la != lb) { return false; }
+	uint8_t *ba = calloc(la, 1);
+	uint8_t *bb = calloc(lb, 1);
+	assert(ba && bb);
+	mp_packMessage_buffer(ba, la, a);
+	mp_packMessage_buffer(bb, lb, b);
+	const bool same = (memcmp(ba, bb, la) == 0);
+	free(ba);
+	free(bb);
+	return same;
+}
+
+/*!
+ * Decode messages from file and pipe
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	uint8_t *big = calloc(70000, 1);
+	assert(big);
+	for (int i = 0; i < 70000; i++) {
+		big[i] = i % 253;
+	}
+	const float fa[4] = {1.0, -2.5, 3.25, 1E6};
+	strarray *sa = sa_new(3);
+	sa_create_entry(sa, 0, 4, "Name");
+	sa_create_entry(sa, 1, 8, "Channels");
+	sa_create_entry(sa, 2, 9, "Timestamp");
+
+	msg_t *msgs[] = {
+		msg_new_string(SLSOURCE_TEST1, SLCHAN_NAME, 11, "Test Source"),
+		msg_new_string_array(SLSOURCE_TEST1, SLCHAN_MAP, sa),
+		msg_new_timestamp(SLSOURCE_TEST1, SLCHAN_TSTAMP, 3503357677),
+		msg_new_float(SLSOURCE_TEST1, 4, 3.14159),
+		msg_new_bytes(SLSOURCE_TEST1, 5, 70000, big),
+		msg_new_float_array(SLSOURCE_TEST1, 6, 4, fa),
+		msg_new_bytes(SLSOURCE_TEST1, 7, 3, big),
+	};
+	const int nMsgs = sizeof(msgs) / sizeof(msgs[0]);
+	sa_destroy(sa);
+	free(sa);
+
+	// Junk, including a false sync byte
+	const uint8_t junk[] = {0x00, 0x94, 0x12, 0x55, 0x94};
+	// Valid header, but nil is not a valid data type
+	const uint8_t invalid[] = {0x94, 0x55, 0x05, 0x04, 0xc0};
+	// Source ID out of range
+	const uint8_t badSource[] = {0x94, 0x55, 0xcc, 0x80, 0x04, 0x01};
+
+	FILE *tmp = tmpfile();
+	assert(tmp);
+	const int fd = fileno(tmp);
+	for (int i = 0; i < nMsgs; i++) {
+		assert(msgs[i]);
+		assert(write(fd, junk, sizeof(junk)) == sizeof(junk));
+		assert(mp_writeMessage(fd, msgs[i]));
+		if (i == 2) { assert(write(fd, badSource, sizeof(badSource)) == sizeof(badSource)); }
+		if (i == 3) { assert(write(fd, invalid, sizeof(invalid)) == sizeof(invalid)); }
+	}
+	// Truncated message at end of file
+	uint8_t part[16] = {0};
+	const size_t partLen = mp_packMessage_buffer(part, sizeof(part), msgs[3]);
+	assert(write(fd, part, partLen - 2) == (ssize_t)(partLen - 2));
+	rewind(tmp);
+
+	mp_stream s = {0};
+	assert(!mp_stream_init(&s, -1, 0));
+	assert(mp_stream_init(&s, fd, 4096));
+
+	int count = 0;
+	int invalidCount = 0;
+	bool eof = false;
+	while (!eof) {
+		msg_t m = {0};
+		if (mp_stream_read(&s, &m)) {
+			assert(count < nMsgs);
+			assert(same_message(&m, msgs[count]));
+			// Small payloads are decoded into the message itself
+			if (m.dtype == MSG_BYTES || m.dtype == MSG_NUMARRAY) {
+				const size_t pl = m.length * (m.dtype == MSG_BYTES ? 1 : sizeof(float));
+				assert(((m.flags & MSG_FLAG_INLINE) != 0) == (pl <= MSG_INLINE_SIZE));
+			}
+			count++;
+		} else {
+			assert(m.dtype == MSG_ERROR);
+			switch ((uint8_t)m.data.value) {
+				case 0xEE:
+					invalidCount++;
+					break;
+				case 0xFD:
+					eof = true;
+					break;
+				default:
+					// LCOV_EXCL_START
+					fprintf(stderr, "Unexpected status 0x%02x\n", (uint8_t)m.data.value);
+					return -1;
+					// LCOV_EXCL_STOP
+			}
+		}
+		msg_destroy(&m);
+	}
+	assert(count == nMsgs);
+	assert(invalidCount == 1);
+	assert(s.capacity > 70000);
+	mp_stream_destroy(&s);
+	fclose(tmp);
+
+	// Every prefix of a valid message is incomplete, not invalid
+	for (size_t i = 0; i < partLen; i++) {
+		msg_t m = {0};
+		size_t used = 0;
+		assert(mp_decodeMessage(part, i, &m, &used) == MP_DECODE_MORE);
+	}
+
+	// Partial message from a non-blocking source
+	int pfd[2] = {0};
+	assert(pipe(pfd) == 0);
+	assert(fcntl(pfd[0], F_SETFL, O_NONBLOCK) == 0);
+	assert(mp_stream_init(&s, pfd[0], 0));
+	assert(write(pfd[1], part, 3) == 3);
+	msg_t m = {0};
+	assert(!mp_stream_read(&s, &m));
+	assert(m.dtype == MSG_ERROR && (uint8_t)m.data.value == 0xFF);
+	assert(write(pfd[1], part + 3, partLen - 3) == (ssize_t)(partLen - 3));
+	assert(mp_stream_read(&s, &m));
+	assert(same_message(&m, msgs[3]));
+	msg_destroy(&m);
+	mp_stream_destroy(&s);
+	close(pfd[0]);
+	close(pfd[1]);
+
+	for (int i = 0; i < nMsgs; i++) {
+		msg_free(msgs[i]);
+	}
+	free(big);
+	return 0;
+}
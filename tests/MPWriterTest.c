@@ -0,0 +1,262 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+#include "SELKIELoggerMP.h"
+
+/*! @file MPWriterTest.c
+ *
+ * @brief Test buffered message writer
+ *
+ * @test Writes the same sequence of messages using mp_writeMessage() and a
+ * buffered writer with a small buffer, and checks that the resulting files
+ * are identical. Includes a message larger than the writer buffer, and
+ * checks that no data is written until a flush is required.
+ *
+ * The test is repeated using an asynchronous writer with a small number of
+ * buffers, so that the writer thread is regularly stalled.
+ *
+ * Also checks that data is synced in each of the durability modes, that
+ * preallocated space is released when the file handle is changed, and that
+ * message latency is recorded for every message written.
+ *
+ * @ingroup testing
+ */
+
+/*!
+ * @param[in] f File to examine
+ * @return Current size of file
+ */
+static long file_size(FILE *f) {
+	struct stat sb = {0};
+	assert(fstat(fileno(f), &sb) == 0);
+	return sb.st_size;
+}
+
+/*!
+ * @param[in] f File to examine
+ * @return Space allocated to file on disk
+ */
+static long file_allocated(FILE *f) {
+	struct stat sb = {0};
+	assert(fstat(fileno(f), &sb) == 0);
+	return sb.st_blocks * 512;
+}
+
+/*!
+ * Compare writer output to individually written messages
+ *
+ * @param[in] queueLen Queue length for asynchronous writer, or 0 for synchronous writer
+ * @returns 0 (Pass), -1 (Fail)
+ */
+static int test_writer(size_t queueLen) {
+	FILE *direct = tmpfile();
+	FILE *buffered = tmpfile();
+	FILE *second = tmpfile();
+	assert(direct && buffered && second);
+
+	mp_writer w = {0};
+	const bool async = (queueLen > 0);
+	// Large interval, so only buffer size or explicit flushes trigger writes
+	if (async) {
+		assert(mp_writer_init_async(&w, fileno(buffered), 100, 1000000, queueLen));
+	} else {
+		assert(mp_writer_init(&w, fileno(buffered), 100, 1000000));
+	}
+	assert(w.capacity == MP_WRITER_ALIGN);
+	assert(mp_writer_set_prealloc(&w, 1024 * 1024));
+
+	lat_set ls = {0};
+	assert(lat_set_init(&ls));
+	lat_stamp_enable(true);
+	assert(mp_writer_set_latency(&w, &ls));
+
+	uint8_t *big = calloc(3 * MP_WRITER_ALIGN, sizeof(uint8_t));
+	assert(big);
+	for (int i = 0; i < (3 * MP_WRITER_ALIGN); i++) {
+		big[i] = i % 251;
+	}
+
+	const float fa[5] = {1.0, 2.0, 3.0, 4.0, 5.0};
+	for (int i = 0; i < 500; i++) {
+		msg_t *m = NULL;
+		switch (i % 4) {
+			case 0:
+				m = msg_new_timestamp(SLSOURCE_TEST1, SLCHAN_TSTAMP, i);
+				break;
+			case 1:
+				m = msg_new_float(SLSOURCE_TEST1, 4, i * 0.5);
+				break;
+			case 2:
+				m = msg_new_float_array(SLSOURCE_TEST1, 5, 5, fa);
+				break;
+			default:
+				m = msg_new_bytes(SLSOURCE_TEST1, 6, (i == 251) ? 3 * MP_WRITER_ALIGN : 17, big);
+				break;
+		}
+		assert(m);
+		assert(mp_writeMessage(fileno(direct), m));
+		assert(mp_writer_add(&w, m));
+		// Buffer may only be flushed between complete messages (asynchronous
+		// writers pack messages on their own thread)
+		if (!async) { assert(w.used <= w.capacity); }
+		// Asynchronous writers hold their own reference until packed
+		msg_free(m);
+	}
+
+	if (async) {
+		// Wait for queued messages to be packed, so buffer state can be checked
+		assert(mp_writer_set_prealloc(&w, 1024 * 1024));
+	}
+	// Buffer enlarged for the largest message
+	assert(w.capacity > MP_WRITER_ALIGN);
+
+	// Invalid messages are rejected without affecting buffered data
+	msg_t bad = {0};
+	const size_t used = w.used;
+	assert(used > 0);
+	assert(!mp_writer_add(&w, &bad));
+	assert(w.used == used);
+
+	// Nothing should be due with such a long interval
+	assert(mp_writer_tick(&w));
+	assert(w.used == used);
+	// Asynchronous writers handle their own flushes
+	assert(async ? (mp_writer_next_flush(&w) == -1) : (mp_writer_next_flush(&w) > 0));
+
+	// Switching handle writes out buffered data first
+	assert(mp_writer_handle_bytes(&w) == (uint64_t)file_size(direct));
+	assert(mp_writer_set_handle(&w, fileno(second)));
+	assert(w.used == 0);
+	assert(mp_writer_next_flush(&w) == -1);
+	assert(file_size(direct) == file_size(buffered));
+	assert(mp_writer_handle_bytes(&w) == 0);
+
+	// Latency recorded once for each message written
+	lat_hist lh = {0};
+	assert(lat_set_take(&ls, SLSOURCE_TEST1, &lh));
+	assert(lh.count == 500 && lh.max > 0);
+	assert(!lat_set_take(&ls, SLSOURCE_TEST1, &lh));
+	lat_stamp_enable(false);
+	assert(mp_writer_set_latency(&w, NULL));
+	lat_set_destroy(&ls);
+
+	// Unused preallocated space is released (if preallocation supported)
+	if (w.prealloc > 0) {
+		assert(file_allocated(buffered) < file_size(buffered) + (512 * 1024));
+	}
+
+	mp_writer_stats ws = {0};
+	mp_writer_get_stats(&w, &ws, true);
+	assert(ws.flushes > 0);
+	assert(ws.bytes == (uint64_t)file_size(buffered));
+	assert(ws.maxLatency >= 0 && ws.maxLag >= ws.maxLatency);
+	mp_writer_get_stats(&w, &ws, false);
+	assert(ws.maxLatency == 0 && ws.maxLag == 0);
+
+	// Compare file contents
+	const long sz = file_size(direct);
+	char *a = calloc(sz, 1);
+	char *b = calloc(sz, 1);
+	assert(a && b);
+	rewind(direct);
+	rewind(buffered);
+	assert(fread(a, 1, sz, direct) == (size_t)sz);
+	assert(fread(b, 1, sz, buffered) == (size_t)sz);
+	if (memcmp(a, b, sz) != 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Buffered output does not match direct output\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	// With a zero interval, every message is written immediately (only
+	// changed for synchronous writers, as the writer thread may be reading it)
+	if (!async) { w.interval = 0; }
+	msg_t *m = msg_new_float(SLSOURCE_TEST1, 4, 1.0);
+	assert(mp_writer_add(&w, m));
+	if (!async) { assert(w.used == 0); }
+	assert(mp_writer_sync(&w));
+	assert(file_size(second) > 0);
+	msg_free(m);
+
+	// Interval durability mode: first sync is only due after interval expires
+	assert(!mp_writer_set_sync(&w, MP_SYNC_BYTES, 0, 0));
+	assert(mp_writer_set_sync(&w, MP_SYNC_INTERVAL, 50, 0));
+	m = msg_new_float(SLSOURCE_TEST1, 4, 2.0);
+	assert(mp_writer_add(&w, m));
+	msg_free(m);
+	// Flush interval unchanged for asynchronous writer, so write out explicitly
+	if (async) { assert(mp_writer_flush(&w)); }
+	for (int i = 0; i < 100; i++) {
+		assert(mp_writer_tick(&w));
+		mp_writer_get_stats(&w, &ws, false);
+		if (ws.syncs > 0) { break; }
+		usleep(5000);
+	}
+	assert(ws.syncs == 1);
+	assert(ws.maxUnsynced > 0 && ws.maxUnsynced >= ws.maxSyncTime);
+
+	// Bytes mode: sync once threshold reached
+	assert(mp_writer_set_sync(&w, MP_SYNC_BYTES, 0, 64));
+	for (int i = 0; i < 10; i++) {
+		m = msg_new_float(SLSOURCE_TEST1, 4, i);
+		assert(mp_writer_add(&w, m));
+		msg_free(m);
+	}
+	assert(mp_writer_sync(&w));
+	mp_writer_get_stats(&w, &ws, false);
+	assert(ws.syncs >= 2);
+
+	assert(mp_writer_destroy(&w));
+	assert(w.buf == NULL);
+
+	fprintf(stdout, "%ld bytes written in %lu writes (%lu stalls)\n", sz,
+	        (unsigned long)ws.flushes, (unsigned long)ws.stalls);
+	free(a);
+	free(b);
+	free(big);
+	fclose(direct);
+	fclose(buffered);
+	fclose(second);
+	return 0;
+}
+
+/*!
+ * Run writer tests in synchronous and asynchronous modes
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	mp_writer w = {0};
+	assert(!mp_writer_init(&w, -1, 0, 1000));
+	assert(!mp_writer_init_async(&w, 1, 0, 1000, 1));
+
+	if (test_writer(0) != 0) { return -1; }
+	return test_writer(2);
+}
@@ -0,0 +1,201 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file PoolTest.c
+ *
+ * @brief Message pool testing
+ *
+ * @test Checks that the pool is inactive until initialised, that requests are
+ * mapped to suitable size classes, and that messages allocated from the pool
+ * by several producer threads can be freed by a consumer thread. Small
+ * payloads must be stored inline, without a separate allocation. Allocation
+ * and free counts must balance once all threads have finished.
+ *
+ * @ingroup testing
+ */
+
+//! Number of producer threads
+#define PT_PRODUCERS 3
+
+//! Number of messages pushed by each producer
+#define PT_MESSAGES 5000
+
+//! Producer thread arguments
+typedef struct {
+	msgqueue *q; //!< Shared queue
+	uint8_t id;  //!< Producer ID, used as message source
+	bool ok;     //!< Set false on error
+} pt_args;
+
+/*!
+ * Push a mix of pooled message types to the shared queue
+ *
+ * @param[in] ptargs Pointer to pt_args
+ * @returns NULL
+ */
+static void *pt_producer(void *ptargs) {
+	pt_args *a = ptargs;
+	const float vals[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	const uint8_t bytes[200] = {0};
+	for (int i = 0; i < PT_MESSAGES; i++) {
+		msg_t *m = NULL;
+		switch (i % 3) {
+			case 0:
+				m = msg_new_timestamp(a->id, 2, i);
+				break;
+			case 1:
+				// Small enough to be stored inline
+				m = msg_new_float_array(a->id, 3, 8, vals);
+				if (m && !(m->flags & MSG_FLAG_INLINE)) { a->ok = false; }
+				break;
+			default:
+				// Too large for inline storage, so uses second pool block
+				m = msg_new_bytes(a->id, 4, 200, bytes);
+				if (m && !(m->flags & MSG_FLAG_POOLDATA)) { a->ok = false; }
+				break;
+		}
+		if (m == NULL || !(m->flags & MSG_FLAG_POOLED) || !queue_push(a->q, m)) {
+			// LCOV_EXCL_START
+			a->ok = false;
+			return NULL;
+			// LCOV_EXCL_STOP
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * Run pool checks
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	if (pool_enabled() || pool_alloc(16) != NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Pool active before initialisation\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	msg_t *plain = msg_new_float(1, 2, 3.0);
+	if (plain->flags != 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Message flagged as pooled while pool disabled\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	// Retained messages survive until every reference is released
+	msg_retain(plain);
+	msg_free(plain);
+	if (plain->dtype != MSG_FLOAT || plain->data.value != 3.0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Retained message released early\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	msg_free(plain);
+
+	if (!pool_init() || pool_init()) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Unexpected result from pool_init()\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	void *big = pool_alloc(1 << 20);
+	if (big != NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Oversize allocation served from pool\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	msgqueue QT = {0};
+	queue_init_size(&QT, 128);
+
+	pthread_t threads[PT_PRODUCERS];
+	pt_args args[PT_PRODUCERS];
+	for (int i = 0; i < PT_PRODUCERS; i++) {
+		args[i] = (pt_args){.q = &QT, .id = i, .ok = true};
+		if (pthread_create(&(threads[i]), NULL, pt_producer, &(args[i]))) {
+			// LCOV_EXCL_START
+			perror("pthread_create");
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+
+	int total = 0;
+	while (total < (PT_PRODUCERS * PT_MESSAGES)) {
+		msg_t *batch[64];
+		size_t n = queue_pop_batch(&QT, batch, 64);
+		if (n == 0) {
+			queue_wait(&QT, 1000);
+			continue;
+		}
+		for (size_t i = 0; i < n; i++) {
+			msg_free(batch[i]);
+		}
+		total += n;
+	}
+
+	bool failed = false;
+	for (int i = 0; i < PT_PRODUCERS; i++) {
+		pthread_join(threads[i], NULL);
+		if (!args[i].ok) { failed = true; }
+	}
+	queue_destroy(&QT);
+
+	pool_stats ps = {0};
+	pool_get_stats(&ps);
+	uint64_t allocs = 0;
+	uint64_t frees = 0;
+	for (int c = 0; c < POOL_CLASSES; c++) {
+		fprintf(stdout,
+		        "Class %d (%zu bytes): %" PRIu64 " allocs, %" PRIu64 " frees, %" PRIu64
+		        " swaps, %" PRIu64 " slabs\n",
+		        c, ps.classes[c].blockSize, ps.classes[c].allocs, ps.classes[c].frees,
+		        ps.classes[c].depotSwaps, ps.classes[c].slabs);
+		allocs += ps.classes[c].allocs;
+		frees += ps.classes[c].frees;
+	}
+
+	// Each producer allocates a header for every message, plus data for the byte arrays
+	const uint64_t expected = PT_PRODUCERS * (PT_MESSAGES + (PT_MESSAGES / 3));
+	if (allocs != expected || frees != allocs || ps.oversize != 1) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Unexpected pool statistics: %" PRIu64 " allocs, %" PRIu64 " frees\n",
+		        allocs, frees);
+		failed = true;
+		// LCOV_EXCL_STOP
+	}
+	pool_destroy();
+
+	fprintf(stdout, "%d messages allocated from pool\n", total);
+	return failed ? -1 : 0;
+}
@@ -31,6 +31,17 @@
  * combinations.  The queue length is verified at various points, and messages
  * removed from the queue are checked to ensure ordering is maintained.
  *
+ * A small queue is also filled and repeatedly wrapped around to check
+ * ordering is maintained as slots are reused.
+ *
+ * Batch removal with queue_pop_batch() and queue_drain() is checked for
+ * ordering and counts, including across the end of the ring. Batches added
+ * with queue_push_batch() are checked in the same way, along with rejection
+ * of batches containing NULL entries.
+ *
+ * queue_try_push() is checked to return immediately, without taking
+ * ownership of the message, when the queue is full.
+ *
  * Note that this is a single threaded test.
  *
  * Ideally this test should also be checked with valgrind to ensure memory is
@@ -232,5 +243,234 @@ int main(void) {
 	}
 	queue_destroy(&QT);
 
+	// Waiting on an empty queue should time out, but return immediately with messages queued
+	queue_init(&QT);
+	if (queue_wait(&QT, 10)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "queue_wait() returned true for empty queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	// A wake without a message ends the next wait early, even if issued first
+	queue_wake(&QT);
+	if (queue_wait(&QT, -1)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "queue_wait() returned true after queue_wake()\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	queue_push(&QT, msg_new_float(1, 4, 0));
+	if (!queue_wait(&QT, -1)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "queue_wait() returned false with messages queued\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	queue_destroy(&QT);
+	if (queue_wait(&QT, -1)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "queue_wait() returned true for destroyed queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	// Small queue, to check capacity rounding and wrapping around the ring
+	if (!queue_init_size(&QT, 3) || QT.capacity != 4) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise small queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	fprintf(stdout, "Filling and wrapping small queue...\n");
+	int next = 0;
+	for (int i = 0; i < 4; i++) {
+		if (!queue_push(&QT, msg_new_float(1, 5, i))) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Unable to push item to small queue\n");
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+	for (int lap = 0; lap < 10; lap++) {
+		count = queue_count(&QT);
+		if (count != 4) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Incorrect item count (expected 4, got %d)\n", count);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		for (int i = 0; i < 3; i++) {
+			msg_t *item = queue_pop(&QT);
+			if (item == NULL || item->data.value != next) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "Messages out of order after wrapping (expected %d)\n", next);
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			next++;
+			msg_destroy(item);
+			free(item);
+		}
+		for (int i = 0; i < 3; i++) {
+			if (!queue_push(&QT, msg_new_float(1, 5, next + 1 + i))) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "Unable to push item to small queue\n");
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+		}
+	}
+	// Destroy with a full queue
+	queue_destroy(&QT);
+
+	// Batch removal, wrapping around the end of the ring
+	fprintf(stdout, "Testing batch removal...\n");
+	if (!queue_init_size(&QT, 8)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise batch test queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	next = 0;
+	int pushed = 0;
+	for (int lap = 0; lap < 5; lap++) {
+		for (int i = 0; i < 6; i++) {
+			queue_push(&QT, msg_new_float(1, 6, pushed++));
+		}
+		msg_t *batch[4] = {0};
+		size_t n = queue_pop_batch(&QT, batch, 4);
+		if (n != 4) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Incorrect batch size (expected 4, got %zu)\n", n);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		for (size_t i = 0; i < n; i++) {
+			if (batch[i]->data.value != next) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "Batch out of order (expected %d)\n", next);
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			next++;
+			msg_destroy(batch[i]);
+			free(batch[i]);
+		}
+
+		msg_t **all = NULL;
+		n = queue_drain(&QT, &all);
+		if (n != 2 || all == NULL || queue_count(&QT) != 0) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Incorrect drain size (expected 2, got %zu)\n", n);
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		for (size_t i = 0; i < n; i++) {
+			if (all[i]->data.value != next) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "Drain out of order (expected %d)\n", next);
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			next++;
+			msg_destroy(all[i]);
+			free(all[i]);
+		}
+		free(all);
+	}
+	msg_t **none = NULL;
+	if (queue_drain(&QT, &none) != 0 || none != NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Drained messages from empty queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	queue_destroy(&QT);
+
+	// Batch addition, wrapping around the end of the ring
+	fprintf(stdout, "Testing batch addition...\n");
+	if (!queue_init_size(&QT, 8)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise batch test queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	next = 0;
+	pushed = 0;
+	for (int lap = 0; lap < 5; lap++) {
+		msg_t *batch[5] = {0};
+		for (int i = 0; i < 5; i++) {
+			batch[i] = msg_new_float(1, 7, pushed++);
+		}
+		if (queue_push_batch(&QT, batch, 5) != 5 || queue_count(&QT) != 5) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Unable to push batch to queue\n");
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+		for (int i = 0; i < 5; i++) {
+			msg_t *item = queue_pop(&QT);
+			if (item == NULL || item->data.value != next) {
+				// LCOV_EXCL_START
+				fprintf(stderr, "Pushed batch out of order (expected %d)\n", next);
+				return -1;
+				// LCOV_EXCL_STOP
+			}
+			next++;
+			msg_destroy(item);
+			free(item);
+		}
+	}
+	msg_t *partial[2] = {msg_new_float(1, 7, 0), NULL};
+	if (queue_push_batch(&QT, partial, 2) != 0 || queue_count(&QT) != 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Batch containing NULL message accepted\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	msg_destroy(partial[0]);
+	free(partial[0]);
+	if (queue_push_batch(&QT, partial, 0) != 0) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Empty batch reported as added\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	queue_destroy(&QT);
+
+	fprintf(stdout, "Testing non-blocking addition...\n");
+	if (!queue_init_size(&QT, 4)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise non-blocking test queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	for (int i = 0; i < 4; i++) {
+		if (!queue_try_push(&QT, msg_new_float(1, 8, i))) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Unable to add message to queue with free space\n");
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+	msg_t *extra = msg_new_float(1, 8, 4);
+	if (queue_try_push(&QT, extra) || queue_count(&QT) != 4) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Message added to full queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	msg_t *first = queue_pop(&QT);
+	msg_destroy(first);
+	free(first);
+	if (!queue_try_push(&QT, extra) || queue_count(&QT) != 4) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Unable to add message after space freed\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+	queue_destroy(&QT);
+
 	return 0;
 }
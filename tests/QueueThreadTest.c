@@ -0,0 +1,187 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file QueueThreadTest.c
+ *
+ * @brief Multi-producer queue testing
+ *
+ * @test Several producer threads push numbered messages into a deliberately
+ * small queue while the main thread consumes them. The consumer checks that
+ * every message arrives exactly once and that messages from each producer
+ * are received in the order they were pushed.
+ *
+ * Half of the producers use queue_push_batch() with batches of varying size,
+ * some larger than the free space in the queue, so that batches are split
+ * and interleaved with messages from other producers.
+ *
+ * The consumer blocks using queue_wait() when the queue is empty, so this
+ * also checks that producers wake the consumer reliably.
+ *
+ * @ingroup testing
+ */
+
+//! Number of producer threads
+#define QTT_PRODUCERS 4
+
+//! Number of messages pushed by each producer
+#define QTT_MESSAGES 20000
+
+//! Producer thread arguments
+typedef struct {
+	msgqueue *q; //!< Shared queue
+	uint8_t id;  //!< Producer ID, used as message source
+	bool ok;     //!< Set false on error
+} qtt_args;
+
+//! Largest batch pushed by batch producers
+#define QTT_BATCH 48
+
+/*!
+ * Push QTT_MESSAGES sequentially numbered messages to the shared queue in
+ * batches of 1 to QTT_BATCH messages
+ *
+ * @param[in] a Producer arguments
+ */
+static void qtt_batch_producer(qtt_args *a) {
+	msg_t *batch[QTT_BATCH] = {0};
+	int i = 0;
+	int size = a->id;
+	while (i < QTT_MESSAGES) {
+		size = (size * 7 + 5) % QTT_BATCH + 1;
+		size_t n = 0;
+		while (n < (size_t)size && i < QTT_MESSAGES) {
+			batch[n++] = msg_new_timestamp(a->id, 2, i++);
+		}
+		const size_t pushed = queue_push_batch(a->q, batch, n);
+		if (pushed != n) {
+			// LCOV_EXCL_START
+			for (size_t j = pushed; j < n; j++) {
+				msg_free(batch[j]);
+			}
+			a->ok = false;
+			return;
+			// LCOV_EXCL_STOP
+		}
+	}
+}
+
+/*!
+ * Push QTT_MESSAGES sequentially numbered messages to the shared queue
+ *
+ * Producers with odd IDs push messages in batches.
+ *
+ * @param[in] ptargs Pointer to qtt_args
+ * @returns NULL
+ */
+static void *qtt_producer(void *ptargs) {
+	qtt_args *a = (qtt_args *)ptargs;
+	if (a->id % 2) {
+		qtt_batch_producer(a);
+		return NULL;
+	}
+	for (int i = 0; i < QTT_MESSAGES; i++) {
+		msg_t *m = msg_new_timestamp(a->id, 2, i);
+		if (!queue_push(a->q, m)) {
+			// LCOV_EXCL_START
+			msg_destroy(m);
+			free(m);
+			a->ok = false;
+			return NULL;
+			// LCOV_EXCL_STOP
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * Start producers, consume and check all messages.
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	msgqueue QT = {0};
+	if (!queue_init_size(&QT, 64)) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Failed to initialise queue\n");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	pthread_t threads[QTT_PRODUCERS];
+	qtt_args args[QTT_PRODUCERS];
+	for (int i = 0; i < QTT_PRODUCERS; i++) {
+		args[i].q = &QT;
+		args[i].id = i;
+		args[i].ok = true;
+		if (pthread_create(&(threads[i]), NULL, qtt_producer, &(args[i]))) {
+			// LCOV_EXCL_START
+			perror("pthread_create");
+			return -1;
+			// LCOV_EXCL_STOP
+		}
+	}
+
+	uint32_t expected[QTT_PRODUCERS] = {0};
+	int total = 0;
+	bool failed = false;
+	while (total < (QTT_PRODUCERS * QTT_MESSAGES)) {
+		msg_t *m = queue_pop(&QT);
+		if (m == NULL) {
+			// Producers should wake us well before this times out
+			queue_wait(&QT, 1000);
+			continue;
+		}
+		if (m->source >= QTT_PRODUCERS || m->data.timestamp != expected[m->source]) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Unexpected message: Source %d, value %u\n", m->source,
+			        m->data.timestamp);
+			failed = true;
+			// LCOV_EXCL_STOP
+		} else {
+			expected[m->source]++;
+		}
+		total++;
+		msg_destroy(m);
+		free(m);
+	}
+
+	for (int i = 0; i < QTT_PRODUCERS; i++) {
+		pthread_join(threads[i], NULL);
+		if (!args[i].ok) { failed = true; }
+	}
+
+	if (queue_count(&QT) != 0 || queue_pop(&QT) != NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Queue not empty after all messages received\n");
+		failed = true;
+		// LCOV_EXCL_STOP
+	}
+	queue_destroy(&QT);
+
+	fprintf(stdout, "%d messages received from %d producers\n", total, QTT_PRODUCERS);
+	return failed ? -1 : 0;
+}
@@ -0,0 +1,269 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file RingTest.c
+ *
+ * @brief Byte ring and message framing tests
+ *
+ * @test Checks that data in a ring can be read as a single block when it
+ * wraps around the end of the ring, both with mirrored storage and with a
+ * plain buffer. Frames of a simple test protocol are then extracted from a
+ * stream containing noise, partial frames and corrupted frames, with the
+ * stream delivered in chunks of varying sizes through a pipe.
+ *
+ * @ingroup testing
+ */
+
+//! Test protocol start byte
+#define RT_SYNC 0x7E
+
+//! Number of frames written to pipe
+#define RT_FRAMES 500
+
+/*!
+ * @param[in] data Unprocessed data
+ * @param[in] len  Length of data
+ * @returns Offset of first RT_SYNC byte, or len
+ */
+static size_t rt_sync(const uint8_t *data, size_t len) {
+	const uint8_t *s = memchr(data, RT_SYNC, len);
+	return s ? (size_t)(s - data) : len;
+}
+
+/*!
+ * Frames are: RT_SYNC, payload length, payload, XOR of payload bytes
+ *
+ * @param[in] data Candidate frame
+ * @param[in] len  Length of data
+ * @returns Frame length, 0 if more data required, -1 if invalid
+ */
+static ssize_t rt_length(const uint8_t *data, size_t len) {
+	if (len < 2) { return 0; }
+	if (data[1] > 64) { return -1; }
+	return data[1] + 3;
+}
+
+/*!
+ * @param[in] data Frame
+ * @param[in] len  Frame length
+ * @returns True if checksum valid
+ */
+static bool rt_check(const uint8_t *data, size_t len) {
+	uint8_t cs = 0;
+	for (size_t i = 2; i < len - 1; i++) {
+		cs ^= data[i];
+	}
+	return cs == data[len - 1];
+}
+
+//! Test protocol description
+static const frame_protocol rt_protocol = {
+	.sync = &rt_sync, .length = &rt_length, .check = &rt_check, .maxLength = 67};
+
+/*!
+ * Add n bytes to ring, then check contents can be read back contiguously
+ *
+ * @param[in] r     Ring
+ * @param[in] n     Number of bytes to add
+ * @param[in] seed  First value written
+ */
+static void rt_wrap(byte_ring *r, size_t n, uint8_t seed) {
+	size_t space = 0;
+	uint8_t *dst = ring_reserve(r, &space);
+	assert(space >= n);
+	for (size_t i = 0; i < n; i++) {
+		dst[i] = (uint8_t)(seed + i);
+	}
+	ring_commit(r, n);
+	assert(ring_used(r) == n);
+	const uint8_t *d = ring_data(r);
+	for (size_t i = 0; i < n; i++) {
+		assert(d[i] == (uint8_t)(seed + i));
+	}
+	ring_consume(r, n);
+	assert(ring_used(r) == 0);
+}
+
+/*!
+ * Write a frame to buffer
+ *
+ * @param[out] out    Output buffer (at least 64 bytes)
+ * @param[in]  id     Frame identifier, used to generate contents
+ * @param[in]  broken Corrupt checksum
+ * @returns Number of bytes written
+ */
+static size_t rt_frame(uint8_t *out, int id, bool broken) {
+	// All payload bytes are below 0x40, so RT_SYNC only appears at the
+	// start of each frame and corrupted frames are skipped cleanly
+	const uint8_t n = (uint8_t)(id % 60) + 2;
+	out[0] = RT_SYNC;
+	out[1] = n;
+	out[2] = (uint8_t)(id & 0x3F);
+	out[3] = (uint8_t)(id >> 6);
+	uint8_t cs = out[2] ^ out[3];
+	for (uint8_t i = 2; i < n; i++) {
+		out[i + 2] = (uint8_t)(i & 0x3F);
+		cs ^= out[i + 2];
+	}
+	out[n + 2] = broken ? (uint8_t)~cs : cs;
+	return n + 3;
+}
+
+/*!
+ * Read frames from a pipe, checking that all valid frames are received in
+ * order and that corrupted frames are reported.
+ *
+ * @param[in] r Ring (must be empty)
+ */
+static void rt_stream(byte_ring *r) {
+	int pfd[2] = {-1, -1};
+	assert(pipe(pfd) == 0);
+
+	// Build stream: noise, valid frames and every 7th frame corrupted
+	const size_t streamLen = RT_FRAMES * 80;
+	uint8_t *stream = calloc(streamLen, 1);
+	assert(stream);
+	size_t sl = 0;
+	int expectInvalid = 0;
+	for (int f = 0; f < RT_FRAMES; f++) {
+		if (f % 5 == 0) {
+			stream[sl++] = 0x00;
+			stream[sl++] = 0x55;
+		}
+		const bool broken = (f % 7 == 3);
+		if (broken) { expectInvalid++; }
+		sl += rt_frame(&(stream[sl]), f, broken);
+	}
+	assert(sl <= streamLen);
+
+	int next = 0;
+	int invalid = 0;
+	size_t written = 0;
+	size_t chunk = 1;
+	while (next < RT_FRAMES) {
+		const uint8_t *fr = NULL;
+		size_t fl = 0;
+		frame_status fs = frame_next(r, &rt_protocol, &fr, &fl);
+		if (fs == FRAME_OK) {
+			while (next % 7 == 3) {
+				next++; // Corrupted frames are skipped
+			}
+			assert(fl == (size_t)(next % 60) + 5);
+			assert((fr[2] + (fr[3] << 6)) == next);
+			next++;
+			continue;
+		}
+		if (fs == FRAME_INVALID) {
+			invalid++;
+			continue;
+		}
+		assert(fs == FRAME_MORE);
+		if (written == sl) { break; }
+
+		// Deliver stream in irregular chunks
+		chunk = (chunk * 7 + 3) % 97 + 1;
+		const size_t n = (sl - written < chunk) ? sl - written : chunk;
+		assert(write(pfd[1], &(stream[written]), n) == (ssize_t)n);
+		written += n;
+		assert(ring_fill(r, pfd[0]) == (ssize_t)n);
+	}
+	while (next % 7 == 3 && next < RT_FRAMES) {
+		next++;
+	}
+	assert(next == RT_FRAMES);
+	assert(invalid == expectInvalid);
+	assert(ring_used(r) == 0);
+
+	free(stream);
+	close(pfd[0]);
+	close(pfd[1]);
+}
+
+/*!
+ * Test ring buffer and framing functions
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	byte_ring r = {0};
+	assert(!ring_init(NULL, 100));
+	assert(!ring_init(&r, 0));
+	assert(ring_init(&r, 100));
+	assert(r.size >= 100);
+	assert((r.size & (r.size - 1)) == 0);
+	if (!r.mirrored) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Mirrored ring not available, using plain buffer\n");
+		// LCOV_EXCL_STOP
+	}
+
+	// Repeatedly fill most of the ring, so data wraps around the end
+	for (int i = 0; i < 10; i++) {
+		rt_wrap(&r, r.size - 3, (uint8_t)i);
+	}
+	rt_wrap(&r, r.size, 0x42);
+
+	const uint8_t *fr = NULL;
+	size_t fl = 0;
+	assert(frame_next(NULL, &rt_protocol, &fr, &fl) == FRAME_ERROR);
+	assert(frame_next(&r, NULL, &fr, &fl) == FRAME_ERROR);
+	assert(frame_next(&r, &rt_protocol, &fr, &fl) == FRAME_MORE);
+
+	// Over-length frame is skipped without waiting for more data
+	size_t space = 0;
+	uint8_t *dst = ring_reserve(&r, &space);
+	dst[0] = RT_SYNC;
+	dst[1] = 200;
+	ring_commit(&r, 2);
+	assert(frame_next(&r, &rt_protocol, &fr, &fl) == FRAME_MORE);
+	assert(ring_used(&r) == 0);
+
+	rt_stream(&r);
+	ring_destroy(&r);
+	assert(r.buf == NULL);
+
+	// Plain buffer, as used if mirrored mapping unavailable
+	byte_ring plain = {.buf = malloc(256), .size = 256, .mirrored = false};
+	assert(plain.buf);
+	for (int i = 0; i < 20; i++) {
+		rt_wrap(&plain, 100 + i, (uint8_t)i);
+		rt_wrap(&plain, 37, (uint8_t)i);
+	}
+	dst = ring_reserve(&plain, &space);
+	assert(space == 256);
+	memset(dst, 0x11, 200);
+	ring_commit(&plain, 200);
+	ring_consume(&plain, 190);
+	dst = ring_reserve(&plain, &space);
+	assert(space == 246);
+	assert(ring_data(&plain)[0] == 0x11);
+	ring_reset(&plain);
+	rt_stream(&plain);
+	ring_destroy(&plain);
+	return 0;
+}
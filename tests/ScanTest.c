@@ -0,0 +1,204 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file ScanTest.c
+ *
+ * @brief Synchronisation byte search tests
+ *
+ * @test Compares scan_byte(), scan_either() and scan_pair() against simple
+ * byte-by-byte searches for every start offset and length within a buffer of
+ * random data, and for buffers with matches placed at each position relative
+ * to the vector block size (including a partial pair at the end of the data).
+ *
+ * Also reports the throughput of each search over a large buffer containing
+ * no sync bytes, as seen when resynchronising on a noisy or misconfigured
+ * input, compared with a byte-by-byte search.
+ *
+ * @ingroup testing
+ */
+
+//! Size of buffer used for comparison with reference searches
+#define SCAN_TEST_LEN 200
+
+//! Size of buffer used for throughput comparison
+#define SCAN_TIMING_LEN (4 * 1024 * 1024)
+
+//! Number of searches over timing buffer for each method
+#define SCAN_TIMING_REPEAT 10
+
+/*!
+ * @param[in] d Data
+ * @param[in] n Length
+ * @param[in] a Byte
+ * @returns Offset of first a, or n
+ */
+static size_t ref_byte(const uint8_t *d, size_t n, uint8_t a) {
+	for (size_t i = 0; i < n; i++) {
+		if (d[i] == a) { return i; }
+	}
+	return n;
+}
+
+/*!
+ * @param[in] d Data
+ * @param[in] n Length
+ * @param[in] a First byte
+ * @param[in] b Second byte
+ * @returns Offset of first a or b, or n
+ */
+static size_t ref_either(const uint8_t *d, size_t n, uint8_t a, uint8_t b) {
+	for (size_t i = 0; i < n; i++) {
+		if (d[i] == a || d[i] == b) { return i; }
+	}
+	return n;
+}
+
+/*!
+ * @param[in] d Data
+ * @param[in] n Length
+ * @param[in] a First byte of sequence
+ * @param[in] b Second byte of sequence
+ * @returns Offset of first a followed by b (or a as final byte), or n
+ */
+static size_t ref_pair(const uint8_t *d, size_t n, uint8_t a, uint8_t b) {
+	for (size_t i = 0; i < n; i++) {
+		if (d[i] == a && (i + 1 == n || d[i + 1] == b)) { return i; }
+	}
+	return n;
+}
+
+/*!
+ * Check all searches against reference implementations for every offset and
+ * length within buffer.
+ *
+ * @param[in] buf Data
+ * @param[in] len Length of data
+ * @param[in] a   First byte
+ * @param[in] b   Second byte
+ */
+static void check_all(const uint8_t *buf, size_t len, uint8_t a, uint8_t b) {
+	for (size_t s = 0; s <= len; s++) {
+		for (size_t n = 0; s + n <= len; n++) {
+			assert(scan_byte(&(buf[s]), n, a) == ref_byte(&(buf[s]), n, a));
+			assert(scan_either(&(buf[s]), n, a, b) == ref_either(&(buf[s]), n, a, b));
+			assert(scan_pair(&(buf[s]), n, a, b) == ref_pair(&(buf[s]), n, a, b));
+		}
+	}
+}
+
+/*!
+ * @returns Current CLOCK_MONOTONIC time in nanoseconds
+ */
+static double now_ns(void) {
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1.0E9) + ts.tv_nsec;
+}
+
+/*!
+ * @param[in] ns Time taken for SCAN_TIMING_REPEAT searches
+ * @returns Throughput in MB/s
+ */
+static double rate(double ns) {
+	return ((double)SCAN_TIMING_LEN * SCAN_TIMING_REPEAT / 1.0E6) / (ns / 1.0E9);
+}
+
+/*!
+ * Test sync byte search functions
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	assert(scan_byte(NULL, 0, 0x24) == 0);
+	assert(scan_either(NULL, 0, 0x24, 0x21) == 0);
+	assert(scan_pair(NULL, 0, 0xB5, 0x62) == 0);
+
+	uint8_t buf[SCAN_TEST_LEN] = {0};
+
+	// Random data, with enough matches to be found at a range of positions
+	srand(1);
+	for (size_t i = 0; i < SCAN_TEST_LEN; i++) {
+		buf[i] = (uint8_t)(rand() % 24);
+	}
+	check_all(buf, SCAN_TEST_LEN, 3, 7);
+	check_all(buf, SCAN_TEST_LEN, 5, 5);
+	check_all(buf, SCAN_TEST_LEN, 0x80, 0x81);
+
+	// Single matches at each position, including either side of block edges
+	for (size_t p = 0; p < 40; p++) {
+		memset(buf, 0x55, sizeof(buf));
+		buf[p] = 0xB5;
+		buf[p + 1] = 0x62;
+		assert(scan_byte(buf, 40, 0xB5) == p);
+		assert(scan_either(buf, 40, 0x24, 0x62) == p + 1);
+		assert(scan_pair(buf, 40, 0xB5, 0x62) == p);
+		// Sequence split by end of data
+		assert(scan_pair(buf, p + 1, 0xB5, 0x62) == p);
+		// First byte alone is not a match unless it ends the data
+		buf[p + 1] = 0x55;
+		assert(scan_pair(buf, 40, 0xB5, 0x62) == ((p == 39) ? 39 : 40));
+	}
+
+	// Throughput over data containing no sync bytes
+	uint8_t *noise = malloc(SCAN_TIMING_LEN);
+	assert(noise);
+	for (size_t i = 0; i < SCAN_TIMING_LEN; i++) {
+		noise[i] = (uint8_t)(i % 0x20);
+	}
+
+	size_t total = 0;
+	double start = now_ns();
+	for (int r = 0; r < SCAN_TIMING_REPEAT; r++) {
+		total += ref_either(noise, SCAN_TIMING_LEN, '$', '!');
+	}
+	const double tRef = now_ns() - start;
+
+	start = now_ns();
+	for (int r = 0; r < SCAN_TIMING_REPEAT; r++) {
+		total += scan_byte(noise, SCAN_TIMING_LEN, 0xB5);
+	}
+	const double tByte = now_ns() - start;
+
+	start = now_ns();
+	for (int r = 0; r < SCAN_TIMING_REPEAT; r++) {
+		total += scan_either(noise, SCAN_TIMING_LEN, '$', '!');
+	}
+	const double tEither = now_ns() - start;
+
+	start = now_ns();
+	for (int r = 0; r < SCAN_TIMING_REPEAT; r++) {
+		total += scan_pair(noise, SCAN_TIMING_LEN, 0xB5, 0x62);
+	}
+	const double tPair = now_ns() - start;
+	assert(total == 4 * SCAN_TIMING_REPEAT * (size_t)SCAN_TIMING_LEN);
+	free(noise);
+
+	fprintf(stdout, "Resync throughput (%s): %.0f MB/s (byte loop), %.0f MB/s (scan_byte), %.0f MB/s (scan_either), %.0f MB/s (scan_pair)\n",
+	        scan_implementation(), rate(tRef), rate(tByte), rate(tEither), rate(tPair));
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (C) 2023 Swansea University
+ *
+ *  This file is part of the SELKIELogger suite of tools.
+ *
+ *  SELKIELogger is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SELKIELogger is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ *  more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this SELKIELogger product.
+ *  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "SELKIELoggerBase.h"
+
+/*! @file SerialTest.c
+ *
+ * @brief Serial port configuration tests
+ *
+ * @test Opens a pseudo-terminal as a serial port and checks that it is only
+ * reported as readable once the minimum amount of data set with
+ * serial_set_minimum() is available, and that error counters are reported
+ * as unavailable. Also checks conversion between baud rates and flags, and
+ * that non-standard baud rates can be set.
+ *
+ * @ingroup testing
+ */
+
+/*!
+ * @param[in] fd      File descriptor
+ * @param[in] timeout Time to wait (milliseconds)
+ * @returns True if fd reported as readable
+ */
+static bool readable(int fd, int timeout) {
+	struct pollfd pfd = {.fd = fd, .events = POLLIN};
+	return poll(&pfd, 1, timeout) == 1 && (pfd.revents & POLLIN);
+}
+
+/*!
+ * Test serial port functions using a pseudo-terminal
+ *
+ * @returns 0 (Pass), -1 (Fail)
+ */
+int main(void) {
+	assert(flag_to_baud(baud_to_flag(115200)) == 115200);
+	assert(flag_to_baud(baud_to_flag(921600)) == 921600);
+	assert(baud_to_flag(12345) == -1);
+
+	const int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+		// LCOV_EXCL_START
+		perror("Unable to create pseudo-terminal");
+		return -1;
+		// LCOV_EXCL_STOP
+	}
+
+	const int port = openSerialConnection(ptsname(master), 115200);
+	assert(port >= 0);
+
+	serial_counts sc = {0};
+	assert(!serial_get_counts(-1, &sc));
+	assert(!serial_get_counts(port, NULL));
+	assert(!serial_get_counts(port, &sc)); // Not supported by pseudo-terminals
+
+	assert(!serial_set_minimum(-1, 8));
+	assert(serial_set_minimum(port, 8));
+
+	const uint8_t data[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+	assert(write(master, data, 4) == 4);
+	assert(!readable(port, 100));
+	assert(write(master, &(data[4]), 4) == 4);
+	assert(readable(port, 1000));
+
+	// Non-blocking reads return whatever is available
+	uint8_t buf[16] = {0};
+	assert(read(port, buf, sizeof(buf)) == 8);
+	for (int i = 0; i < 8; i++) {
+		assert(buf[i] == data[i]);
+	}
+	assert(!readable(port, 0));
+
+	// Any data at all with a threshold of 1
+	assert(serial_set_minimum(port, 0));
+	assert(write(master, data, 1) == 1);
+	assert(readable(port, 1000));
+	assert(read(port, buf, sizeof(buf)) == 1);
+
+	close(port);
+
+	// Rates not listed in termios.h
+	assert(!serial_set_rate(-1, 250000));
+	assert(serial_get_rate(-1) == -1);
+	assert(!serial_set_low_latency(-1));
+	const int fast = openSerialConnection(ptsname(master), 250000);
+	assert(fast >= 0);
+	assert(serial_get_rate(fast) == 250000);
+	assert(serial_set_rate(fast, 115200));
+	assert(serial_get_rate(fast) == 115200);
+	close(fast);
+
+	close(master);
+	return 0;
+}
@@ -41,6 +41,10 @@
  *
  * Does not attempt to use friendly names for sources or channels.
  *
+ * For block structured (version 2) files, the checksum of each block is
+ * verified and a summary of each block header is printed instead of its raw
+ * contents.
+ *
  * @param[in] argc Argument count
  * @param[in] argv Arguments
  * @returns -1 on error, otherwise 0
@@ -87,12 +91,23 @@ int main(int argc, char *argv[]) {
 		return -1;
 	}
 
+	mp_stream stream = {0};
+	if (!mp_stream_init(&stream, fileno(inFile), 0)) {
+		log_error(&state, "Unable to allocate input buffer");
+		fclose(inFile);
+		free(inFileName);
+		destroy_program_state(&state);
+		return -1;
+	}
+
 	state.started = 1;
 	int msgCount = 0;
+	int blockCount = 0;
+	int badBlocks = 0;
 	while (!(feof(inFile))) {
 		// Read message from data file
 		msg_t tmp = {0};
-		if (!mp_readMessage(fileno(inFile), &tmp)) {
+		if (!mp_stream_read(&stream, &tmp)) {
 			if (tmp.data.value == 0xAA || tmp.data.value == 0xEE) {
 				log_error(&state,
 				          "Error reading messages from file (Code: 0x%52x)\n",
@@ -105,6 +120,21 @@ int main(int argc, char *argv[]) {
 			break;
 		}
 
+		mp_block_info bi = {0};
+		if (mp_block_parse(&tmp, &bi)) {
+			blockCount++;
+			const bool valid = mp_stream_check_block(&stream, &bi);
+			if (!valid) { badBlocks++; }
+			if (!valid || state.verbose > 1) {
+				fprintf(stdout,
+				        "Block: %u messages, %u bytes, timestamps %u - %u, checksum %s\n",
+				        bi.count, bi.length, bi.firstStamp, bi.lastStamp,
+				        valid ? "OK" : "FAILED");
+			}
+			msg_destroy(&tmp);
+			continue;
+		}
+
 		msgCount++;
 		if (tmp.type >= 0x03 || state.verbose > 1) {
 			char *msgstring = msg_to_string(&tmp);
@@ -115,6 +145,11 @@ int main(int argc, char *argv[]) {
 	}
 
 	log_info(&state, 1, "%d messages processed", msgCount);
+	if (blockCount > 0) {
+		log_info(&state, 1, "%d blocks processed, %d failed verification", blockCount,
+		         badBlocks);
+	}
+	mp_stream_destroy(&stream);
 	free(inFileName);
 	fclose(inFile);
 	return 0;
@@ -236,12 +236,21 @@ int main(int argc, char *argv[]) {
 	inFileName = NULL;
 
 	char *GNSS[] = {"GPS", "SBAS", "Galileo", "BeiDou", "IMES", "QZSS", "GLONASS"};
+	mp_stream stream = {0};
+	if (!mp_stream_init(&stream, fileno(inFile), 0)) {
+		log_error(&state, "Unable to allocate input buffer");
+		fclose(inFile);
+		gzclose(outFile);
+		destroy_program_state(&state);
+		return -1;
+	}
+
 	gzprintf(outFile,
 	         "TOW,Source,GNSS,SatID,SNR,Elevation,Azimuth,Residual,Quality,SatUsed\n");
 	while (!(feof(inFile))) {
 		// Read message from data file
 		msg_t tmp = {0};
-		if (!mp_readMessage(fileno(inFile), &tmp)) {
+		if (!mp_stream_read(&stream, &tmp)) {
 			if (tmp.data.value == 0xAA || tmp.data.value == 0xEE) {
 				log_error(&state,
 				          "Error reading messages from file (Code: 0x%52x)\n",
@@ -289,6 +298,7 @@ int main(int argc, char *argv[]) {
 			log_info(&state, 2, "Progress: %d%% (%ld / %ld)", progress, inPos, inSize);
 		}
 	}
+	mp_stream_destroy(&stream);
 	fclose(inFile);
 	gzclose(outFile);
 
@@ -40,6 +40,10 @@
 /*!
  * Writes a new .dat file containing only messages with a specific source ID.
  *
+ * Output can be limited to a range of primary clock timestamps. If an index
+ * file (.idx) is found alongside the input file, it is used to skip directly
+ * to the start of the requested range.
+ *
  * @param[in] argc Argument count
  * @param[in] argv Arguments
  * @returns -1 on error, otherwise 0
@@ -53,9 +57,12 @@ int main(int argc, char *argv[]) {
 	uint8_t source = 0;
 	bool type[255] = {0};
 	bool raw = false;
+	uint32_t tsBegin = 0;
+	uint32_t tsEnd = UINT32_MAX;
+	bool tsRange = false;
 
 	char *usage =
-		"Usage: %1$s [-v] [-q] [-f] [-r] [-o outfile] -S source [-C channel [-C channel ...]] DATFILE\n"
+		"Usage: %1$s [-v] [-q] [-f] [-r] [-o outfile] [-b begin] [-e end] -S source [-C channel [-C channel ...]] DATFILE\n"
 		"\t-v\tIncrease verbosity\n"
 		"\t-q\tDecrease verbosity\n"
 		"\t-f\tOverwrite existing output files\n"
@@ -63,6 +70,8 @@ int main(int argc, char *argv[]) {
 		"\t-S\tSource number to extract\n"
 		"\t-T\tMessage type(s) to extract\n"
 		"\t-o\tWrite output to named file\n"
+		"\t-b\tFirst primary clock timestamp to extract\n"
+		"\t-e\tLast primary clock timestamp to extract\n"
 		"\nVersion: " GIT_VERSION_STRING "\n"
 		"\nOutput file name will be generated based on input file name, unless set by -o option\n";
 
@@ -71,7 +80,7 @@ int main(int argc, char *argv[]) {
 	bool doUsage = false;
 	uint8_t tmp = 0;
 	uint8_t typeCount = 0;
-	while ((go = getopt(argc, argv, "vqfro:S:C:")) != -1) {
+	while ((go = getopt(argc, argv, "vqfro:S:C:b:e:")) != -1) {
 		switch (go) {
 			case 'v':
 				state.verbose++;
@@ -102,6 +111,24 @@ int main(int argc, char *argv[]) {
 				type[tmp] = true;
 				typeCount++;
 				break;
+			case 'b':
+				errno = 0;
+				tsBegin = strtoul(optarg, NULL, 0);
+				if (errno) {
+					log_error(&state, "Invalid start timestamp (%s)", optarg);
+					doUsage = true;
+				}
+				tsRange = true;
+				break;
+			case 'e':
+				errno = 0;
+				tsEnd = strtoul(optarg, NULL, 0);
+				if (errno) {
+					log_error(&state, "Invalid end timestamp (%s)", optarg);
+					doUsage = true;
+				}
+				tsRange = true;
+				break;
 
 			case 'o':
 				if (outFileName) {
@@ -125,6 +152,11 @@ int main(int argc, char *argv[]) {
 		doUsage = true;
 	}
 
+	if (tsBegin > tsEnd) {
+		log_error(&state, "Invalid timestamp range requested");
+		doUsage = true;
+	}
+
 	if (doUsage) {
 		fprintf(stderr, usage, argv[0]);
 		destroy_program_state(&state);
@@ -236,12 +268,44 @@ int main(int argc, char *argv[]) {
 		log_info(&state, 1, "Reading %ld bytes of data from %s", inSize, inFileName);
 	}
 
+	mp_stream stream = {0};
+	if (!mp_stream_init(&stream, fileno(inFile), 0)) {
+		log_error(&state, "Unable to allocate input buffer");
+		free(inFileName);
+		fclose(inFile);
+		fclose(outFile);
+		destroy_program_state(&state);
+		return -1;
+	}
+
+	// Primary timestamp preceding current message (0 if none yet)
+	uint32_t curStamp = 0;
+	if (tsRange) {
+		log_info(&state, 1, "Extracting messages between timestamps %u and %u", tsBegin,
+		         tsEnd);
+		// Index file name: replace .dat extension with .idx
+		const size_t inLen = strlen(inFileName);
+		if (tsBegin > 0 && inLen > 4 && strcmp(&inFileName[inLen - 4], ".dat") == 0) {
+			mp_index idx = {0};
+			memcpy(&inFileName[inLen - 4], ".idx", 4);
+			if (!mp_index_open(&idx, inFileName)) {
+				log_info(&state, 2, "No usable index file found (%s)", inFileName);
+			} else if (idx.clock != SLSOURCE_TIMER) {
+				log_warning(&state, "Index file uses unexpected clock source - ignored");
+			} else if (mp_index_seek(&idx, &stream, tsBegin)) {
+				log_info(&state, 1, "Using index file %s", inFileName);
+			} else {
+				log_warning(&state, "Unable to seek using index file");
+			}
+			mp_index_close(&idx);
+		}
+	}
 	free(inFileName);
 
 	while (!(feof(inFile))) {
 		// Read message from data file
 		msg_t mtmp = {0};
-		if (!mp_readMessage(fileno(inFile), &mtmp)) {
+		if (!mp_stream_read(&stream, &mtmp)) {
 			if (mtmp.data.value == 0xAA || mtmp.data.value == 0xEE) {
 				log_error(&state,
 				          "Error reading messages from file (Code: 0x%52x)\n",
@@ -253,7 +317,35 @@ int main(int argc, char *argv[]) {
 			}
 			break;
 		}
-		if (mtmp.source == source) {
+		mp_block_info bi = {0};
+		if (mp_block_parse(&mtmp, &bi)) {
+			if (bi.firstStamp > tsEnd) {
+				log_info(&state, 1, "End of requested time range reached");
+				msg_destroy(&mtmp);
+				break;
+			}
+			// Skip blocks that can't contain any messages of interest
+			if (bi.lastStamp < tsBegin || !mp_block_has_source(&bi, source)) {
+				if (!mp_stream_skip(&stream, bi.length)) {
+					log_error(&state, "Unable to skip block - truncated file?");
+					msg_destroy(&mtmp);
+					break;
+				}
+				// The last timestamp in a skipped block still applies
+				curStamp = bi.lastStamp;
+			}
+			msg_destroy(&mtmp);
+			continue;
+		}
+		if (mtmp.source == SLSOURCE_TIMER && mtmp.type == SLCHAN_TSTAMP) {
+			curStamp = mtmp.data.timestamp;
+			if (curStamp > tsEnd) {
+				log_info(&state, 1, "End of requested time range reached");
+				msg_destroy(&mtmp);
+				break;
+			}
+		}
+		if (curStamp >= tsBegin && mtmp.source == source) {
 			bool writeMsg = true;
 			if (typeCount > 0) { writeMsg = type[mtmp.type]; }
 
@@ -281,12 +373,13 @@ int main(int argc, char *argv[]) {
 			}
 		}
 		msg_destroy(&mtmp);
-		inPos = ftell(inFile);
+		inPos = lseek(fileno(inFile), 0, SEEK_CUR);
 		if (((((1.0 * inPos) / inSize) * 100) - progress) >= 5) {
 			progress = (((1.0 * inPos) / inSize) * 100);
 			log_info(&state, 2, "Progress: %d%% (%ld / %ld)", progress, inPos, inSize);
 		}
 	}
+	mp_stream_destroy(&stream);
 	fclose(inFile);
 	fclose(outFile);
 
@@ -275,11 +275,18 @@ int main(int argc, char *argv[]) {
 			log_error(&state, "Unable to open variable file");
 			return -1;
 		}
+		mp_stream varStream = {0};
+		if (!mp_stream_init(&varStream, fileno(varFile), 0)) {
+			log_error(&state, "Unable to allocate input buffer");
+			fclose(varFile);
+			return -1;
+		}
 		bool exitLoop = false;
 		while (!(feof(varFile) || exitLoop)) {
 			msg_t tmp = {0};
-			if (!mp_readMessage(fileno(varFile), &tmp)) {
-				if (tmp.data.value == 0xFF) {
+			if (!mp_stream_read(&varStream, &tmp)) {
+				if (tmp.data.value == 0xFF || tmp.data.value == 0xEE) {
+					// Skip over invalid messages
 					continue;
 				} else if (tmp.data.value == 0xFD) {
 					// No more data, exit cleanly
@@ -322,6 +329,7 @@ int main(int argc, char *argv[]) {
 			} // And ignore any other message types
 			msg_destroy(&tmp);
 		}
+		mp_stream_destroy(&varStream);
 		fclose(varFile);
 		// clang-format off
 		for (int i = 0; i < 128; i++) {
@@ -558,10 +566,21 @@ int main(int argc, char *argv[]) {
 	free(header);
 	header = NULL;
 
+	mp_stream stream = {0};
+	if (!mp_stream_init(&stream, fileno(inFile), 0)) {
+		log_error(&state, "Unable to allocate input buffer");
+		gzclose(outFile);
+		fclose(inFile);
+		free(handlers);
+		free_sn_cn(sourceNames, channelNames);
+		destroy_program_state(&state);
+		return -1;
+	}
+
 	while (!(feof(inFile))) {
 		// Read message from data file
 		msg_t *tmp = &(currentTimestep[currMsg++]);
-		if (!mp_readMessage(fileno(inFile), tmp)) {
+		if (!mp_stream_read(&stream, tmp)) {
 			if (tmp->data.value == 0xAA || tmp->data.value == 0xEE) {
 				log_error(&state,
 				          "Error reading messages from file (Code: 0x%52x)\n",
@@ -658,6 +677,7 @@ int main(int argc, char *argv[]) {
 			log_info(&state, 2, "Progress: %d%% (%ld / %ld)", progress, inPos, inSize);
 		}
 	}
+	mp_stream_destroy(&stream);
 	fclose(inFile);
 	gzclose(outFile);
 